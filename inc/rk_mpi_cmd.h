@@ -110,6 +110,7 @@ typedef enum {
     MPP_DEC_CMD_QUERY                   = CMD_MODULE_CODEC | CMD_CTX_ID_DEC | CMD_DEC_QUERY,
     /* query decoder runtime information for decode stage */
     MPP_DEC_QUERY,                      /* set and get MppDecQueryCfg structure */
+    MPP_DEC_GET_PERF_STATS,             /* get MppDecPerfStats structure */
 
     CMD_DEC_CMD_CFG                     = CMD_MODULE_CODEC | CMD_CTX_ID_DEC | CMD_DEC_CFG,
     MPP_DEC_SET_CFG,                    /* set MppDecCfg structure */
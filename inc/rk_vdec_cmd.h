@@ -63,6 +63,37 @@ typedef struct MppDecQueryCfg_t {
     RK_U32      dec_out_frm_cnt;
 } MppDecQueryCfg;
 
+/*
+ * decoder per-stage latency statistic for MPP_DEC_GET_PERF_STATS
+ * All time values are in microsecond.
+ */
+typedef enum MppDecPerfStage_e {
+    MPP_DEC_PERF_PKT_IN,        /* packet stays in input queue before parser gets it */
+    MPP_DEC_PERF_WAIT_PKT,      /* parser thread waits for input packet */
+    MPP_DEC_PERF_WAIT_BUF,      /* parser thread waits for buffer slot or hal task */
+    MPP_DEC_PERF_PREPARE,       /* parser prepare for stream split */
+    MPP_DEC_PERF_PARSE,         /* parser syntax parse */
+    MPP_DEC_PERF_GEN_REG,       /* hal register generation */
+    MPP_DEC_PERF_HW_START,      /* hal hardware start */
+    MPP_DEC_PERF_HW_WAIT,       /* hal hardware wait */
+    MPP_DEC_PERF_FRM_OUT,       /* interval between two output frames */
+    MPP_DEC_PERF_STAGE_BUTT,
+} MppDecPerfStage;
+
+typedef struct MppDecPerfStat_t {
+    /* short stage name for log, static string in mpp */
+    const char  *name;
+    RK_U64      count;
+    RK_U64      sum;
+    RK_U32      p50;
+    RK_U32      p99;
+    RK_U32      max;
+} MppDecPerfStat;
+
+typedef struct MppDecPerfStats_t {
+    MppDecPerfStat  stage[MPP_DEC_PERF_STAGE_BUTT];
+} MppDecPerfStats;
+
 typedef void* MppExtCbCtx;
 typedef MPP_RET (*MppExtCbFunc)(MppExtCbCtx cb_ctx, MppCtx mpp, RK_S32 cmd, void *arg);
 
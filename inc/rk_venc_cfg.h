@@ -43,6 +43,26 @@ MPP_RET mpp_enc_cfg_get_u64(MppEncCfg cfg, const char *name, RK_U64 *val);
 MPP_RET mpp_enc_cfg_get_ptr(MppEncCfg cfg, const char *name, void **val);
 MPP_RET mpp_enc_cfg_get_st(MppEncCfg cfg, const char *name, void *val);
 
+/*
+ * Resolve a config name to a handle once, then access by handle on the per
+ * frame path without name lookup. Handle is shared by all MppEncCfg.
+ */
+MPP_RET mpp_enc_cfg_get_hnd(const char *name, RK_S32 *hnd);
+
+MPP_RET mpp_enc_cfg_set_s32_hnd(MppEncCfg cfg, RK_S32 hnd, RK_S32 val);
+MPP_RET mpp_enc_cfg_set_u32_hnd(MppEncCfg cfg, RK_S32 hnd, RK_U32 val);
+MPP_RET mpp_enc_cfg_set_s64_hnd(MppEncCfg cfg, RK_S32 hnd, RK_S64 val);
+MPP_RET mpp_enc_cfg_set_u64_hnd(MppEncCfg cfg, RK_S32 hnd, RK_U64 val);
+MPP_RET mpp_enc_cfg_set_ptr_hnd(MppEncCfg cfg, RK_S32 hnd, void *val);
+MPP_RET mpp_enc_cfg_set_st_hnd(MppEncCfg cfg, RK_S32 hnd, void *val);
+
+MPP_RET mpp_enc_cfg_get_s32_hnd(MppEncCfg cfg, RK_S32 hnd, RK_S32 *val);
+MPP_RET mpp_enc_cfg_get_u32_hnd(MppEncCfg cfg, RK_S32 hnd, RK_U32 *val);
+MPP_RET mpp_enc_cfg_get_s64_hnd(MppEncCfg cfg, RK_S32 hnd, RK_S64 *val);
+MPP_RET mpp_enc_cfg_get_u64_hnd(MppEncCfg cfg, RK_S32 hnd, RK_U64 *val);
+MPP_RET mpp_enc_cfg_get_ptr_hnd(MppEncCfg cfg, RK_S32 hnd, void **val);
+MPP_RET mpp_enc_cfg_get_st_hnd(MppEncCfg cfg, RK_S32 hnd, void *val);
+
 void mpp_enc_cfg_show(void);
 
 #ifdef __cplusplus
@@ -72,6 +72,9 @@ typedef struct MppBufLogs_t {
     MppBufLog           *logs;
 } MppBufLogs;
 
+/* size class bin of unused buffer by log2 of size */
+#define MPP_BUF_BIN_CNT                 40
+
 typedef struct MppBufferImpl_t          MppBufferImpl;
 typedef struct MppBufferGroupImpl_t     MppBufferGroupImpl;
 typedef void (*MppBufCallback)(void *, void *);
@@ -111,6 +114,10 @@ struct MppBufferImpl_t {
     RK_U32              used;
     RK_S32              ref_count;
     struct list_head    list_status;
+    // link to size class bin of unused buffer
+    struct list_head    list_bin;
+    // time when buffer is put to unused list for idle trim
+    RK_S64              unused_time;
 };
 
 struct MppBufferGroupImpl_t {
@@ -155,6 +162,23 @@ struct MppBufferGroupImpl_t {
     struct list_head    list_unused;
     RK_S32              count_used;
     RK_S32              count_unused;
+    // unused buffer in size class bins for best-fit lookup
+    struct list_head    list_bins[MPP_BUF_BIN_CNT];
+    size_t              unused_size;
+
+    // retention config in internal mode
+    // retain_size: max unused buffer size to keep, 0 - no limit
+    // idle_time  : unused buffer idle time in us before trimming, 0 - never
+    size_t              retain_size;
+    RK_S64              idle_time;
+
+    // alloc / free statistic
+    RK_S32              alloc_count;
+    RK_S32              free_count;
+    RK_S32              reuse_count;
+    RK_S32              trim_count;
+    RK_U64              alloc_bytes;
+    RK_U64              free_bytes;
 
     // buffer log function
     MppBufLogs          *logs;
@@ -207,6 +231,12 @@ MPP_RET mpp_buffer_group_deinit(MppBufferGroupImpl *p);
 MPP_RET mpp_buffer_group_reset(MppBufferGroupImpl *p);
 MPP_RET mpp_buffer_group_set_callback(MppBufferGroupImpl *p,
                                       MppBufCallback callback, void *arg);
+/*
+ * config unused buffer retention in internal mode
+ * retain_size : max total size of unused buffer to keep, 0 - no limit
+ * idle_ms     : unused buffer is released after idle for idle_ms, 0 - never
+ */
+MPP_RET mpp_buffer_group_retain_config(MppBufferGroupImpl *p, size_t retain_size, RK_S32 idle_ms);
 // mpp_buffer_group helper function
 void mpp_buffer_group_dump(MppBufferGroupImpl *p);
 void mpp_buffer_service_dump(const char *info);
@@ -45,8 +45,9 @@ typedef struct MppMetaImpl_t {
     RK_S32              meta_id;
     RK_S32              ref_count;
 
-    struct list_head    list_meta;
     RK_S32              node_count;
+    /* bit i is set when vals[i] is valid */
+    RK_U64              valid;
     MppMetaVal          vals[];
 } MppMetaImpl;
 
@@ -22,6 +22,8 @@
 #define MPP_PACKET_FLAG_EOS             (0x00000001)
 #define MPP_PACKET_FLAG_EXTRA_DATA      (0x00000002)
 #define MPP_PACKET_FLAG_INTERNAL        (0x00000004)
+/* packet only holds a reference of the user MppBuffer on zero copy input */
+#define MPP_PACKET_FLAG_BUF_REF         (0x00000008)
 
 #define MPP_PKT_SEG_CNT_DEFAULT         8
 
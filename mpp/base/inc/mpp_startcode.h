@@ -0,0 +1,31 @@
+/* SPDX-License-Identifier: Apache-2.0 OR MIT */
+/*
+ * Copyright (c) 2024 Rockchip Electronics Co., Ltd.
+ */
+
+#ifndef __MPP_STARTCODE_H__
+#define __MPP_STARTCODE_H__
+
+#include "rk_type.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Find the first Annex-B start code prefix (00 00 01) in buf[0, size).
+ *
+ * Return the offset of the first 0x00 of the prefix. When no complete prefix
+ * is found size is returned, prefix which is cut by the buffer end is not
+ * reported and caller should keep the tail bytes for next search.
+ */
+RK_S32 mpp_find_startcode(const RK_U8 *buf, RK_S32 size);
+
+/* plain C reference implementation, kept for verification and benchmark */
+RK_S32 mpp_find_startcode_c(const RK_U8 *buf, RK_S32 size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __MPP_STARTCODE_H__ */
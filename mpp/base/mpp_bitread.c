@@ -107,6 +107,70 @@ static MPP_RET update_curbyte_avs2(BitReadCtx_t *bitctx)
     return MPP_OK;
 }
 
+/* 0x80 on each zero byte */
+#define BYTE_ZERO_MASK(x, m)    (~((((x) & (m)) + (m)) | (x) | (m)))
+
+/*
+ * Fast path window: peek next 4 stream bytes as one big-endian word.
+ * The window is only usable when no emulation prevention byte is in it.
+ * Then the window bytes can be loaded directly and give the same state as
+ * the byte by byte update_curbyte path.
+ */
+static RK_S32 bitread_get_window(BitReadCtx_t *bitctx, RK_U32 *word)
+{
+    RK_U32 val;
+
+    if (bitctx->bytes_left_ < 4)
+        return 0;
+
+    val = MPP_RB32(bitctx->data_);
+
+    if (bitctx->prevention_type != PSEUDO_CODE_NONE) {
+        /* previous two bytes and window bytes */
+        RK_U64 seq = ((RK_U64)(bitctx->prev_two_bytes_ & 0xffff) << 32) | val;
+        RK_U64 zero = BYTE_ZERO_MASK(seq, 0x7f7f7f7f7f7f7f7fULL);
+        RK_U32 code = (bitctx->prevention_type == PSEUDO_CODE_AVS2) ? 0x02020202 : 0x03030303;
+        RK_U32 match = BYTE_ZERO_MASK(val ^ code, 0x7f7f7f7f);
+
+        /* 00 00 03 (00 00 02 for avs2) ends in window */
+        if ((RK_U32)((zero >> 8) & (zero >> 16)) & match)
+            return 0;
+    }
+
+    *word = val;
+    return 1;
+}
+
+/* consume num_bits (up to remaining bits + 32) with window from bitread_get_window */
+static void bitread_skip_window(BitReadCtx_t *bitctx, RK_U32 word, RK_S32 num_bits)
+{
+    RK_S32 need = num_bits - bitctx->num_remaining_bits_in_curr_byte_;
+
+    if (need > 0) {
+        RK_S32 bytes = (need + 7) >> 3;
+        RK_U32 loaded = word >> (32 - bytes * 8);
+
+        bitctx->data_ += bytes;
+        bitctx->bytes_left_ -= bytes;
+        bitctx->curr_byte_ = loaded & 0xff;
+        bitctx->prev_two_bytes_ = (RK_S64)(((RK_U64)bitctx->prev_two_bytes_ << (bytes * 8)) | loaded);
+        bitctx->num_remaining_bits_in_curr_byte_ = bytes * 8 - need;
+    } else {
+        bitctx->num_remaining_bits_in_curr_byte_ -= num_bits;
+    }
+
+    bitctx->used_bits += num_bits;
+}
+
+/* current byte remaining bits and window bits in low bits of a 64bit cache */
+static RK_U64 bitread_get_cache(BitReadCtx_t *bitctx, RK_U32 word)
+{
+    RK_S32 left = bitctx->num_remaining_bits_in_curr_byte_;
+    RK_U64 curr = (RK_U64)bitctx->curr_byte_ & ((1 << left) - 1);
+
+    return (curr << 32) | word;
+}
+
 /*!
 ***********************************************************************
 * \brief
@@ -118,10 +182,23 @@ static MPP_RET update_curbyte_avs2(BitReadCtx_t *bitctx)
 MPP_RET mpp_read_bits(BitReadCtx_t *bitctx, RK_S32 num_bits, RK_S32 *out)
 {
     RK_S32 bits_left = num_bits;
+    RK_U32 word;
+
     *out = 0;
     if (num_bits > 31) {
         return  MPP_ERR_READ_BIT;
     }
+
+    if (num_bits > bitctx->num_remaining_bits_in_curr_byte_ &&
+        bitread_get_window(bitctx, &word)) {
+        RK_U64 cache = bitread_get_cache(bitctx, word);
+        RK_S32 shift = bitctx->num_remaining_bits_in_curr_byte_ + 32 - num_bits;
+
+        *out = (RK_S32)((cache >> shift) & ((1 << num_bits) - 1));
+        bitread_skip_window(bitctx, word, num_bits);
+        return MPP_OK;
+    }
+
     while (bitctx->num_remaining_bits_in_curr_byte_ < bits_left) {
         // Take all that's left in current byte, shift to make space for the rest.
         *out |= (bitctx->curr_byte_ << (bits_left - bitctx->num_remaining_bits_in_curr_byte_));
@@ -170,6 +247,14 @@ MPP_RET mpp_read_longbits(BitReadCtx_t *bitctx, RK_S32 num_bits, RK_U32 *out)
 MPP_RET mpp_skip_bits(BitReadCtx_t *bitctx, RK_S32 num_bits)
 {
     RK_S32 bits_left = num_bits;
+    RK_U32 word;
+
+    if (num_bits > bitctx->num_remaining_bits_in_curr_byte_ &&
+        num_bits <= bitctx->num_remaining_bits_in_curr_byte_ + 32 &&
+        bitread_get_window(bitctx, &word)) {
+        bitread_skip_window(bitctx, word, num_bits);
+        return MPP_OK;
+    }
 
     while (bitctx->num_remaining_bits_in_curr_byte_ < bits_left) {
         // Take all that's left in current byte, shift to make space for the rest.
@@ -246,6 +331,24 @@ MPP_RET mpp_read_ue(BitReadCtx_t *bitctx, RK_U32 *val)
     RK_S32 num_bits = -1;
     RK_S32 bit;
     RK_S32 rest;
+    RK_U32 word;
+
+    // Count leading zeros in 64bit cache when the whole code is in it
+    if (bitread_get_window(bitctx, &word)) {
+        RK_S32 avail = bitctx->num_remaining_bits_in_curr_byte_ + 32;
+        RK_U64 cache = bitread_get_cache(bitctx, word) << (64 - avail);
+
+        if (cache) {
+            RK_S32 len = __builtin_clzll(cache) * 2 + 1;
+
+            if (len <= avail) {
+                *val = (RK_U32)((cache >> (64 - len)) - 1);
+                bitread_skip_window(bitctx, word, len);
+                return MPP_OK;
+            }
+        }
+    }
+
     // Count the number of contiguous zero bits.
     do {
         if (mpp_read_bits(bitctx, 1, &bit)) {
@@ -56,6 +56,7 @@ typedef struct MppBufSlotEntry_t MppBufSlotEntry;
 typedef struct MppBufSlotsImpl_t MppBufSlotsImpl;
 
 #define SLOT_OPS_MAX_COUNT              1024
+#define SLOT_MAP_BITS                   32
 
 typedef enum MppBufSlotOps_e {
     // status opertaion
@@ -243,6 +244,10 @@ struct MppBufSlotsImpl_t {
     // list for log
     MppBufSlotLogs      *logs;
 
+    // bitmap of on_used status for fast unused slot lookup
+    RK_U32              *used_map;
+    RK_S32              map_size;
+
     MppBufSlotEntry     *slots;
 };
 
@@ -483,6 +488,76 @@ static void _dump_slots(const char *caller, MppBufSlotsImpl *impl)
     return;
 }
 
+static MPP_RET slot_map_resize(MppBufSlotsImpl *impl, RK_S32 count)
+{
+    RK_S32 size = (count + SLOT_MAP_BITS - 1) / SLOT_MAP_BITS;
+    RK_U32 *map;
+
+    if (size <= impl->map_size)
+        return MPP_OK;
+
+    map = mpp_realloc(impl->used_map, RK_U32, size);
+    if (NULL == map) {
+        mpp_err_f("failed to resize used map to %d\n", count);
+        return MPP_ERR_MALLOC;
+    }
+
+    memset(map + impl->map_size, 0, (size - impl->map_size) * sizeof(RK_U32));
+    impl->used_map = map;
+    impl->map_size = size;
+    return MPP_OK;
+}
+
+static void slot_map_update(MppBufSlotsImpl *impl, RK_S32 index, RK_U32 on_used)
+{
+    RK_U32 bit = 1U << (index % SLOT_MAP_BITS);
+    RK_U32 *word;
+
+    if (index / SLOT_MAP_BITS >= impl->map_size)
+        return;
+
+    word = &impl->used_map[index / SLOT_MAP_BITS];
+    if (on_used)
+        *word |= bit;
+    else
+        *word &= ~bit;
+}
+
+/* rebuild the whole map from slot status after slots are reinitialized */
+static void slot_map_rebuild(MppBufSlotsImpl *impl, RK_S32 count)
+{
+    RK_S32 i;
+
+    if (slot_map_resize(impl, count))
+        return;
+
+    memset(impl->used_map, 0, impl->map_size * sizeof(RK_U32));
+    for (i = 0; i < count; i++) {
+        if (impl->slots[i].status.on_used)
+            impl->used_map[i / SLOT_MAP_BITS] |= 1U << (i % SLOT_MAP_BITS);
+    }
+}
+
+/* find the lowest unused slot index which is the same order as linear scan */
+static RK_S32 slot_map_find_unused(MppBufSlotsImpl *impl)
+{
+    RK_S32 size = MPP_MIN(impl->map_size,
+                          (impl->buf_count + SLOT_MAP_BITS - 1) / SLOT_MAP_BITS);
+    RK_S32 i;
+
+    for (i = 0; i < size; i++) {
+        RK_U32 unused = ~impl->used_map[i];
+
+        if (unused) {
+            RK_S32 index = i * SLOT_MAP_BITS + __builtin_ctz(unused);
+
+            return (index < impl->buf_count) ? index : -1;
+        }
+    }
+
+    return -1;
+}
+
 static void slot_ops_with_log(MppBufSlotsImpl *impl, MppBufSlotEntry *slot, MppBufSlotOps op, void *arg)
 {
     RK_U32 error = 0;
@@ -586,6 +661,8 @@ static void slot_ops_with_log(MppBufSlotsImpl *impl, MppBufSlotEntry *slot, MppB
     } break;
     }
     slot->status = status;
+    if (before.on_used != status.on_used)
+        slot_map_update(impl, index, status.on_used);
     buf_slot_dbg(BUF_SLOT_DBG_OPS_RUNTIME, "slot %3d index %2d op: %s arg %010p status in %08x out %08x",
                  impl->slots_idx, index, op_string[op], arg, before.val, status.val);
     if (impl->logs)
@@ -676,6 +753,7 @@ static void clear_slots_impl(MppBufSlotsImpl *impl)
     if (impl->lock)
         delete impl->lock;
 
+    MPP_FREE(impl->used_map);
     mpp_free(impl->slots);
     mpp_free(impl);
 }
@@ -762,6 +840,7 @@ MPP_RET mpp_buf_slot_setup(MppBufSlots slots, RK_S32 count)
         impl->buf_count = impl->new_count = count;
         impl->slots = mpp_calloc(MppBufSlotEntry, count);
         init_slot_entry(impl, 0, count);
+        slot_map_rebuild(impl, count);
         impl->used_count = 0;
     } else {
         // record the slot count for info changed ready config
@@ -769,6 +848,7 @@ MPP_RET mpp_buf_slot_setup(MppBufSlots slots, RK_S32 count)
             impl->slots = mpp_realloc(impl->slots, MppBufSlotEntry, count);
             mpp_assert(impl->slots);
             init_slot_entry(impl, impl->buf_count, (count - impl->buf_count));
+            slot_map_rebuild(impl, count);
         }
         impl->new_count = count;
     }
@@ -808,6 +888,7 @@ MPP_RET mpp_buf_slot_ready(MppBufSlots slots)
         impl->slots = mpp_realloc(impl->slots, MppBufSlotEntry, impl->new_count);
         mpp_assert(impl->slots);
         init_slot_entry(impl, 0, impl->new_count);
+        slot_map_rebuild(impl, impl->new_count);
     }
     impl->buf_count = impl->new_count;
 
@@ -868,16 +949,16 @@ MPP_RET mpp_buf_slot_get_unused(MppBufSlots slots, RK_S32 *index)
 
     MppBufSlotsImpl *impl = (MppBufSlotsImpl *)slots;
     AutoMutex auto_lock(impl->lock);
-    RK_S32 i;
-    MppBufSlotEntry *slot = impl->slots;
-    for (i = 0; i < impl->buf_count; i++, slot++) {
-        if (!slot->status.on_used) {
-            *index = i;
-            slot_ops_with_log(impl, slot, SLOT_SET_ON_USE, NULL);
-            slot_ops_with_log(impl, slot, SLOT_SET_NOT_READY, NULL);
-            impl->used_count++;
-            return MPP_OK;
-        }
+    RK_S32 i = slot_map_find_unused(impl);
+
+    if (i >= 0) {
+        MppBufSlotEntry *slot = &impl->slots[i];
+
+        *index = i;
+        slot_ops_with_log(impl, slot, SLOT_SET_ON_USE, NULL);
+        slot_ops_with_log(impl, slot, SLOT_SET_NOT_READY, NULL);
+        impl->used_count++;
+        return MPP_OK;
     }
 
     *index = -1;
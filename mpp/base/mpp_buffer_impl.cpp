@@ -21,6 +21,7 @@
 #include "mpp_env.h"
 #include "mpp_hash.h"
 #include "mpp_lock.h"
+#include "mpp_time.h"
 #include "mpp_debug.h"
 #include "mpp_mem_pool.h"
 
@@ -232,6 +233,31 @@ static void buf_grp_add_log(MppBufferGroupImpl *group, MppBufOps ops, const char
         buf_logs_write(group->logs, group->group_id, -1, ops, 0, caller);
 }
 
+static RK_S32 buf_size_bin(size_t size)
+{
+    RK_S32 bin = size ? (63 - __builtin_clzll((RK_U64)size)) : 0;
+
+    return MPP_MIN(bin, MPP_BUF_BIN_CNT - 1);
+}
+
+/* unused buffer is on list_unused in lru order and on size class bin */
+static void buf_unused_add(MppBufferGroupImpl *group, MppBufferImpl *buffer)
+{
+    list_add_tail(&buffer->list_status, &group->list_unused);
+    list_add_tail(&buffer->list_bin, &group->list_bins[buf_size_bin(buffer->info.size)]);
+    buffer->unused_time = mpp_time();
+    group->count_unused++;
+    group->unused_size += buffer->info.size;
+}
+
+static void buf_unused_del(MppBufferGroupImpl *group, MppBufferImpl *buffer)
+{
+    list_del_init(&buffer->list_status);
+    list_del_init(&buffer->list_bin);
+    group->count_unused--;
+    group->unused_size -= buffer->info.size;
+}
+
 static MPP_RET put_buffer(MppBufferGroupImpl *group, MppBufferImpl *buffer,
                           RK_U32 reuse, const char *caller)
 {
@@ -242,13 +268,15 @@ static MPP_RET put_buffer(MppBufferGroupImpl *group, MppBufferImpl *buffer,
     if (!MppBufferService::get_instance()->is_finalizing())
         mpp_assert(buffer->ref_count == 0);
 
-    list_del_init(&buffer->list_status);
+    if (!buffer->used && group)
+        buf_unused_del(group, buffer);
+    else
+        list_del_init(&buffer->list_status);
 
     if (reuse) {
         if (buffer->used && group) {
             group->count_used--;
-            list_add_tail(&buffer->list_status, &group->list_unused);
-            group->count_unused++;
+            buf_unused_add(group, buffer);
         } else {
             mpp_err_f("can not reuse unused buffer %d at group %p:%d\n",
                       buffer->buffer_id, group, buffer->group_id);
@@ -271,11 +299,11 @@ static MPP_RET put_buffer(MppBufferGroupImpl *group, MppBufferImpl *buffer,
 
         if (buffer->used)
             group->count_used--;
-        else
-            group->count_unused--;
 
         group->usage -= buffer->info.size;
         group->buffer_count--;
+        group->free_count++;
+        group->free_bytes += buffer->info.size;
 
         if (group->mode == MPP_BUFFER_INTERNAL)
             MppBufferService::get_instance()->dec_total(buffer->info.size);
@@ -316,10 +344,9 @@ static MPP_RET inc_buffer_ref(MppBufferImpl *buffer, const char *caller)
         buffer->used = 1;
         if (group) {
             pthread_mutex_lock(&group->buf_lock);
-            list_del_init(&buffer->list_status);
+            buf_unused_del(group, buffer);
             list_add_tail(&buffer->list_status, &group->list_used);
             group->count_used++;
-            group->count_unused--;
             pthread_mutex_unlock(&group->buf_lock);
         } else {
             mpp_err_f("unused buffer without group\n");
@@ -330,6 +357,35 @@ static MPP_RET inc_buffer_ref(MppBufferImpl *buffer, const char *caller)
     return ret;
 }
 
+/*
+ * Lazy trim of unused buffer in internal mode. Called with buf_lock on group
+ * buffer get and put. Unused buffers are released from the oldest one when
+ * the unused size is over the retain size or the buffer is idle too long.
+ */
+static void buf_group_trim(MppBufferGroupImpl *group, const char *caller)
+{
+    RK_S64 now;
+
+    /* orphan group will be destroyed on its last buffer release */
+    if (group->mode != MPP_BUFFER_INTERNAL || group->is_orphan ||
+        list_empty(&group->list_unused))
+        return;
+
+    now = mpp_time();
+
+    while (!list_empty(&group->list_unused)) {
+        MppBufferImpl *pos = list_first_entry(&group->list_unused, MppBufferImpl, list_status);
+        RK_U32 over_size = group->retain_size && group->unused_size > group->retain_size;
+        RK_U32 idle = group->idle_time && now - pos->unused_time >= group->idle_time;
+
+        if (!over_size && !idle)
+            break;
+
+        group->trim_count++;
+        put_buffer(group, pos, 0, caller);
+    }
+}
+
 static void dump_buffer_info(MppBufferImpl *buffer)
 {
     mpp_log("buffer %p fd %4d size %10d ref_count %3d discard %d caller %s\n",
@@ -407,6 +463,7 @@ MPP_RET mpp_buffer_create(const char *tag, const char *caller,
     pthread_mutex_lock(&group->buf_lock);
     p->buffer_id = group->buffer_id++;
     INIT_LIST_HEAD(&p->list_status);
+    INIT_LIST_HEAD(&p->list_bin);
 
     if (buffer) {
         p->ref_count++;
@@ -415,12 +472,13 @@ MPP_RET mpp_buffer_create(const char *tag, const char *caller,
         group->count_used++;
         *buffer = p;
     } else {
-        list_add_tail(&p->list_status, &group->list_unused);
-        group->count_unused++;
+        buf_unused_add(group, p);
     }
 
     group->usage += info->size;
     group->buffer_count++;
+    group->alloc_count++;
+    group->alloc_bytes += info->size;
     pthread_mutex_unlock(&group->buf_lock);
 
     buf_add_log(p, (group->mode == MPP_BUFFER_INTERNAL) ? (BUF_CREATE) : (BUF_COMMIT), caller);
@@ -503,6 +561,8 @@ MPP_RET mpp_buffer_ref_dec(MppBufferImpl *buffer, const char* caller)
 
             reuse = (!group->is_misc && !buffer->discard);
             put_buffer(group, buffer, reuse, caller);
+            if (reuse)
+                buf_group_trim(group, caller);
 
             if (group->callback)
                 group->callback(group->arg, group);
@@ -530,15 +590,46 @@ void mpp_buffer_group_dump(MppBufferGroupImpl *group, const char *caller)
         dump_buffer_info(pos);
     }
 
-    mpp_log("unused buffer count %d\n", group->count_unused);
+    mpp_log("unused buffer count %d size %lld\n", group->count_unused,
+            (RK_S64)group->unused_size);
     list_for_each_entry_safe(pos, n, &group->list_unused, MppBufferImpl, list_status) {
         dump_buffer_info(pos);
     }
 
+    mpp_log("alloc count %d bytes %lld free count %d bytes %lld\n",
+            group->alloc_count, (RK_S64)group->alloc_bytes,
+            group->free_count, (RK_S64)group->free_bytes);
+    mpp_log("reuse count %d trim count %d retain size %lld idle %lld ms\n",
+            group->reuse_count, group->trim_count, (RK_S64)group->retain_size,
+            (RK_S64)(group->idle_time / 1000));
+
     if (group->logs)
         buf_logs_dump(group->logs);
 }
 
+/* best-fit search on size class bins */
+static MppBufferImpl *buf_group_best_fit(MppBufferGroupImpl *p, size_t size)
+{
+    RK_S32 bin;
+
+    for (bin = buf_size_bin(size); bin < MPP_BUF_BIN_CNT; bin++) {
+        MppBufferImpl *pos;
+        MppBufferImpl *best = NULL;
+
+        list_for_each_entry(pos, &p->list_bins[bin], MppBufferImpl, list_bin) {
+            mpp_buf_dbg(MPP_BUF_DBG_CHECK_SIZE, "request size %d on buf idx %d size %d\n",
+                        size, pos->buffer_id, pos->info.size);
+            if (pos->info.size >= size && (!best || pos->info.size < best->info.size))
+                best = pos;
+        }
+
+        if (best)
+            return best;
+    }
+
+    return NULL;
+}
+
 MppBufferImpl *mpp_buffer_get_unused(MppBufferGroupImpl *p, size_t size, const char* caller)
 {
     MPP_BUF_FUNCTION_ENTER();
@@ -547,39 +638,35 @@ MppBufferImpl *mpp_buffer_get_unused(MppBufferGroupImpl *p, size_t size, const c
 
     pthread_mutex_lock(&p->buf_lock);
     if (!list_empty(&p->list_unused)) {
-        MppBufferImpl *pos, *n;
-        RK_S32 found = 0;
-        RK_S32 search_count = 0;
+        buffer = buf_group_best_fit(p, size);
+        if (buffer) {
+            pthread_mutex_lock(&buffer->lock);
+            buf_add_log(buffer, BUF_REF_INC, caller);
+            buffer->ref_count++;
+            buffer->used = 1;
+            buf_unused_del(p, buffer);
+            list_add_tail(&buffer->list_status, &p->list_used);
+            p->count_used++;
+            p->reuse_count++;
+            pthread_mutex_unlock(&buffer->lock);
+        } else if (MPP_BUFFER_INTERNAL == p->mode) {
+            MppBufferImpl *pos, *n;
 
-        list_for_each_entry_safe(pos, n, &p->list_unused, MppBufferImpl, list_status) {
-            mpp_buf_dbg(MPP_BUF_DBG_CHECK_SIZE, "request size %d on buf idx %d size %d\n",
-                        size, pos->buffer_id, pos->info.size);
-            if (pos->info.size >= size) {
-                buffer = pos;
-                pthread_mutex_lock(&buffer->lock);
-                buf_add_log(buffer, BUF_REF_INC, caller);
-                buffer->ref_count++;
-                buffer->used = 1;
-                list_del_init(&buffer->list_status);
-                list_add_tail(&buffer->list_status, &p->list_used);
-                p->count_used++;
-                p->count_unused--;
-                pthread_mutex_unlock(&buffer->lock);
-                found = 1;
-                break;
-            } else {
-                if (MPP_BUFFER_INTERNAL == p->mode) {
+            /* undersized unused buffers can not be reused so release them */
+            list_for_each_entry_safe(pos, n, &p->list_unused, MppBufferImpl, list_status) {
+                if (pos->info.size < size) {
+                    p->trim_count++;
                     put_buffer(p, pos, 0, caller);
-                } else
-                    search_count++;
+                }
             }
-        }
-
-        if (!found && search_count) {
+        } else {
             mpp_err_f("can not found match buffer with size larger than %d\n", size);
             mpp_buffer_group_dump(p, caller);
         }
     }
+
+    /* new buffer will be allocated on miss so release the idle buffers first */
+    buf_group_trim(p, caller);
     pthread_mutex_unlock(&p->buf_lock);
 
     MPP_BUF_FUNCTION_LEAVE();
@@ -618,6 +705,17 @@ MPP_RET mpp_buffer_group_init(MppBufferGroupImpl **group, const char *tag, const
 
     *group = MppBufferService::get_instance()->get_group(tag, caller, mode, type, 0);
 
+    /* unused buffer retention of internal group can be tuned by environment */
+    if (*group && MPP_BUFFER_INTERNAL == mode) {
+        RK_U32 retain_size = 0;
+        RK_U32 idle_ms = 0;
+
+        mpp_env_get_u32("mpp_buffer_retain_size", &retain_size, 0);
+        mpp_env_get_u32("mpp_buffer_idle_ms", &idle_ms, 0);
+        if (retain_size || idle_ms)
+            mpp_buffer_group_retain_config(*group, retain_size, idle_ms);
+    }
+
     MPP_BUF_FUNCTION_LEAVE();
     return ((*group) ? (MPP_OK) : (MPP_NOK));
 }
@@ -673,6 +771,22 @@ MPP_RET mpp_buffer_group_reset(MppBufferGroupImpl *p)
     return MPP_OK;
 }
 
+MPP_RET mpp_buffer_group_retain_config(MppBufferGroupImpl *p, size_t retain_size, RK_S32 idle_ms)
+{
+    if (NULL == p) {
+        mpp_err_f("found NULL pointer\n");
+        return MPP_ERR_NULL_PTR;
+    }
+
+    pthread_mutex_lock(&p->buf_lock);
+    p->retain_size = retain_size;
+    p->idle_time = (RK_S64)MPP_MAX(idle_ms, 0) * 1000;
+    buf_group_trim(p, __FUNCTION__);
+    pthread_mutex_unlock(&p->buf_lock);
+
+    return MPP_OK;
+}
+
 MPP_RET mpp_buffer_group_set_callback(MppBufferGroupImpl *p,
                                       MppBufCallback callback, void *arg)
 {
@@ -781,8 +895,6 @@ MppBufferService::MppBufferService()
         INIT_HLIST_HEAD(&mHashGroup[i]);
 }
 
-#include "mpp_time.h"
-
 MppBufferService::~MppBufferService()
 {
     RK_S32 i, j;
@@ -930,6 +1042,9 @@ MppBufferGroupImpl *MppBufferService::get_group(const char *tag, const char *cal
     INIT_LIST_HEAD(&p->list_unused);
     INIT_HLIST_NODE(&p->hlist);
 
+    for (RK_S32 i = 0; i < MPP_BUF_BIN_CNT; i++)
+        INIT_LIST_HEAD(&p->list_bins[i]);
+
     p->log_runtime_en   = (mpp_buffer_debug & MPP_BUF_DBG_OPS_RUNTIME) ? (1) : (0);
     p->log_history_en   = (mpp_buffer_debug & MPP_BUF_DBG_OPS_HISTORY) ? (1) : (0);
 
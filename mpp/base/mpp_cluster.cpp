@@ -16,6 +16,7 @@
 
 #define  MODULE_TAG "mpp_cluster"
 
+#include <sched.h>
 #include <string.h>
 
 #include "mpp_mem.h"
@@ -39,12 +40,23 @@
 
 RK_U32 mpp_cluster_debug = 0;
 RK_U32 mpp_cluster_thd_cnt = 1;
+RK_U32 mpp_cluster_cpu_mask = 0;
+
+/*
+ * Each worker has a lock-free bounded ring of waiting tasks. Trigger pushes
+ * the task to the ring of the worker which runs the node last time. Worker
+ * pops its own ring first and steals from other workers when it is empty.
+ * The mutex protected cluster queue is only used when the ring is full.
+ */
+#define CLUSTER_RING_SIZE       64
+#define CLUSTER_SPIN_COUNT      16
 
 typedef struct MppNodeProc_s    MppNodeProc;
 typedef struct MppNodeTask_s    MppNodeTask;
 typedef struct MppNodeImpl_s    MppNodeImpl;
 
 typedef struct ClusterQueue_s   ClusterQueue;
+typedef struct ClusterRing_s    ClusterRing;
 typedef struct ClusterWorker_s  ClusterWorker;
 typedef struct MppCluster_s     MppCluster;
 
@@ -83,6 +95,9 @@ struct MppNodeTask_s {
     ClusterQueue            *queue;
 
     MppNodeProc             *proc;
+
+    /* worker index hint for locality */
+    RK_S32                  worker_hint;
 };
 
 /* MppNode will be embeded in MppCtx */
@@ -110,17 +125,34 @@ struct ClusterQueue_s {
     RK_S32                  count;
 };
 
+typedef struct ClusterRingSlot_s {
+    volatile RK_U32         seq;
+    MppNodeTask             *task;
+} ClusterRingSlot;
+
+/* bounded multi-producer multi-consumer ring */
+struct ClusterRing_s {
+    volatile RK_U32         head;
+    RK_U32                  reserved0[15];
+    volatile RK_U32         tail;
+    RK_U32                  reserved1[15];
+    ClusterRingSlot         slots[CLUSTER_RING_SIZE];
+};
+
 struct ClusterWorker_s {
     char                    name[32];
     MppCluster              *cluster;
     RK_S32                  worker_id;
 
     MppThread               *thd;
-    MppWorkerState          state;
+    volatile MppWorkerState state;
+
+    ClusterRing             ring;
+    RK_S32                  cpu;
 
-    RK_S32                  batch_count;
-    RK_S32                  work_count;
-    struct list_head        list_task;
+    /* statistic */
+    RK_S64                  run_count;
+    RK_S64                  steal_count;
 };
 
 struct MppCluster_s {
@@ -176,7 +208,84 @@ static MPP_RET cluster_queue_unlock_f(const char *caller, ClusterQueue *queue)
     return (ret) ? MPP_NOK : MPP_OK;
 }
 
-void cluster_signal_f(const char *caller, MppCluster *p);
+void cluster_signal_f(const char *caller, MppCluster *p, ClusterWorker *worker);
+
+static void cluster_ring_init(ClusterRing *ring)
+{
+    RK_U32 i;
+
+    ring->head = 0;
+    ring->tail = 0;
+
+    for (i = 0; i < CLUSTER_RING_SIZE; i++) {
+        ring->slots[i].seq = i;
+        ring->slots[i].task = NULL;
+    }
+}
+
+static MPP_RET cluster_ring_push(ClusterRing *ring, MppNodeTask *task)
+{
+    ClusterRingSlot *slot;
+    RK_U32 pos = ring->tail;
+
+    do {
+        RK_S32 diff;
+
+        slot = &ring->slots[pos & (CLUSTER_RING_SIZE - 1)];
+        diff = (RK_S32)(slot->seq - pos);
+
+        if (diff == 0) {
+            if (MPP_BOOL_CAS(&ring->tail, pos, pos + 1))
+                break;
+        } else if (diff < 0) {
+            /* ring full */
+            return MPP_NOK;
+        }
+
+        pos = ring->tail;
+    } while (1);
+
+    slot->task = task;
+    MPP_SYNC();
+    slot->seq = pos + 1;
+
+    return MPP_OK;
+}
+
+static MppNodeTask *cluster_ring_pop(ClusterRing *ring)
+{
+    ClusterRingSlot *slot;
+    MppNodeTask *task;
+    RK_U32 pos = ring->head;
+
+    do {
+        RK_S32 diff;
+
+        slot = &ring->slots[pos & (CLUSTER_RING_SIZE - 1)];
+        diff = (RK_S32)(slot->seq - (pos + 1));
+
+        if (diff == 0) {
+            if (MPP_BOOL_CAS(&ring->head, pos, pos + 1))
+                break;
+        } else if (diff < 0) {
+            /* ring empty */
+            return NULL;
+        }
+
+        pos = ring->head;
+    } while (1);
+
+    task = slot->task;
+    MPP_SYNC();
+    slot->seq = pos + CLUSTER_RING_SIZE;
+
+    return task;
+}
+
+static RK_S32 cluster_ring_empty(ClusterRing *ring)
+{
+    return ring->head == ring->tail;
+}
 
 MPP_RET mpp_cluster_queue_init(ClusterQueue *queue, MppCluster *cluster)
 {
@@ -204,9 +313,52 @@ MPP_RET mpp_cluster_queue_deinit(ClusterQueue *queue)
     return MPP_OK;
 }
 
+static void cluster_queue_push(ClusterQueue *queue, MppNodeTask *task)
+{
+    cluster_queue_lock(queue);
+    mpp_assert(list_empty(&task->list_sched));
+    list_add_tail(&task->list_sched, &queue->list);
+    MPP_FETCH_ADD(&queue->count, 1);
+    cluster_queue_unlock(queue);
+}
+
+static MppNodeTask *cluster_queue_pop(ClusterQueue *queue)
+{
+    MppNodeTask *task = NULL;
+
+    /* avoid locking on empty queue */
+    if (!queue->count)
+        return NULL;
+
+    cluster_queue_lock(queue);
+    if (!list_empty(&queue->list)) {
+        task = list_first_entry(&queue->list, MppNodeTask, list_sched);
+        list_del_init(&task->list_sched);
+        MPP_FETCH_SUB(&queue->count, 1);
+    }
+    cluster_queue_unlock(queue);
+
+    return task;
+}
+
+/* push waiting task to the hinted worker and return the worker */
+static ClusterWorker *cluster_push_task(MppCluster *cluster, MppNodeTask *task)
+{
+    ClusterWorker *worker = &cluster->worker[task->worker_hint];
+
+    if (cluster_ring_push(&worker->ring, task)) {
+        cluster_dbg_flow("%s ring full push %s to queue\n", worker->name, task->node_name);
+        cluster_queue_push(task->queue, task);
+    }
+
+    return worker;
+}
+
 MPP_RET mpp_node_task_attach(MppNodeTask *task, MppNodeImpl *node,
                              ClusterQueue *queue, MppNodeProc *proc)
 {
+    MppCluster *cluster = queue->cluster;
+
     INIT_LIST_HEAD(&task->list_sched);
 
     task->node = node;
@@ -214,6 +366,7 @@ MPP_RET mpp_node_task_attach(MppNodeTask *task, MppNodeImpl *node,
 
     task->queue = queue;
     task->proc = proc;
+    task->worker_hint = node->node_id % cluster->worker_count;
 
     node->state = NODE_VALID | NODE_IDLE;
     node->attached = 1;
@@ -265,19 +418,15 @@ MPP_RET mpp_node_task_schedule_f(const char *caller, MppNodeTask *task)
 
     switch (action) {
     case NODE_ACT_IDLE_TO_WAIT : {
-        cluster_queue_lock(queue);
-        mpp_assert(list_empty(&task->list_sched));
-        list_add_tail(&task->list_sched, &queue->list);
-        queue->count++;
-        cluster_dbg_flow("%s sched task -> wq %s:%d\n", node_name, cluster->name, queue->count);
-        cluster_queue_unlock(queue);
+        ClusterWorker *worker = cluster_push_task(cluster, task);
 
+        cluster_dbg_flow("%s sched task -> %s\n", node_name, worker->name);
         cluster_dbg_flow("%s sched signal from %s\n", node_name, caller);
-        cluster_signal_f(caller, cluster);
+        cluster_signal_f(caller, cluster, worker);
     } break;
     case NODE_ACT_RUN_TO_SIGNAL : {
-        cluster_dbg_flow("%s sched signal from %s\n", node_name, caller);
-        cluster_signal_f(caller, cluster);
+        /* running worker will requeue the task after current run */
+        cluster_dbg_flow("%s sched signal to running worker from %s\n", node_name, caller);
     } break;
     }
 
@@ -354,23 +503,46 @@ MPP_RET mpp_node_set_func(MppNode node, TaskProc proc, void *param)
     return MPP_OK;
 }
 
+/* bind worker to the n-th cpu in cpu mask */
+static RK_S32 cluster_worker_get_cpu(RK_S32 worker_id)
+{
+    RK_U32 mask = mpp_cluster_cpu_mask;
+    RK_S32 cnt = 0;
+    RK_S32 n;
+    RK_S32 i;
+
+    for (i = 0; i < 32; i++)
+        cnt += (mask >> i) & 1;
+
+    if (!cnt)
+        return -1;
+
+    n = worker_id % cnt;
+    for (i = 0; i < 32; i++) {
+        if (((mask >> i) & 1) && !n--)
+            return i;
+    }
+
+    return -1;
+}
+
 MPP_RET cluster_worker_init(ClusterWorker *p, MppCluster *cluster)
 {
     MppThread *thd = NULL;
     MPP_RET ret = MPP_NOK;
 
-    INIT_LIST_HEAD(&p->list_task);
+    cluster_ring_init(&p->ring);
     p->worker_id = cluster->worker_id++;
 
-    p->batch_count = 1;
-    p->work_count = 0;
     p->cluster = cluster;
-    p->state = WORKER_IDLE;
+    p->state = WORKER_RUNNING;
+    p->cpu = cluster_worker_get_cpu(p->worker_id);
+    p->run_count = 0;
+    p->steal_count = 0;
     snprintf(p->name, sizeof(p->name) - 1, "%d:W%d", cluster->pid, p->worker_id);
     thd = new MppThread(cluster->worker_func, p, p->name);
     if (thd) {
         p->thd = thd;
-        thd->start();
         ret = MPP_OK;
     }
 
@@ -385,166 +557,172 @@ MPP_RET cluster_worker_deinit(ClusterWorker *p)
         p->thd = NULL;
     }
 
-    mpp_assert(list_empty(&p->list_task));
-    mpp_assert(p->work_count == 0);
+    mpp_assert(cluster_ring_empty(&p->ring));
+
+    cluster_dbg_flow("%s run %lld steal %lld\n", p->name, p->run_count, p->steal_count);
 
-    p->batch_count = 0;
     p->cluster = NULL;
 
     return MPP_OK;
 }
 
-RK_S32 cluster_worker_get_task(ClusterWorker *p)
+static RK_S32 cluster_has_task(MppCluster *cluster)
 {
-    MppCluster *cluster = p->cluster;
-    RK_S32 batch_count = p->batch_count;
-    RK_S32 count = 0;
-    RK_U32 new_st;
-    RK_U32 old_st;
-    bool ret;
     RK_S32 i;
 
-    cluster_dbg_flow("%s get %d task start\n", p->name, batch_count);
-
     for (i = 0; i < MAX_PRIORITY; i++) {
-        ClusterQueue *queue = &cluster->queue[i];
-        MppNodeTask *task = NULL;
-        MppNodeImpl *node = NULL;
-
-        do {
-            cluster_queue_lock(queue);
-
-            if (list_empty(&queue->list)) {
-                mpp_assert(queue->count == 0);
-                cluster_dbg_flow("%s get P%d task ret no task\n", p->name, i);
-                cluster_queue_unlock(queue);
-                break;
-            }
-
-            mpp_assert(queue->count);
-            task = list_first_entry(&queue->list, MppNodeTask, list_sched);
-            list_del_init(&task->list_sched);
-            node = task->node;
-
-            queue->count--;
+        if (cluster->queue[i].count)
+            return 1;
+    }
 
-            do {
-                old_st = node->state;
-                new_st = old_st ^ (NODE_WAIT | NODE_RUN);
+    for (i = 0; i < cluster->worker_count; i++) {
+        if (!cluster_ring_empty(&cluster->worker[i].ring))
+            return 1;
+    }
 
-                mpp_assert(old_st & NODE_WAIT);
-                ret = MPP_BOOL_CAS(&node->state, old_st, new_st);
-            } while (!ret);
+    return 0;
+}
 
-            list_add_tail(&task->list_sched, &p->list_task);
-            p->work_count++;
-            count++;
+static MppNodeTask *cluster_worker_get_task(ClusterWorker *p)
+{
+    MppCluster *cluster = p->cluster;
+    MppNodeTask *task = NULL;
+    RK_S32 i;
 
-            cluster_dbg_flow("%s get P%d %s -> rq %d\n", p->name, i, node->name, p->work_count);
+    /* own ring first */
+    task = cluster_ring_pop(&p->ring);
+    if (task)
+        return task;
 
-            cluster_queue_unlock(queue);
+    /* then the overflow queue */
+    for (i = 0; i < MAX_PRIORITY; i++) {
+        task = cluster_queue_pop(&cluster->queue[i]);
+        if (task)
+            return task;
+    }
 
-            if (count >= batch_count)
-                break;
-        } while (1);
+    /* steal from other workers */
+    for (i = 1; i < cluster->worker_count; i++) {
+        ClusterWorker *victim = &cluster->worker[(p->worker_id + i) % cluster->worker_count];
 
-        if (count >= batch_count)
-            break;
+        task = cluster_ring_pop(&victim->ring);
+        if (task) {
+            p->steal_count++;
+            cluster_dbg_flow("%s steal %s from %s\n", p->name, task->node_name, victim->name);
+            return task;
+        }
     }
 
-    cluster_dbg_flow("%s get %d task ret %d\n", p->name, batch_count, count);
-
-    return count;
+    return NULL;
 }
 
-static void cluster_worker_run_task(ClusterWorker *p)
+static void cluster_worker_run_task(ClusterWorker *p, MppNodeTask *task)
 {
+    MppNodeProc *proc = task->proc;
+    MppNodeImpl *node = task->node;
+    RK_S64 time_start;
+    RK_S64 time_end;
     RK_U32 new_st;
     RK_U32 old_st;
+    RK_U32 state;
+    MPP_RET proc_ret;
     bool cas_ret;
 
-    cluster_dbg_flow("%s run %d work start\n", p->name, p->work_count);
+    do {
+        old_st = node->state;
+        new_st = old_st ^ (NODE_WAIT | NODE_RUN);
 
-    while (!list_empty(&p->list_task)) {
-        MppNodeTask *task = list_first_entry(&p->list_task, MppNodeTask, list_sched);
-        MppNodeProc *proc = task->proc;
-        MppNodeImpl *node = task->node;
-        RK_S64 time_start;
-        RK_S64 time_end;
-        RK_U32 state;
-        MPP_RET proc_ret;
-
-        /* check trigger for re-add task */
-        cluster_dbg_flow("%s run %s start atate %d\n", p->name, task->node_name, node->state);
-        mpp_assert(node->state & NODE_RUN);
-        if (!(node->state & NODE_RUN))
-            mpp_err_f("%s run state check %x is invalid on run", p->name, node->state);
-
-        time_start = mpp_time();
-        proc_ret = proc->proc(proc->param);
-        time_end = mpp_time();
-
-        cluster_dbg_flow("%s run %s ret %d\n", p->name, task->node_name, proc_ret);
-        proc->run_time += time_end - time_start;
-        proc->run_count++;
-
-        state = node->state;
-        if (!(state & NODE_VALID)) {
-            cluster_dbg_flow("%s run found destroy\n", p->name);
-            list_del_init(&task->list_sched);
-            node->attached = 0;
-
-            sem_post(&node->sem_detach);
-            cluster_dbg_flow("%s run sem post done\n", p->name);
-        } else if (state & NODE_SIGNAL) {
-            ClusterQueue *queue = task->queue;
-
-            list_del_init(&task->list_sched);
-
-            do {
-                old_st = state;
-                // NOTE: clear NODE_RUN and NODE_SIGNAL, set NODE_WAIT
-                new_st = old_st ^ (NODE_SIGNAL | NODE_WAIT | NODE_RUN);
-                cas_ret = MPP_BOOL_CAS(&node->state, old_st, new_st);
-            } while (!cas_ret);
-
-            cluster_dbg_flow("%s run state %x -> %x signal -> wait\n", p->name, old_st, new_st);
-
-            cluster_queue_lock(queue);
-            list_add_tail(&task->list_sched, &queue->list);
-            queue->count++;
-            cluster_queue_unlock(queue);
-        } else {
-            list_del_init(&task->list_sched);
-            do {
-                old_st = node->state;
-                new_st = old_st ^ (NODE_IDLE | NODE_RUN);
+        mpp_assert(old_st & NODE_WAIT);
+        cas_ret = MPP_BOOL_CAS(&node->state, old_st, new_st);
+    } while (!cas_ret);
 
-                cas_ret = MPP_BOOL_CAS(&node->state, old_st, new_st);
-            } while (!cas_ret);
-            mpp_assert(node->state & NODE_IDLE);
-            mpp_assert(!(node->state & NODE_RUN));
+    /* keep the node on this worker for cache locality */
+    task->worker_hint = p->worker_id;
 
-            cluster_dbg_flow("%s run state %x -> %x run -> idle\n", p->name, old_st, new_st);
-        }
+    cluster_dbg_flow("%s run %s start state %x\n", p->name, task->node_name, node->state);
 
-        p->work_count--;
-    }
+    time_start = mpp_time();
+    proc_ret = proc->proc(proc->param);
+    time_end = mpp_time();
+
+    cluster_dbg_flow("%s run %s ret %d\n", p->name, task->node_name, proc_ret);
+    proc->run_time += time_end - time_start;
+    proc->run_count++;
+    p->run_count++;
 
-    mpp_assert(p->work_count == 0);
+    state = node->state;
+    if (!(state & NODE_VALID)) {
+        cluster_dbg_flow("%s run found destroy\n", p->name);
+        node->attached = 0;
 
-    cluster_dbg_flow("%s run all done\n", p->name);
+        sem_post(&node->sem_detach);
+        cluster_dbg_flow("%s run sem post done\n", p->name);
+    } else if (state & NODE_SIGNAL) {
+        do {
+            old_st = state;
+            // NOTE: clear NODE_RUN and NODE_SIGNAL, set NODE_WAIT
+            new_st = old_st ^ (NODE_SIGNAL | NODE_WAIT | NODE_RUN);
+            cas_ret = MPP_BOOL_CAS(&node->state, old_st, new_st);
+            state = node->state;
+        } while (!cas_ret);
+
+        cluster_dbg_flow("%s run state %x -> %x signal -> wait\n", p->name, old_st, new_st);
+
+        /* requeue to own ring and it will be picked on next loop */
+        if (cluster_ring_push(&p->ring, task))
+            cluster_queue_push(task->queue, task);
+    } else {
+        do {
+            old_st = node->state;
+            new_st = old_st ^ (NODE_IDLE | NODE_RUN);
+
+            cas_ret = MPP_BOOL_CAS(&node->state, old_st, new_st);
+        } while (!cas_ret);
+
+        cluster_dbg_flow("%s run state %x -> %x run -> idle\n", p->name, old_st, new_st);
+    }
 }
 
 static void *cluster_worker(void *data)
 {
     ClusterWorker *p = (ClusterWorker *)data;
+    MppCluster *cluster = p->cluster;
     MppThread *thd = p->thd;
+    RK_S32 spin = 0;
+
+#if defined(__linux__)
+    if (p->cpu >= 0) {
+        cpu_set_t cpus;
+
+        CPU_ZERO(&cpus);
+        CPU_SET(p->cpu, &cpus);
+        if (sched_setaffinity(0, sizeof(cpus), &cpus))
+            mpp_err_f("%s failed to bind cpu %d\n", p->name, p->cpu);
+    }
+#endif
 
     while (1) {
-        {
-            RK_S32 task_count = 0;
+        MppNodeTask *task = NULL;
+
+        if (MPP_THREAD_RUNNING != thd->get_status())
+            break;
 
+        task = cluster_worker_get_task(p);
+        if (task) {
+            spin = 0;
+            cluster_worker_run_task(p, task);
+            continue;
+        }
+
+        /* yield a few rounds before sleep for new trigger */
+        if (spin < CLUSTER_SPIN_COUNT) {
+            spin++;
+            sched_yield();
+            continue;
+        }
+        spin = 0;
+
+        {
             cluster_dbg_lock("%s lock start\n", p->name);
             AutoMutex autolock(thd->mutex());
             cluster_dbg_lock("%s lock done\n", p->name);
@@ -552,34 +730,49 @@ static void *cluster_worker(void *data)
             if (MPP_THREAD_RUNNING != thd->get_status())
                 break;
 
-            task_count = cluster_worker_get_task(p);
-            if (!task_count) {
-                p->state = WORKER_IDLE;
+            /* pairs with the barrier in cluster_signal_f to avoid lost wakeup */
+            p->state = WORKER_IDLE;
+            MPP_SYNC();
+
+            if (!cluster_has_task(cluster))
                 thd->wait();
-                p->state = WORKER_RUNNING;
-            }
-        }
 
-        cluster_worker_run_task(p);
+            p->state = WORKER_RUNNING;
+        }
     }
 
     return NULL;
 }
 
-void cluster_signal_f(const char *caller, MppCluster *p)
+static void cluster_worker_signal(ClusterWorker *worker)
+{
+    MppThread *thd = worker->thd;
+    AutoMutex auto_lock(thd->mutex());
+
+    thd->signal();
+}
+
+void cluster_signal_f(const char *caller, MppCluster *p, ClusterWorker *worker)
 {
     RK_S32 i;
 
-    cluster_dbg_flow("%s signal from %s\n", p->name, caller);
+    cluster_dbg_flow("%s signal %s from %s\n", p->name, worker->name, caller);
+
+    MPP_SYNC();
 
-    for (i = 0; i < p->worker_count; i++) {
-        ClusterWorker *worker = &p->worker[i];
-        MppThread *thd = worker->thd;
-        AutoMutex auto_lock(thd->mutex());
+    /* wake up the worker owning the task */
+    if (worker->state == WORKER_IDLE) {
+        cluster_worker_signal(worker);
+        return;
+    }
+
+    /* owner is busy then wake up one idle worker to steal */
+    for (i = 1; i < p->worker_count; i++) {
+        ClusterWorker *thief = &p->worker[(worker->worker_id + i) % p->worker_count];
 
-        if (worker->state == WORKER_IDLE) {
-            thd->signal();
-            cluster_dbg_flow("%s signal\n", p->name);
+        if (thief->state == WORKER_IDLE) {
+            cluster_worker_signal(thief);
+            cluster_dbg_flow("%s signal %s to steal\n", p->name, thief->name);
             break;
         }
     }
@@ -617,6 +810,7 @@ MppClusterServer::MppClusterServer()
 
     mpp_env_get_u32("mpp_cluster_debug", &mpp_cluster_debug, 0);
     mpp_env_get_u32("mpp_cluster_thd_cnt", &mpp_cluster_thd_cnt, 1);
+    mpp_env_get_u32("mpp_cluster_cpu_mask", &mpp_cluster_cpu_mask, 0);
 }
 
 MppClusterServer::~MppClusterServer()
@@ -662,6 +856,10 @@ MppCluster *MppClusterServer::get(MppClientType client_type)
             for (i = 0; i < p->worker_count; i++)
                 cluster_worker_init(&p->worker[i], p);
 
+            /* start after all workers are ready for stealing */
+            for (i = 0; i < p->worker_count; i++)
+                p->worker[i].thd->start();
+
             mClusters[client_type] = p;
             cluster_dbg_flow("%s created\n", p->name);
         }
@@ -694,7 +892,9 @@ MPP_RET MppClusterServer::put(MppClientType client_type)
 
     cluster_dbg_flow("put %s\n", p->name);
 
+    mpp_free(p->worker);
     mpp_free(p);
+    mClusters[client_type] = NULL;
 
     return MPP_OK;
 }
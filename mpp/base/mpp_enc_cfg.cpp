@@ -89,6 +89,8 @@ private:
 
     MppEncCfgInfo *mInfo;
     RK_S32 mCfgSize;
+    /* info node table indexed by handle */
+    MppCfgInfoNode **mNodes;
 
 public:
     static MppEncCfgService *get() {
@@ -100,7 +102,11 @@ public:
     }
 
     MppCfgInfoNode *get_info(const char *name) { return mpp_enc_cfg_find(mInfo, name); };
+    MppCfgInfoNode *get_info(RK_S32 hnd) {
+        return (hnd >= 0 && hnd < get_info_count()) ? mNodes[hnd] : NULL;
+    };
     MppCfgInfoNode *get_info_root();
+    RK_S32 get_hnd(const char *name);
 
     RK_S32 get_node_count() { return mInfo ? mInfo->head.node_count : 0; };
     RK_S32 get_info_count() { return mInfo ? mInfo->head.info_count : 0; };
@@ -369,7 +375,8 @@ static MppEncCfgInfo *mpp_enc_cfg_flaten(MppTrie trie, MppCfgApi **cfgs)
 
 MppEncCfgService::MppEncCfgService() :
     mInfo(NULL),
-    mCfgSize(0)
+    mCfgSize(0),
+    mNodes(NULL)
 {
     ENTRY_TABLE(EXPAND_AS_API);
 
@@ -394,6 +401,16 @@ MppEncCfgService::MppEncCfgService() :
     mInfo = mpp_enc_cfg_flaten(trie, cfgs);
     mCfgSize = mInfo->head.cfg_size;
 
+    mNodes = mpp_malloc(MppCfgInfoNode *, cfg_cnt);
+    if (mNodes) {
+        char *p = (char *)get_info_root();
+
+        for (i = 0; i < cfg_cnt; i++) {
+            mNodes[i] = (MppCfgInfoNode *)p;
+            p += mNodes[i]->node_size;
+        }
+    }
+
     mpp_enc_cfg_dbg_func("node cnt: %d\n", get_node_count());
 
     mpp_trie_deinit(trie);
@@ -401,6 +418,7 @@ MppEncCfgService::MppEncCfgService() :
 
 MppEncCfgService::~MppEncCfgService()
 {
+    MPP_FREE(mNodes);
     MPP_FREE(mInfo);
 }
 
@@ -412,6 +430,21 @@ MppCfgInfoNode *MppEncCfgService::get_info_root()
     return (MppCfgInfoNode *)(mInfo->trie_node + mInfo->head.node_count);
 }
 
+RK_S32 MppEncCfgService::get_hnd(const char *name)
+{
+    MppCfgInfoNode *info = get_info(name);
+    RK_S32 i;
+
+    if (NULL == info || NULL == mNodes)
+        return -1;
+
+    for (i = 0; i < get_info_count(); i++)
+        if (mNodes[i] == info)
+            return i;
+
+    return -1;
+}
+
 static void mpp_enc_cfg_set_default(MppEncCfgSet *cfg)
 {
     RK_U32 i;
@@ -522,6 +555,71 @@ ENC_CFG_GET_ACCESS(mpp_enc_cfg_get_u64, RK_U64, U64);
 ENC_CFG_GET_ACCESS(mpp_enc_cfg_get_ptr, void *, Ptr);
 ENC_CFG_GET_ACCESS(mpp_enc_cfg_get_st,  void  , St);
 
+MPP_RET mpp_enc_cfg_get_hnd(const char *name, RK_S32 *hnd)
+{
+    if (NULL == name || NULL == hnd) {
+        mpp_err_f("invalid input name %p hnd %p\n", name, hnd);
+        return MPP_ERR_NULL_PTR;
+    }
+
+    *hnd = MppEncCfgService::get()->get_hnd(name);
+    if (*hnd < 0) {
+        mpp_err_f("cfg %s is invalid\n", name);
+        return MPP_NOK;
+    }
+
+    mpp_enc_cfg_dbg_info("name %s hnd %d\n", name, *hnd);
+    return MPP_OK;
+}
+
+#define ENC_CFG_SET_HND_ACCESS(func_name, in_type, cfg_type) \
+    MPP_RET func_name(MppEncCfg cfg, RK_S32 hnd, in_type val) \
+    { \
+        if (NULL == cfg) { \
+            mpp_err_f("invalid input cfg %p hnd %d\n", cfg, hnd); \
+            return MPP_ERR_NULL_PTR; \
+        } \
+        MppEncCfgImpl *p = (MppEncCfgImpl *)cfg; \
+        MppCfgInfoNode *info = MppEncCfgService::get()->get_info(hnd); \
+        if (CHECK_CFG_INFO(info, "by hnd", CFG_FUNC_TYPE_##cfg_type)) { \
+            return MPP_NOK; \
+        } \
+        mpp_enc_cfg_dbg_set("name %s type %s\n", info->name, cfg_type_names[info->data_type]); \
+        MPP_RET ret = MPP_CFG_SET_##cfg_type(info, &p->cfg, val); \
+        return ret; \
+    }
+
+ENC_CFG_SET_HND_ACCESS(mpp_enc_cfg_set_s32_hnd, RK_S32, S32);
+ENC_CFG_SET_HND_ACCESS(mpp_enc_cfg_set_u32_hnd, RK_U32, U32);
+ENC_CFG_SET_HND_ACCESS(mpp_enc_cfg_set_s64_hnd, RK_S64, S64);
+ENC_CFG_SET_HND_ACCESS(mpp_enc_cfg_set_u64_hnd, RK_U64, U64);
+ENC_CFG_SET_HND_ACCESS(mpp_enc_cfg_set_ptr_hnd, void *, Ptr);
+ENC_CFG_SET_HND_ACCESS(mpp_enc_cfg_set_st_hnd,  void *, St);
+
+#define ENC_CFG_GET_HND_ACCESS(func_name, in_type, cfg_type) \
+    MPP_RET func_name(MppEncCfg cfg, RK_S32 hnd, in_type *val) \
+    { \
+        if (NULL == cfg) { \
+            mpp_err_f("invalid input cfg %p hnd %d\n", cfg, hnd); \
+            return MPP_ERR_NULL_PTR; \
+        } \
+        MppEncCfgImpl *p = (MppEncCfgImpl *)cfg; \
+        MppCfgInfoNode *info = MppEncCfgService::get()->get_info(hnd); \
+        if (CHECK_CFG_INFO(info, "by hnd", CFG_FUNC_TYPE_##cfg_type)) { \
+            return MPP_NOK; \
+        } \
+        mpp_enc_cfg_dbg_get("name %s type %s\n", info->name, cfg_type_names[info->data_type]); \
+        MPP_RET ret = MPP_CFG_GET_##cfg_type(info, &p->cfg, val); \
+        return ret; \
+    }
+
+ENC_CFG_GET_HND_ACCESS(mpp_enc_cfg_get_s32_hnd, RK_S32, S32);
+ENC_CFG_GET_HND_ACCESS(mpp_enc_cfg_get_u32_hnd, RK_U32, U32);
+ENC_CFG_GET_HND_ACCESS(mpp_enc_cfg_get_s64_hnd, RK_S64, S64);
+ENC_CFG_GET_HND_ACCESS(mpp_enc_cfg_get_u64_hnd, RK_U64, U64);
+ENC_CFG_GET_HND_ACCESS(mpp_enc_cfg_get_ptr_hnd, void *, Ptr);
+ENC_CFG_GET_HND_ACCESS(mpp_enc_cfg_get_st_hnd,  void  , St);
+
 void mpp_enc_cfg_show(void)
 {
     RK_S32 node_count = MppEncCfgService::get()->get_node_count();
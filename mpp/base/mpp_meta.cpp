@@ -19,8 +19,8 @@
 #include <string.h>
 
 #include "mpp_mem.h"
-#include "mpp_list.h"
 #include "mpp_lock.h"
+#include "mpp_mem_pool.h"
 
 #include "mpp_meta_impl.h"
 
@@ -28,6 +28,11 @@
 #define META_VAL_VALID      (0x00000001)
 #define META_VAL_READY      (0x00000002)
 
+/* open addressing key hash table, keep it at least twice of meta_defs */
+#define META_KEY_HASH_BITS  7
+#define META_KEY_HASH_SIZE  (1 << META_KEY_HASH_BITS)
+#define META_KEY_HASH(key)  (((RK_U32)(key) * 0x9E3779B1) >> (32 - META_KEY_HASH_BITS))
+
 #define WRITE_ONCE(x, val)  ((*(volatile typeof(x) *) &(x)) = (val))
 #define READ_ONCE(var)      (*((volatile typeof(var) *)(&(var))))
 
@@ -95,8 +100,9 @@ private:
     MppMetaService(const MppMetaService &);
     MppMetaService &operator=(const MppMetaService &);
 
-    spinlock_t          mLock;
-    struct list_head    mlist_meta;
+    MppMemPool          mPool;
+    /* index + 1 of meta_defs, zero for empty slot */
+    RK_U8               mKeyHash[META_KEY_HASH_SIZE];
 
     RK_U32              meta_id;
     RK_S32              meta_count;
@@ -112,9 +118,21 @@ public:
      * get_index_of_key does two things:
      * 1. Check the key / type pair is correct or not.
      *    If failed on check return negative value
-     * 2. Compare all exsisting meta data defines to find the non-negative index
+     * 2. Lookup the key hash table to find the non-negative index
      */
-    RK_S32 get_index_of_key(MppMetaKey key, MppMetaType type);
+    RK_S32 get_index_of_key(MppMetaKey key, MppMetaType type) {
+        RK_U32 pos = META_KEY_HASH(key);
+        RK_S32 idx;
+
+        while ((idx = mKeyHash[pos])) {
+            if (meta_defs[idx - 1].key == key)
+                return (meta_defs[idx - 1].type == type) ? (idx - 1) : (-1);
+
+            pos = (pos + 1) & (META_KEY_HASH_SIZE - 1);
+        }
+
+        return -1;
+    }
 
     MppMetaImpl  *get_meta(const char *tag, const char *caller);
     void          put_meta(MppMetaImpl *meta);
@@ -125,60 +143,53 @@ MppMetaService::MppMetaService()
       meta_count(0),
       finished(0)
 {
-    mpp_spinlock_init(&mLock);
-    INIT_LIST_HEAD(&mlist_meta);
-}
+    RK_U32 i;
 
-MppMetaService::~MppMetaService()
-{
-    if (!list_empty(&mlist_meta)) {
-        MppMetaImpl *pos, *n;
+    /* valid bitmap is 64bit */
+    mpp_assert(MPP_ARRAY_ELEMS(meta_defs) <= 64);
+    mpp_assert(MPP_ARRAY_ELEMS(meta_defs) * 2 <= META_KEY_HASH_SIZE);
 
-        mpp_log_f("cleaning leaked metadata\n");
+    memset(mKeyHash, 0, sizeof(mKeyHash));
 
-        list_for_each_entry_safe(pos, n, &mlist_meta, MppMetaImpl, list_meta) {
-            put_meta(pos);
-        }
+    for (i = 0; i < MPP_ARRAY_ELEMS(meta_defs); i++) {
+        RK_U32 pos = META_KEY_HASH(meta_defs[i].key);
+
+        while (mKeyHash[pos])
+            pos = (pos + 1) & (META_KEY_HASH_SIZE - 1);
+
+        mKeyHash[pos] = i + 1;
     }
 
-    mpp_assert(meta_count == 0);
-    finished = 1;
+    mPool = mpp_mem_pool_init_f(MODULE_TAG, sizeof(MppMetaImpl) +
+                                sizeof(MppMetaVal) * MPP_ARRAY_ELEMS(meta_defs));
 }
 
-RK_S32 MppMetaService::get_index_of_key(MppMetaKey key, MppMetaType type)
+MppMetaService::~MppMetaService()
 {
-    RK_S32 i = 0;
-    RK_S32 num = MPP_ARRAY_ELEMS(meta_defs);
+    if (meta_count)
+        mpp_log_f("cleaning %d leaked metadata\n", meta_count);
 
-    for (i = 0; i < num; i++) {
-        if ((meta_defs[i].key == key) && (meta_defs[i].type == type))
-            break;
+    /* leaked meta is released along with the pool */
+    if (mPool) {
+        mpp_mem_pool_deinit_f(MODULE_TAG, mPool);
+        mPool = NULL;
     }
 
-    return (i < num) ? (i) : (-1);
+    finished = 1;
 }
 
 MppMetaImpl *MppMetaService::get_meta(const char *tag, const char *caller)
 {
-    MppMetaImpl *impl = mpp_malloc_size(MppMetaImpl, sizeof(MppMetaImpl) +
-                                        sizeof(MppMetaVal) * MPP_ARRAY_ELEMS(meta_defs));
+    /* recycled meta from pool is all zero so all values are invalid */
+    MppMetaImpl *impl = (MppMetaImpl *)mpp_mem_pool_get_f(caller, mPool);
     if (impl) {
         const char *tag_src = (tag) ? (tag) : (MODULE_TAG);
-        RK_U32 i;
 
         strncpy(impl->tag, tag_src, sizeof(impl->tag));
         impl->caller = caller;
         impl->meta_id = MPP_FETCH_ADD(&meta_id, 1);
-        INIT_LIST_HEAD(&impl->list_meta);
         impl->ref_count = 1;
-        impl->node_count = 0;
 
-        for (i = 0; i < MPP_ARRAY_ELEMS(meta_defs); i++)
-            impl->vals[i].state = 0;
-
-        mpp_spinlock_lock(&mLock);
-        list_add_tail(&impl->list_meta, &mlist_meta);
-        mpp_spinlock_unlock(&mLock);
         MPP_FETCH_ADD(&meta_count, 1);
     } else {
         mpp_err_f("failed to malloc meta data\n");
@@ -201,12 +212,9 @@ void MppMetaService::put_meta(MppMetaImpl *meta)
         return;
     }
 
-    mpp_spinlock_lock(&mLock);
-    list_del_init(&meta->list_meta);
-    mpp_spinlock_unlock(&mLock);
     MPP_FETCH_SUB(&meta_count, 1);
 
-    mpp_free(meta);
+    mpp_mem_pool_put_f(meta->caller, mPool, meta);
 }
 
 MPP_RET mpp_meta_get_with_tag(MppMeta *meta, const char *tag, const char *caller)
@@ -269,13 +277,14 @@ MPP_RET mpp_meta_dump(MppMeta meta)
     }
 
     MppMetaImpl *impl = (MppMetaImpl *)meta;
-    RK_U32 i;
+    RK_U64 valid = impl->valid;
 
     mpp_log("dumping meta %d node count %d\n", impl->meta_id, impl->node_count);
 
-    for (i = 0; i < MPP_ARRAY_ELEMS(meta_defs); i++) {
-        if (!impl->vals[i].state)
-            continue;
+    while (valid) {
+        RK_S32 i = __builtin_ctzll(valid);
+
+        valid &= valid - 1;
 
         const char *key = (const char *)&meta_defs[i].key;
         const char *type = (const char *)&meta_defs[i].type;
@@ -301,8 +310,10 @@ MPP_RET mpp_meta_dump(MppMeta meta)
             return MPP_NOK; \
         MppMetaImpl *impl = (MppMetaImpl *)meta; \
         MppMetaVal *meta_val = &impl->vals[index]; \
-        if (MPP_BOOL_CAS(&meta_val->state, META_VAL_INVALID, META_VAL_VALID)) \
+        if (MPP_BOOL_CAS(&meta_val->state, META_VAL_INVALID, META_VAL_VALID)) { \
+            MPP_FETCH_OR(&impl->valid, (RK_U64)1 << index); \
             MPP_FETCH_ADD(&impl->node_count, 1); \
+        } \
         meta_val->key_field = val; \
         MPP_FETCH_OR(&meta_val->state, META_VAL_READY); \
         return MPP_OK; \
@@ -322,6 +333,7 @@ MPP_RET mpp_meta_dump(MppMeta meta)
         MPP_RET ret = MPP_NOK; \
         if (MPP_BOOL_CAS(&meta_val->state, META_VAL_VALID | META_VAL_READY, META_VAL_INVALID)) { \
             *val = meta_val->key_field; \
+            MPP_FETCH_AND(&impl->valid, ~((RK_U64)1 << index)); \
             MPP_FETCH_SUB(&impl->node_count, 1); \
             ret = MPP_OK; \
         } \
@@ -342,6 +354,7 @@ MPP_RET mpp_meta_dump(MppMeta meta)
         MPP_RET ret = MPP_NOK; \
         if (MPP_BOOL_CAS(&meta_val->state, META_VAL_VALID | META_VAL_READY, META_VAL_INVALID)) { \
             *val = meta_val->key_field; \
+            MPP_FETCH_AND(&impl->valid, ~((RK_U64)1 << index)); \
             MPP_FETCH_SUB(&impl->node_count, 1); \
             ret = MPP_OK; \
         } else { \
@@ -0,0 +1,132 @@
+/* SPDX-License-Identifier: Apache-2.0 OR MIT */
+/*
+ * Copyright (c) 2024 Rockchip Electronics Co., Ltd.
+ */
+
+#include <string.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+#include "mpp_startcode.h"
+
+#define HAS_ZERO_BYTE(x)    (((x) - 0x0101010101010101ULL) & ~(x) & 0x8080808080808080ULL)
+
+static RK_S32 find_startcode_byte(const RK_U8 *buf, RK_S32 pos, RK_S32 end)
+{
+    for (; pos < end; pos++) {
+        if (!buf[pos] && !buf[pos + 1] && buf[pos + 2] == 1)
+            return pos;
+    }
+
+    return -1;
+}
+
+/*
+ * Scalar version: skip 8 bytes at once when there is no zero byte in the
+ * word, for a prefix must start with a zero byte.
+ */
+static RK_S32 find_startcode_word(const RK_U8 *buf, RK_S32 pos, RK_S32 size)
+{
+    RK_S32 end = size - 2;
+    RK_S32 ret;
+
+    while (pos + 8 <= end) {
+        RK_U64 val;
+
+        memcpy(&val, buf + pos, sizeof(val));
+        if (HAS_ZERO_BYTE(val)) {
+            ret = find_startcode_byte(buf, pos, pos + 8);
+            if (ret >= 0)
+                return ret;
+        }
+        pos += 8;
+    }
+
+    ret = find_startcode_byte(buf, pos, end);
+
+    return (ret >= 0) ? ret : size;
+}
+
+RK_S32 mpp_find_startcode_c(const RK_U8 *buf, RK_S32 size)
+{
+    RK_S32 ret;
+
+    if (!buf || size < 3)
+        return size < 0 ? 0 : size;
+
+    ret = find_startcode_byte(buf, 0, size - 2);
+
+    return (ret >= 0) ? ret : size;
+}
+
+#if defined(__SSE2__)
+static RK_S32 find_startcode_simd(const RK_U8 *buf, RK_S32 size)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i one = _mm_set1_epi8(1);
+    RK_S32 pos = 0;
+
+    /* load at pos, pos + 1 and pos + 2 so 18 bytes must be readable */
+    while (pos + 18 <= size) {
+        __m128i b0 = _mm_loadu_si128((const __m128i *)(buf + pos));
+        __m128i b1 = _mm_loadu_si128((const __m128i *)(buf + pos + 1));
+        __m128i b2 = _mm_loadu_si128((const __m128i *)(buf + pos + 2));
+        __m128i m = _mm_and_si128(_mm_cmpeq_epi8(b0, zero),
+                                  _mm_cmpeq_epi8(b1, zero));
+        RK_S32 mask;
+
+        m = _mm_and_si128(m, _mm_cmpeq_epi8(b2, one));
+        mask = _mm_movemask_epi8(m);
+        if (mask)
+            return pos + __builtin_ctz(mask);
+
+        pos += 16;
+    }
+
+    return find_startcode_word(buf, pos, size);
+}
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+static RK_S32 find_startcode_simd(const RK_U8 *buf, RK_S32 size)
+{
+    const uint8x16_t zero = vdupq_n_u8(0);
+    const uint8x16_t one = vdupq_n_u8(1);
+    RK_S32 pos = 0;
+
+    while (pos + 18 <= size) {
+        uint8x16_t b0 = vld1q_u8(buf + pos);
+        uint8x16_t b1 = vld1q_u8(buf + pos + 1);
+        uint8x16_t b2 = vld1q_u8(buf + pos + 2);
+        uint8x16_t m = vandq_u8(vceqq_u8(b0, zero), vceqq_u8(b1, zero));
+
+        m = vandq_u8(m, vceqq_u8(b2, one));
+        if (vmaxvq_u8(m)) {
+            /* narrow each byte lane to 4 bits and locate the first hit */
+            RK_U64 bits = vget_lane_u64(vreinterpret_u64_u8(
+                                            vshrn_n_u16(vreinterpretq_u16_u8(m), 4)), 0);
+
+            return pos + (__builtin_ctzll(bits) >> 2);
+        }
+
+        pos += 16;
+    }
+
+    return find_startcode_word(buf, pos, size);
+}
+#else
+static RK_S32 find_startcode_simd(const RK_U8 *buf, RK_S32 size)
+{
+    return find_startcode_word(buf, 0, size);
+}
+#endif
+
+RK_S32 mpp_find_startcode(const RK_U8 *buf, RK_S32 size)
+{
+    if (!buf || size < 3)
+        return size < 0 ? 0 : size;
+
+    return find_startcode_simd(buf, size);
+}
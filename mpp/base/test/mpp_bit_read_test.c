@@ -20,11 +20,18 @@
 #include <string.h>
 
 #include "mpp_log.h"
+#include "mpp_mem.h"
+#include "mpp_time.h"
 #include "mpp_common.h"
 #include "mpp_bitread.h"
+#include "mpp_bitwrite.h"
 
 #define BIT_READ_BUFFER_SIZE        (1024)
 
+#define BIT_BENCH_SYNTAX_COUNT      (64 * 1024)
+#define BIT_BENCH_BUFFER_SIZE       (BIT_BENCH_SYNTAX_COUNT * 8)
+#define BIT_BENCH_LOOP              20
+
 typedef enum BitOpsType_e {
     BIT_GET,
     BIT_GET_UE,
@@ -328,6 +335,105 @@ __NORMAL:
     return ret;
 }
 
+/*
+ * Write random syntax with emulation prevention by bit writer then read it
+ * back for checking and timing. Small values and zero bits are preferred to
+ * create plenty of 00 00 03 sequences.
+ */
+static MPP_RET bit_read_bench(void)
+{
+    BitOps *ops = mpp_malloc(BitOps, BIT_BENCH_SYNTAX_COUNT);
+    RK_U8 *buf = mpp_malloc(RK_U8, BIT_BENCH_BUFFER_SIZE);
+    MPP_RET ret = MPP_NOK;
+    MppWriteCtx writer;
+    BitReadCtx_t reader;
+    RK_S64 bits = 0;
+    RK_S64 time_start;
+    RK_S64 time_end;
+    RK_S32 loop;
+    RK_S32 i;
+
+    if (!ops || !buf)
+        goto DONE;
+
+    srand(0x1234);
+    mpp_writer_init(&writer, buf, BIT_BENCH_BUFFER_SIZE);
+
+    for (i = 0; i < BIT_BENCH_SYNTAX_COUNT; i++) {
+        BitOps *op = &ops[i];
+        RK_S32 big = !(rand() % 8);
+
+        op->type = (BitOpsType)(rand() % 3);
+        switch (op->type) {
+        case BIT_GET : {
+            op->len = rand() % 24 + 1;
+            op->val = big ? (rand() & ((1 << op->len) - 1)) : 0;
+            mpp_writer_put_bits(&writer, op->val, op->len);
+        } break;
+        case BIT_GET_UE : {
+            op->val = big ? rand() % 4096 : rand() % 4;
+            mpp_writer_put_ue(&writer, op->val);
+        } break;
+        default : {
+            op->val = big ? rand() % 4096 - 2048 : rand() % 5 - 2;
+            mpp_writer_put_se(&writer, op->val);
+        } break;
+        }
+    }
+    mpp_writer_trailing(&writer);
+    bits = (RK_S64)mpp_writer_bits(&writer);
+
+    time_start = mpp_time();
+
+    for (loop = 0; loop < BIT_BENCH_LOOP; loop++) {
+        mpp_set_bitread_ctx(&reader, buf, mpp_writer_bytes(&writer));
+        mpp_set_bitread_pseudo_code_type(&reader, PSEUDO_CODE_H264_H265);
+
+        for (i = 0; i < BIT_BENCH_SYNTAX_COUNT; i++) {
+            BitOps *op = &ops[i];
+            RK_S32 val = 0;
+
+            switch (op->type) {
+            case BIT_GET : {
+                mpp_read_bits(&reader, op->len, &val);
+            } break;
+            case BIT_GET_UE : {
+                mpp_read_ue(&reader, (RK_U32 *)&val);
+            } break;
+            default : {
+                mpp_read_se(&reader, &val);
+            } break;
+            }
+
+            if (val != op->val) {
+                mpp_err("bench syntax %d %s expect %d but %d\n", i,
+                        bitOpsStr[op->type], op->val, val);
+                goto DONE;
+            }
+        }
+    }
+
+    time_end = mpp_time();
+
+    /* only rbsp trailing bits and its emulation byte are left */
+    if (writer.emul_cnt - reader.emulation_prevention_bytes_ > 1 ||
+        bits - reader.used_bits < 1 || bits - reader.used_bits > 16) {
+        mpp_err("bench used bits %d emulation %lld mismatch with written bits %lld emulation %d\n",
+                reader.used_bits, reader.emulation_prevention_bytes_, bits, writer.emul_cnt);
+        goto DONE;
+    }
+
+    mpp_log("bench %d syntax %lld bits %d emulation bytes %.2f ns per syntax\n",
+            BIT_BENCH_SYNTAX_COUNT, bits, writer.emul_cnt,
+            (time_end - time_start) * 1000.0 / BIT_BENCH_LOOP / BIT_BENCH_SYNTAX_COUNT);
+    ret = MPP_OK;
+
+DONE:
+    MPP_FREE(ops);
+    MPP_FREE(buf);
+    return ret;
+}
+
 int main()
 {
     BitReadCtx_t reader;
@@ -381,6 +487,11 @@ int main()
 
         tmp = 0;
     }
+
+    mpp_log("Reading random H264 syntax with emulation prevention...");
+    if (bit_read_bench())
+        goto __READ_FAILED;
+
     mpp_log("mpp bit read test end\n");
     return 0;
 __READ_FAILED:
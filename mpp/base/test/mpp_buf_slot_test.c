@@ -0,0 +1,282 @@
+/* SPDX-License-Identifier: Apache-2.0 OR MIT */
+/*
+ * Copyright (c) 2024 Rockchip Electronics Co., Ltd.
+ */
+
+#define MODULE_TAG "mpp_buf_slot_test"
+
+#include <string.h>
+
+#include "mpp_mem.h"
+#include "mpp_log.h"
+#include "mpp_debug.h"
+#include "mpp_time.h"
+#include "mpp_common.h"
+
+#include "mpp_buf_slot.h"
+
+/*
+ * Record slot operations of a decoder with 16 reference frames and display
+ * queue then replay the record as benchmark. Each unused slot returned on
+ * replay must match the record and the lowest unused slot index of a
+ * reference model.
+ */
+#define SLOT_COUNT          24
+#define REF_COUNT           16
+#define FRAME_COUNT         2000
+#define REPLAY_ROUND        50
+#define MAX_OP_COUNT        (FRAME_COUNT * 24)
+
+typedef enum SlotTestOp_e {
+    OP_GET_UNUSED,
+    OP_SET_FLAG,
+    OP_CLR_FLAG,
+    OP_ENQUEUE,
+    OP_DEQUEUE,
+    OP_GET_BUFFER,
+} SlotTestOp;
+
+typedef struct SlotTestRecord_t {
+    SlotTestOp  op;
+    RK_S32      type;
+    RK_S32      index;
+} SlotTestRecord;
+
+typedef struct SlotTestCtx_t {
+    SlotTestRecord  *records;
+    RK_S32          count;
+    RK_U32          used[SLOT_COUNT];
+} SlotTestCtx;
+
+static void record_op(SlotTestCtx *ctx, SlotTestOp op, RK_S32 type, RK_S32 index)
+{
+    SlotTestRecord *rec;
+
+    mpp_assert(ctx->count < MAX_OP_COUNT);
+    if (ctx->count >= MAX_OP_COUNT)
+        return;
+
+    rec = &ctx->records[ctx->count++];
+    rec->op = op;
+    rec->type = type;
+    rec->index = index;
+}
+
+static RK_S32 model_lowest_unused(SlotTestCtx *ctx)
+{
+    RK_S32 i;
+
+    for (i = 0; i < SLOT_COUNT; i++)
+        if (!ctx->used[i])
+            return i;
+
+    return -1;
+}
+
+static MPP_RET run_op(MppBufSlots slots, SlotTestRecord *rec, RK_S32 *index)
+{
+    MppBuffer buffer = NULL;
+    MPP_RET ret = MPP_OK;
+
+    switch (rec->op) {
+    case OP_GET_UNUSED : {
+        ret = mpp_buf_slot_get_unused(slots, index);
+    } break;
+    case OP_SET_FLAG : {
+        ret = mpp_buf_slot_set_flag(slots, rec->index, (SlotUsageType)rec->type);
+    } break;
+    case OP_CLR_FLAG : {
+        ret = mpp_buf_slot_clr_flag(slots, rec->index, (SlotUsageType)rec->type);
+    } break;
+    case OP_ENQUEUE : {
+        ret = mpp_buf_slot_enqueue(slots, rec->index, (SlotQueueType)rec->type);
+    } break;
+    case OP_DEQUEUE : {
+        ret = mpp_buf_slot_dequeue(slots, index, (SlotQueueType)rec->type);
+    } break;
+    case OP_GET_BUFFER : {
+        ret = mpp_buf_slot_get_prop(slots, rec->index, SLOT_BUFFER, &buffer);
+    } break;
+    }
+
+    return ret;
+}
+
+/* generate the operation record by running a simple decoder flow */
+static MPP_RET slot_test_record(SlotTestCtx *ctx, MppBufSlots slots)
+{
+    SlotTestRecord rec;
+    RK_S32 refs[REF_COUNT];
+    RK_S32 ref_count = 0;
+    RK_S32 frame;
+    RK_S32 i;
+
+    for (frame = 0; frame < FRAME_COUNT; frame++) {
+        RK_S32 index = -1;
+        RK_S32 expect = model_lowest_unused(ctx);
+
+        rec.op = OP_GET_UNUSED;
+        if (run_op(slots, &rec, &index) || index != expect) {
+            mpp_err("frame %d get unused %d expect %d\n", frame, index, expect);
+            return MPP_NOK;
+        }
+        record_op(ctx, OP_GET_UNUSED, 0, index);
+        ctx->used[index] = 1;
+
+        /* parser: mark ready and reference */
+#define RUN_OP(o, t, i) do { \
+            rec.op = o; rec.type = t; rec.index = i; \
+            run_op(slots, &rec, &rec.index); \
+            record_op(ctx, o, t, i); \
+        } while (0)
+
+        RUN_OP(OP_SET_FLAG, SLOT_CODEC_READY, index);
+        RUN_OP(OP_SET_FLAG, SLOT_CODEC_USE, index);
+
+        /* hal: output slot and reference inputs */
+        RUN_OP(OP_SET_FLAG, SLOT_HAL_OUTPUT, index);
+        for (i = 0; i < MPP_MIN(ref_count, 4); i++) {
+            RUN_OP(OP_SET_FLAG, SLOT_HAL_INPUT, refs[i]);
+            RUN_OP(OP_GET_BUFFER, 0, refs[i]);
+        }
+        for (i = 0; i < MPP_MIN(ref_count, 4); i++)
+            RUN_OP(OP_CLR_FLAG, SLOT_HAL_INPUT, refs[i]);
+        RUN_OP(OP_CLR_FLAG, SLOT_HAL_OUTPUT, index);
+
+        /* display */
+        RUN_OP(OP_ENQUEUE, QUEUE_DISPLAY, index);
+        RUN_OP(OP_DEQUEUE, QUEUE_DISPLAY, index);
+
+        /* sliding window reference */
+        if (ref_count == REF_COUNT) {
+            RK_S32 drop = refs[0];
+
+            RUN_OP(OP_CLR_FLAG, SLOT_CODEC_USE, drop);
+            ctx->used[drop] = 0;
+            memmove(refs, refs + 1, sizeof(refs[0]) * (REF_COUNT - 1));
+            ref_count--;
+        }
+        refs[ref_count++] = index;
+#undef RUN_OP
+    }
+
+    /* release all reference */
+    for (i = 0; i < ref_count; i++) {
+        rec.op = OP_CLR_FLAG;
+        rec.type = SLOT_CODEC_USE;
+        rec.index = refs[i];
+        run_op(slots, &rec, &rec.index);
+        record_op(ctx, OP_CLR_FLAG, SLOT_CODEC_USE, refs[i]);
+        ctx->used[refs[i]] = 0;
+    }
+
+    return MPP_OK;
+}
+
+static MPP_RET slot_test_replay(SlotTestCtx *ctx, MppBufSlots slots)
+{
+    RK_S32 i;
+
+    for (i = 0; i < ctx->count; i++) {
+        SlotTestRecord *rec = &ctx->records[i];
+        RK_S32 index = -1;
+
+        run_op(slots, rec, &index);
+        if ((rec->op == OP_GET_UNUSED || rec->op == OP_DEQUEUE) && index != rec->index) {
+            mpp_err("op %d at %d return index %d mismatch record %d\n",
+                    rec->op, i, index, rec->index);
+            return MPP_NOK;
+        }
+    }
+
+    return MPP_OK;
+}
+
+/*
+ * setup and info change ready reinitialize slot status, the unused slot
+ * lookup must follow the new status instead of the status before reset
+ */
+static MPP_RET slot_test_reinit(MppBufSlots slots)
+{
+    RK_S32 count = SLOT_COUNT + 8;
+    RK_S32 index = -1;
+    RK_S32 i;
+
+    for (i = 0; i < 4; i++)
+        mpp_buf_slot_get_unused(slots, &index);
+
+    mpp_buf_slot_setup(slots, count);
+    mpp_buf_slot_ready(slots);
+
+    for (i = 0; i < count; i++) {
+        if (mpp_buf_slot_get_unused(slots, &index) || index != i) {
+            mpp_err("get unused %d expect %d after reinit\n", index, i);
+            return MPP_NOK;
+        }
+    }
+
+    for (i = 0; i < count; i++) {
+        mpp_buf_slot_set_flag(slots, i, SLOT_CODEC_READY);
+        mpp_buf_slot_set_flag(slots, i, SLOT_CODEC_USE);
+        mpp_buf_slot_clr_flag(slots, i, SLOT_CODEC_USE);
+    }
+
+    return MPP_OK;
+}
+
+int main()
+{
+    SlotTestCtx ctx;
+    MppBufSlots slots = NULL;
+    RK_S64 time_start;
+    RK_S64 time_end;
+    RK_S32 i;
+    MPP_RET ret = MPP_NOK;
+
+    mpp_log("mpp_buf_slot test start\n");
+
+    memset(&ctx, 0, sizeof(ctx));
+    ctx.records = mpp_calloc(SlotTestRecord, MAX_OP_COUNT);
+    if (NULL == ctx.records)
+        goto DONE;
+
+    if (mpp_buf_slot_init(&slots))
+        goto DONE;
+
+    mpp_buf_slot_setup(slots, SLOT_COUNT);
+
+    ret = slot_test_record(&ctx, slots);
+    if (ret)
+        goto DONE;
+
+    mpp_log("recorded %d slot ops for %d frames\n", ctx.count, FRAME_COUNT);
+
+    if (mpp_slots_get_used_count(slots)) {
+        mpp_err("slots used count %d after record\n", mpp_slots_get_used_count(slots));
+        ret = MPP_NOK;
+        goto DONE;
+    }
+
+    time_start = mpp_time();
+    for (i = 0; i < REPLAY_ROUND; i++) {
+        ret = slot_test_replay(&ctx, slots);
+        if (ret)
+            goto DONE;
+    }
+    time_end = mpp_time();
+
+    mpp_log("replay %d ops in %lld us, %.1f ns per op\n",
+            ctx.count * REPLAY_ROUND, time_end - time_start,
+            (float)(time_end - time_start) * 1000 / (ctx.count * REPLAY_ROUND));
+
+    ret = slot_test_reinit(slots);
+
+DONE:
+    if (slots)
+        mpp_buf_slot_deinit(slots);
+    MPP_FREE(ctx.records);
+
+    mpp_log("mpp_buf_slot test %s\n", ret ? "failed" : "success");
+
+    return ret;
+}
@@ -234,6 +234,48 @@ int main()
 
     mpp_log("mpp_buffer_test normal mode success\n");
 
+    mpp_log("mpp_buffer_test normal mode reuse start\n");
+
+    {
+        /* best-fit reuse should keep the smaller unused buffers */
+        size_t usage = mpp_buffer_group_usage(group);
+
+        ret = mpp_buffer_get(group, &normal_buffer[0], SZ_1K * 3 + SZ_1K / 2);
+        if (MPP_OK != ret || mpp_buffer_get_size(normal_buffer[0]) != SZ_1K * 4 ||
+            mpp_buffer_group_usage(group) != usage) {
+            mpp_err("mpp_buffer_test reuse get size %d usage %d -> %d failed\n",
+                    normal_buffer[0] ? mpp_buffer_get_size(normal_buffer[0]) : 0,
+                    usage, mpp_buffer_group_usage(group));
+            ret = MPP_NOK;
+            goto MPP_BUFFER_failed;
+        }
+
+        mpp_buffer_put(normal_buffer[0]);
+        normal_buffer[0] = NULL;
+    }
+
+    mpp_log("mpp_buffer_test normal mode reuse success\n");
+
+    mpp_log("mpp_buffer_test normal mode evict start\n");
+
+    {
+        /* miss on larger size should release all undersized unused buffers */
+        size_t evict_size = SZ_1K * (MPP_BUFFER_TEST_NORMAL_COUNT + 6);
+
+        ret = mpp_buffer_get(group, &normal_buffer[0], evict_size);
+        if (MPP_OK != ret || mpp_buffer_group_usage(group) != evict_size) {
+            mpp_err("mpp_buffer_test evict get size %d usage %d failed\n",
+                    evict_size, mpp_buffer_group_usage(group));
+            ret = MPP_NOK;
+            goto MPP_BUFFER_failed;
+        }
+
+        mpp_buffer_put(normal_buffer[0]);
+        normal_buffer[0] = NULL;
+    }
+
+    mpp_log("mpp_buffer_test normal mode evict success\n");
+
     if (group) {
         mpp_buffer_group_put(group);
         group = NULL;
@@ -16,16 +16,41 @@
 
 #define MODULE_TAG "mpp_cluster_test"
 
+#include <stdlib.h>
+#include <string.h>
+#include <sched.h>
+#include <pthread.h>
+
+#include "mpp_mem.h"
 #include "mpp_log.h"
+#include "mpp_lock.h"
 #include "mpp_time.h"
 #include "mpp_common.h"
 
 #include "mpp_cluster.h"
 
+#define BENCH_NODE_CNT      64
+#define BENCH_THREAD_CNT    4
+#define BENCH_ROUND_CNT     2000
+
 typedef struct MppTestNode_t {
     MppNode         node;
 } MppTestNode;
 
+typedef struct BenchNode_t {
+    MppNode         node;
+    RK_S64          trigger_time;
+    RK_U32          run_count;
+    RK_U32          lat_count;
+    RK_S32          *lat;
+} BenchNode;
+
+typedef struct BenchThread_t {
+    pthread_t       thd;
+    BenchNode       *nodes;
+    RK_S32          node_count;
+} BenchThread;
+
 MppTestNode test_node;
 
 static RK_S32 mpp_cluster_test_worker(void *param)
@@ -39,6 +64,118 @@ static RK_S32 mpp_cluster_test_worker(void *param)
     return ret;
 }
 
+static MPP_RET bench_node_proc(void *param)
+{
+    BenchNode *p = (BenchNode *)param;
+    RK_S64 trigger = MPP_SYNC_TEST_SET(&p->trigger_time, 0);
+
+    /* extra run from signal on running node has no trigger time */
+    if (trigger) {
+        p->lat[p->lat_count++] = (RK_S32)(mpp_time() - trigger);
+        MPP_SYNC();
+        p->run_count++;
+    }
+
+    return MPP_OK;
+}
+
+static void *bench_trigger(void *arg)
+{
+    BenchThread *t = (BenchThread *)arg;
+    RK_U32 round;
+    RK_S32 i;
+
+    for (round = 1; round <= BENCH_ROUND_CNT; round++) {
+        for (i = 0; i < t->node_count; i++) {
+            BenchNode *p = &t->nodes[i];
+
+            p->trigger_time = mpp_time();
+            mpp_node_trigger(p->node, 1);
+        }
+
+        for (i = 0; i < t->node_count; i++) {
+            while (((volatile BenchNode *)&t->nodes[i])->run_count < round)
+                sched_yield();
+        }
+    }
+
+    return NULL;
+}
+
+static int lat_cmp(const void *a, const void *b)
+{
+    return *(const RK_S32 *)a - *(const RK_S32 *)b;
+}
+
+static MPP_RET cluster_bench(void)
+{
+    BenchNode *nodes = mpp_calloc(BenchNode, BENCH_NODE_CNT);
+    BenchThread thds[BENCH_THREAD_CNT];
+    RK_S32 *lat = mpp_calloc(RK_S32, BENCH_NODE_CNT * BENCH_ROUND_CNT);
+    RK_S32 per_thd = BENCH_NODE_CNT / BENCH_THREAD_CNT;
+    RK_S64 total = 0;
+    RK_S64 time_start;
+    RK_S64 time_end;
+    RK_S32 count = 0;
+    RK_S32 i;
+
+    if (!nodes || !lat) {
+        MPP_FREE(nodes);
+        MPP_FREE(lat);
+        return MPP_ERR_MALLOC;
+    }
+
+    for (i = 0; i < BENCH_NODE_CNT; i++) {
+        BenchNode *p = &nodes[i];
+
+        p->lat = lat + i * BENCH_ROUND_CNT;
+        mpp_node_init(&p->node);
+        mpp_node_set_func(p->node, bench_node_proc, p);
+        mpp_node_attach(p->node, VPU_CLIENT_RKVDEC);
+    }
+
+    time_start = mpp_time();
+
+    for (i = 0; i < BENCH_THREAD_CNT; i++) {
+        thds[i].nodes = nodes + i * per_thd;
+        thds[i].node_count = per_thd;
+        pthread_create(&thds[i].thd, NULL, bench_trigger, &thds[i]);
+    }
+
+    for (i = 0; i < BENCH_THREAD_CNT; i++)
+        pthread_join(thds[i].thd, NULL);
+
+    time_end = mpp_time();
+
+    for (i = 0; i < BENCH_NODE_CNT; i++) {
+        BenchNode *p = &nodes[i];
+
+        mpp_node_detach(p->node);
+        mpp_node_deinit(p->node);
+
+        /* compact the latency record */
+        memmove(lat + count, p->lat, p->lat_count * sizeof(*lat));
+        count += p->lat_count;
+    }
+
+    for (i = 0; i < count; i++)
+        total += lat[i];
+
+    qsort(lat, count, sizeof(*lat), lat_cmp);
+
+    mpp_log("bench %d nodes %d threads %d runs in %lld ms %.2f K runs/s\n",
+            BENCH_NODE_CNT, BENCH_THREAD_CNT, count, (time_end - time_start) / 1000,
+            (float)count * 1000 / (time_end - time_start));
+    mpp_log("trigger to run latency avg %lld p50 %d p99 %d max %d us\n",
+            count ? total / count : 0, lat[count / 2], lat[count * 99 / 100],
+            lat[count - 1]);
+
+    mpp_free(nodes);
+    mpp_free(lat);
+
+    return MPP_OK;
+}
+
 int main()
 {
     MPP_RET ret = MPP_OK;
@@ -97,6 +234,8 @@ int main()
 
     mpp_log("mpp_cluster_test deinit done\n");
 
+    ret = cluster_bench();
+
 DONE:
     mpp_log("mpp_cluster_test done %s\n", ret ? "failed" : "success");
     return ret;
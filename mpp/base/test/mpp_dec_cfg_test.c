@@ -54,6 +54,25 @@ int main()
 
     mpp_log("after  get: fast_out %d\n", fast_out);
 
+    RK_U32 zero_copy_pkt = 0;
+
+    ret = mpp_dec_cfg_set_u32(cfg, "base:zero_copy_pkt", 1);
+    if (ret) {
+        mpp_err("set zero_copy_pkt failed\n");
+        goto DONE;
+    }
+
+    ret = mpp_dec_cfg_get_u32(cfg, "base:zero_copy_pkt", &zero_copy_pkt);
+    if (ret || zero_copy_pkt != 1 ||
+        !(impl->cfg.base.change & MPP_DEC_CFG_CHANGE_ZERO_COPY_PKT)) {
+        mpp_err("get zero_copy_pkt %d mismatch change %llx\n", zero_copy_pkt,
+                impl->cfg.base.change);
+        ret = MPP_NOK;
+        goto DONE;
+    }
+
+    mpp_log("zero_copy_pkt %d\n", zero_copy_pkt);
+
     ret = mpp_dec_cfg_deinit(cfg);
     if (ret) {
         mpp_err("mpp_dec_cfg_deinit failed\n");
@@ -0,0 +1,312 @@
+/* SPDX-License-Identifier: Apache-2.0 OR MIT */
+/*
+ * Copyright (c) 2024 Rockchip Electronics Co., Ltd.
+ */
+
+#define MODULE_TAG "mpp_dec_zc_test"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "mpp_log.h"
+#include "mpp_time.h"
+#include "mpp_common.h"
+#include "mpp_buffer_impl.h"
+
+#include "rk_mpi.h"
+#include "rk_vdec_cfg.h"
+
+/*
+ * Feed a buffer backed packet with two h264 IDR frames to decoder with
+ * base:zero_copy_pkt on the null device (mpp_null_dev=1). The decoder holds
+ * the packet while it waits for info change ready after the first frame, so
+ * the buffer reference taken by decode_put_packet is checked there. Then the
+ * reference must be dropped after the packet is consumed while the group
+ * usage shows no extra buffer was allocated for the packet.
+ */
+#define PIC_MBS             4
+#define SLICE_DATA_SIZE     256
+#define WAIT_TIMEOUT_MS     2000
+
+typedef struct BitWriter_t {
+    RK_U8   *buf;
+    RK_S32  size;
+    RK_U64  val;
+    RK_S32  bits;
+} BitWriter;
+
+static void bw_put(BitWriter *bw, RK_S32 n, RK_U32 v)
+{
+    bw->val = (bw->val << n) | (v & ((1ULL << n) - 1));
+    bw->bits += n;
+    while (bw->bits >= 8) {
+        bw->bits -= 8;
+        bw->buf[bw->size++] = (RK_U8)(bw->val >> bw->bits);
+    }
+}
+
+static void bw_ue(BitWriter *bw, RK_U32 v)
+{
+    RK_S32 len = 32 - __builtin_clz(v + 1);
+
+    bw_put(bw, len - 1, 0);
+    bw_put(bw, len, v + 1);
+}
+
+static void bw_trailing(BitWriter *bw)
+{
+    bw_put(bw, 1, 1);
+    if (bw->bits)
+        bw_put(bw, 8 - bw->bits, 0);
+}
+
+/* write start code and nal with emulation prevention */
+static RK_S32 write_nal(RK_U8 *dst, RK_U8 header, const RK_U8 *rbsp, RK_S32 size)
+{
+    RK_S32 zeros = 0;
+    RK_S32 len = 0;
+    RK_S32 i;
+
+    dst[len++] = 0;
+    dst[len++] = 0;
+    dst[len++] = 0;
+    dst[len++] = 1;
+    dst[len++] = header;
+
+    for (i = 0; i < size; i++) {
+        if (zeros == 2 && rbsp[i] <= 3) {
+            dst[len++] = 3;
+            zeros = 0;
+        }
+        dst[len++] = rbsp[i];
+        zeros = rbsp[i] ? 0 : zeros + 1;
+    }
+
+    return len;
+}
+
+static RK_S32 write_sps(RK_U8 *dst, RK_U8 *tmp)
+{
+    BitWriter bw = { tmp, 0, 0, 0 };
+
+    bw_put(&bw, 8, 66);         /* baseline profile */
+    bw_put(&bw, 8, 0);          /* constraint_set_flags */
+    bw_put(&bw, 8, 40);         /* level 4.0 */
+    bw_ue(&bw, 0);              /* seq_parameter_set_id */
+    bw_ue(&bw, 0);              /* log2_max_frame_num_minus4 */
+    bw_ue(&bw, 2);              /* pic_order_cnt_type */
+    bw_ue(&bw, 1);              /* max_num_ref_frames */
+    bw_put(&bw, 1, 0);          /* gaps_in_frame_num_value_allowed_flag */
+    bw_ue(&bw, PIC_MBS - 1);    /* pic_width_in_mbs_minus1 */
+    bw_ue(&bw, PIC_MBS - 1);    /* pic_height_in_map_units_minus1 */
+    bw_put(&bw, 1, 1);          /* frame_mbs_only_flag */
+    bw_put(&bw, 1, 1);          /* direct_8x8_inference_flag */
+    bw_put(&bw, 1, 0);          /* frame_cropping_flag */
+    bw_put(&bw, 1, 0);          /* vui_parameters_present_flag */
+    bw_trailing(&bw);
+
+    return write_nal(dst, 0x67, tmp, bw.size);
+}
+
+static RK_S32 write_pps(RK_U8 *dst, RK_U8 *tmp)
+{
+    BitWriter bw = { tmp, 0, 0, 0 };
+
+    bw_ue(&bw, 0);              /* pic_parameter_set_id */
+    bw_ue(&bw, 0);              /* seq_parameter_set_id */
+    bw_put(&bw, 1, 0);          /* entropy_coding_mode_flag */
+    bw_put(&bw, 1, 0);          /* bottom_field_pic_order_in_frame_present_flag */
+    bw_ue(&bw, 0);              /* num_slice_groups_minus1 */
+    bw_ue(&bw, 0);              /* num_ref_idx_l0_default_active_minus1 */
+    bw_ue(&bw, 0);              /* num_ref_idx_l1_default_active_minus1 */
+    bw_put(&bw, 1, 0);          /* weighted_pred_flag */
+    bw_put(&bw, 2, 0);          /* weighted_bipred_idc */
+    bw_ue(&bw, 0);              /* pic_init_qp_minus26 */
+    bw_ue(&bw, 0);              /* pic_init_qs_minus26 */
+    bw_ue(&bw, 0);              /* chroma_qp_index_offset */
+    bw_put(&bw, 1, 1);          /* deblocking_filter_control_present_flag */
+    bw_put(&bw, 1, 0);          /* constrained_intra_pred_flag */
+    bw_put(&bw, 1, 0);          /* redundant_pic_cnt_present_flag */
+    bw_trailing(&bw);
+
+    return write_nal(dst, 0x68, tmp, bw.size);
+}
+
+/* IDR frame with one I slice, the slice data is filler for null device */
+static RK_S32 write_idr(RK_U8 *dst, RK_U8 *tmp, RK_U32 idr_pic_id)
+{
+    BitWriter bw = { tmp, 0, 0, 0 };
+
+    bw_ue(&bw, 0);              /* first_mb_in_slice */
+    bw_ue(&bw, 7);              /* I slice */
+    bw_ue(&bw, 0);              /* pic_parameter_set_id */
+    bw_put(&bw, 4, 0);          /* frame_num */
+    bw_ue(&bw, idr_pic_id);
+    bw_put(&bw, 1, 0);          /* no_output_of_prior_pics_flag */
+    bw_put(&bw, 1, 0);          /* long_term_reference_flag */
+    bw_ue(&bw, 0);              /* slice_qp_delta */
+    bw_ue(&bw, 1);              /* disable_deblocking_filter_idc */
+    bw_trailing(&bw);
+
+    memset(tmp + bw.size, 0x55, SLICE_DATA_SIZE);
+    bw.size += SLICE_DATA_SIZE;
+    tmp[bw.size++] = 0x80;
+
+    return write_nal(dst, 0x65, tmp, bw.size);
+}
+
+static RK_S32 wait_ref_count(MppBufferImpl *impl, RK_S32 ref_count)
+{
+    RK_S32 i;
+
+    for (i = 0; i < WAIT_TIMEOUT_MS && impl->ref_count != ref_count; i++)
+        msleep(1);
+
+    return impl->ref_count;
+}
+
+int main()
+{
+    MppCtx ctx = NULL;
+    MppApi *mpi = NULL;
+    MppDecCfg cfg = NULL;
+    MppBufferGroup pkt_grp = NULL;
+    MppBufferGroup frm_grp = NULL;
+    MppBuffer buf = NULL;
+    MppBufferImpl *impl;
+    MppPacket packet = NULL;
+    RK_U8 tmp[SLICE_DATA_SIZE + 64];
+    RK_U8 *data;
+    RK_S32 size = 0;
+    RK_S32 frame_cnt = 0;
+    RK_S32 ref_count;
+    RK_U32 info_change = 0;
+    RK_U32 frm_eos = 0;
+    size_t usage;
+    RK_S32 i;
+    MPP_RET ret = MPP_NOK;
+
+    mpp_log("mpp_dec_zc_test start\n");
+
+    setenv("mpp_null_dev", "1", 0);
+    setenv("mpp_soc_name", "rk3588", 0);
+
+    mpp_buffer_group_get_internal(&pkt_grp, MPP_BUFFER_TYPE_ION);
+    if (!pkt_grp || mpp_buffer_get(pkt_grp, &buf, SZ_4K)) {
+        mpp_err("failed to get packet buffer\n");
+        goto DONE;
+    }
+
+    data = (RK_U8 *)mpp_buffer_get_ptr(buf);
+    size += write_sps(data + size, tmp);
+    size += write_pps(data + size, tmp);
+    size += write_idr(data + size, tmp, 0);
+    size += write_idr(data + size, tmp, 1);
+
+    impl = (MppBufferImpl *)buf;
+    usage = mpp_buffer_group_usage(pkt_grp);
+
+    ret = mpp_create(&ctx, &mpi);
+    if (ret)
+        goto DONE;
+
+    ret = mpp_init(ctx, MPP_CTX_DEC, MPP_VIDEO_CodingAVC);
+    if (ret)
+        goto DONE;
+
+    mpp_dec_cfg_init(&cfg);
+    mpi->control(ctx, MPP_DEC_GET_CFG, cfg);
+    mpp_dec_cfg_set_u32(cfg, "base:split_parse", 1);
+    mpp_dec_cfg_set_u32(cfg, "base:zero_copy_pkt", 1);
+    ret = mpi->control(ctx, MPP_DEC_SET_CFG, cfg);
+    if (ret) {
+        mpp_err("failed to set zero copy config ret %d\n", ret);
+        goto DONE;
+    }
+
+    mpp_packet_init_with_buffer(&packet, buf);
+    mpp_packet_set_length(packet, size);
+
+    ret = mpi->decode_put_packet(ctx, packet);
+    mpp_packet_deinit(&packet);
+    if (ret) {
+        mpp_err("failed to put zero copy packet ret %d\n", ret);
+        goto DONE;
+    }
+
+    /* test and decoder reference */
+    ref_count = impl->ref_count;
+    if (ref_count != 2) {
+        mpp_err("packet buffer ref_count %d after put expect 2\n", ref_count);
+        ret = MPP_NOK;
+        goto DONE;
+    }
+
+    mpp_packet_init(&packet, NULL, 0);
+    mpp_packet_set_eos(packet);
+
+    for (i = 0; i < WAIT_TIMEOUT_MS && !frm_eos; i++) {
+        MppFrame frame = NULL;
+
+        if (info_change && packet && !mpi->decode_put_packet(ctx, packet))
+            mpp_packet_deinit(&packet);
+
+        mpi->decode_get_frame(ctx, &frame);
+        if (!frame) {
+            msleep(1);
+            continue;
+        }
+
+        if (mpp_frame_get_info_change(frame)) {
+            /* the second frame is still in the packet held by decoder */
+            ref_count = impl->ref_count;
+            if (ref_count != 2) {
+                mpp_err("packet buffer ref_count %d on info change expect 2\n", ref_count);
+                mpp_frame_deinit(&frame);
+                ret = MPP_NOK;
+                goto DONE;
+            }
+
+            mpp_buffer_group_get_internal(&frm_grp, MPP_BUFFER_TYPE_ION);
+            mpi->control(ctx, MPP_DEC_SET_EXT_BUF_GROUP, frm_grp);
+            mpi->control(ctx, MPP_DEC_SET_INFO_CHANGE_READY, NULL);
+            info_change = 1;
+        } else if (mpp_frame_get_buffer(frame)) {
+            frame_cnt++;
+        }
+
+        frm_eos = mpp_frame_get_eos(frame);
+        mpp_frame_deinit(&frame);
+    }
+
+    ref_count = wait_ref_count(impl, 1);
+    mpp_log("decoded %d frames packet buffer ref_count %d usage %d -> %d\n",
+            frame_cnt, ref_count, usage, mpp_buffer_group_usage(pkt_grp));
+
+    if (!info_change || frame_cnt != 2 || ref_count != 1 ||
+        mpp_buffer_group_usage(pkt_grp) != usage) {
+        mpp_err("zero copy packet check failed\n");
+        ret = MPP_NOK;
+        goto DONE;
+    }
+
+    ret = MPP_OK;
+
+DONE:
+    if (packet)
+        mpp_packet_deinit(&packet);
+    if (ctx)
+        mpp_destroy(ctx);
+    if (cfg)
+        mpp_dec_cfg_deinit(cfg);
+    if (buf)
+        mpp_buffer_put(buf);
+    if (pkt_grp)
+        mpp_buffer_group_put(pkt_grp);
+    if (frm_grp)
+        mpp_buffer_group_put(frm_grp);
+
+    mpp_log("mpp_dec_zc_test %s\n", ret ? "failed" : "success");
+
+    return ret;
+}
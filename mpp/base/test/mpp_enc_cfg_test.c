@@ -16,6 +16,8 @@
 
 #define MODULE_TAG "mpp_enc_cfg_test"
 
+#include <string.h>
+
 #include "mpp_log.h"
 #include "mpp_mem.h"
 #include "mpp_time.h"
@@ -23,6 +25,106 @@
 
 #include "rk_venc_cfg.h"
 #include "mpp_enc_cfg_impl.h"
+#include "mpp_enc.h"
+
+#define BENCH_FRAMES    100000
+
+/* per frame abr ladder update: bitrate and qp bounds */
+static const char *bench_names[] = {
+    "rc:bps_target",
+    "rc:bps_max",
+    "rc:bps_min",
+    "rc:qp_min",
+    "rc:qp_max",
+};
+
+static void bench_val(RK_S32 frm, RK_S32 *val)
+{
+    RK_S32 bps = 1000000 + (frm % 16) * 100000;
+
+    val[0] = bps;
+    val[1] = bps * 5 / 4;
+    val[2] = bps * 3 / 4;
+    val[3] = 10 + (frm % 4);
+    val[4] = 44 + (frm % 4);
+}
+
+static MPP_RET bench_cfg(MppEncCfg cfg_str, MppEncCfg cfg_hnd)
+{
+    MppEncCfgImpl *impl_str = (MppEncCfgImpl *)cfg_str;
+    MppEncCfgImpl *impl_hnd = (MppEncCfgImpl *)cfg_hnd;
+    RK_S32 cnt = MPP_ARRAY_ELEMS(bench_names);
+    RK_S32 hnd[MPP_ARRAY_ELEMS(bench_names)];
+    RK_S32 val[MPP_ARRAY_ELEMS(bench_names)];
+    MppEncRcCfg rc;
+    RK_S64 time_str = 0;
+    RK_S64 time_hnd = 0;
+    RK_S64 time_apply = 0;
+    RK_S64 start;
+    RK_S32 i, j;
+
+    for (j = 0; j < cnt; j++) {
+        if (mpp_enc_cfg_get_hnd(bench_names[j], &hnd[j]))
+            return MPP_NOK;
+    }
+
+    /* both path should give the same config and change flag */
+    for (i = 0; i < 64; i++) {
+        bench_val(i, val);
+        for (j = 0; j < cnt; j++) {
+            mpp_enc_cfg_set_s32(cfg_str, bench_names[j], val[j]);
+            mpp_enc_cfg_set_s32_hnd(cfg_hnd, hnd[j], val[j]);
+        }
+        if (memcmp(&impl_str->cfg, &impl_hnd->cfg, sizeof(impl_str->cfg))) {
+            mpp_err("frame %d handle set mismatch\n", i);
+            return MPP_NOK;
+        }
+    }
+
+    for (i = 0; i < BENCH_FRAMES; i++) {
+        bench_val(i, val);
+        start = mpp_time();
+        for (j = 0; j < cnt; j++)
+            mpp_enc_cfg_set_s32(cfg_str, bench_names[j], val[j]);
+        time_str += mpp_time() - start;
+
+        start = mpp_time();
+        for (j = 0; j < cnt; j++)
+            mpp_enc_cfg_set_s32_hnd(cfg_hnd, hnd[j], val[j]);
+        time_hnd += mpp_time() - start;
+    }
+
+    /* qp bound only update applies without bitrate check and log */
+    memset(&rc, 0, sizeof(rc));
+    rc.rc_mode = MPP_ENC_RC_MODE_CBR;
+    rc.bps_target = 1000000;
+    rc.bps_max = 1250000;
+    rc.bps_min = 750000;
+    rc.fps_in_num = 30;
+    rc.fps_in_denom = 1;
+    rc.fps_out_num = 30;
+    rc.fps_out_denom = 1;
+    rc.qp_min = 10;
+    rc.qp_max = 44;
+
+    for (i = 0; i < BENCH_FRAMES; i++) {
+        bench_val(i, val);
+        impl_hnd->cfg.rc.change = 0;
+        mpp_enc_cfg_set_s32_hnd(cfg_hnd, hnd[3], val[3]);
+        mpp_enc_cfg_set_s32_hnd(cfg_hnd, hnd[4], val[4]);
+
+        start = mpp_time();
+        if (mpp_enc_proc_rc_cfg(MPP_VIDEO_CodingAVC, &rc, &impl_hnd->cfg.rc))
+            return MPP_NOK;
+        time_apply += mpp_time() - start;
+    }
+
+    mpp_log("set %d cfg per frame by name   %.3f us\n", cnt, (float)time_str / BENCH_FRAMES);
+    mpp_log("set %d cfg per frame by handle %.3f us\n", cnt, (float)time_hnd / BENCH_FRAMES);
+    mpp_log("apply qp range change per frame %.3f us\n", (float)time_apply / BENCH_FRAMES);
+
+    return MPP_OK;
+}
 
 int main()
 {
@@ -103,6 +205,17 @@ int main()
         goto DONE;
     }
 
+    MppEncCfg cfg_str = NULL;
+    MppEncCfg cfg_hnd = NULL;
+
+    mpp_enc_cfg_init(&cfg_str);
+    mpp_enc_cfg_init(&cfg_hnd);
+    ret = (cfg_str && cfg_hnd) ? bench_cfg(cfg_str, cfg_hnd) : MPP_ERR_NOMEM;
+    mpp_enc_cfg_deinit(cfg_str);
+    mpp_enc_cfg_deinit(cfg_hnd);
+    if (ret)
+        mpp_err("handle benchmark failed\n");
+
 DONE:
     mpp_log("mpp_enc_cfg_test done %s\n", ret ? "failed" : "success");
     return ret;
@@ -24,6 +24,82 @@
 
 #define TEST_MAX    200
 #define LOOP_MAX    100000
+#define BENCH_MAX   1000000
+
+static const MppMetaKey bench_keys[] = {
+    KEY_ENC_AVERAGE_QP,     KEY_ENC_START_QP,       KEY_ENC_FRAME_QP,
+    KEY_LVL64_INTER_NUM,    KEY_LVL32_INTER_NUM,    KEY_LVL16_INTER_NUM,
+    KEY_LVL8_INTER_NUM,     KEY_LVL32_INTRA_NUM,    KEY_LVL16_INTRA_NUM,
+    KEY_LVL8_INTRA_NUM,     KEY_LVL4_INTRA_NUM,     KEY_OUTPUT_PSKIP,
+    KEY_DEC_TBN_UV_OFFSET,  KEY_OUTPUT_INTRA,
+};
+
+/* single thread check and per-frame encoder style meta usage benchmark */
+static MPP_RET meta_bench(void)
+{
+    RK_S32 key_cnt = MPP_ARRAY_ELEMS(bench_keys);
+    MppMeta meta = NULL;
+    MPP_RET ret = MPP_OK;
+    RK_S64 time_start;
+    RK_S64 time_end;
+    RK_S64 sse = 0;
+    void *ptr = NULL;
+    RK_S32 val = 0;
+    RK_S32 i, j;
+
+    /* value round trip and key / type mismatch check */
+    mpp_meta_get(&meta);
+    if (!meta)
+        return MPP_NOK;
+
+    if (mpp_meta_set_s32(meta, KEY_ENC_SSE, 1) == MPP_OK ||
+        mpp_meta_set_s32(meta, KEY_INPUT_IDR_REQ, 1) == MPP_OK) {
+        mpp_err("invalid key / type pair accepted\n");
+        ret = MPP_NOK;
+    }
+
+    mpp_meta_set_s64(meta, KEY_ENC_SSE, 0x123456789ll);
+    mpp_meta_set_ptr(meta, KEY_ROI_DATA, meta);
+    mpp_meta_set_s32(meta, KEY_DEC_TBN_UV_OFFSET, 7);
+    if (mpp_meta_size(meta) != 3)
+        ret = MPP_NOK;
+
+    mpp_meta_dump(meta);
+
+    if (mpp_meta_get_s64(meta, KEY_ENC_SSE, &sse) || sse != 0x123456789ll ||
+        mpp_meta_get_ptr(meta, KEY_ROI_DATA, &ptr) || ptr != meta ||
+        mpp_meta_get_s32(meta, KEY_DEC_TBN_UV_OFFSET, &val) || val != 7 ||
+        mpp_meta_get_s32(meta, KEY_DEC_TBN_UV_OFFSET, &val) == MPP_OK ||
+        mpp_meta_size(meta)) {
+        mpp_err("meta value round trip failed\n");
+        ret = MPP_NOK;
+    }
+    mpp_meta_put(meta);
+
+    time_start = mpp_time();
+
+    for (i = 0; i < BENCH_MAX; i++) {
+        mpp_meta_get(&meta);
+
+        for (j = 0; j < key_cnt; j++)
+            mpp_meta_set_s32(meta, bench_keys[j], i + j);
+
+        for (j = 0; j < key_cnt; j++) {
+            if (mpp_meta_get_s32(meta, bench_keys[j], &val) || val != i + j)
+                ret = MPP_NOK;
+        }
+
+        mpp_meta_put(meta);
+    }
+
+    time_end = mpp_time();
+
+    mpp_log("mpp_meta_test bench %d meta with %d set/get each %.1f ns per meta %.1f ns per key\n",
+            BENCH_MAX, key_cnt, (time_end - time_start) * 1000.0 / BENCH_MAX,
+            (time_end - time_start) * 1000.0 / BENCH_MAX / (key_cnt * 2));
+
+    return ret;
+}
 
 void *meta_test(void *param)
 {
@@ -135,6 +211,11 @@ int main()
 
     mpp_log("mpp_meta_test start\n");
 
+    if (meta_bench()) {
+        mpp_err("mpp_meta_test bench failed\n");
+        return -1;
+    }
+
     for (i = 0; i < thd_cnt; i++)
         pthread_create(&thds[i], &attr, meta_test, &times[i]);
 
@@ -0,0 +1,172 @@
+/* SPDX-License-Identifier: Apache-2.0 OR MIT */
+/*
+ * Copyright (c) 2024 Rockchip Electronics Co., Ltd.
+ */
+
+#define MODULE_TAG "mpp_startcode_test"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "mpp_mem.h"
+#include "mpp_log.h"
+#include "mpp_time.h"
+#include "mpp_common.h"
+#include "mpp_startcode.h"
+
+#define CHECK_BUF_SIZE      (256)
+#define CHECK_LOOP          (2000)
+#define BENCH_BUF_SIZE      (SZ_32M)
+#define BENCH_LOOP          (4)
+
+typedef RK_S32 (*FindFunc)(const RK_U8 *buf, RK_S32 size);
+
+/* random payload with sparse zero runs and start codes like real bitstream */
+static void fill_stream(RK_U8 *buf, RK_S32 size, RK_S32 nal_gap)
+{
+    RK_S32 i;
+
+    for (i = 0; i < size; i++) {
+        RK_S32 r = rand();
+
+        buf[i] = (r & 0xff) ? (r >> 8) & 0xff : 0;
+    }
+
+    for (i = 0; i + 4 < size; i += nal_gap + rand() % (nal_gap + 1)) {
+        buf[i] = 0;
+        buf[i + 1] = 0;
+        buf[i + 2] = 1;
+        buf[i + 3] = rand() & 0x7f;
+    }
+}
+
+static MPP_RET check_match(void)
+{
+    RK_U8 buf[CHECK_BUF_SIZE];
+    RK_S32 loop;
+
+    for (loop = 0; loop < CHECK_LOOP; loop++) {
+        RK_S32 size = rand() % CHECK_BUF_SIZE;
+        RK_S32 start;
+
+        fill_stream(buf, size, 1 + rand() % 64);
+        /* dense zero area to stress the partial prefix cases */
+        if (loop & 1)
+            memset(buf + size / 3, 0, size / 4);
+
+        for (start = 0; start <= size; start++) {
+            RK_S32 ref = mpp_find_startcode_c(buf + start, size - start);
+            RK_S32 val = mpp_find_startcode(buf + start, size - start);
+
+            if (ref != val) {
+                mpp_err("mismatch size %d start %d ref %d val %d\n",
+                        size, start, ref, val);
+                return MPP_NOK;
+            }
+        }
+    }
+
+    return MPP_OK;
+}
+
+static RK_S64 bench_scan(FindFunc func, const RK_U8 *buf, RK_S32 size, RK_S32 *count)
+{
+    RK_S64 start = mpp_time();
+    RK_S32 nal_cnt = 0;
+    RK_S32 loop;
+
+    for (loop = 0; loop < BENCH_LOOP; loop++) {
+        RK_S32 pos = 0;
+
+        nal_cnt = 0;
+        while (pos < size) {
+            pos += func(buf + pos, size - pos) + 3;
+            nal_cnt++;
+        }
+    }
+
+    *count = nal_cnt;
+
+    return mpp_time() - start;
+}
+
+static RK_U8 *load_file(const char *name, RK_S32 *size)
+{
+    FILE *fp = fopen(name, "rb");
+    RK_U8 *buf = NULL;
+    long len;
+
+    if (!fp) {
+        mpp_err("failed to open %s\n", name);
+        return NULL;
+    }
+
+    fseek(fp, 0, SEEK_END);
+    len = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+
+    buf = mpp_malloc(RK_U8, len);
+    if (buf && fread(buf, 1, len, fp) != (size_t)len) {
+        MPP_FREE(buf);
+        len = 0;
+    }
+
+    fclose(fp);
+    *size = (RK_S32)len;
+
+    return buf;
+}
+
+int main(int argc, char **argv)
+{
+    RK_U8 *buf = NULL;
+    RK_S32 size = BENCH_BUF_SIZE;
+    RK_S32 cnt_c = 0;
+    RK_S32 cnt_v = 0;
+    RK_S64 time_c;
+    RK_S64 time_v;
+
+    mpp_log("mpp_startcode_test start\n");
+
+    if (check_match()) {
+        mpp_err("mpp_startcode_test check failed\n");
+        return -1;
+    }
+    mpp_log("mpp_startcode_test check success\n");
+
+    /* benchmark over bitstream file from argv[1] or synthetic stream */
+    if (argc > 1) {
+        buf = load_file(argv[1], &size);
+    } else {
+        buf = mpp_malloc(RK_U8, size);
+        if (buf)
+            fill_stream(buf, size, SZ_16K);
+    }
+
+    if (!buf || !size) {
+        MPP_FREE(buf);
+        mpp_err("mpp_startcode_test no benchmark input\n");
+        return -1;
+    }
+
+    time_c = bench_scan(mpp_find_startcode_c, buf, size, &cnt_c);
+    time_v = bench_scan(mpp_find_startcode, buf, size, &cnt_v);
+
+    mpp_log("scan %d bytes %d nal x %d loop\n", size, cnt_c, BENCH_LOOP);
+    mpp_log("byte loop %8lld us %8.2f MB/s\n", time_c,
+            (double)size * BENCH_LOOP / MPP_MAX(time_c, 1));
+    mpp_log("scanner   %8lld us %8.2f MB/s\n", time_v,
+            (double)size * BENCH_LOOP / MPP_MAX(time_v, 1));
+
+    MPP_FREE(buf);
+
+    if (cnt_c != cnt_v) {
+        mpp_err("mpp_startcode_test nal count mismatch %d vs %d\n", cnt_c, cnt_v);
+        return -1;
+    }
+
+    mpp_log("mpp_startcode_test done\n");
+
+    return 0;
+}
@@ -47,6 +47,7 @@ extern const RK_S8 av1hwd_partition_tree[];
 void Av1EntropyModeInit(void);
 void AV1SetDefaultCDFs(AV1CDFs *cdfs, MvCDFs *cdfs_ndvc);
 void Av1DefaultCoeffProbs(RK_U32 base_qindex, void *ptr);
+int get_q_ctx(int q);
 struct AV1Common;
 
 // void Av1InitMbmodeProbs(struct Av1Decoder *x);
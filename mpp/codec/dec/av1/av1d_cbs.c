@@ -2048,9 +2048,7 @@ static RK_S32 mpp_av1_uncompressed_header(AV1Context *ctx, BitReadCtx_t *gb,
     if (current->error_resilient_mode || frame_is_intra || current->primary_ref_frame == AV1_PRIMARY_REF_NONE) {
         // Init non-coeff CDFs.
         // Setup past independence.
-        ctx->cdfs = &ctx->default_cdfs;
-        ctx->cdfs_ndvc = &ctx->default_cdfs_ndvc;
-        Av1DefaultCoeffProbs(current->base_q_idx, ctx->cdfs);
+        CHECK(Av1GetDefaultCDFs(ctx, current->base_q_idx));
     } else {
         // Load CDF tables from previous frame.
         // Load params from previous frame.
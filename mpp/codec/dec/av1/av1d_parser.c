@@ -878,9 +878,8 @@ MPP_RET av1d_parser_init(Av1CodecContext *ctx, ParserCfg *init)
         mpp_err("Failed to allocate frame buffer %d\n", i);
         return MPP_ERR_NOMEM;
     }
-    s->cdfs = &s->default_cdfs;
-    s->cdfs_ndvc = &s->default_cdfs_ndvc;
-    AV1SetDefaultCDFs(s->cdfs, s->cdfs_ndvc);
+    if (Av1InitCDFStore(s))
+        return MPP_ERR_NOMEM;
 
     return MPP_OK;
 
@@ -908,6 +907,8 @@ MPP_RET av1d_parser_deinit(Av1CodecContext *ctx)
     mpp_frame_deinit(&s->cur_frame.f);
 
     mpp_av1_fragment_reset(&s->current_obu);
+    av1d_dbg(AV1D_DBG_REF, "cdf copy count %d\n", s->cdf_copy_cnt);
+    Av1DeinitCDFStore(s);
     MPP_FREE(s->seq_ref);
     MPP_FREE((s->hdr_dynamic_meta));
     MPP_FREE(ctx->priv_data);
@@ -1127,8 +1128,10 @@ void av1d_parser_update(Av1CodecContext *ctx, void *info)
     if (!c_ctx->disable_frame_end_update_cdf) {
         for (i = 0; i < NUM_REF_FRAMES; i++) {
             if (c_ctx->refresh_frame_flags & (1 << i)) {
-                /* 1. get cdfs */
+                /* 1. get cdfs and detach it from slots not refreshed */
                 Av1GetCDFs(c_ctx, i);
+                if (Av1UpdateCDFs(c_ctx, c_ctx->refresh_frame_flags))
+                    break;
                 {
                     RK_U8 *cdf_base = (RK_U8 *)c_ctx->cdfs;
                     RK_U8 *cdf_ndvc_base = (RK_U8 *)c_ctx->cdfs_ndvc;
@@ -1143,8 +1146,7 @@ void av1d_parser_update(Av1CodecContext *ctx, void *info)
                         memcpy(cdf_base, data, cdf_size);
                     }
                 }
-                /* 3. store cdfs*/
-                Av1StoreCDFs(c_ctx, c_ctx->refresh_frame_flags);
+                /* 3. refresh slots share the cdfs stored in step 1 */
                 break;
             }
         }
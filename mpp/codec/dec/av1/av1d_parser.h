@@ -43,6 +43,18 @@ extern RK_U32 av1d_debug;
 #define av1d_dbg(flag, fmt, ...) _mpp_dbg_f(av1d_debug, flag, fmt, ##__VA_ARGS__)
 #define av1d_dbg_func(fmt, ...)  av1d_dbg(AV1D_DBG_FUNCTION, fmt, ## __VA_ARGS__)
 
+/*
+ * CDF set shared by reference slots. Slots refreshed by one frame point to
+ * the same buffer and a private copy is only made when the hardware writes
+ * back adapted CDFs to a buffer still used by others.
+ */
+typedef struct Av1CdfBuf_t {
+    AV1CDFs     cdfs;
+    MvCDFs      cdfs_ndvc;
+    RK_S32      ref_count;
+    struct Av1CdfBuf_t *next;
+} Av1CdfBuf;
+
 typedef struct RefInfo {
     RK_S32 ref_count;
     RK_U32 invisible;
@@ -126,10 +138,13 @@ typedef struct AV1Context_t {
 
     AV1CDFs *cdfs;
     MvCDFs  *cdfs_ndvc;
-    AV1CDFs default_cdfs;
-    MvCDFs  default_cdfs_ndvc;
-    AV1CDFs cdfs_last[NUM_REF_FRAMES];
-    MvCDFs  cdfs_last_ndvc[NUM_REF_FRAMES];
+    Av1CdfBuf *cdf_cur;
+    Av1CdfBuf *cdf_last[NUM_REF_FRAMES];
+    /* default tables for each coeff q context, built on first use */
+    Av1CdfBuf *cdf_default[TOKEN_CDF_Q_CTXS];
+    Av1CdfBuf *cdf_free;
+    /* number of cdf buffer copied on write back */
+    RK_U32 cdf_copy_cnt;
     RK_U8 disable_frame_end_update_cdf;
     RK_U8 frame_is_intra;
     RK_U8 refresh_frame_flags;
@@ -188,8 +203,12 @@ void mpp_av1_flush(AV1Context *ctx);
 void mpp_av1_close(AV1Context *ctx);
 void mpp_av1_free_metadata(void *unit, RK_U8 *content);
 
+MPP_RET Av1InitCDFStore(AV1Context *ctx);
+void Av1DeinitCDFStore(AV1Context *ctx);
+MPP_RET Av1GetDefaultCDFs(AV1Context *ctx, RK_U32 base_qindex);
 void Av1GetCDFs(AV1Context *ctx, RK_U32 ref_idx);
 void Av1StoreCDFs(AV1Context *ctx, RK_U32 refresh_frame_flags);
+MPP_RET Av1UpdateCDFs(AV1Context *ctx, RK_U32 refresh_frame_flags);
 
 #ifdef  __cplusplus
 }
@@ -13,26 +13,169 @@
  * See the License for the specific language governing permissions and
  * limitations under the License.
  */
+#include <string.h>
+
+#include "mpp_debug.h"
+
 #include "av1d_parser.h"
 #include "av1d_common.h"
 
+static Av1CdfBuf *cdf_buf_get(AV1Context *ctx)
+{
+    Av1CdfBuf *buf = ctx->cdf_free;
+
+    if (buf)
+        ctx->cdf_free = buf->next;
+    else
+        buf = mpp_malloc(Av1CdfBuf, 1);
+
+    if (buf) {
+        buf->ref_count = 1;
+        buf->next = NULL;
+    }
+
+    return buf;
+}
+
+static void cdf_buf_put(AV1Context *ctx, Av1CdfBuf *buf)
+{
+    if (!buf)
+        return;
+
+    mpp_assert(buf->ref_count > 0);
+    if (--buf->ref_count)
+        return;
+
+    buf->next = ctx->cdf_free;
+    ctx->cdf_free = buf;
+}
+
+static void cdf_set_cur(AV1Context *ctx, Av1CdfBuf *buf)
+{
+    buf->ref_count++;
+    cdf_buf_put(ctx, ctx->cdf_cur);
+
+    ctx->cdf_cur = buf;
+    ctx->cdfs = &buf->cdfs;
+    ctx->cdfs_ndvc = &buf->cdfs_ndvc;
+}
+
+MPP_RET Av1InitCDFStore(AV1Context *ctx)
+{
+    return Av1GetDefaultCDFs(ctx, 0);
+}
+
+void Av1DeinitCDFStore(AV1Context *ctx)
+{
+    Av1CdfBuf *buf;
+    RK_U32 i;
+
+    cdf_buf_put(ctx, ctx->cdf_cur);
+    ctx->cdf_cur = NULL;
+    ctx->cdfs = NULL;
+    ctx->cdfs_ndvc = NULL;
+
+    for (i = 0; i < NUM_REF_FRAMES; i++) {
+        cdf_buf_put(ctx, ctx->cdf_last[i]);
+        ctx->cdf_last[i] = NULL;
+    }
+
+    for (i = 0; i < TOKEN_CDF_Q_CTXS; i++) {
+        cdf_buf_put(ctx, ctx->cdf_default[i]);
+        ctx->cdf_default[i] = NULL;
+    }
+
+    while ((buf = ctx->cdf_free)) {
+        ctx->cdf_free = buf->next;
+        mpp_free(buf);
+    }
+}
+
+MPP_RET Av1GetDefaultCDFs(AV1Context *ctx, RK_U32 base_qindex)
+{
+    RK_S32 idx = get_q_ctx(base_qindex);
+    Av1CdfBuf *buf = ctx->cdf_default[idx];
+
+    if (!buf) {
+        buf = cdf_buf_get(ctx);
+        if (!buf) {
+            mpp_err_f("failed to malloc cdf buffer\n");
+            return MPP_ERR_NOMEM;
+        }
+
+        /* the whole table goes to hardware, keep the unset part zero */
+        memset(&buf->cdfs, 0, sizeof(buf->cdfs));
+        memset(&buf->cdfs_ndvc, 0, sizeof(buf->cdfs_ndvc));
+        AV1SetDefaultCDFs(&buf->cdfs, &buf->cdfs_ndvc);
+        Av1DefaultCoeffProbs(base_qindex, &buf->cdfs);
+        /* the default array holds one reference so it is never written */
+        ctx->cdf_default[idx] = buf;
+    }
+
+    cdf_set_cur(ctx, buf);
+
+    return MPP_OK;
+}
+
 void Av1GetCDFs(AV1Context *ctx, RK_U32 ref_idx)
 {
+    Av1CdfBuf *buf = ctx->cdf_last[ref_idx];
 
-    ctx->cdfs = &ctx->cdfs_last[ref_idx];
-    ctx->cdfs_ndvc = &ctx->cdfs_last_ndvc[ref_idx];
+    if (!buf) {
+        mpp_err_f("cdf of ref %d is not stored, use default\n", ref_idx);
+        Av1GetDefaultCDFs(ctx, 0);
+        return;
+    }
+
+    cdf_set_cur(ctx, buf);
 }
 
 void Av1StoreCDFs(AV1Context *ctx, RK_U32 refresh_frame_flags)
 {
+    Av1CdfBuf *cur = ctx->cdf_cur;
+    RK_U32 i;
+
+    for (i = 0; i < NUM_REF_FRAMES; i++) {
+        if ((refresh_frame_flags & (1 << i)) && ctx->cdf_last[i] != cur) {
+            cur->ref_count++;
+            cdf_buf_put(ctx, ctx->cdf_last[i]);
+            ctx->cdf_last[i] = cur;
+        }
+    }
+}
+
+/*
+ * Make current cdf writable for the adapted cdf of current frame and store
+ * it to refresh slots. The buffer is copied only when it is still used by
+ * other slots or it is a default table.
+ */
+MPP_RET Av1UpdateCDFs(AV1Context *ctx, RK_U32 refresh_frame_flags)
+{
+    Av1CdfBuf *cur = ctx->cdf_cur;
+    RK_S32 users = 1;
     RK_U32 i;
 
     for (i = 0; i < NUM_REF_FRAMES; i++) {
-        if (refresh_frame_flags & (1 << i)) {
-            if (&ctx->cdfs_last[i] != ctx->cdfs) {
-                ctx->cdfs_last[i] = *ctx->cdfs;
-                ctx->cdfs_last_ndvc[i] = *ctx->cdfs_ndvc;
-            }
+        if ((refresh_frame_flags & (1 << i)) && ctx->cdf_last[i] == cur)
+            users++;
+    }
+
+    if (cur->ref_count > users) {
+        Av1CdfBuf *buf = cdf_buf_get(ctx);
+
+        if (!buf) {
+            mpp_err_f("failed to malloc cdf buffer\n");
+            return MPP_ERR_NOMEM;
         }
+
+        buf->cdfs = cur->cdfs;
+        buf->cdfs_ndvc = cur->cdfs_ndvc;
+        cdf_set_cur(ctx, buf);
+        cdf_buf_put(ctx, buf);
+        ctx->cdf_copy_cnt++;
     }
+
+    Av1StoreCDFs(ctx, refresh_frame_flags);
+
+    return MPP_OK;
 }
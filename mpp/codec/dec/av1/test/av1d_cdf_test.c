@@ -0,0 +1,264 @@
+/* SPDX-License-Identifier: Apache-2.0 OR MIT */
+/*
+ * Copyright (c) 2024 Rockchip Electronics Co., Ltd.
+ */
+
+#define MODULE_TAG "av1d_cdf_test"
+
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+
+#include "mpp_mem.h"
+#include "mpp_log.h"
+#include "mpp_time.h"
+#include "mpp_common.h"
+
+#include "av1d_parser.h"
+
+/*
+ * Run random frame sequences with frequent key frames and refreshes on the
+ * shared cdf store and on the deep copy store it replaced, check every slot
+ * holds the same cdf after each frame, then compare cdf memory traffic and
+ * time per frame of both.
+ */
+#define FRAME_CNT           2000
+#define KEY_INTERVAL        16
+#define ADAPT_CNT           4
+#define BENCH_ROUND         5
+
+typedef struct TestFrame_t {
+    RK_U32  intra;
+    RK_U32  primary_ref;
+    RK_U32  base_q_idx;
+    RK_U32  refresh;
+    RK_U32  update_cdf;
+    RK_U32  adapt_idx;
+} TestFrame;
+
+/* cdf store before the shared one, every refresh slot has its own copy */
+typedef struct RefStore_t {
+    AV1CDFs *cdfs;
+    MvCDFs  *cdfs_ndvc;
+    AV1CDFs default_cdfs;
+    MvCDFs  default_cdfs_ndvc;
+    AV1CDFs cdfs_last[NUM_REF_FRAMES];
+    MvCDFs  cdfs_last_ndvc[NUM_REF_FRAMES];
+    RK_U64  bytes;
+} RefStore;
+
+typedef struct AdaptData_t {
+    RK_U8   cdfs[sizeof(AV1CDFs)];
+} AdaptData;
+
+static void ref_store(RefStore *p, RK_U32 refresh)
+{
+    RK_U32 i;
+
+    for (i = 0; i < NUM_REF_FRAMES; i++) {
+        if ((refresh & (1 << i)) && &p->cdfs_last[i] != p->cdfs) {
+            p->cdfs_last[i] = *p->cdfs;
+            p->cdfs_last_ndvc[i] = *p->cdfs_ndvc;
+            p->bytes += sizeof(AV1CDFs) + sizeof(MvCDFs);
+        }
+    }
+}
+
+static void write_back(AV1CDFs *cdfs, MvCDFs *cdfs_ndvc, const RK_U8 *data, RK_U32 intra)
+{
+    const RK_U32 mv_cdf_offset = offsetof(AV1CDFs, mv_cdf);
+    const RK_U32 mv_cdf_size = sizeof(MvCDFs);
+    const RK_U32 mv_cdf_end_offset = mv_cdf_offset + mv_cdf_size;
+    const RK_U32 cdf_size = sizeof(AV1CDFs);
+    RK_U8 *cdf_base = (RK_U8 *)cdfs;
+
+    /* same as av1d_parser_update */
+    if (intra) {
+        memcpy(cdf_base, data, mv_cdf_offset);
+        memcpy(cdfs_ndvc, data + mv_cdf_offset, mv_cdf_size);
+        memcpy(cdf_base + mv_cdf_end_offset, data + mv_cdf_end_offset,
+               cdf_size - mv_cdf_end_offset);
+    } else {
+        memcpy(cdf_base, data, cdf_size);
+    }
+}
+
+static RK_U32 first_refresh(RK_U32 refresh)
+{
+    return __builtin_ctz(refresh);
+}
+
+static void ref_frame(RefStore *p, TestFrame *frm, AdaptData *adapt)
+{
+    if (frm->intra || frm->primary_ref == AV1_PRIMARY_REF_NONE) {
+        p->cdfs = &p->default_cdfs;
+        p->cdfs_ndvc = &p->default_cdfs_ndvc;
+        Av1DefaultCoeffProbs(frm->base_q_idx, p->cdfs);
+    } else {
+        p->cdfs = &p->cdfs_last[frm->primary_ref];
+        p->cdfs_ndvc = &p->cdfs_last_ndvc[frm->primary_ref];
+    }
+    ref_store(p, frm->refresh);
+
+    if (frm->update_cdf && frm->refresh) {
+        RK_U32 i = first_refresh(frm->refresh);
+
+        p->cdfs = &p->cdfs_last[i];
+        p->cdfs_ndvc = &p->cdfs_last_ndvc[i];
+        write_back(p->cdfs, p->cdfs_ndvc, adapt[frm->adapt_idx].cdfs, frm->intra);
+        p->bytes += sizeof(AV1CDFs);
+        ref_store(p, frm->refresh);
+    }
+}
+
+static MPP_RET new_frame(AV1Context *s, TestFrame *frm, AdaptData *adapt)
+{
+    MPP_RET ret;
+
+    if (frm->intra || frm->primary_ref == AV1_PRIMARY_REF_NONE) {
+        ret = Av1GetDefaultCDFs(s, frm->base_q_idx);
+        if (ret)
+            return ret;
+    } else {
+        Av1GetCDFs(s, frm->primary_ref);
+    }
+    Av1StoreCDFs(s, frm->refresh);
+
+    if (frm->update_cdf && frm->refresh) {
+        Av1GetCDFs(s, first_refresh(frm->refresh));
+        ret = Av1UpdateCDFs(s, frm->refresh);
+        if (ret)
+            return ret;
+
+        write_back(s->cdfs, s->cdfs_ndvc, adapt[frm->adapt_idx].cdfs, frm->intra);
+    }
+
+    return MPP_OK;
+}
+
+static void gen_frames(TestFrame *frms, RK_S32 cnt)
+{
+    RK_S32 i;
+
+    for (i = 0; i < cnt; i++) {
+        TestFrame *frm = &frms[i];
+        RK_U32 r = rand();
+
+        if (i % KEY_INTERVAL == 0) {
+            frm->intra = 1;
+            frm->refresh = (1 << NUM_REF_FRAMES) - 1;
+        } else {
+            frm->intra = (r & 0xf) == 0;
+            /* mostly one slot refreshed, sometimes several or none */
+            frm->refresh = (r >> 4) & 3 ? 1U << ((r >> 6) & 7) : (r >> 9) & 0xff;
+        }
+        frm->primary_ref = ((r >> 17) & 7) ? (r >> 20) & 7 : AV1_PRIMARY_REF_NONE;
+        frm->base_q_idx = (r >> 23) & 0xff;
+        frm->update_cdf = ((r >> 24) & 3) != 0;
+        frm->adapt_idx = (r >> 26) % ADAPT_CNT;
+    }
+}
+
+int main()
+{
+    TestFrame *frms = mpp_calloc(TestFrame, FRAME_CNT);
+    AdaptData *adapt = mpp_calloc(AdaptData, ADAPT_CNT);
+    RefStore *ref = mpp_calloc(RefStore, 1);
+    AV1Context *s = mpp_calloc(AV1Context, 1);
+    RK_U64 new_bytes = 0;
+    RK_S64 time_ref = 0;
+    RK_S64 time_new = 0;
+    RK_S32 ret = 0;
+    RK_S32 i, j, k;
+
+    if (!frms || !adapt || !ref || !s) {
+        mpp_err("failed to malloc test context\n");
+        ret = -1;
+        goto DONE;
+    }
+
+    srand(0x5a5a);
+    for (i = 0; i < ADAPT_CNT; i++)
+        for (j = 0; j < (RK_S32)sizeof(adapt[i].cdfs); j++)
+            adapt[i].cdfs[j] = rand();
+
+    gen_frames(frms, FRAME_CNT);
+
+    AV1SetDefaultCDFs(&ref->default_cdfs, &ref->default_cdfs_ndvc);
+    if (Av1InitCDFStore(s)) {
+        ret = -1;
+        goto DONE;
+    }
+
+    /* check all stored slots after each frame */
+    for (i = 0; i < FRAME_CNT && !ret; i++) {
+        ref_frame(ref, &frms[i], adapt);
+        if (new_frame(s, &frms[i], adapt)) {
+            mpp_err("frame %d failed\n", i);
+            ret = -1;
+            break;
+        }
+
+        for (k = 0; k < NUM_REF_FRAMES; k++) {
+            Av1CdfBuf *buf = s->cdf_last[k];
+
+            if (!buf)
+                continue;
+
+            if (memcmp(&buf->cdfs, &ref->cdfs_last[k], sizeof(AV1CDFs)) ||
+                memcmp(&buf->cdfs_ndvc, &ref->cdfs_last_ndvc[k], sizeof(MvCDFs))) {
+                mpp_err("frame %d slot %d cdf mismatch\n", i, k);
+                ret = -1;
+                break;
+            }
+        }
+
+        if (!ret && (memcmp(s->cdfs, ref->cdfs, sizeof(AV1CDFs)) ||
+                     memcmp(s->cdfs_ndvc, ref->cdfs_ndvc, sizeof(MvCDFs)))) {
+            mpp_err("frame %d current cdf mismatch\n", i);
+            ret = -1;
+        }
+    }
+
+    if (ret)
+        goto DONE;
+
+    /* copy on write back plus the hardware write back itself */
+    for (i = 0; i < FRAME_CNT; i++)
+        if (frms[i].update_cdf && frms[i].refresh)
+            new_bytes += sizeof(AV1CDFs);
+    new_bytes += (RK_U64)s->cdf_copy_cnt * (sizeof(AV1CDFs) + sizeof(MvCDFs));
+
+    mpp_log("cdf size %d mv cdf size %d\n", (RK_S32)sizeof(AV1CDFs), (RK_S32)sizeof(MvCDFs));
+    mpp_log("deep copy store %lld bytes per frame\n", ref->bytes / FRAME_CNT);
+    mpp_log("shared store    %lld bytes per frame, %d copy on write in %d frames\n",
+            new_bytes / FRAME_CNT, s->cdf_copy_cnt, FRAME_CNT);
+
+    for (k = 0; k < BENCH_ROUND; k++) {
+        RK_S64 start = mpp_time();
+
+        for (i = 0; i < FRAME_CNT; i++)
+            ref_frame(ref, &frms[i], adapt);
+        time_ref += mpp_time() - start;
+
+        start = mpp_time();
+        for (i = 0; i < FRAME_CNT; i++)
+            new_frame(s, &frms[i], adapt);
+        time_new += mpp_time() - start;
+    }
+
+    mpp_log("deep copy store %.2f us per frame\n", (float)time_ref / (BENCH_ROUND * FRAME_CNT));
+    mpp_log("shared store    %.2f us per frame\n", (float)time_new / (BENCH_ROUND * FRAME_CNT));
+
+DONE:
+    if (s)
+        Av1DeinitCDFStore(s);
+    MPP_FREE(frms);
+    MPP_FREE(adapt);
+    MPP_FREE(ref);
+    MPP_FREE(s);
+
+    mpp_log("av1d cdf test %s\n", ret ? "failed" : "success");
+
+    return ret;
+}
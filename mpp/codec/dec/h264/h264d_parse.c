@@ -22,6 +22,7 @@
 
 #include "mpp_mem.h"
 #include "mpp_packet_impl.h"
+#include "mpp_startcode.h"
 #include "hal_dec_task.h"
 
 #include "h264d_global.h"
@@ -147,6 +148,46 @@ static void find_prefix_code(RK_U8 *p_data, H264dCurStream_t *p_strm)
     }
 }
 
+/*
+ * Copy the nalu payload up to the next start code with one memcpy. The last
+ * byte of the start code is left to the byte loop which does end detection.
+ */
+static MPP_RET copy_nalu_run(H264dInputCtx_t *p_Inp, H264dCurStream_t *p_strm)
+{
+    MPP_RET ret = MPP_ERR_UNKNOW;
+    MppPacketImpl *pkt_impl = (MppPacketImpl *)p_Inp->in_pkt;
+    RK_U8 *src = &p_Inp->in_buf[p_strm->nalu_offset];
+    RK_U32 len = (RK_U32)pkt_impl->length;
+    RK_U32 run = 0;
+
+    /* start code may cross previous data, let byte loop handle it */
+    if (len < 3 || !(p_strm->prefixdata & 0xFF))
+        return ret = MPP_OK;
+
+    run = (RK_U32)mpp_find_startcode(src, (RK_S32)len);
+    if (run < len)
+        run += 2;
+    if (!run)
+        return ret = MPP_OK;
+
+    if (p_strm->nalu_len + run > p_strm->nalu_max_size) {
+        RK_U32 add_size = p_strm->nalu_len + run - p_strm->nalu_max_size;
+
+        FUN_CHECK(ret = realloc_buffer(&p_strm->nalu_buf, &p_strm->nalu_max_size,
+                                       MPP_MAX(NALU_BUF_ADD_SIZE, add_size)));
+    }
+    memcpy(&p_strm->nalu_buf[p_strm->nalu_len], src, run);
+    p_strm->nalu_len += run;
+    p_strm->nalu_offset += run;
+    p_strm->curdata = src + run - 1;
+    p_strm->prefixdata = U32_AT(&p_strm->nalu_buf[p_strm->nalu_len - 4]);
+    pkt_impl->length -= run;
+
+    return ret = MPP_OK;
+__FAILED:
+    return ret;
+}
+
 static MPP_RET parser_nalu_header(H264_SLICE_t *currSlice)
 {
     MPP_RET ret = MPP_ERR_UNKNOW;
@@ -629,6 +670,11 @@ MPP_RET parse_prepare(H264dInputCtx_t *p_Inp, H264dCurCtx_t *p_Cur)
     }
 
     while (pkt_impl->length > 0) {
+        if (p_strm->startcode_found && p_strm->nalu_len >= NALU_TYPE_EXT_LENGTH) {
+            FUN_CHECK(ret = copy_nalu_run(p_Inp, p_strm));
+            if (!pkt_impl->length)
+                break;
+        }
         p_strm->curdata = &p_Inp->in_buf[p_strm->nalu_offset++];
         pkt_impl->length--;
         p_strm->prefixdata = (p_strm->prefixdata << 8) | (*p_strm->curdata);
@@ -711,6 +757,11 @@ MPP_RET parse_prepare_fast(H264dInputCtx_t *p_Inp, H264dCurCtx_t *p_Cur)
     p_Inp->task_valid = 0;
 
     while (pkt_impl->length > 0) {
+        if (p_strm->startcode_found && p_strm->nalu_len >= NALU_TYPE_EXT_LENGTH) {
+            FUN_CHECK(ret = copy_nalu_run(p_Inp, p_strm));
+            if (!pkt_impl->length)
+                break;
+        }
         p_strm->curdata = &p_Inp->in_buf[p_strm->nalu_offset++];
         pkt_impl->length--;
         p_strm->prefixdata = (p_strm->prefixdata << 8) | (*p_strm->curdata);
@@ -30,6 +30,7 @@
 #include "mpp_env.h"
 #include "mpp_mem.h"
 #include "mpp_bitread.h"
+#include "mpp_startcode.h"
 #include "mpp_packet_impl.h"
 #include "rk_hdr_meta_com.h"
 
@@ -58,10 +59,23 @@ static RK_S32 hevc_find_frame_end(SplitContext_t *sc, const RK_U8 *buf,
     for (i = 0; i < buf_size; i++) {
         int nut, layer_id;
 
-        sc->state64 = (sc->state64 << 8) | buf[i];
+        if (i < 8) {
+            sc->state64 = (sc->state64 << 8) | buf[i];
 
-        if (((sc->state64 >> 3 * 8) & 0xFFFFFF) != START_CODE)
-            continue;
+            if (((sc->state64 >> 3 * 8) & 0xFFFFFF) != START_CODE)
+                continue;
+        } else {
+            /* whole state64 is inside buf now, jump to next start code */
+            RK_S32 pos = i - 5 + mpp_find_startcode(buf + i - 5, buf_size - i + 5);
+
+            if (pos + 5 >= buf_size) {
+                sc->state64 = MPP_RB64(buf + buf_size - 8);
+                break;
+            }
+
+            i = pos + 5;
+            sc->state64 = MPP_RB64(buf + i - 7);
+        }
         nut = (sc->state64 >> (2 * 8 + 1)) & 0x3F;
         layer_id  =  (((sc->state64 >> 2 * 8) & 0x01) << 5) + (((sc->state64 >> 1 * 8) & 0xF8) >> 3);
         //mpp_log("nut = %d layer_id = %d\n",nut,layer_id);
@@ -1533,6 +1547,18 @@ RK_S32 mpp_hevc_extract_rbsp(HEVCContext *s, const RK_U8 *src, int length,
     }
 #endif
 
+    /*
+     * Slice nal is read in place. The bit reader skips emulation prevention
+     * bytes and stops at nal end so no padded copy is needed. The slice data
+     * is copied once to stream buffer in h265d_syntax_fill_slice which also
+     * redirects nal data there for the parse stage.
+     */
+    if (((src[0] >> 1) & 0x3f) < NAL_VPS) {
+        nal->data = src;
+        nal->size = length;
+        return length;
+    }
+
     if (length + MPP_INPUT_BUFFER_PADDING_SIZE > nal->rbsp_buffer_size) {
         RK_S32 min_size = length + MPP_INPUT_BUFFER_PADDING_SIZE;
         mpp_free(nal->rbsp_buffer);
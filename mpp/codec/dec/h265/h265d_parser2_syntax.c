@@ -350,7 +350,8 @@ RK_S32 h265d_parser2_syntax(void *ctx)
 RK_S32 h265d_syntax_fill_slice(void *ctx, RK_S32 input_index)
 {
     H265dContext_t *h265dctx = (H265dContext_t *)ctx;
-    const HEVCContext *h = (const HEVCContext *)h265dctx->priv_data;
+    /* not const, slice nal data is pointed to the stream buffer copy */
+    HEVCContext *h = (HEVCContext *)h265dctx->priv_data;
     h265d_dxva2_picture_context_t *ctx_pic = (h265d_dxva2_picture_context_t *)h->hal_pic_private;
     MppBuffer streambuf = NULL;
     RK_S32 i, count = 0;
@@ -421,6 +422,8 @@ RK_S32 h265d_syntax_fill_slice(void *ctx, RK_S32 input_index)
         current += start_code_size;
         position += start_code_size;
         memcpy(current, h->nals[i].data, h->nals[i].size);
+        /* input may be reused after prepare, parse slice header from the copy */
+        h->nals[i].data = current;
         // mpp_log("h->nals[%d].size = %d", i, h->nals[i].size);
         fill_slice_short(&ctx_pic->slice_short[count], position, h->nals[i].size);
         init_slice_cut_param(&ctx_pic->slice_cut_param[count]);
@@ -22,6 +22,7 @@
 #include "mpp_env.h"
 #include "mpp_debug.h"
 #include "mpp_packet_impl.h"
+#include "mpp_startcode.h"
 
 #include "m2vd_parser.h"
 #include "m2vd_codec.h"
@@ -437,6 +438,23 @@ MPP_RET mpp_m2vd_parser_split(M2VDParserContext *ctx, MppPacket dst, MppPacket s
 
     if (p->vop_header_found) {
         while (src_pos < src_len) {
+            /* copy the bytes before next start code with one memcpy */
+            if (src_pos >= 4) {
+                /* search from two bytes back, end stops at the 0x01 byte */
+                RK_U32 end = src_pos + mpp_find_startcode(src_buf + src_pos - 2,
+                                                          src_len - src_pos + 2);
+
+                end = MPP_MIN(end, src_len);
+                if (end > src_pos) {
+                    memcpy(dst_buf + dst_len, src_buf + src_pos, end - src_pos);
+                    dst_len += end - src_pos;
+                    src_pos = end;
+                    p->state = MPP_RB32(src_buf + src_pos - 4);
+                    if (src_pos >= src_len)
+                        break;
+                }
+            }
+
             p->state = (p->state << 8) | src_buf[src_pos];
             dst_buf[dst_len++] = src_buf[src_pos++];
 
@@ -972,6 +972,69 @@ RK_S32 h264e_slice_write_pskip(H264eSlice *slice, void *p, RK_U32 size)
     return bitCnt;
 }
 
+/* nonzero when any byte in the 64bit word is zero */
+#define HAS_ZERO_BYTE(v)    (((v) - 0x0101010101010101ULL) & ~(v) & 0x8080808080808080ULL)
+
+static RK_U64 load_be64(const RK_U8 *p)
+{
+    return ((RK_U64)p[0] << 56) | ((RK_U64)p[1] << 48) |
+           ((RK_U64)p[2] << 40) | ((RK_U64)p[3] << 32) |
+           ((RK_U64)p[4] << 24) | ((RK_U64)p[5] << 16) |
+           ((RK_U64)p[6] << 8) | (RK_U64)p[7];
+}
+
+static void store_be64(RK_U8 *p, RK_U64 v)
+{
+    p[0] = (RK_U8)(v >> 56);
+    p[1] = (RK_U8)(v >> 48);
+    p[2] = (RK_U8)(v >> 40);
+    p[3] = (RK_U8)(v >> 32);
+    p[4] = (RK_U8)(v >> 24);
+    p[5] = (RK_U8)(v >> 16);
+    p[6] = (RK_U8)(v >> 8);
+    p[7] = (RK_U8)v;
+}
+
+/*
+ * Move 8 bytes in one 64bit shift when there is no emulation prevention
+ * hazard: no zero byte in source and output and no pending dst zero run.
+ * Return 0 when the hazard is found and the byte loop should be used.
+ * The result is the same as running the byte loop for 8 times.
+ */
+static RK_S32 slice_move_64(RK_U8 *pdst, const RK_U8 *psrc, RK_S32 src_bit_r,
+                            RK_S32 dst_bit_r, RK_U16 dst_mask, RK_U16 *last_tmp,
+                            RK_U32 dst_zero_cnt)
+{
+    RK_U64 src = load_be64(psrc);
+    RK_U64 val;
+    RK_U64 out;
+    RK_U8 next = psrc[8];
+    RK_U8 low;
+
+    if (HAS_ZERO_BYTE(src))
+        return 0;
+
+    val = src_bit_r ? ((src << src_bit_r) | (next >> (8 - src_bit_r))) : src;
+    low = (RK_U8)(next << src_bit_r);
+
+    if (dst_bit_r) {
+        /* keep only the dst_bit_r bits already in dst */
+        out = (val >> dst_bit_r) | (((RK_U64)(*last_tmp & 0xFF) << 56) & ((RK_U64)dst_mask << 48));
+        low = (RK_U8)((val << (8 - dst_bit_r)) | (low >> dst_bit_r));
+    } else {
+        out = val;
+    }
+
+    if (HAS_ZERO_BYTE(out) || (dst_zero_cnt == 2 && (out >> 56) <= 0x3))
+        return 0;
+
+    store_be64(pdst, out);
+    pdst[8] = low;
+    *last_tmp = ((RK_U16)(out & 0xFF) << 8) | low;
+
+    return 1;
+}
+
 RK_S32 h264e_slice_move(RK_U8 *dst, RK_U8 *src, RK_S32 dst_bit, RK_S32 src_bit, RK_S32 src_size)
 {
     RK_S32 dst_byte = dst_bit / 8;
@@ -1007,13 +1070,26 @@ RK_S32 h264e_slice_move(RK_U8 *dst, RK_U8 *src, RK_S32 dst_bit, RK_S32 src_bit,
     RK_U32 dst_len = 0;
 
     last_tmp = (RK_U16)pdst[0];
-    dst_mask = 0xFFFF << (8 - dst_bit_r);
+    /* keep the dst_bit_r high bits of last byte, clear the bits after dst_bit */
+    dst_mask = 0xFF00 << (8 - dst_bit_r);
 
     h264e_dbg_slice("bit [%d %d] [%d %d] [%d %d] loop %d mask %04x last %04x\n",
                     src_bit, dst_bit, src_byte, dst_byte,
                     src_bit_r, dst_bit_r, loop, dst_mask, last_tmp);
 
     for (i = 0; i < loop; i++) {
+        /* fast path for 8 bytes without emulation prevention */
+        if (!(h264e_debug & H264E_DBG_SLICE) && i + 8 < loop &&
+            slice_move_64(pdst, psrc, src_bit_r, dst_bit_r, dst_mask, &last_tmp, dst_zero_cnt)) {
+            src_zero_cnt = 0;
+            dst_zero_cnt = 0;
+            psrc += 8;
+            pdst += 8;
+            dst_len += 8;
+            i += 7;
+            continue;
+        }
+
         if (psrc[0] == 0) {
             src_zero_cnt++;
         } else {
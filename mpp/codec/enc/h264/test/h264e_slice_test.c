@@ -0,0 +1,237 @@
+/* SPDX-License-Identifier: Apache-2.0 OR MIT */
+/*
+ * Copyright (c) 2024 Rockchip Electronics Co., Ltd.
+ */
+
+#define MODULE_TAG "h264e_slice_test"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "mpp_mem.h"
+#include "mpp_log.h"
+#include "mpp_time.h"
+#include "mpp_common.h"
+
+#include "h264e_slice.h"
+
+/*
+ * Compare h264e_slice_move with the byte-wise reference on random streams
+ * with dense zero and emulation prevention bytes, then benchmark both on a
+ * large slice.
+ */
+#define FUZZ_ROUND          20000
+#define FUZZ_MAX_SIZE       256
+#define BENCH_SIZE          (SZ_1M)
+#define BENCH_ROUND         20
+#define BUF_PAD             64
+
+/* the byte-wise implementation before the 64bit fast path */
+static RK_S32 slice_move_ref(RK_U8 *dst, RK_U8 *src, RK_S32 dst_bit, RK_S32 src_bit, RK_S32 src_size)
+{
+    RK_S32 dst_byte = dst_bit / 8;
+    RK_S32 src_byte = src_bit / 8;
+    RK_S32 dst_bit_r = dst_bit & 7;
+    RK_S32 src_bit_r = src_bit & 7;
+    RK_S32 src_len = src_size - src_byte;
+    RK_S32 diff_len = 0;
+
+    if (src_bit_r == 0 && dst_bit_r == 0) {
+        memcpy(dst + dst_byte, src + src_byte, src_len);
+        return diff_len;
+    }
+
+    RK_U8 *psrc = src + src_byte;
+    RK_U8 *pdst = dst + dst_byte;
+
+    RK_U16 tmp16a, tmp16b, tmp16c, last_tmp, dst_mask;
+    RK_U8 tmp0, tmp1;
+    RK_U32 loop = src_len + (src_bit_r > 0);
+    RK_U32 i = 0;
+    RK_U32 src_zero_cnt = 0;
+    RK_U32 dst_zero_cnt = 0;
+
+    last_tmp = (RK_U16)pdst[0];
+    dst_mask = 0xFFFF << (8 - dst_bit_r);
+
+    for (i = 0; i < loop; i++) {
+        if (psrc[0] == 0) {
+            src_zero_cnt++;
+        } else {
+            src_zero_cnt = 0;
+        }
+
+        tmp0 = psrc[0];
+        tmp1 = (i < loop - 1) ? psrc[1] : 0;
+
+        if (src_zero_cnt >= 2 && tmp1 == 3) {
+            psrc++;
+            i++;
+            tmp1 = psrc[1];
+            src_zero_cnt = 0;
+            diff_len--;
+        }
+        tmp16a = ((RK_U16)tmp0 << 8) | (RK_U16)tmp1;
+
+        if (src_bit_r) {
+            tmp16b = tmp16a << src_bit_r;
+        } else {
+            tmp16b = tmp16a;
+        }
+
+        if (dst_bit_r)
+            tmp16c = tmp16b >> dst_bit_r | ((last_tmp << 8) & dst_mask);
+        else
+            tmp16c = tmp16b;
+
+        pdst[0] = (tmp16c >> 8) & 0xFF;
+        pdst[1] = tmp16c & 0xFF;
+
+        if (dst_zero_cnt == 2 && pdst[0] <= 0x3) {
+            pdst[2] = pdst[1];
+            pdst[1] = pdst[0];
+            pdst[0] = 0x3;
+            pdst++;
+            diff_len++;
+            dst_zero_cnt = 0;
+        }
+
+        if (pdst[0] == 0)
+            dst_zero_cnt++;
+        else
+            dst_zero_cnt = 0;
+
+        last_tmp = tmp16c;
+
+        psrc++;
+        pdst++;
+    }
+
+    return diff_len;
+}
+
+/* random rbsp with zero runs converted to nal payload with emulation prevention */
+static RK_S32 gen_stream(RK_U8 *buf, RK_S32 size, RK_S32 zero_permille)
+{
+    RK_S32 zero_cnt = 0;
+    RK_S32 len = 0;
+
+    while (len < size) {
+        RK_U8 val = ((rand() % 1000) < zero_permille) ? 0 : (RK_U8)(rand() % 256);
+
+        if (zero_cnt >= 2 && val <= 3) {
+            buf[len++] = 3;
+            zero_cnt = 0;
+            if (len >= size)
+                break;
+        }
+
+        buf[len++] = val;
+        zero_cnt = val ? 0 : zero_cnt + 1;
+    }
+
+    /* rbsp trailing bit */
+    buf[size - 1] |= 1;
+    return size;
+}
+
+static MPP_RET slice_move_fuzz(void)
+{
+    RK_U8 *src = mpp_calloc(RK_U8, FUZZ_MAX_SIZE + BUF_PAD);
+    RK_U8 *dst0 = mpp_calloc(RK_U8, FUZZ_MAX_SIZE * 2 + BUF_PAD);
+    RK_U8 *dst1 = mpp_calloc(RK_U8, FUZZ_MAX_SIZE * 2 + BUF_PAD);
+    MPP_RET ret = MPP_OK;
+    RK_S32 i;
+
+    if (!src || !dst0 || !dst1) {
+        ret = MPP_ERR_MALLOC;
+        goto DONE;
+    }
+
+    for (i = 0; i < FUZZ_ROUND; i++) {
+        RK_S32 size = 16 + rand() % (FUZZ_MAX_SIZE - 16);
+        RK_S32 src_bit = rand() % 64;
+        RK_S32 dst_bit = rand() % 64;
+        RK_S32 diff0, diff1;
+        RK_S32 j;
+
+        memset(src, 0, FUZZ_MAX_SIZE + BUF_PAD);
+        gen_stream(src, size, (i & 1) ? 300 : 20);
+
+        for (j = 0; j < FUZZ_MAX_SIZE * 2 + BUF_PAD; j++)
+            dst0[j] = (RK_U8)rand();
+        memcpy(dst1, dst0, FUZZ_MAX_SIZE * 2 + BUF_PAD);
+        /*
+         * the reference ORs the whole first byte, so it needs zero after
+         * dst_bit. The slice move under test keeps the garbage there and
+         * must mask it out.
+         */
+        dst0[dst_bit / 8] &= 0xFF << (8 - (dst_bit & 7));
+
+        diff0 = slice_move_ref(dst0, src, dst_bit, src_bit, size);
+        diff1 = h264e_slice_move(dst1, src, dst_bit, src_bit, size);
+
+        if (diff0 != diff1 || memcmp(dst0, dst1, FUZZ_MAX_SIZE * 2 + BUF_PAD)) {
+            mpp_err("round %d size %d bit src %d dst %d diff %d vs %d mismatch\n",
+                    i, size, src_bit, dst_bit, diff0, diff1);
+            ret = MPP_NOK;
+            break;
+        }
+    }
+
+DONE:
+    MPP_FREE(src);
+    MPP_FREE(dst0);
+    MPP_FREE(dst1);
+    return ret;
+}
+
+static void slice_move_bench(void)
+{
+    RK_U8 *src = mpp_calloc(RK_U8, BENCH_SIZE + BUF_PAD);
+    RK_U8 *dst = mpp_calloc(RK_U8, BENCH_SIZE * 2 + BUF_PAD);
+    RK_S64 time_ref, time_new;
+    RK_S64 start;
+    RK_S32 i;
+
+    if (!src || !dst)
+        goto DONE;
+
+    gen_stream(src, BENCH_SIZE, 20);
+
+    start = mpp_time();
+    for (i = 0; i < BENCH_ROUND; i++)
+        slice_move_ref(dst, src, 13, 27, BENCH_SIZE);
+    time_ref = mpp_time() - start;
+
+    start = mpp_time();
+    for (i = 0; i < BENCH_ROUND; i++)
+        h264e_slice_move(dst, src, 13, 27, BENCH_SIZE);
+    time_new = mpp_time() - start;
+
+    mpp_log("slice move %d KB x %d: byte loop %lld us %.1f MB/s, 64bit %lld us %.1f MB/s\n",
+            BENCH_SIZE / SZ_1K, BENCH_ROUND,
+            time_ref, (float)BENCH_SIZE * BENCH_ROUND / MPP_MAX(time_ref, 1),
+            time_new, (float)BENCH_SIZE * BENCH_ROUND / MPP_MAX(time_new, 1));
+
+DONE:
+    MPP_FREE(src);
+    MPP_FREE(dst);
+}
+
+int main()
+{
+    MPP_RET ret;
+
+    mpp_log("h264e_slice test start\n");
+
+    srand(0x264);
+
+    ret = slice_move_fuzz();
+    if (!ret)
+        slice_move_bench();
+
+    mpp_log("h264e_slice test %s\n", ret ? "failed" : "success");
+
+    return ret;
+}
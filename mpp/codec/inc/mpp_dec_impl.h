@@ -28,6 +28,7 @@
 
 #include "mpp_parser.h"
 #include "mpp_hal.h"
+#include "mpp_dec_perf.h"
 
 // for timing record
 typedef enum MppDecTimingType_e {
@@ -107,7 +108,6 @@ struct MppDecImpl_t {
     RK_U32              parser_wait_count;
     RK_U32              parser_status_flag;
     RK_U32              parser_wait_flag;
-    RK_U32              parser_notify_flag;
     RK_U32              hal_notify_flag;
 
     // reset process:
@@ -139,6 +139,7 @@ struct MppDecImpl_t {
     // statistics data
     RK_U32              statistics_en;
     MppClock            clocks[DEC_TIMING_BUTT];
+    MppDecPerf          perf;
 
     // query data
     RK_U32              dec_in_pkt_count;
@@ -0,0 +1,39 @@
+/* SPDX-License-Identifier: Apache-2.0 OR MIT */
+/*
+ * Copyright (c) 2024 Rockchip Electronics Co., Ltd.
+ */
+
+#ifndef __MPP_DEC_PERF_H__
+#define __MPP_DEC_PERF_H__
+
+#include "rk_vdec_cmd.h"
+
+typedef void* MppDecPerf;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+MPP_RET mpp_dec_perf_init(MppDecPerf *perf);
+MPP_RET mpp_dec_perf_deinit(MppDecPerf perf);
+MPP_RET mpp_dec_perf_reset(MppDecPerf perf);
+
+/* record one stage with start and end time from mpp_time */
+void mpp_dec_perf_record(MppDecPerf perf, MppDecPerfStage stage, RK_S64 start, RK_S64 end);
+
+/* packet input queue latency: pkt_put on input enqueue and pkt_get on parser dequeue */
+void mpp_dec_perf_pkt_put(MppDecPerf perf);
+void mpp_dec_perf_pkt_get(MppDecPerf perf);
+/* frame output interval */
+void mpp_dec_perf_frm_out(MppDecPerf perf);
+
+MPP_RET mpp_dec_perf_get_stats(MppDecPerf perf, MppDecPerfStats *stats);
+void mpp_dec_perf_show(MppDecPerf perf, const char *tag);
+/* dump recent stage records to chrome trace json file */
+MPP_RET mpp_dec_perf_dump_trace(MppDecPerf perf, const char *path);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __MPP_DEC_PERF_H__ */
@@ -172,6 +172,9 @@ MPP_RET mpp_enc_control_v2(MppEnc ctx, MpiCmd cmd, void *param);
 MPP_RET mpp_enc_notify_v2(MppEnc ctx, RK_U32 flag);
 MPP_RET mpp_enc_reset_v2(MppEnc ctx);
 
+/* merge changed rc config from src to dst with check on the changed part */
+MPP_RET mpp_enc_proc_rc_cfg(MppCodingType coding, MppEncRcCfg *dst, MppEncRcCfg *src);
+
 #ifdef __cplusplus
 }
 #endif
@@ -102,7 +102,6 @@ typedef struct MppEncImpl_t {
     RK_U32              wait_count;
     RK_U32              work_count;
     RK_U32              status_flag;
-    RK_U32              notify_flag;
     RK_U32              enc_failed_drop;
 
     /* control process */
@@ -80,6 +80,9 @@ MPP_RET rc_frm_end(RcCtx ctx, EncRcTask *task);
 MPP_RET rc_hal_start(RcCtx ctx, EncRcTask *task);
 MPP_RET rc_hal_end(RcCtx ctx, EncRcTask *task);
 
+/* clear hardware feedback in task info before reencode, keep frame target */
+void rc_frm_clr_hal_info(EncRcTask *task);
+
 #ifdef __cplusplus
 }
 #endif
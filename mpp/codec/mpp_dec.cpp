@@ -325,6 +325,7 @@ void mpp_dec_put_frame(Mpp *mpp, RK_S32 index, HalDecTaskFlag flags)
     }
 
     dec->dec_out_frame_count++;
+    mpp_dec_perf_frm_out(dec->perf);
     dec_dbg_detail("detail: %p put frm pts %llu fd %d\n", dec,
                    mpp_frame_get_pts(frame),
                    (NULL == mpp_frame_get_buffer(frame)) ? (-1) :
@@ -369,7 +370,6 @@ void mpp_dec_put_frame(Mpp *mpp, RK_S32 index, HalDecTaskFlag flags)
         dec_vproc_signal(dec->vproc);
     } else {
         // direct output -> copy a new MppFrame and output
-        mpp_list *list = mpp->mFrmOut;
         MppFrame out = NULL;
 
         mpp_frame_init(&out);
@@ -377,11 +377,8 @@ void mpp_dec_put_frame(Mpp *mpp, RK_S32 index, HalDecTaskFlag flags)
 
         mpp_dbg_pts("output frame pts %lld\n", mpp_frame_get_pts(out));
 
-        list->lock();
-        list->add_at_tail(&out, sizeof(out));
-        mpp->mFramePutCount++;
-        list->signal();
-        list->unlock();
+        MPP_FETCH_ADD(&mpp->mFramePutCount, 1);
+        mpp_spsc_queue_push(mpp->mFrmOut, out);
 
         if (fake_frame)
             mpp_frame_deinit(&frame);
@@ -534,6 +531,9 @@ MPP_RET mpp_dec_set_cfg(MppDecCfgSet *dst, MppDecCfgSet *src)
         if (change & MPP_DEC_CFG_CHANGE_ENABLE_MVC)
             dst_base->enable_mvc = src_base->enable_mvc;
 
+        if (change & MPP_DEC_CFG_CHANGE_ZERO_COPY_PKT)
+            dst_base->zero_copy_pkt = src_base->zero_copy_pkt;
+
         if (change & MPP_DEC_CFG_CHANGE_DISABLE_THREAD)
             dst_base->disable_thread = src_base->disable_thread;
 
@@ -701,6 +701,12 @@ MPP_RET mpp_dec_init(MppDec *dec, MppDecInitCfg *cfg)
 
         p->hw_info = hal_cfg.hw_info;
         p->dev = hal_cfg.dev;
+        /* send hardware task through mpp server batch, mode 2 is latency sensitive */
+        if (dec_cfg->base.batch_mode) {
+            RK_S32 prio = (dec_cfg->base.batch_mode > 1) ? 1 : 0;
+
+            mpp_dev_ioctl(p->dev, MPP_DEV_BATCH_ON, &prio);
+        }
         /* check fbc cap after hardware info is valid */
         mpp_dec_check_fbc_cap(p);
 
@@ -739,6 +745,10 @@ MPP_RET mpp_dec_init(MppDec *dec, MppDecInitCfg *cfg)
             mpp_clock_enable(p->clocks[i], p->statistics_en);
         }
 
+        ret = mpp_dec_perf_init(&p->perf);
+        if (ret)
+            break;
+
         p->cmd_lock = new MppMutexCond();
         sem_init(&p->parser_reset, 0, 0);
         sem_init(&p->hal_reset, 0, 0);
@@ -804,6 +814,19 @@ MPP_RET mpp_dec_deinit(MppDec ctx)
                     mpp_clock_get_name(timer), time * 100.0 / total, time,
                     time / mpp_clock_get_count(timer));
         }
+
+        mpp_dec_perf_show(dec->perf, "perf");
+    }
+
+    if (dec->perf) {
+        const char *path = NULL;
+
+        mpp_env_get_str("mpp_dec_perf_trace", &path, NULL);
+        if (path)
+            mpp_dec_perf_dump_trace(dec->perf, path);
+
+        mpp_dec_perf_deinit(dec->perf);
+        dec->perf = NULL;
     }
 
     for (i = 0; i < DEC_TIMING_BUTT; i++) {
@@ -894,6 +917,13 @@ MPP_RET mpp_dec_stop(MppDec ctx)
     if (dec->thread_hal)
         dec->thread_hal->stop();
 
+    if (dec->statistics_en) {
+        if (dec->thread_parser)
+            dec->thread_parser->dump_stats();
+        if (dec->thread_hal)
+            dec->thread_hal->dump_stats();
+    }
+
     if (dec->thread_parser) {
         delete dec->thread_parser;
         dec->thread_parser = NULL;
@@ -923,6 +953,8 @@ MPP_RET mpp_dec_reset(MppDec ctx)
     if (dec->api && dec->api->reset)
         ret = dec->api->reset(dec);
 
+    mpp_dec_perf_reset(dec->perf);
+
     dec_dbg_func("%p out ret %d\n", dec, ret);
 
     return ret;
@@ -999,6 +1031,10 @@ MPP_RET mpp_dec_control(MppDec ctx, MpiCmd cmd, void *param)
     dec_dbg_func("%p in %08x %p\n", dec, cmd, param);
     dec_dbg_detail("detail: %p control cmd %08x param %p start\n", dec, cmd, param);
 
+    /* perf stats is lock-free and do not need to go through parser thread */
+    if (cmd == MPP_DEC_GET_PERF_STATS)
+        return mpp_dec_perf_get_stats(dec->perf, (MppDecPerfStats *)param);
+
     if (dec->api && dec->api->control)
         ret = dec->api->control(dec, cmd, param);
 
@@ -37,6 +37,8 @@ MPP_RET mpp_dec_decode(MppDec ctx, MppPacket packet)
     MppPacket input = dec->mpp_pkt_in;
     size_t stream_size = 0;
     RK_S32 output = 0;
+    RK_S64 start;
+    RK_S64 end;
 
     AutoMutex auto_lock(cmd_lock->mutex());
 
@@ -61,7 +63,9 @@ MPP_RET mpp_dec_decode(MppDec ctx, MppPacket packet)
      * 2. prepare stream to generate task
      */
     if (!status->curr_task_rdy) {
+        start = mpp_time();
         mpp_parser_prepare(dec->parser, input, task_dec);
+        mpp_dec_perf_record(dec->perf, MPP_DEC_PERF_PREPARE, start, mpp_time());
 
         dec_dbg_detail("detail: %p prepare pkt %p get task %d\n", dec,
                        input, task_dec->valid);
@@ -155,9 +159,11 @@ MPP_RET mpp_dec_decode(MppDec ctx, MppPacket packet)
      * 7. parse the stream in input buffer and generate task
      */
     if (!status->task_parsed_rdy) {
+        start = mpp_time();
         mpp_clock_start(dec->clocks[DEC_PRS_PARSE]);
         mpp_parser_parse(dec->parser, task_dec);
         mpp_clock_pause(dec->clocks[DEC_PRS_PARSE]);
+        mpp_dec_perf_record(dec->perf, MPP_DEC_PERF_PARSE, start, mpp_time());
         status->task_parsed_rdy = 1;
     }
 
@@ -275,9 +281,19 @@ MPP_RET mpp_dec_decode(MppDec ctx, MppPacket packet)
     if (task->wait.dec_pic_match)
         return MPP_NOK;
 
+    start = mpp_time();
     mpp_hal_reg_gen(dec->hal, &task->info);
+    end = mpp_time();
+    mpp_dec_perf_record(dec->perf, MPP_DEC_PERF_GEN_REG, start, end);
+
+    start = end;
     mpp_hal_hw_start(dec->hal, &task->info);
+    end = mpp_time();
+    mpp_dec_perf_record(dec->perf, MPP_DEC_PERF_HW_START, start, end);
+
+    start = end;
     mpp_hal_hw_wait(dec->hal, &task->info);
+    mpp_dec_perf_record(dec->perf, MPP_DEC_PERF_HW_WAIT, start, mpp_time());
     dec->dec_hw_run_count++;
     /*
      * when hardware decoding is done:
@@ -19,11 +19,16 @@
 #include <string.h>
 
 #include "mpp_buffer_impl.h"
+#include "mpp_packet_impl.h"
 
 #include "mpp_dec_debug.h"
 #include "mpp_dec_vproc.h"
 #include "mpp_dec_normal.h"
 
+/* hal thread wait events */
+#define DEC_HAL_EVENT_TASK      (0x00000001)
+#define DEC_HAL_EVENT_RESET     (0x00000002)
+
 static RK_S32 ts_cmp(void *priv, const struct list_head *a, const struct list_head *b)
 {
     MppPktTs *ts1, *ts2;
@@ -35,6 +40,17 @@ static RK_S32 ts_cmp(void *priv, const struct list_head *a, const struct list_he
     return ts1->pts - ts2->pts;
 }
 
+/*
+ * Packet copied or referenced by Mpp::put_packet is owned by decoder and its
+ * input task can be returned once the packet is fetched.
+ */
+static RK_U32 dec_pkt_is_owned(MppPacket packet)
+{
+    MppPacketImpl *impl = (MppPacketImpl *)packet;
+
+    return !impl->buffer || (impl->flag & MPP_PACKET_FLAG_BUF_REF);
+}
+
 /*
  * return MPP_OK for not wait
  * return MPP_NOK for wait
@@ -42,7 +58,7 @@ static RK_S32 ts_cmp(void *priv, const struct list_head *a, const struct list_he
 static MPP_RET check_task_wait(MppDecImpl *dec, DecTask *task)
 {
     MPP_RET ret = MPP_OK;
-    RK_U32 notify = dec->parser_notify_flag;
+    RK_U32 notify = dec->thread_parser->get_event();
     RK_U32 last_wait = dec->parser_wait_flag;
     RK_U32 curr_wait = task->wait.val;
     RK_U32 wait_chg  = last_wait & (~curr_wait);
@@ -71,7 +87,7 @@ static MPP_RET check_task_wait(MppDecImpl *dec, DecTask *task)
 
     dec->parser_status_flag = task->status.val;
     dec->parser_wait_flag = task->wait.val;
-    dec->parser_notify_flag = keep_notify;
+    dec->thread_parser->clear_event(notify & ~keep_notify);
 
     if (ret) {
         dec->parser_wait_count++;
@@ -106,7 +122,7 @@ static MPP_RET dec_release_task_in_port(MppPort port)
             frame = NULL;
         }
         ret = mpp_task_meta_get_packet(mpp_task, KEY_INPUT_PACKET, &packet);
-        if (packet && NULL == mpp_packet_get_buffer(packet)) {
+        if (packet && dec_pkt_is_owned(packet)) {
             mpp_packet_deinit(&packet);
             packet = NULL;
         }
@@ -148,7 +164,7 @@ static RK_U32 reset_parser_thread(Mpp *mpp, DecTask *task)
 
     hal->lock();
     dec->hal_reset_post++;
-    hal->signal();
+    hal->notify_event(DEC_HAL_EVENT_RESET);
     hal->unlock();
 
     sem_wait(&dec->hal_reset);
@@ -244,7 +260,7 @@ static void mpp_dec_put_task(Mpp *mpp, DecTask *task)
     dec->thread_hal->lock();
     hal_task_hnd_set_status(task->hnd, TASK_PROCESSING);
     mpp->mTaskPutCount++;
-    dec->thread_hal->signal();
+    dec->thread_hal->notify_event(DEC_HAL_EVENT_TASK);
     dec->thread_hal->unlock();
     task->hnd = NULL;
 }
@@ -298,13 +314,14 @@ static MPP_RET try_get_input_packet(Mpp *mpp, DecTask *task)
     mpp_task_meta_get_packet(mpp_task, KEY_INPUT_PACKET, &packet);
     mpp_assert(packet);
 
-    /* when it is copy buffer return packet right here */
-    if (NULL == mpp_packet_get_buffer(packet))
+    /* when it is copy or referenced buffer return packet right here */
+    if (dec_pkt_is_owned(packet))
         mpp_port_enqueue(input, mpp_task);
 
     dec->mpp_pkt_in = packet;
     mpp->mPacketGetCount++;
     dec->dec_in_pkt_count++;
+    mpp_dec_perf_pkt_get(dec->perf);
 
     task->status.mpp_pkt_in_rdy = 1;
     task->wait.dec_pkt_in = 0;
@@ -323,6 +340,8 @@ static MPP_RET try_proc_dec_task(Mpp *mpp, DecTask *task)
     MppBuffer hal_buf_out = NULL;
     size_t stream_size = 0;
     RK_S32 output = 0;
+    RK_S64 start;
+    RK_S64 end;
 
     /*
      * 1. get task handle from hal for parsing one frame
@@ -379,9 +398,11 @@ static MPP_RET try_proc_dec_task(Mpp *mpp, DecTask *task)
     if (!task->status.curr_task_rdy) {
         mpp_dbg_pts("input packet pts %lld\n", mpp_packet_get_pts(dec->mpp_pkt_in));
 
+        start = mpp_time();
         mpp_clock_start(dec->clocks[DEC_PRS_PREPARE]);
         mpp_parser_prepare(dec->parser, dec->mpp_pkt_in, task_dec);
         mpp_clock_pause(dec->clocks[DEC_PRS_PREPARE]);
+        mpp_dec_perf_record(dec->perf, MPP_DEC_PERF_PREPARE, start, mpp_time());
         if (dec->cfg.base.sort_pts && task_dec->valid) {
             task->ts_cur.pts = mpp_packet_get_pts(dec->mpp_pkt_in);
             task->ts_cur.dts = mpp_packet_get_dts(dec->mpp_pkt_in);
@@ -480,7 +501,7 @@ static MPP_RET try_proc_dec_task(Mpp *mpp, DecTask *task)
 
     /* too many frame delay in dispaly queue */
     if (mpp->mFrmOut) {
-        task->wait.dis_que_full = (mpp->mFrmOut->list_size() > 4) ? 1 : 0;
+        task->wait.dis_que_full = (mpp_spsc_queue_size(mpp->mFrmOut) > 4) ? 1 : 0;
         if (task->wait.dis_que_full)
             return MPP_ERR_DISPLAY_FULL;
     }
@@ -506,9 +527,11 @@ static MPP_RET try_proc_dec_task(Mpp *mpp, DecTask *task)
      *    4. detect whether output index has MppBuffer and task valid
      */
     if (!task->status.task_parsed_rdy) {
+        start = mpp_time();
         mpp_clock_start(dec->clocks[DEC_PRS_PARSE]);
         mpp_parser_parse(dec->parser, task_dec);
         mpp_clock_pause(dec->clocks[DEC_PRS_PARSE]);
+        mpp_dec_perf_record(dec->perf, MPP_DEC_PERF_PARSE, start, mpp_time());
         task->status.task_parsed_rdy = 1;
     }
 
@@ -640,14 +663,19 @@ static MPP_RET try_proc_dec_task(Mpp *mpp, DecTask *task)
     }
 
     /* generating registers table */
+    start = mpp_time();
     mpp_clock_start(dec->clocks[DEC_HAL_GEN_REG]);
     mpp_hal_reg_gen(dec->hal, &task->info);
     mpp_clock_pause(dec->clocks[DEC_HAL_GEN_REG]);
+    end = mpp_time();
+    mpp_dec_perf_record(dec->perf, MPP_DEC_PERF_GEN_REG, start, end);
 
     /* send current register set to hardware */
+    start = end;
     mpp_clock_start(dec->clocks[DEC_HW_START]);
     mpp_hal_hw_start(dec->hal, &task->info);
     mpp_clock_pause(dec->clocks[DEC_HW_START]);
+    mpp_dec_perf_record(dec->perf, MPP_DEC_PERF_HW_START, start, mpp_time());
 
     /*
      * 12. send dxva output information and buffer information to hal thread
@@ -697,9 +725,14 @@ void *mpp_dec_parser_thread(void *data)
              * 3. no buffer on analyzing output task
              */
             if (check_task_wait(dec, &task)) {
+                RK_S64 start = mpp_time();
+
                 mpp_clock_start(dec->clocks[DEC_PRS_WAIT]);
-                parser->wait();
+                parser->wait_event(task.wait.val | MPP_DEC_CONTROL);
                 mpp_clock_pause(dec->clocks[DEC_PRS_WAIT]);
+                mpp_dec_perf_record(dec->perf, task.wait.dec_pkt_in ?
+                                    MPP_DEC_PERF_WAIT_PKT : MPP_DEC_PERF_WAIT_BUF,
+                                    start, mpp_time());
             }
         }
 
@@ -784,7 +817,9 @@ void *mpp_dec_hal_thread(void *data)
 
                 mpp_dec_notify(dec, MPP_DEC_NOTIFY_TASK_ALL_DONE);
                 mpp_clock_start(dec->clocks[DEC_HAL_WAIT]);
-                hal->wait();
+                /* both are checked above under lock so old events are stale */
+                hal->clear_event(DEC_HAL_EVENT_TASK | DEC_HAL_EVENT_RESET);
+                hal->wait_event(DEC_HAL_EVENT_TASK | DEC_HAL_EVENT_RESET);
                 mpp_clock_pause(dec->clocks[DEC_HAL_WAIT]);
                 continue;
             }
@@ -838,9 +873,12 @@ void *mpp_dec_hal_thread(void *data)
                 continue;
             }
 
+            RK_S64 start = mpp_time();
+
             mpp_clock_start(dec->clocks[DEC_HW_WAIT]);
             mpp_hal_hw_wait(dec->hal, &task_info);
             mpp_clock_pause(dec->clocks[DEC_HW_WAIT]);
+            mpp_dec_perf_record(dec->perf, MPP_DEC_PERF_HW_WAIT, start, mpp_time());
             dec->dec_hw_run_count++;
 
             /*
@@ -912,7 +950,7 @@ void *mpp_dec_advanced_thread(void *data)
                 break;
 
             if (check_task_wait(dec, &task))
-                thd_dec->wait();
+                thd_dec->wait_event(task.wait.val | MPP_DEC_CONTROL);
         }
 
         // process user control
@@ -1129,29 +1167,15 @@ MPP_RET mpp_dec_reset_normal(MppDecImpl *dec)
 MPP_RET mpp_dec_notify_normal(MppDecImpl *dec, RK_U32 flag)
 {
     MppThread *thd_dec  = dec->thread_parser;
-    RK_U32 notify = 0;
 
     if (!thd_dec)
         return MPP_NOK;
 
     thd_dec->lock();
-    if (flag == MPP_DEC_CONTROL) {
-        dec->parser_notify_flag |= flag;
-        notify = 1;
-    } else {
-        RK_U32 old_flag = dec->parser_notify_flag;
-
-        dec->parser_notify_flag |= flag;
-        if ((old_flag != dec->parser_notify_flag) &&
-            (dec->parser_notify_flag & dec->parser_wait_flag))
-            notify = 1;
-    }
-
-    if (notify) {
-        dec_dbg_notify("%p status %08x notify control signal\n", dec,
-                       dec->parser_wait_flag, dec->parser_notify_flag);
-        thd_dec->signal();
-    }
+    dec_dbg_notify("%p status %08x notify %08x flag %08x\n", dec,
+                   dec->parser_wait_flag, thd_dec->get_event(), flag);
+    /* parser waits with MPP_DEC_CONTROL in mask so control always wakes it */
+    thd_dec->notify_event(flag);
     thd_dec->unlock();
 
     return MPP_OK;
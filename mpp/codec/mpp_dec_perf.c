@@ -0,0 +1,304 @@
+/* SPDX-License-Identifier: Apache-2.0 OR MIT */
+/*
+ * Copyright (c) 2024 Rockchip Electronics Co., Ltd.
+ */
+
+#define MODULE_TAG "mpp_dec_perf"
+
+#include <string.h>
+#include <unistd.h>
+
+#include "mpp_mem.h"
+#include "mpp_lock.h"
+#include "mpp_time.h"
+#include "mpp_debug.h"
+#include "mpp_trace.h"
+#include "mpp_common.h"
+
+#include "mpp_dec_perf.h"
+
+/*
+ * Always-on decoder stage latency record.
+ *
+ * Each stage has a log-linear histogram with 8 sub-buckets per power of two
+ * so the percentile error is below 12.5%. Recent records are also kept in a
+ * ring buffer for chrome trace dump. All updates are atomic operations so
+ * parser, hal and output threads can record without lock.
+ */
+#define PERF_SUB_BITS       3
+#define PERF_SUB_CNT        (1 << PERF_SUB_BITS)
+#define PERF_BUCKET_CNT     ((32 - PERF_SUB_BITS + 1) << PERF_SUB_BITS)
+
+#define PERF_EVENT_CNT      1024
+#define PERF_PKT_TS_CNT     64
+
+typedef struct DecPerfEvent_t {
+    RK_S64          start;
+    RK_U32          dur;
+    RK_U32          stage;
+} DecPerfEvent;
+
+typedef struct DecPerfHist_t {
+    RK_U64          count;
+    RK_U64          sum;
+    RK_U32          max;
+    RK_U32          bucket[PERF_BUCKET_CNT];
+} DecPerfHist;
+
+typedef struct MppDecPerfImpl_t {
+    DecPerfHist     hist[MPP_DEC_PERF_STAGE_BUTT];
+
+    /* recent records ring for trace */
+    RK_U32          event_idx;
+    DecPerfEvent    events[PERF_EVENT_CNT];
+
+    /* packet input time fifo */
+    RK_U32          pkt_put;
+    RK_U32          pkt_get;
+    RK_S64          pkt_ts[PERF_PKT_TS_CNT];
+
+    RK_S64          frm_out_time;
+} MppDecPerfImpl;
+
+static const char *perf_stage_name[MPP_DEC_PERF_STAGE_BUTT] = {
+    "pkt_in",
+    "wait_pkt",
+    "wait_buf",
+    "prepare",
+    "parse",
+    "gen_reg",
+    "hw_start",
+    "hw_wait",
+    "frm_out",
+};
+
+static RK_U32 perf_bucket(RK_U32 val)
+{
+    RK_U32 exp;
+
+    if (val < PERF_SUB_CNT)
+        return val;
+
+    exp = 31 - __builtin_clz(val);
+
+    return ((exp - PERF_SUB_BITS + 1) << PERF_SUB_BITS) +
+           ((val >> (exp - PERF_SUB_BITS)) & (PERF_SUB_CNT - 1));
+}
+
+/* return the upper bound of the bucket */
+static RK_U32 perf_bucket_val(RK_U32 idx)
+{
+    RK_U32 exp;
+    RK_U32 low;
+
+    if (idx < PERF_SUB_CNT)
+        return idx;
+
+    exp = (idx >> PERF_SUB_BITS) + PERF_SUB_BITS - 1;
+    low = (PERF_SUB_CNT + (idx & (PERF_SUB_CNT - 1))) << (exp - PERF_SUB_BITS);
+
+    return low + ((1 << (exp - PERF_SUB_BITS)) - 1);
+}
+
+static RK_U32 perf_percentile(DecPerfHist *hist, RK_U64 count, RK_U32 permille)
+{
+    RK_U64 target = (count * permille + 999) / 1000;
+    RK_U64 acc = 0;
+    RK_U32 i;
+
+    for (i = 0; i < PERF_BUCKET_CNT; i++) {
+        acc += hist->bucket[i];
+        if (acc >= target)
+            return MPP_MIN(perf_bucket_val(i), hist->max);
+    }
+
+    return hist->max;
+}
+
+MPP_RET mpp_dec_perf_init(MppDecPerf *perf)
+{
+    MppDecPerfImpl *p;
+
+    if (NULL == perf) {
+        mpp_err_f("invalid NULL input\n");
+        return MPP_ERR_NULL_PTR;
+    }
+
+    p = mpp_calloc(MppDecPerfImpl, 1);
+    *perf = p;
+    if (NULL == p) {
+        mpp_err_f("failed to malloc context\n");
+        return MPP_ERR_MALLOC;
+    }
+
+    return MPP_OK;
+}
+
+MPP_RET mpp_dec_perf_deinit(MppDecPerf perf)
+{
+    MPP_FREE(perf);
+    return MPP_OK;
+}
+
+MPP_RET mpp_dec_perf_reset(MppDecPerf perf)
+{
+    MppDecPerfImpl *p = (MppDecPerfImpl *)perf;
+
+    if (NULL == p)
+        return MPP_ERR_NULL_PTR;
+
+    /* packets in queue are dropped on reset */
+    p->pkt_get = p->pkt_put;
+    p->frm_out_time = 0;
+
+    return MPP_OK;
+}
+
+void mpp_dec_perf_record(MppDecPerf perf, MppDecPerfStage stage, RK_S64 start, RK_S64 end)
+{
+    MppDecPerfImpl *p = (MppDecPerfImpl *)perf;
+    DecPerfHist *hist;
+    DecPerfEvent *event;
+    RK_U32 dur;
+    RK_U32 max;
+
+    if (NULL == p || stage >= MPP_DEC_PERF_STAGE_BUTT)
+        return;
+
+    dur = (end > start) ? (RK_U32)MPP_MIN(end - start, (RK_S64)0xffffffff) : 0;
+    hist = &p->hist[stage];
+
+    MPP_FETCH_ADD(&hist->bucket[perf_bucket(dur)], 1);
+    MPP_FETCH_ADD(&hist->sum, dur);
+    MPP_FETCH_ADD(&hist->count, 1);
+
+    max = hist->max;
+    while (dur > max && !MPP_BOOL_CAS(&hist->max, max, dur))
+        max = hist->max;
+
+    event = &p->events[MPP_FETCH_ADD(&p->event_idx, 1) & (PERF_EVENT_CNT - 1)];
+    event->start = start;
+    event->dur = dur;
+    event->stage = stage;
+}
+
+void mpp_dec_perf_pkt_put(MppDecPerf perf)
+{
+    MppDecPerfImpl *p = (MppDecPerfImpl *)perf;
+
+    if (NULL == p)
+        return;
+
+    p->pkt_ts[p->pkt_put & (PERF_PKT_TS_CNT - 1)] = mpp_time();
+    MPP_SYNC();
+    p->pkt_put++;
+}
+
+void mpp_dec_perf_pkt_get(MppDecPerf perf)
+{
+    MppDecPerfImpl *p = (MppDecPerfImpl *)perf;
+    RK_U32 put;
+
+    if (NULL == p)
+        return;
+
+    put = p->pkt_put;
+    /* packet not stamped or overwritten */
+    if (p->pkt_get == put || put - p->pkt_get > PERF_PKT_TS_CNT) {
+        p->pkt_get = put;
+        return;
+    }
+
+    mpp_dec_perf_record(p, MPP_DEC_PERF_PKT_IN,
+                        p->pkt_ts[p->pkt_get & (PERF_PKT_TS_CNT - 1)], mpp_time());
+    p->pkt_get++;
+}
+
+void mpp_dec_perf_frm_out(MppDecPerf perf)
+{
+    MppDecPerfImpl *p = (MppDecPerfImpl *)perf;
+    RK_S64 now = mpp_time();
+    RK_S64 last;
+
+    if (NULL == p)
+        return;
+
+    last = MPP_SYNC_TEST_SET(&p->frm_out_time, now);
+    if (last)
+        mpp_dec_perf_record(p, MPP_DEC_PERF_FRM_OUT, last, now);
+}
+
+MPP_RET mpp_dec_perf_get_stats(MppDecPerf perf, MppDecPerfStats *stats)
+{
+    MppDecPerfImpl *p = (MppDecPerfImpl *)perf;
+    RK_U32 i;
+
+    if (NULL == p || NULL == stats) {
+        mpp_err_f("invalid input perf %p stats %p\n", p, stats);
+        return MPP_ERR_NULL_PTR;
+    }
+
+    for (i = 0; i < MPP_DEC_PERF_STAGE_BUTT; i++) {
+        DecPerfHist *hist = &p->hist[i];
+        MppDecPerfStat *stat = &stats->stage[i];
+        RK_U64 count = hist->count;
+
+        stat->name = perf_stage_name[i];
+        stat->count = count;
+        stat->sum = hist->sum;
+        stat->max = hist->max;
+        stat->p50 = count ? perf_percentile(hist, count, 500) : 0;
+        stat->p99 = count ? perf_percentile(hist, count, 990) : 0;
+    }
+
+    return MPP_OK;
+}
+
+void mpp_dec_perf_show(MppDecPerf perf, const char *tag)
+{
+    MppDecPerfStats stats;
+    RK_U32 i;
+
+    if (mpp_dec_perf_get_stats(perf, &stats))
+        return;
+
+    for (i = 0; i < MPP_DEC_PERF_STAGE_BUTT; i++) {
+        MppDecPerfStat *stat = &stats.stage[i];
+
+        if (!stat->count)
+            continue;
+
+        mpp_log("%s %-8s count %-8lld avg %-6lld p50 %-6d p99 %-6d max %-6d\n",
+                tag, perf_stage_name[i], stat->count, stat->sum / stat->count,
+                stat->p50, stat->p99, stat->max);
+    }
+}
+
+MPP_RET mpp_dec_perf_dump_trace(MppDecPerf perf, const char *path)
+{
+    MppDecPerfImpl *p = (MppDecPerfImpl *)perf;
+    MppTraceJson json = NULL;
+    RK_U32 end;
+    RK_U32 i;
+    MPP_RET ret;
+
+    if (NULL == p)
+        return MPP_ERR_NULL_PTR;
+
+    ret = mpp_trace_json_open(&json, path);
+    if (ret)
+        return ret;
+
+    end = p->event_idx;
+    i = (end > PERF_EVENT_CNT) ? (end - PERF_EVENT_CNT) : 0;
+
+    /* one trace row for each stage */
+    for (; i != end; i++) {
+        DecPerfEvent *event = &p->events[i & (PERF_EVENT_CNT - 1)];
+
+        mpp_trace_json_event(json, perf_stage_name[event->stage], getpid(),
+                             event->stage + 1, event->start, event->dur);
+    }
+
+    return mpp_trace_json_close(json);
+}
@@ -193,7 +193,7 @@ static void check_hal_task_pkt_len(HalEncTask *task, const char *reason)
 static MPP_RET check_enc_task_wait(MppEncImpl *enc, EncAsyncWait *wait)
 {
     MPP_RET ret = MPP_OK;
-    RK_U32 notify = enc->notify_flag;
+    RK_U32 notify = enc->thread_enc->get_event();
     RK_U32 last_wait = enc->status_flag;
     RK_U32 curr_wait = wait->val;
     RK_U32 wait_chg  = last_wait & (~curr_wait);
@@ -220,7 +220,7 @@ static MPP_RET check_enc_task_wait(MppEncImpl *enc, EncAsyncWait *wait)
                    last_wait, curr_wait, wait_chg, notify, (ret) ? ("wait") : ("work"));
 
     enc->status_flag = wait->val;
-    enc->notify_flag = keep_notify;
+    enc->thread_enc->clear_event(notify & ~keep_notify);
 
     if (ret) {
         enc->wait_count++;
@@ -679,19 +679,25 @@ MPP_RET mpp_enc_proc_rc_cfg(MppCodingType coding, MppEncRcCfg *dst, MppEncRcCfg
             dst->refresh_num = src->refresh_num;
         }
 
-        // parameter checking
-        if (dst->rc_mode >= MPP_ENC_RC_MODE_BUTT) {
+        /*
+         * parameter checking
+         * dst is valid before this call so only the changed groups are checked
+         */
+        if ((change & MPP_ENC_RC_CFG_CHANGE_RC_MODE) &&
+            dst->rc_mode >= MPP_ENC_RC_MODE_BUTT) {
             mpp_err("invalid rc mode %d should be RC_MODE_VBR or RC_MODE_CBR\n",
                     src->rc_mode);
             ret = MPP_ERR_VALUE;
         }
-        if (dst->quality >= MPP_ENC_RC_QUALITY_BUTT) {
+        if ((change & MPP_ENC_RC_CFG_CHANGE_QUALITY) &&
+            dst->quality >= MPP_ENC_RC_QUALITY_BUTT) {
             mpp_err("invalid quality %d should be from QUALITY_WORST to QUALITY_BEST\n",
                     dst->quality);
             ret = MPP_ERR_VALUE;
         }
 
-        if (dst->rc_mode != MPP_ENC_RC_MODE_FIXQP) {
+        if ((change & (MPP_ENC_RC_CFG_CHANGE_RC_MODE | MPP_ENC_RC_CFG_CHANGE_BPS)) &&
+            dst->rc_mode != MPP_ENC_RC_MODE_FIXQP) {
             RK_S32 bps_min = MPP_ENC_MIN_BPS;
             RK_S32 bps_max = MPP_ENC_MAX_BPS;
 
@@ -713,8 +719,9 @@ MPP_RET mpp_enc_proc_rc_cfg(MppCodingType coding, MppEncRcCfg *dst, MppEncRcCfg
             }
         }
 
-        if (dst->fps_in_num < 0 || dst->fps_in_denom < 0 ||
-            dst->fps_out_num < 0 || dst->fps_out_denom < 0) {
+        if ((change & (MPP_ENC_RC_CFG_CHANGE_FPS_IN | MPP_ENC_RC_CFG_CHANGE_FPS_OUT)) &&
+            (dst->fps_in_num < 0 || dst->fps_in_denom < 0 ||
+             dst->fps_out_num < 0 || dst->fps_out_denom < 0)) {
             mpp_err("invalid fps cfg [number:denom:flex]: in [%d:%d:%d] out [%d:%d:%d]\n",
                     dst->fps_in_num, dst->fps_in_denom, dst->fps_in_flex,
                     dst->fps_out_num, dst->fps_out_denom, dst->fps_out_flex);
@@ -726,11 +733,13 @@ MPP_RET mpp_enc_proc_rc_cfg(MppCodingType coding, MppEncRcCfg *dst, MppEncRcCfg
             dst->qp_min_i = dst->qp_min;
         if (dst->qp_max_i <= 0)
             dst->qp_max_i = dst->qp_max;
-        if (dst->qp_min < 0 || dst->qp_max < 0 || dst->qp_min > dst->qp_max ||
-            dst->qp_min_i < 0 || dst->qp_max_i < 0 ||
-            dst->qp_min_i > dst->qp_max_i ||
-            (dst->qp_init > 0 &&
-             (dst->qp_init > dst->qp_max_i || dst->qp_init < dst->qp_min_i))) {
+        if ((change & (MPP_ENC_RC_CFG_CHANGE_QP_INIT | MPP_ENC_RC_CFG_CHANGE_QP_RANGE |
+                       MPP_ENC_RC_CFG_CHANGE_QP_RANGE_I)) &&
+            (dst->qp_min < 0 || dst->qp_max < 0 || dst->qp_min > dst->qp_max ||
+             dst->qp_min_i < 0 || dst->qp_max_i < 0 ||
+             dst->qp_min_i > dst->qp_max_i ||
+             (dst->qp_init > 0 &&
+              (dst->qp_init > dst->qp_max_i || dst->qp_init < dst->qp_min_i)))) {
             mpp_err("invalid qp range: init %d i [%d:%d] p [%d:%d]\n",
                     dst->qp_init, dst->qp_min_i, dst->qp_max_i,
                     dst->qp_min, dst->qp_max);
@@ -745,22 +754,23 @@ MPP_RET mpp_enc_proc_rc_cfg(MppCodingType coding, MppEncRcCfg *dst, MppEncRcCfg
                     dst->qp_init, dst->qp_min_i, dst->qp_max_i,
                     dst->qp_min, dst->qp_max);
         }
-        if (MPP_ABS(dst->qp_delta_ip) > 8) {
+        if ((change & MPP_ENC_RC_CFG_CHANGE_QP_IP) && MPP_ABS(dst->qp_delta_ip) > 8) {
             mpp_err("invalid qp delta ip %d restore to %d\n",
                     dst->qp_delta_ip, bak.qp_delta_ip);
             dst->qp_delta_ip = bak.qp_delta_ip;
         }
-        if (MPP_ABS(dst->qp_delta_vi) > 6) {
+        if ((change & MPP_ENC_RC_CFG_CHANGE_QP_VI) && MPP_ABS(dst->qp_delta_vi) > 6) {
             mpp_err("invalid qp delta vi %d restore to %d\n",
                     dst->qp_delta_vi, bak.qp_delta_vi);
             dst->qp_delta_vi = bak.qp_delta_vi;
         }
-        if (dst->qp_max_step < 0) {
+        if ((change & MPP_ENC_RC_CFG_CHANGE_QP_MAX_STEP) && dst->qp_max_step < 0) {
             mpp_err("invalid qp max step %d restore to %d\n",
                     dst->qp_max_step, bak.qp_max_step);
             dst->qp_max_step = bak.qp_max_step;
         }
-        if (dst->stats_time && dst->stats_time > 60) {
+        if ((change & MPP_ENC_RC_CFG_CHANGE_ST_TIME) &&
+            dst->stats_time && dst->stats_time > 60) {
             mpp_err("warning: bitrate statistic time %d is larger than 60s\n",
                     dst->stats_time);
         }
@@ -770,7 +780,9 @@ MPP_RET mpp_enc_proc_rc_cfg(MppCodingType coding, MppEncRcCfg *dst, MppEncRcCfg
         if (ret) {
             mpp_err_f("failed to accept new rc config\n");
             *dst = bak;
-        } else {
+        } else if (change & (MPP_ENC_RC_CFG_CHANGE_RC_MODE | MPP_ENC_RC_CFG_CHANGE_BPS |
+                             MPP_ENC_RC_CFG_CHANGE_FPS_IN | MPP_ENC_RC_CFG_CHANGE_FPS_OUT |
+                             MPP_ENC_RC_CFG_CHANGE_GOP)) {
             mpp_log("MPP_ENC_SET_RC_CFG bps %d [%d : %d] fps [%d:%d] gop %d\n",
                     dst->bps_target, dst->bps_min, dst->bps_max,
                     dst->fps_in_num, dst->fps_out_num, dst->gop);
@@ -1673,22 +1685,6 @@ TASK_DONE:
     return ret;
 }
 
-static void mpp_enc_clr_rc_cb_info(EncRcTask *rc_task)
-{
-    EncRcTaskInfo *hal_rc = (EncRcTaskInfo *) &rc_task->info;
-    EncRcTaskInfo bak = rc_task->info;
-
-    memset(hal_rc, 0, sizeof(rc_task->info));
-
-    hal_rc->frame_type = bak.frame_type;
-    hal_rc->bit_target = bak.bit_target;
-    hal_rc->bit_max = bak.bit_max;
-    hal_rc->bit_min = bak.bit_min;
-    hal_rc->quality_target = bak.quality_target;
-    hal_rc->quality_max = bak.quality_max;
-    hal_rc->quality_min = bak.quality_min;
-}
-
 static MPP_RET mpp_enc_reenc_simple(Mpp *mpp, EncAsyncTaskInfo *task)
 {
     MppEncImpl *enc = (MppEncImpl *)mpp->mEnc;
@@ -1700,7 +1696,7 @@ static MPP_RET mpp_enc_reenc_simple(Mpp *mpp, EncAsyncTaskInfo *task)
 
     enc_dbg_func("enter\n");
 
-    mpp_enc_clr_rc_cb_info(rc_task);
+    rc_frm_clr_hal_info(rc_task);
 
     enc_dbg_detail("task %d enc proc hal\n", frm->seq_idx);
     ENC_RUN_FUNC2(enc_impl_proc_hal, enc->impl, hal_task, mpp, ret);
@@ -2356,7 +2352,7 @@ void *mpp_enc_thread(void *data)
                 break;
 
             if (check_enc_task_wait(enc, &wait))
-                thd_enc->wait();
+                thd_enc->wait_event(wait.val | MPP_ENC_CONTROL);
         }
 
         // When encoder is not on encoding process external config and reset
@@ -2900,7 +2896,7 @@ TASK_DONE:
 static MPP_RET check_enc_async_wait(MppEncImpl *enc, EncAsyncWait *wait)
 {
     MPP_RET ret = MPP_OK;
-    RK_U32 notify = enc->notify_flag;
+    RK_U32 notify = enc->thread_enc->get_event();
     RK_U32 last_wait = enc->status_flag;
     RK_U32 curr_wait = wait->val;
     RK_U32 wait_chg  = last_wait & (~curr_wait);
@@ -2927,7 +2923,7 @@ static MPP_RET check_enc_async_wait(MppEncImpl *enc, EncAsyncWait *wait)
                    last_wait, curr_wait, wait_chg, notify, (ret) ? ("wait") : ("work"));
 
     enc->status_flag = wait->val;
-    enc->notify_flag = keep_notify;
+    enc->thread_enc->clear_event(notify & ~keep_notify);
 
     if (ret) {
         enc->wait_count++;
@@ -3030,7 +3026,7 @@ void *mpp_enc_async_thread(void *data)
 
             if (check_enc_async_wait(enc, &wait)) {
                 enc_dbg_detail("wait start\n");
-                thd_enc->wait();
+                thd_enc->wait_event(wait.val | MPP_ENC_CONTROL);
                 enc_dbg_detail("wait done\n");
             }
         }
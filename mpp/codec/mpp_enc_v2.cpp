@@ -291,22 +291,10 @@ MPP_RET mpp_enc_notify_v2(MppEnc ctx, RK_U32 flag)
     MppThread *thd  = enc->thread_enc;
 
     thd->lock();
-    if (flag == MPP_ENC_CONTROL) {
-        enc->notify_flag |= flag;
-        enc_dbg_notify("%p status %08x notify control signal\n", enc,
-                       enc->status_flag);
-        thd->signal();
-    } else {
-        RK_U32 old_flag = enc->notify_flag;
-
-        enc->notify_flag |= flag;
-        if ((old_flag != enc->notify_flag) &&
-            (enc->notify_flag & enc->status_flag)) {
-            enc_dbg_notify("%p status %08x notify %08x signal\n", enc,
-                           enc->status_flag, enc->notify_flag);
-            thd->signal();
-        }
-    }
+    enc_dbg_notify("%p status %08x notify %08x flag %08x\n", enc,
+                   enc->status_flag, thd->get_event(), flag);
+    /* encoder waits with MPP_ENC_CONTROL in mask so control always wakes it */
+    thd->notify_event(flag);
     thd->unlock();
     enc_dbg_func("%p out\n", enc);
     return MPP_OK;
@@ -21,6 +21,7 @@
 
 #include "mpp_env.h"
 #include "mpp_mem.h"
+#include "mpp_lock.h"
 #include "mpp_list.h"
 #include "mpp_common.h"
 
@@ -28,6 +29,7 @@
 #include "rc.h"
 #include "rc_impl.h"
 #include "rc_base.h"
+#include "rc_trace.h"
 
 typedef struct MppRcImpl_t {
     void            *ctx;
@@ -39,9 +41,42 @@ typedef struct MppRcImpl_t {
 
     RK_U32          frm_send;
     RK_U32          frm_done;
+
+    /* trace for offline replay */
+    FILE            *trace;
 } MppRcImpl;
 
 RK_U32 rc_debug = 0;
+static RK_S32 rc_trace_cnt = 0;
+
+static FILE *rc_trace_open(const RcImplApi *api)
+{
+    const char *path = NULL;
+    char name[256];
+    RK_S32 idx;
+    FILE *fp;
+
+    mpp_env_get_str("rc_trace_path", &path, NULL);
+    if (!path || !path[0])
+        return NULL;
+
+    /* first context uses the path as it is, others add index */
+    idx = MPP_FETCH_ADD(&rc_trace_cnt, 1);
+    if (idx)
+        snprintf(name, sizeof(name), "%s.%d", path, idx);
+    else
+        snprintf(name, sizeof(name), "%s", path);
+
+    fp = fopen(name, "w");
+    if (!fp) {
+        mpp_err_f("failed to open rc trace %s\n", name);
+        return NULL;
+    }
+
+    mpp_log("rc trace %s\n", name);
+    rc_trace_write_api(fp, api->type, api->name);
+    return fp;
+}
 
 const static char default_rc_api[] = "default";
 
@@ -77,6 +112,7 @@ MPP_RET rc_init(RcCtx *ctx, MppCodingType type, const char **request_name)
             p->ctx = rc_ctx;
             p->api = api;
             p->frm_cnt = -1;
+            p->trace = rc_trace_open(api);
             if (request_name && *request_name)
                 mpp_log("using rc impl %s\n", api->name);
             ret = MPP_OK;
@@ -105,6 +141,11 @@ MPP_RET rc_deinit(RcCtx ctx)
         MPP_FREE(p->ctx);
     }
 
+    if (p->trace) {
+        fclose(p->trace);
+        p->trace = NULL;
+    }
+
     MPP_FREE(p);
 
     rc_dbg_func("leave %p\n", ctx);
@@ -123,6 +164,9 @@ MPP_RET rc_update_usr_cfg(RcCtx ctx, RcCfg *cfg)
     p->cfg = *cfg;
     p->fps = cfg->fps;
 
+    if (p->trace)
+        rc_trace_write_cfg(p->trace, cfg);
+
     if (api && api->init && p->ctx)
         api->init(p->ctx, &p->cfg);
 
@@ -203,6 +247,9 @@ MPP_RET rc_frm_end(RcCtx ctx, EncRcTask *task)
     if (!api || !api->frm_end || !p->ctx || !task)
         return MPP_OK;
 
+    if (p->trace)
+        rc_trace_write_frm(p->trace, task);
+
     return api->frm_end(p->ctx, task);
 }
 
@@ -227,3 +274,19 @@ MPP_RET rc_hal_end(RcCtx ctx, EncRcTask *task)
 
     return api->hal_end(p->ctx, task);
 }
+
+void rc_frm_clr_hal_info(EncRcTask *task)
+{
+    EncRcTaskInfo *info = &task->info;
+    EncRcTaskInfo bak = task->info;
+
+    memset(info, 0, sizeof(*info));
+
+    info->frame_type = bak.frame_type;
+    info->bit_target = bak.bit_target;
+    info->bit_max = bak.bit_max;
+    info->bit_min = bak.bit_min;
+    info->quality_target = bak.quality_target;
+    info->quality_max = bak.quality_max;
+    info->quality_min = bak.quality_min;
+}
@@ -21,6 +21,8 @@
 
 typedef struct RcModelV2Ctx_t {
     RcCfg           usr_cfg;
+    /* user config before model fixup for change check */
+    RcCfg           usr_cfg_in;
 
     RK_U32          last_frame_type;
     RK_S64          gop_total_bits;
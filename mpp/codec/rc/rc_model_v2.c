@@ -17,6 +17,7 @@
 #define MODULE_TAG "rc_model_v2"
 
 #include <math.h>
+#include <stddef.h>
 #include <string.h>
 
 #include "mpp_env.h"
@@ -1317,13 +1318,38 @@ MPP_RET check_re_enc(RcModelV2Ctx *ctx, EncRcTaskInfo *cfg)
 }
 
 
+/*
+ * qp bounds are read on each frame, a change limited to them can be applied
+ * without resetting the bit model and its statistic windows
+ */
+static RK_S32 check_quality_only(RcCfg *old, RcCfg *cfg)
+{
+    size_t start = offsetof(RcCfg, max_quality);
+    size_t end = offsetof(RcCfg, max_reencode_times);
+
+    return !memcmp(old, cfg, start) &&
+           !memcmp((RK_U8 *)old + end, (RK_U8 *)cfg + end, sizeof(RcCfg) - end);
+}
+
 MPP_RET rc_model_v2_init(void *ctx, RcCfg *cfg)
 {
     RcModelV2Ctx *p = (RcModelV2Ctx*)ctx;
 
     rc_dbg_func("enter %p\n", ctx);
 
+    if (p->i_bit && check_quality_only(&p->usr_cfg_in, cfg)) {
+        size_t start = offsetof(RcCfg, max_quality);
+        size_t end = offsetof(RcCfg, max_reencode_times);
+
+        memcpy((RK_U8 *)&p->usr_cfg + start, (RK_U8 *)cfg + start, end - start);
+        memcpy(&p->usr_cfg_in, cfg, sizeof(RcCfg));
+        rc_dbg_rc("update qp bounds only\n");
+        rc_dbg_func("leave %p\n", ctx);
+        return MPP_OK;
+    }
+
     memcpy(&p->usr_cfg, cfg, sizeof(RcCfg));
+    memcpy(&p->usr_cfg_in, cfg, sizeof(RcCfg));
     bits_model_init(p);
 
     rc_dbg_func("leave %p\n", ctx);
@@ -0,0 +1,271 @@
+/* SPDX-License-Identifier: Apache-2.0 OR MIT */
+/*
+ * Copyright (c) 2024 Rockchip Electronics Co., Ltd.
+ */
+
+#define MODULE_TAG "rc_trace"
+
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "mpp_mem.h"
+#include "mpp_debug.h"
+#include "mpp_common.h"
+
+#include "rc_trace.h"
+
+#define RC_TRACE_LINE_MAX   2048
+
+typedef struct RcTraceField_t {
+    const char  *name;
+    RK_S32      offset;
+    RK_S32      size;
+} RcTraceField;
+
+#define TRACE_FIELD(type, field) \
+    { #field, offsetof(type, field), sizeof(((type *)0)->field) }
+
+#define CFG_FIELD(field)    TRACE_FIELD(RcCfg, field)
+#define INFO_FIELD(field)   TRACE_FIELD(EncRcTaskInfo, field)
+
+static const RcTraceField cfg_fields[] = {
+    CFG_FIELD(width),
+    CFG_FIELD(height),
+    CFG_FIELD(mode),
+    CFG_FIELD(fps.fps_in_flex),
+    CFG_FIELD(fps.fps_in_num),
+    CFG_FIELD(fps.fps_in_denom),
+    CFG_FIELD(fps.fps_out_flex),
+    CFG_FIELD(fps.fps_out_num),
+    CFG_FIELD(fps.fps_out_denom),
+    CFG_FIELD(gop_mode),
+    CFG_FIELD(igop),
+    CFG_FIELD(vgop),
+    CFG_FIELD(bps_min),
+    CFG_FIELD(bps_target),
+    CFG_FIELD(bps_max),
+    CFG_FIELD(stats_time),
+    CFG_FIELD(max_i_bit_prop),
+    CFG_FIELD(min_i_bit_prop),
+    CFG_FIELD(init_ip_ratio),
+    CFG_FIELD(layer_bit_prop[0]),
+    CFG_FIELD(layer_bit_prop[1]),
+    CFG_FIELD(layer_bit_prop[2]),
+    CFG_FIELD(layer_bit_prop[3]),
+    CFG_FIELD(init_quality),
+    CFG_FIELD(max_quality),
+    CFG_FIELD(min_quality),
+    CFG_FIELD(max_i_quality),
+    CFG_FIELD(min_i_quality),
+    CFG_FIELD(i_quality_delta),
+    CFG_FIELD(vi_quality_delta),
+    CFG_FIELD(fqp_min_i),
+    CFG_FIELD(fqp_min_p),
+    CFG_FIELD(fqp_max_i),
+    CFG_FIELD(fqp_max_p),
+    CFG_FIELD(layer_quality_delta[0]),
+    CFG_FIELD(layer_quality_delta[1]),
+    CFG_FIELD(layer_quality_delta[2]),
+    CFG_FIELD(layer_quality_delta[3]),
+    CFG_FIELD(max_reencode_times),
+    CFG_FIELD(min_still_prop),
+    CFG_FIELD(max_still_quality),
+    CFG_FIELD(vbr_hi_prop),
+    CFG_FIELD(vbr_lo_prop),
+    CFG_FIELD(drop_mode),
+    CFG_FIELD(drop_thd),
+    CFG_FIELD(drop_gap),
+    CFG_FIELD(super_cfg.super_mode),
+    CFG_FIELD(super_cfg.super_i_thd),
+    CFG_FIELD(super_cfg.super_p_thd),
+    CFG_FIELD(super_cfg.rc_priority),
+    CFG_FIELD(debreath_cfg.enable),
+    CFG_FIELD(debreath_cfg.strength),
+    CFG_FIELD(hier_qp_cfg.hier_qp_en),
+    CFG_FIELD(hier_qp_cfg.hier_qp_delta[0]),
+    CFG_FIELD(hier_qp_cfg.hier_qp_delta[1]),
+    CFG_FIELD(hier_qp_cfg.hier_qp_delta[2]),
+    CFG_FIELD(hier_qp_cfg.hier_qp_delta[3]),
+    CFG_FIELD(hier_qp_cfg.hier_frame_num[0]),
+    CFG_FIELD(hier_qp_cfg.hier_frame_num[1]),
+    CFG_FIELD(hier_qp_cfg.hier_frame_num[2]),
+    CFG_FIELD(hier_qp_cfg.hier_frame_num[3]),
+    CFG_FIELD(refresh_len),
+    CFG_FIELD(scene_mode),
+    CFG_FIELD(fps_chg_prop),
+};
+
+static const RcTraceField info_fields[] = {
+    INFO_FIELD(frame_type),
+    INFO_FIELD(bit_target),
+    INFO_FIELD(bit_max),
+    INFO_FIELD(bit_min),
+    INFO_FIELD(quality_target),
+    INFO_FIELD(quality_max),
+    INFO_FIELD(quality_min),
+    INFO_FIELD(bit_real),
+    INFO_FIELD(quality_real),
+    INFO_FIELD(madi),
+    INFO_FIELD(madp),
+    INFO_FIELD(iblk4_prop),
+    INFO_FIELD(sse),
+    INFO_FIELD(lvl64_inter_num),
+    INFO_FIELD(lvl32_inter_num),
+    INFO_FIELD(lvl16_inter_num),
+    INFO_FIELD(lvl8_inter_num),
+    INFO_FIELD(lvl32_intra_num),
+    INFO_FIELD(lvl16_intra_num),
+    INFO_FIELD(lvl8_intra_num),
+    INFO_FIELD(lvl4_intra_num),
+};
+
+static void write_fields(FILE *fp, const RcTraceField *fields, RK_S32 count, void *base)
+{
+    RK_S32 i;
+
+    for (i = 0; i < count; i++) {
+        RK_U8 *p = (RK_U8 *)base + fields[i].offset;
+
+        if (fields[i].size == sizeof(RK_S64)) {
+            long long val = *(RK_S64 *)p;
+
+            fprintf(fp, " %s=%lld", fields[i].name, val);
+        } else
+            fprintf(fp, " %s=%d", fields[i].name, *(RK_S32 *)p);
+    }
+}
+
+static RK_S32 parse_fields(const RcTraceField *fields, RK_S32 count, void *base, char *str)
+{
+    char *save = NULL;
+    char *tok;
+    RK_S32 found = 0;
+
+    for (tok = strtok_r(str, " \t\r\n", &save); tok; tok = strtok_r(NULL, " \t\r\n", &save)) {
+        char *val = strchr(tok, '=');
+        RK_S32 i;
+
+        if (!val)
+            continue;
+
+        *val++ = '\0';
+
+        for (i = 0; i < count; i++) {
+            RK_U8 *p = (RK_U8 *)base + fields[i].offset;
+
+            if (strcmp(tok, fields[i].name))
+                continue;
+
+            if (fields[i].size == sizeof(RK_S64))
+                *(RK_S64 *)p = strtoll(val, NULL, 0);
+            else
+                *(RK_S32 *)p = (RK_S32)strtoll(val, NULL, 0);
+
+            found++;
+            break;
+        }
+    }
+
+    return found;
+}
+
+void rc_trace_write_api(FILE *fp, MppCodingType type, const char *name)
+{
+    fprintf(fp, "api type=%d name=%s\n", type, name);
+}
+
+void rc_trace_write_cfg(FILE *fp, RcCfg *cfg)
+{
+    fprintf(fp, "cfg");
+    write_fields(fp, cfg_fields, MPP_ARRAY_ELEMS(cfg_fields), cfg);
+    fprintf(fp, "\n");
+}
+
+void rc_trace_write_frm(FILE *fp, EncRcTask *task)
+{
+    fprintf(fp, "frm status=0x%llx", (unsigned long long)task->frm.val);
+    write_fields(fp, info_fields, MPP_ARRAY_ELEMS(info_fields), &task->info);
+    fprintf(fp, "\n");
+}
+
+RK_S32 rc_trace_parse_cfg(RcCfg *cfg, char *str)
+{
+    return parse_fields(cfg_fields, MPP_ARRAY_ELEMS(cfg_fields), cfg, str);
+}
+
+MPP_RET rc_trace_add_frm(RcTraceData *data, RcTraceFrm *frm)
+{
+    if (data->count >= data->size) {
+        RK_S32 size = data->size ? data->size * 2 : 1024;
+        RcTraceFrm *frms = mpp_realloc(data->frms, RcTraceFrm, size);
+
+        if (!frms) {
+            mpp_err_f("failed to grow frame trace to %d\n", size);
+            return MPP_ERR_MALLOC;
+        }
+
+        data->frms = frms;
+        data->size = size;
+    }
+
+    data->frms[data->count++] = *frm;
+    return MPP_OK;
+}
+
+MPP_RET rc_trace_load(RcTraceData *data, FILE *fp)
+{
+    char *line = mpp_malloc(char, RC_TRACE_LINE_MAX);
+    RK_S32 cfg_cnt = 0;
+    MPP_RET ret = MPP_OK;
+
+    if (!line)
+        return MPP_ERR_MALLOC;
+
+    memset(data, 0, sizeof(*data));
+
+    while (fgets(line, RC_TRACE_LINE_MAX, fp)) {
+        if (!strncmp(line, "api ", 4)) {
+            char *name = strstr(line, "name=");
+
+            data->type = (MppCodingType)strtol(line + 9, NULL, 0);
+            if (name)
+                sscanf(name + 5, "%31s", data->name);
+        } else if (!strncmp(line, "cfg ", 4)) {
+            /* replay runs on one config, keep the one before first frame */
+            if (!data->count)
+                rc_trace_parse_cfg(&data->cfg, line + 4);
+            cfg_cnt++;
+        } else if (!strncmp(line, "frm ", 4)) {
+            RcTraceFrm frm;
+            char *status = strstr(line, "status=");
+
+            memset(&frm, 0, sizeof(frm));
+            if (status)
+                frm.frm.val = strtoull(status + 7, NULL, 0);
+            parse_fields(info_fields, MPP_ARRAY_ELEMS(info_fields), &frm.info, line + 4);
+
+            ret = rc_trace_add_frm(data, &frm);
+            if (ret)
+                break;
+        }
+    }
+
+    if (cfg_cnt > 1)
+        mpp_log_f("%d config changes found, replay on the first config\n", cfg_cnt - 1);
+
+    if (!ret && !cfg_cnt) {
+        mpp_err_f("no rc config found in trace\n");
+        ret = MPP_NOK;
+    }
+
+    MPP_FREE(line);
+    return ret;
+}
+
+void rc_trace_release(RcTraceData *data)
+{
+    MPP_FREE(data->frms);
+    data->count = 0;
+    data->size = 0;
+}
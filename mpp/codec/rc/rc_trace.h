@@ -0,0 +1,61 @@
+/* SPDX-License-Identifier: Apache-2.0 OR MIT */
+/*
+ * Copyright (c) 2024 Rockchip Electronics Co., Ltd.
+ */
+
+#ifndef __RC_TRACE_H__
+#define __RC_TRACE_H__
+
+#include <stdio.h>
+
+#include "mpp_rc_api.h"
+
+/*
+ * Rate control trace for offline replay
+ *
+ * When env rc_trace_path is set each rc context writes a text trace with the
+ * rc api, every user config and the status, rc decision and hardware feedback
+ * of every encoded frame. Each line is a tag followed by key=value pairs:
+ *
+ * api type=<coding> name=<rc api name>
+ * cfg width=1920 height=1080 mode=1 ...        (RcCfg fields)
+ * frm status=0x... bit_target=... bit_real=...  (EncFrmStatus / EncRcTaskInfo)
+ *
+ * Unknown keys are skipped on loading so old traces still load after new
+ * fields are added.
+ */
+typedef struct RcTraceFrm_t {
+    EncFrmStatus    frm;
+    EncRcTaskInfo   info;
+} RcTraceFrm;
+
+typedef struct RcTraceData_t {
+    MppCodingType   type;
+    char            name[32];
+    /* the first config, later config changes are not kept */
+    RcCfg           cfg;
+    RcTraceFrm      *frms;
+    RK_S32          count;
+    RK_S32          size;
+} RcTraceData;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void rc_trace_write_api(FILE *fp, MppCodingType type, const char *name);
+void rc_trace_write_cfg(FILE *fp, RcCfg *cfg);
+void rc_trace_write_frm(FILE *fp, EncRcTask *task);
+
+/* parse key=value list of RcCfg field into cfg, return parsed key count */
+RK_S32 rc_trace_parse_cfg(RcCfg *cfg, char *str);
+
+MPP_RET rc_trace_load(RcTraceData *data, FILE *fp);
+MPP_RET rc_trace_add_frm(RcTraceData *data, RcTraceFrm *frm);
+void rc_trace_release(RcTraceData *data);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __RC_TRACE_H__ */
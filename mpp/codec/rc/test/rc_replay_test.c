@@ -0,0 +1,676 @@
+/* SPDX-License-Identifier: Apache-2.0 OR MIT */
+/*
+ * Copyright (c) 2024 Rockchip Electronics Co., Ltd.
+ */
+
+#define MODULE_TAG "rc_replay_test"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#include "mpp_env.h"
+#include "mpp_mem.h"
+#include "mpp_log.h"
+#include "mpp_lock.h"
+#include "mpp_time.h"
+#include "mpp_common.h"
+
+#include "rc.h"
+#include "rc_trace.h"
+
+/*
+ * Offline rate control replay
+ *
+ * Replay a rc trace recorded on board (env rc_trace_path) with many rc
+ * configs in parallel. The hardware is modeled from the recorded frame:
+ * the frame keeps its qp offset to the rc target qp and its bits scale by
+ * 2^(dqp / 6) from the recorded bits, other feedback is used as it is.
+ *
+ * usage: rc_replay_test [-i trace] [-g field=start:end[:step]] [-g field=a,b,c]
+ *                       [-t threads] [-o csv]
+ *
+ * -g sweeps one RcCfg field with the trace name, e.g. -g bps_target=1000000:
+ * 8000000:1000000 -g mode=0,1. All -g are combined. bps_max / bps_min follow
+ * bps_target with the trace ratio when they are not swept.
+ *
+ * Without -i a synthetic trace is recorded from a simple hardware model, then
+ * replayed on its own config and checked to give the same decisions before a
+ * default sweep.
+ */
+#define MAX_SWEEP_PARAM     8
+#define MAX_SWEEP_VALUE     256
+#define SYNTH_FRAMES        1800
+
+typedef struct SweepParam_t {
+    char        name[32];
+    RK_S32      val[MAX_SWEEP_VALUE];
+    RK_S32      count;
+} SweepParam;
+
+typedef struct ReplayStat_t {
+    RK_S32      frames;
+    RK_S64      bits;
+    double      bps;
+    /* average and max one second bitrate error to target in percent */
+    double      bps_err;
+    double      win_err_max;
+    /* max one second buffer fullness in percent and overflow frames */
+    double      buf_max;
+    RK_S32      overflow;
+    double      qp_mean;
+    double      qp_std;
+    RK_S32      reenc;
+    RK_S32      drop;
+} ReplayStat;
+
+typedef struct ReplayCtx_t {
+    RcTraceData *trace;
+    SweepParam  *params;
+    RK_S32      param_cnt;
+    RK_S32      cfg_cnt;
+    RcCfg       *cfgs;
+    ReplayStat  *stats;
+    RK_S32      next;
+    RK_S32      failed;
+} ReplayCtx;
+
+/* 2^(d / 6) for qp delta d in [-51, 51] */
+static double qp_scale[103];
+
+static void init_qp_scale(void)
+{
+    const double step = 1.122462048309373; /* 2^(1/6) */
+    RK_S32 i;
+
+    qp_scale[51] = 1.0;
+    for (i = 1; i <= 51; i++) {
+        qp_scale[51 + i] = qp_scale[51 + i - 1] * step;
+        qp_scale[51 - i] = qp_scale[51 - i + 1] / step;
+    }
+}
+
+/* hardware model: recorded frame encoded at the new target qp */
+static void sim_hw(EncRcTaskInfo *info, RcTraceFrm *rec)
+{
+    RK_S32 qp_ofs = rec->info.quality_real - rec->info.quality_target;
+    RK_S32 qp = info->quality_target + qp_ofs;
+    RK_S32 dqp;
+
+    if (info->quality_max > 0)
+        qp = mpp_clip(qp, info->quality_min, info->quality_max);
+    qp = mpp_clip(qp, 0, 51);
+    dqp = mpp_clip(rec->info.quality_real - qp, -51, 51);
+
+    info->bit_real = (RK_S32)(rec->info.bit_real * qp_scale[51 + dqp] + 0.5);
+    info->quality_real = qp;
+    info->madi = rec->info.madi;
+    info->madp = rec->info.madp;
+    info->iblk4_prop = rec->info.iblk4_prop;
+    info->sse = rec->info.sse;
+    info->lvl64_inter_num = rec->info.lvl64_inter_num;
+    info->lvl32_inter_num = rec->info.lvl32_inter_num;
+    info->lvl16_inter_num = rec->info.lvl16_inter_num;
+    info->lvl8_inter_num = rec->info.lvl8_inter_num;
+    info->lvl32_intra_num = rec->info.lvl32_intra_num;
+    info->lvl16_intra_num = rec->info.lvl16_intra_num;
+    info->lvl8_intra_num = rec->info.lvl8_intra_num;
+    info->lvl4_intra_num = rec->info.lvl4_intra_num;
+}
+
+/* run one frame in the mpp_enc rc call flow, return rc decision in task */
+static void replay_frm(RcCtx ctx, RcCfg *cfg, RcTraceFrm *rec, EncRcTask *task, ReplayStat *stat)
+{
+    EncFrmStatus *frm = &task->frm;
+    RK_S32 pass = 0;
+
+    memset(task, 0, sizeof(*task));
+    task->frm = rec->frm;
+    frm->drop = 0;
+    frm->re_dpb_proc = 0;
+    frm->reencode = 0;
+    frm->super_frame = 0;
+    frm->force_pskip = 0;
+    frm->reencode_times = 0;
+    task->cpb.curr = *frm;
+
+    rc_frm_start(ctx, task);
+    rc_hal_start(ctx, task);
+    sim_hw(&task->info, rec);
+    rc_hal_end(ctx, task);
+    rc_frm_check_reenc(ctx, task);
+
+    while (frm->reencode && pass++ < cfg->max_reencode_times) {
+        if (frm->drop) {
+            task->info.bit_real = 0;
+            task->info.quality_real = task->info.quality_target;
+            rc_frm_end(ctx, task);
+            stat->drop++;
+            return;
+        }
+
+        if (frm->force_pskip && !frm->is_idr && !frm->is_lt_ref) {
+            /* software pskip frame, nearly no bits */
+            task->info.bit_real = 0;
+            rc_frm_end(ctx, task);
+            stat->drop++;
+            return;
+        }
+
+        frm->force_pskip = 0;
+        rc_frm_clr_hal_info(task);
+        rc_hal_start(ctx, task);
+        sim_hw(&task->info, rec);
+        rc_hal_end(ctx, task);
+        rc_frm_check_reenc(ctx, task);
+        stat->reenc++;
+    }
+
+    rc_frm_end(ctx, task);
+}
+
+static MPP_RET replay_cfg(RcTraceData *trace, RcCfg *cfg, ReplayStat *stat, FILE *record)
+{
+    RK_S32 fps = cfg->fps.fps_out_num / MPP_MAX(cfg->fps.fps_out_denom, 1);
+    RK_S64 bps = cfg->bps_target;
+    RK_S64 drain = bps / MPP_MAX(fps, 1);
+    RK_S64 *win = mpp_calloc(RK_S64, MPP_MAX(fps, 1));
+    const char *name = strcmp(trace->name, "default") ? trace->name : NULL;
+    RcCtx ctx = NULL;
+    RK_S64 win_sum = 0;
+    RK_S64 buf = 0;
+    double qp_sum = 0;
+    double qp_sq = 0;
+    EncRcTask task;
+    RK_S32 i;
+
+    memset(stat, 0, sizeof(*stat));
+
+    if (!win || fps <= 0 || bps <= 0 || rc_init(&ctx, trace->type, &name)) {
+        MPP_FREE(win);
+        return MPP_NOK;
+    }
+
+    rc_update_usr_cfg(ctx, cfg);
+
+    for (i = 0; i < trace->count; i++) {
+        RcTraceFrm *rec = &trace->frms[i];
+        RK_S32 bits;
+
+        /* no hardware feedback of dropped frame */
+        if (rec->frm.drop || rec->frm.force_pskip)
+            continue;
+
+        replay_frm(ctx, cfg, rec, &task, stat);
+        if (record)
+            rc_trace_write_frm(record, &task);
+
+        bits = task.info.bit_real;
+        stat->bits += bits;
+        qp_sum += task.info.quality_real;
+        qp_sq += (double)task.info.quality_real * task.info.quality_real;
+
+        /* one second window bitrate */
+        win_sum += bits - win[stat->frames % fps];
+        win[stat->frames % fps] = bits;
+        stat->frames++;
+        if (stat->frames >= fps) {
+            double err = (win_sum - bps) * 100.0 / bps;
+
+            if (err < 0)
+                err = -err;
+            if (err > stat->win_err_max)
+                stat->win_err_max = err;
+        }
+
+        /* leaky bucket of one second drained at target bitrate */
+        buf = MPP_MAX(buf + bits - drain, 0);
+        if (buf > bps)
+            stat->overflow++;
+        if (buf * 100.0 / bps > stat->buf_max)
+            stat->buf_max = buf * 100.0 / bps;
+    }
+
+    rc_deinit(ctx);
+    MPP_FREE(win);
+
+    if (stat->frames) {
+        double var;
+
+        stat->bps = (double)stat->bits * fps / stat->frames;
+        stat->bps_err = (stat->bps - bps) * 100.0 / bps;
+        stat->qp_mean = qp_sum / stat->frames;
+        var = qp_sq / stat->frames - stat->qp_mean * stat->qp_mean;
+        stat->qp_std = (var > 0) ? sqrt(var) : 0;
+    }
+
+    return MPP_OK;
+}
+
+static void *replay_worker(void *arg)
+{
+    ReplayCtx *ctx = (ReplayCtx *)arg;
+
+    while (1) {
+        RK_S32 idx = MPP_FETCH_ADD(&ctx->next, 1);
+
+        if (idx >= ctx->cfg_cnt)
+            break;
+
+        if (replay_cfg(ctx->trace, &ctx->cfgs[idx], &ctx->stats[idx], NULL))
+            MPP_FETCH_ADD(&ctx->failed, 1);
+    }
+
+    return NULL;
+}
+
+static MPP_RET add_sweep_param(ReplayCtx *ctx, const char *arg)
+{
+    SweepParam *param;
+    const char *val = strchr(arg, '=');
+    RK_S32 len = val ? (RK_S32)(val - arg) : 0;
+
+    if (!val || len <= 0 || len >= (RK_S32)sizeof(param->name) ||
+        ctx->param_cnt >= MAX_SWEEP_PARAM) {
+        mpp_err("invalid sweep %s\n", arg);
+        return MPP_NOK;
+    }
+
+    param = &ctx->params[ctx->param_cnt];
+    memset(param, 0, sizeof(*param));
+    memcpy(param->name, arg, len);
+    val++;
+
+    if (strchr(val, ':')) {
+        RK_S32 start = 0, end = 0, step = 1;
+
+        sscanf(val, "%d:%d:%d", &start, &end, &step);
+        for (; step > 0 && start <= end && param->count < MAX_SWEEP_VALUE; start += step)
+            param->val[param->count++] = start;
+
+        if (step > 0 && start <= end)
+            mpp_log("sweep %s truncated to %d values\n", param->name, param->count);
+    } else {
+        char *end = NULL;
+
+        do {
+            param->val[param->count++] = strtol(val, &end, 0);
+            val = end + 1;
+        } while (*end == ',' && param->count < MAX_SWEEP_VALUE);
+    }
+
+    if (!param->count) {
+        mpp_err("no value in sweep %s\n", arg);
+        return MPP_NOK;
+    }
+
+    ctx->param_cnt++;
+    return MPP_OK;
+}
+
+static RK_S32 is_swept(ReplayCtx *ctx, const char *name)
+{
+    RK_S32 i;
+
+    for (i = 0; i < ctx->param_cnt; i++)
+        if (!strcmp(ctx->params[i].name, name))
+            return 1;
+
+    return 0;
+}
+
+/* combine all sweep values on the trace config */
+static MPP_RET gen_sweep_cfgs(ReplayCtx *ctx)
+{
+    RcCfg *base = &ctx->trace->cfg;
+    RK_S32 follow_max = !is_swept(ctx, "bps_max");
+    RK_S32 follow_min = !is_swept(ctx, "bps_min");
+    RK_S32 cnt = 1;
+    RK_S32 i, j;
+
+    for (i = 0; i < ctx->param_cnt; i++)
+        cnt *= ctx->params[i].count;
+
+    ctx->cfgs = mpp_calloc(RcCfg, cnt);
+    ctx->stats = mpp_calloc(ReplayStat, cnt);
+    if (!ctx->cfgs || !ctx->stats)
+        return MPP_ERR_MALLOC;
+
+    for (i = 0; i < cnt; i++) {
+        RcCfg *cfg = &ctx->cfgs[i];
+        RK_S32 rest = i;
+
+        *cfg = *base;
+        for (j = 0; j < ctx->param_cnt; j++) {
+            SweepParam *param = &ctx->params[j];
+            char str[64];
+
+            snprintf(str, sizeof(str), "%s=%d", param->name, param->val[rest % param->count]);
+            rest /= param->count;
+            if (!rc_trace_parse_cfg(cfg, str)) {
+                mpp_err("unknown rc config %s\n", param->name);
+                return MPP_NOK;
+            }
+        }
+
+        if (cfg->bps_target != base->bps_target && base->bps_target) {
+            if (follow_max)
+                cfg->bps_max = (RK_S64)base->bps_max * cfg->bps_target / base->bps_target;
+            if (follow_min)
+                cfg->bps_min = (RK_S64)base->bps_min * cfg->bps_target / base->bps_target;
+        }
+    }
+
+    ctx->cfg_cnt = cnt;
+    return MPP_OK;
+}
+
+static void write_stat(FILE *fp, ReplayCtx *ctx, RK_S32 idx)
+{
+    ReplayStat *stat = &ctx->stats[idx];
+    RK_S32 rest = idx;
+    RK_S32 j;
+
+    fprintf(fp, "%d", idx);
+    for (j = 0; j < ctx->param_cnt; j++) {
+        SweepParam *param = &ctx->params[j];
+
+        fprintf(fp, ",%d", param->val[rest % param->count]);
+        rest /= param->count;
+    }
+
+    fprintf(fp, ",%.0f,%.2f,%.2f,%.1f,%d,%.2f,%.2f,%d,%d\n",
+            stat->bps, stat->bps_err, stat->win_err_max, stat->buf_max,
+            stat->overflow, stat->qp_mean, stat->qp_std, stat->reenc, stat->drop);
+}
+
+/*
+ * synthetic hardware: frame complexity in bits at qp 30 with slow change and
+ * scene cut, intra frame costs 6 times of inter frame
+ */
+static void synth_hw(EncRcTaskInfo *info, RK_S32 cplx, RK_S32 intra)
+{
+    RK_S32 qp = mpp_clip(info->quality_target, 0, 51);
+
+    info->quality_real = qp;
+    info->bit_real = (RK_S32)((RK_S64)cplx * (intra ? 6 : 1) * qp_scale[51 + 30 - qp] + 0.5);
+    info->madi = cplx / 4000;
+    info->madp = intra ? 0 : cplx / 8000;
+    info->iblk4_prop = intra ? 256 : 16;
+}
+
+static MPP_RET gen_synth_trace(RcTraceData *trace)
+{
+    RcCfg *cfg = &trace->cfg;
+    FILE *fp = tmpfile();
+    RcCtx ctx = NULL;
+    const char *name = NULL;
+    RK_S32 cplx = 60000;
+    EncRcTask task;
+    MPP_RET ret;
+    RK_S32 i;
+
+    if (!fp)
+        return MPP_NOK;
+
+    /* same as h264e default config */
+    memset(cfg, 0, sizeof(*cfg));
+    cfg->width = 1920;
+    cfg->height = 1080;
+    cfg->mode = RC_CBR;
+    cfg->fps.fps_in_num = 30;
+    cfg->fps.fps_in_denom = 1;
+    cfg->fps.fps_out_num = 30;
+    cfg->fps.fps_out_denom = 1;
+    cfg->igop = 60;
+    cfg->bps_target = 2000000;
+    cfg->bps_max = cfg->bps_target * 17 / 16;
+    cfg->bps_min = cfg->bps_target * 15 / 16;
+    cfg->stats_time = 3;
+    cfg->max_i_bit_prop = 30;
+    cfg->min_i_bit_prop = 10;
+    cfg->init_ip_ratio = 160;
+    cfg->layer_bit_prop[0] = 256;
+    cfg->init_quality = -1;
+    cfg->max_quality = 48;
+    cfg->min_quality = 8;
+    cfg->max_i_quality = 48;
+    cfg->min_i_quality = 8;
+    cfg->i_quality_delta = 2;
+    cfg->fqp_min_i = 8;
+    cfg->fqp_min_p = 8;
+    cfg->fqp_max_i = 48;
+    cfg->fqp_max_p = 48;
+    /* reencode pass is not recorded so replay is exact only without it */
+    cfg->max_reencode_times = 0;
+
+    rc_trace_write_api(fp, MPP_VIDEO_CodingAVC, "default");
+    rc_trace_write_cfg(fp, cfg);
+
+    if (rc_init(&ctx, MPP_VIDEO_CodingAVC, &name)) {
+        fclose(fp);
+        return MPP_NOK;
+    }
+    rc_update_usr_cfg(ctx, cfg);
+
+    srand(0x1357);
+    for (i = 0; i < SYNTH_FRAMES; i++) {
+        EncFrmStatus *frm = &task.frm;
+
+        if (rand() % 300 == 0)
+            cplx = 20000 + rand() % 200000;
+        else
+            cplx = mpp_clip(cplx + rand() % 4001 - 2000, 10000, 300000);
+
+        memset(&task, 0, sizeof(task));
+        frm->valid = 1;
+        frm->seq_idx = i;
+        frm->is_intra = (i % cfg->igop) == 0;
+        frm->is_idr = frm->is_intra;
+        task.cpb.curr = *frm;
+
+        rc_frm_start(ctx, &task);
+        rc_hal_start(ctx, &task);
+        synth_hw(&task.info, cplx, frm->is_intra);
+        rc_hal_end(ctx, &task);
+        rc_frm_check_reenc(ctx, &task);
+        rc_trace_write_frm(fp, &task);
+        rc_frm_end(ctx, &task);
+    }
+
+    rc_deinit(ctx);
+
+    rewind(fp);
+    ret = rc_trace_load(trace, fp);
+    fclose(fp);
+
+    return ret;
+}
+
+/* replay on the recorded config should give the recorded decisions */
+static MPP_RET check_replay_exact(RcTraceData *trace)
+{
+    RcTraceData out;
+    ReplayStat stat;
+    FILE *fp = tmpfile();
+    MPP_RET ret = MPP_NOK;
+    RK_S32 i;
+
+    if (!fp)
+        return MPP_NOK;
+
+    rc_trace_write_api(fp, trace->type, trace->name);
+    rc_trace_write_cfg(fp, &trace->cfg);
+
+    if (!replay_cfg(trace, &trace->cfg, &stat, fp)) {
+        rewind(fp);
+        ret = rc_trace_load(&out, fp);
+    }
+    fclose(fp);
+
+    if (ret)
+        return ret;
+
+    if (out.count != trace->count)
+        ret = MPP_NOK;
+
+    for (i = 0; !ret && i < out.count; i++) {
+        EncRcTaskInfo *a = &trace->frms[i].info;
+        EncRcTaskInfo *b = &out.frms[i].info;
+
+        if (a->bit_target != b->bit_target || a->quality_target != b->quality_target ||
+            a->bit_real != b->bit_real) {
+            mpp_err("frame %d replay bits %d:%d qp %d:%d vs record bits %d:%d qp %d:%d\n",
+                    i, b->bit_target, b->bit_real, b->quality_target, b->quality_real,
+                    a->bit_target, a->bit_real, a->quality_target, a->quality_real);
+            ret = MPP_NOK;
+        }
+    }
+
+    rc_trace_release(&out);
+    return ret;
+}
+
+int main(int argc, char **argv)
+{
+    SweepParam params[MAX_SWEEP_PARAM];
+    RcTraceData trace;
+    ReplayCtx ctx;
+    pthread_t *threads = NULL;
+    const char *input = NULL;
+    const char *output = NULL;
+    RK_S32 thread_cnt = (RK_S32)sysconf(_SC_NPROCESSORS_ONLN);
+    RK_S64 start;
+    RK_S64 time;
+    MPP_RET ret = MPP_NOK;
+    RK_S32 i;
+
+    memset(&trace, 0, sizeof(trace));
+    memset(&ctx, 0, sizeof(ctx));
+    ctx.trace = &trace;
+    ctx.params = params;
+
+    init_qp_scale();
+
+    /* rc_init in workers must not write a trace for each replayed config */
+    mpp_env_set_str("rc_trace_path", (char *)"");
+
+    for (i = 1; i < argc; i++) {
+        const char *opt = argv[i];
+
+        if (i + 1 >= argc || opt[0] != '-') {
+            mpp_err("invalid option %s\n", opt);
+            goto DONE;
+        }
+
+        switch (opt[1]) {
+        case 'i' : {
+            input = argv[++i];
+        } break;
+        case 'o' : {
+            output = argv[++i];
+        } break;
+        case 't' : {
+            thread_cnt = atoi(argv[++i]);
+        } break;
+        case 'g' : {
+            if (add_sweep_param(&ctx, argv[++i]))
+                goto DONE;
+        } break;
+        default : {
+            mpp_err("invalid option %s\n", opt);
+            goto DONE;
+        } break;
+        }
+    }
+
+    if (input) {
+        FILE *fp = fopen(input, "r");
+
+        if (!fp) {
+            mpp_err("failed to open trace %s\n", input);
+            goto DONE;
+        }
+        ret = rc_trace_load(&trace, fp);
+        fclose(fp);
+        if (ret)
+            goto DONE;
+    } else {
+        ret = gen_synth_trace(&trace);
+        if (!ret)
+            ret = check_replay_exact(&trace);
+        if (ret) {
+            mpp_err("synthetic trace replay mismatch\n");
+            goto DONE;
+        }
+        mpp_log("synthetic trace of %d frames replays exactly\n", trace.count);
+
+        if (!ctx.param_cnt) {
+            add_sweep_param(&ctx, "bps_target=1000000:8000000:1000000");
+            add_sweep_param(&ctx, "mode=0,1");
+            add_sweep_param(&ctx, "i_quality_delta=0:3");
+            add_sweep_param(&ctx, "min_quality=8,16,24");
+        }
+    }
+
+    ret = gen_sweep_cfgs(&ctx);
+    if (ret)
+        goto DONE;
+
+    thread_cnt = mpp_clip(thread_cnt, 1, ctx.cfg_cnt);
+    threads = mpp_calloc(pthread_t, thread_cnt);
+    if (!threads) {
+        ret = MPP_ERR_MALLOC;
+        goto DONE;
+    }
+
+    start = mpp_time();
+    for (i = 0; i < thread_cnt; i++)
+        pthread_create(&threads[i], NULL, replay_worker, &ctx);
+    for (i = 0; i < thread_cnt; i++)
+        pthread_join(threads[i], NULL);
+    time = mpp_time() - start;
+
+    if (ctx.failed) {
+        mpp_err("%d configs failed to replay\n", ctx.failed);
+        ret = MPP_NOK;
+        goto DONE;
+    }
+
+    mpp_log("replay %d frames with %d configs on %d threads in %.2f s, %.0f configs/s\n",
+            trace.count, ctx.cfg_cnt, thread_cnt, time / 1000000.0,
+            ctx.cfg_cnt * 1000000.0 / MPP_MAX(time, 1));
+
+    {
+        FILE *fp = output ? fopen(output, "w") : stdout;
+
+        if (!fp) {
+            mpp_err("failed to open output %s\n", output);
+            ret = MPP_NOK;
+            goto DONE;
+        }
+
+        fprintf(fp, "idx");
+        for (i = 0; i < ctx.param_cnt; i++)
+            fprintf(fp, ",%s", params[i].name);
+        fprintf(fp, ",bps,bps_err%%,win_err_max%%,buf_max%%,overflow,qp_mean,qp_std,reenc,drop\n");
+
+        for (i = 0; i < ctx.cfg_cnt; i++)
+            write_stat(fp, &ctx, i);
+
+        if (output)
+            fclose(fp);
+    }
+
+DONE:
+    MPP_FREE(threads);
+    MPP_FREE(ctx.cfgs);
+    MPP_FREE(ctx.stats);
+    rc_trace_release(&trace);
+
+    mpp_log("rc replay test %s\n", ret ? "failed" : "success");
+
+    return ret;
+}
@@ -368,7 +368,8 @@ MPP_RET vepu541_set_one_roi(void *buf, MppEncROIRegion *region, RK_S32 w, RK_S32
     RK_S32 pos_y_init = region->y / 16;
     RK_S32 pos_x_end  = pos_x_init + roi_width;
     RK_S32 pos_y_end  = pos_y_init + roi_height;
-    RK_S32 x, y;
+    RK_U16 val;
+    RK_S32 y;
 
     pos_x_end = MPP_MIN(pos_x_end, mb_w);
     pos_y_end = MPP_MIN(pos_y_end, mb_h);
@@ -390,12 +391,9 @@ MPP_RET vepu541_set_one_roi(void *buf, MppEncROIRegion *region, RK_S32 w, RK_S32
     roi_width = pos_x_end - pos_x_init;
     roi_height = pos_y_end - pos_y_init;
 
+    memcpy(&val, &cfg, sizeof(val));
     for (y = 0; y < roi_height; y++) {
-        Vepu541RoiCfg *dst = ptr;
-
-        for (x = 0; x < roi_width; x++, dst++)
-            memcpy(dst, &cfg, sizeof(cfg));
-
+        mpp_fill_u16(ptr, val, roi_width);
         ptr += stride_h;
     }
 DONE:
@@ -412,6 +410,7 @@ MPP_RET vepu541_set_roi(void *buf, MppEncROICfg *roi, RK_S32 w, RK_S32 h)
     RK_S32 stride_v = MPP_ALIGN(mb_h, 4);
     Vepu541RoiCfg cfg;
     MPP_RET ret = MPP_NOK;
+    RK_U16 val;
     RK_S32 i;
 
     if (NULL == buf || NULL == roi) {
@@ -427,8 +426,8 @@ MPP_RET vepu541_set_roi(void *buf, MppEncROICfg *roi, RK_S32 w, RK_S32 h)
     cfg.qp_adj_mode = 0;
 
     /* step 1. reset all the config */
-    for (i = 0; i < stride_h * stride_v; i++, ptr++)
-        memcpy(ptr, &cfg, sizeof(cfg));
+    memcpy(&val, &cfg, sizeof(val));
+    mpp_fill_u16(ptr, val, stride_h * stride_v);
 
     if (w <= 0 || h <= 0) {
         mpp_err_f("invalid size [%d:%d]\n", w, h);
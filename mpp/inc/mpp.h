@@ -18,6 +18,7 @@
 #define __MPP_H__
 
 #include "mpp_queue.h"
+#include "mpp_spsc_queue.h"
 #include "mpp_task_impl.h"
 
 #include "mpp_dec.h"
@@ -136,7 +137,7 @@ public:
     mpp_list        *mPktIn;
     mpp_list        *mPktOut;
     mpp_list        *mFrmIn;
-    mpp_list        *mFrmOut;
+    MppSpscQueue    mFrmOut;
     /* counters for debug */
     RK_U32          mPacketPutCount;
     RK_U32          mPacketGetCount;
@@ -213,6 +214,8 @@ private:
     RK_U32          mParserNeedSplit;
     RK_U32          mParserInternalPts;     /* for MPEG2/MPEG4 */
     RK_U32          mImmediateOut;
+    /* reference MppBuffer of input packet instead of copy or block */
+    RK_U32          mZeroCopyPkt;
     /* backup extra packet for seek */
     MppPacket       mExtraPacket;
 
@@ -38,6 +38,7 @@ typedef enum MppDecCfgChange_e {
     MPP_DEC_CFG_CHANGE_ENABLE_HDR_META  = (1 << 17),
     MPP_DEC_CFG_CHANGE_ENABLE_THUMBNAIL = (1 << 18),
     MPP_DEC_CFG_CHANGE_ENABLE_MVC       = (1 << 19),
+    MPP_DEC_CFG_CHANGE_ZERO_COPY_PKT    = (1 << 20),
     /* reserve high bit for global config */
     MPP_DEC_CFG_CHANGE_DISABLE_THREAD   = (1 << 28),
 
@@ -63,6 +64,7 @@ typedef struct MppDecBaseCfg_t {
     MppCtxType          type;
     MppCodingType       coding;
     RK_S32              hw_type;
+    /* 0 - off, 1 - mpp server batch, 2 - batch with high priority */
     RK_U32              batch_mode;
 
     MppFrameFormat      out_fmt;
@@ -77,6 +79,8 @@ typedef struct MppDecBaseCfg_t {
     RK_U32              enable_hdr_meta;
     RK_U32              enable_thumbnail;
     RK_U32              enable_mvc;
+    /* reference input packet MppBuffer instead of blocking on its task */
+    RK_U32              zero_copy_pkt;
     RK_U32              disable_thread;
 } MppDecBaseCfg;
 
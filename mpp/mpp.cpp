@@ -37,6 +37,7 @@
 #include "mpp_packet_impl.h"
 
 #include "mpp_dec_cfg_impl.h"
+#include "mpp_dec_impl.h"
 
 #define MPP_TEST_FRAME_SIZE     SZ_1M
 #define MPP_TEST_PACKET_SIZE    SZ_512K
@@ -54,10 +55,11 @@ static void *list_wraper_packet(void *arg)
     return NULL;
 }
 
-static void *list_wraper_frame(void *arg)
+static void queue_release_frame(void *data)
 {
-    mpp_frame_deinit((MppFrame *)arg);
-    return NULL;
+    MppFrame frame = data;
+
+    mpp_frame_deinit(&frame);
 }
 
 static RK_S32 check_frm_task_cnt_cap(MppCodingType coding)
@@ -112,6 +114,7 @@ Mpp::Mpp(MppCtx ctx)
       mCoding(MPP_VIDEO_CodingUnused),
       mInitDone(0),
       mStatus(0),
+      mZeroCopyPkt(0),
       mExtraPacket(NULL)
 {
     mpp_env_get_u32("mpp_debug", &mpp_debug, 0);
@@ -152,7 +155,7 @@ MPP_RET Mpp::init(MppCtxType type, MppCodingType coding)
     switch (mType) {
     case MPP_CTX_DEC : {
         mPktIn  = new mpp_list(list_wraper_packet);
-        mFrmOut = new mpp_list(list_wraper_frame);
+        mpp_spsc_queue_init(&mFrmOut, 0, queue_release_frame);
 
         if (mInputTimeout == MPP_POLL_BUTT)
             mInputTimeout = MPP_POLL_NON_BLOCK;
@@ -199,7 +202,7 @@ MPP_RET Mpp::init(MppCtxType type, MppCodingType coding)
         mPktIn  = new mpp_list(list_wraper_packet);
         mPktOut = new mpp_list(list_wraper_packet);
         mFrmIn  = new mpp_list(NULL);
-        mFrmOut = new mpp_list(NULL);
+        mpp_spsc_queue_init(&mFrmOut, 0, NULL);
 
         if (mInputTimeout == MPP_POLL_BUTT)
             mInputTimeout = MPP_POLL_BLOCK;
@@ -275,6 +278,8 @@ void Mpp::clear()
 
     if (mType == MPP_CTX_DEC) {
         if (mDec) {
+            /* wake output thread blocked on full frame queue */
+            mpp_spsc_queue_flush(mFrmOut);
             mpp_dec_stop(mDec);
             mpp_dec_deinit(mDec);
             mDec = NULL;
@@ -319,7 +324,7 @@ void Mpp::clear()
         mFrmIn = NULL;
     }
     if (mFrmOut) {
-        delete mFrmOut;
+        mpp_spsc_queue_deinit(mFrmOut);
         mFrmOut = NULL;
     }
 
@@ -429,6 +434,16 @@ MPP_RET Mpp::put_packet(MppPacket packet)
         pkt_copy = 1;
         packet = pkt_in;
         ret = MPP_OK;
+    } else if (mZeroCopyPkt) {
+        /* packet zero copy path, only take a reference of input buffer */
+        MppPacket pkt_in = NULL;
+
+        mpp_packet_copy_init(&pkt_in, packet);
+        mpp_packet_set_length(packet, 0);
+        ((MppPacketImpl *)pkt_in)->flag |= MPP_PACKET_FLAG_BUF_REF;
+        pkt_copy = 1;
+        packet = pkt_in;
+        ret = MPP_OK;
     } else {
         /* packet zero copy path */
         mpp_log_f("not support zero copy path\n");
@@ -445,6 +460,7 @@ MPP_RET Mpp::put_packet(MppPacket packet)
     }
 
     mpp_ops_dec_put_pkt(mDump, packet);
+    mpp_dec_perf_pkt_put(((MppDecImpl *)mDec)->perf);
 
     /* enqueue valid task to decoder */
     ret = enqueue(MPP_PORT_INPUT, task_dequeue);
@@ -477,30 +493,14 @@ MPP_RET Mpp::get_frame(MppFrame *frame)
     if (!mInitDone)
         return MPP_ERR_INIT;
 
-    AutoMutex autoFrameLock(mFrmOut->mutex());
     MppFrame frm = NULL;
 
-    if (0 == mFrmOut->list_size()) {
-        if (mOutputTimeout) {
-            if (mOutputTimeout < 0) {
-                /* block wait */
-                mFrmOut->wait();
-            } else {
-                RK_S32 ret = mFrmOut->wait(mOutputTimeout);
-                if (ret) {
-                    if (ret == ETIMEDOUT)
-                        return MPP_ERR_TIMEOUT;
-                    else
-                        return MPP_NOK;
-                }
-            }
-        }
-    }
+    if (mOutputTimeout && mpp_spsc_queue_wait(mFrmOut, mOutputTimeout))
+        return MPP_ERR_TIMEOUT;
 
-    if (mFrmOut->list_size()) {
+    if (!mpp_spsc_queue_pop(mFrmOut, &frm)) {
         MppBuffer buffer;
 
-        mFrmOut->del_at_head(&frm, sizeof(frame));
         mFrameGetCount++;
         notify(MPP_OUTPUT_DEQUEUE);
 
@@ -534,13 +534,10 @@ MPP_RET Mpp::get_frame_noblock(MppFrame *frame)
     if (!mInitDone)
         return MPP_ERR_INIT;
 
-    mFrmOut->lock();
-    if (mFrmOut->list_size()) {
-        mFrmOut->del_at_head(&first, sizeof(frame));
+    if (!mpp_spsc_queue_pop(mFrmOut, &first)) {
         mpp_buffer_sync_ro_begin(mpp_frame_get_buffer(first));
         mFrameGetCount++;
     }
-    mFrmOut->unlock();
     *frame = first;
 
     return MPP_OK;
@@ -563,12 +560,9 @@ MPP_RET Mpp::decode(MppPacket packet, MppFrame *frame)
      * But if the output mode is block then we need to send packet first
      */
     if (!mOutputTimeout) {
-        AutoMutex autoFrameLock(mFrmOut->mutex());
-
-        if (mFrmOut->list_size()) {
+        if (!mpp_spsc_queue_pop(mFrmOut, frame)) {
             MppBuffer buffer;
 
-            mFrmOut->del_at_head(frame, sizeof(*frame));
             buffer = mpp_frame_get_buffer(*frame);
             if (buffer)
                 mpp_buffer_sync_ro_begin(buffer);
@@ -586,19 +580,13 @@ MPP_RET Mpp::decode(MppPacket packet, MppFrame *frame)
             pkt_done = 1;
 
         /* always try getting frame */
-        {
-            AutoMutex autoFrameLock(mFrmOut->mutex());
-
-            if (mFrmOut->list_size()) {
-                MppBuffer buffer;
-
-                mFrmOut->del_at_head(frame, sizeof(*frame));
-                buffer = mpp_frame_get_buffer(*frame);
-                if (buffer)
-                    mpp_buffer_sync_ro_begin(buffer);
-                mFrameGetCount++;
-                frm_rdy = 1;
-            }
+        if (!mpp_spsc_queue_pop(mFrmOut, frame)) {
+            MppBuffer buffer = mpp_frame_get_buffer(*frame);
+
+            if (buffer)
+                mpp_buffer_sync_ro_begin(buffer);
+            mFrameGetCount++;
+            frm_rdy = 1;
         }
 
         /* return on flow error */
@@ -1070,11 +1058,11 @@ MPP_RET Mpp::reset()
         mPktIn->flush();
         mPktIn->unlock();
 
+        /* wake output thread blocked on full frame queue before reset waits it */
+        mpp_spsc_queue_flush(mFrmOut);
         mpp_dec_reset(mDec);
 
-        mFrmOut->lock();
-        mFrmOut->flush();
-        mFrmOut->unlock();
+        mpp_spsc_queue_flush(mFrmOut);
 
         mpp_port_awake(mUsrInPort);
         mpp_port_awake(mUsrOutPort);
@@ -1271,17 +1259,20 @@ MPP_RET Mpp::control_dec(MpiCmd cmd, MppParam param)
     case MPP_DEC_GET_VPUMEM_USED_COUNT :
     case MPP_DEC_SET_OUTPUT_FORMAT :
     case MPP_DEC_QUERY :
+    case MPP_DEC_GET_PERF_STATS :
     case MPP_DEC_SET_MAX_USE_BUFFER_SIZE: {
         ret = mpp_dec_control(mDec, cmd, param);
     } break;
     case MPP_DEC_SET_CFG : {
+        MppDecCfgImpl *dec_cfg = (MppDecCfgImpl *)param;
+
+        if (dec_cfg && (dec_cfg->cfg.base.change & MPP_DEC_CFG_CHANGE_ZERO_COPY_PKT))
+            mZeroCopyPkt = dec_cfg->cfg.base.zero_copy_pkt;
+
         if (mDec)
             ret = mpp_dec_control(mDec, cmd, param);
-        else if (param) {
-            MppDecCfgImpl *dec_cfg = (MppDecCfgImpl *)param;
-
+        else if (param)
             ret = mpp_dec_set_cfg(&mDecInitcfg, &dec_cfg->cfg);
-        }
     } break;
     case MPP_DEC_GET_CFG : {
         if (mDec)
@@ -0,0 +1,33 @@
+/*
+ * Copyright 2010 Rockchip Electronics S.LSI Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __VERSION_H__
+#define __VERSION_H__
+
+#define MPP_VERSION             "123467b author: agent          2026-10-18 [user-024] fix: drop unused rc window sum cache and seq_id index"
+#define MPP_VER_HIST_CNT        10
+#define MPP_VER_HIST_0          "123467b author: agent          2026-10-18 [user-024] fix: drop unused rc window sum cache and seq_id index  (HEAD -> master)"
+#define MPP_VER_HIST_1          "9f88a18 author: agent          2026-10-18 [user-017] fix: lock free bounded frame queue and keep mpp_list for packet output"
+#define MPP_VER_HIST_2          "54c62df author: agent          2026-10-18 [user-002] fix: read zero copy packets on demand and test buffer reference"
+#define MPP_VER_HIST_3          "66f9847 author: agent          2026-10-18 [user-011] fix: evict undersized buffers on miss and apply retain config on group init"
+#define MPP_VER_HIST_4          "e600b81 author: agent          2026-10-18 [user-009] fix: assert scheduler behaviour and read pending under lock"
+#define MPP_VER_HIST_5          "2d14f04 author: agent          2026-10-18 [user-007] fix: return stage names in decoder perf stats"
+#define MPP_VER_HIST_6          "03236f3 author: agent          2026-10-18 [user-006] fix: rename null device enable env to mpp_null_dev"
+#define MPP_VER_HIST_7          "5bcd8b6 author: agent          2026-10-18 [user-025] fix: share rc reencode info clear and use sqrt in replay"
+#define MPP_VER_HIST_8          "b09bed6 author: agent          2026-10-18 [user-002] fix: read zero copy input straight into MppBuffer"
+#define MPP_VER_HIST_9          "b2237b3 author: agent          2026-10-18 [user-007] fix: export decoder perf stage names"
+
+#endif /*__VERSION_H__*/
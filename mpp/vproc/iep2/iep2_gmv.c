@@ -25,33 +25,39 @@
 #include "iep2_api.h"
 #include "iep2_gmv.h"
 
-static void iep2_sort(uint32_t bin[], int map[], int size)
+/*
+ * Put the indices of the top k bins in map[0] ~ map[k - 1] in descending
+ * order. It runs the first k passes of an in-place selection sort on the
+ * index map, so the order of equal bins is the same as a full selection
+ * sort while the cost is O(k * size) without any temporary buffer.
+ */
+void iep2_top_k(const uint32_t bin[], int map[], int size, int k)
 {
-    int i, m, n;
-    uint32_t *dat = malloc(size * sizeof(uint32_t));
+    int m, n;
 
-    for (i = 0; i < size; ++i) {
-        map[i] = i;
-        dat[i] = bin[i];
-    }
+    for (m = 0; m < size; ++m)
+        map[m] = m;
+
+    k = MPP_MIN(k, size);
 
-    for (m = 0; m < size; ++m) {
+    for (m = 0; m < k; ++m) {
         int max = m;
-        uint32_t temp;
+        uint32_t max_val = bin[map[m]];
         int p;
 
-        for (n = m + 1; n < size; ++n) if (dat[n] > dat[max]) max = n;
-        // Put found minimum element in its place
-        temp = dat[m];
-        p = map[m];
+        for (n = m + 1; n < size; ++n) {
+            uint32_t val = bin[map[n]];
 
+            if (val > max_val) {
+                max = n;
+                max_val = val;
+            }
+        }
+
+        p = map[m];
         map[m] = map[max];
         map[max] = p;
-        dat[m] = dat[max];
-        dat[max] = temp;
     }
-
-    free(dat);
 }
 
 static int iep2_is_subt_mv(int mv, struct mv_list *mv_ls)
@@ -88,21 +94,13 @@ void iep2_update_gmv(struct iep2_api_ctx *ctx, struct mv_list *mv_ls)
     bin[MVL] = 0; // disable 0 mv
 
     // update motion vector candidates
-    iep2_sort(bin, map, lbin);
-
-    iep_dbg_trace("sort map:\n");
-    if (0) {
-        for (i = 0; i < lbin; ++i) {
-            fprintf(stderr, "%d ", map[i]);
-        }
-        fprintf(stderr, "\n");
-    }
+    iep2_top_k(bin, map, lbin, IEP2_GMV_CAND_NUM);
 
     memset(ctx->params.mv_tru_list, 0, sizeof(ctx->params.mv_tru_list));
     memset(ctx->params.mv_tru_vld, 0, sizeof(ctx->params.mv_tru_vld));
 
     // Get top 8 candidates of current motion estimation.
-    for (i = 0; i < 8; ++i) {
+    for (i = 0; i < IEP2_GMV_CAND_NUM; ++i) {
         int8_t x = map[i] - MVL;
 
         if (bin[map[i]] > r * ((rows * cols) >> 7) ||
@@ -120,7 +118,7 @@ void iep2_update_gmv(struct iep2_api_ctx *ctx, struct mv_list *mv_ls)
         }
     }
 
-    for (i = 0; i < 8; ++i)
+    for (i = 0; i < IEP2_GMV_CAND_NUM; ++i)
         iep_dbg_trace("new mv candidates list[%d] (%d,%d) %d\n",
                       i, ctx->params.mv_tru_list[i], 0, ctx->params.mv_tru_vld[i]);
 }
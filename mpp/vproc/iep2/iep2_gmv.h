@@ -20,6 +20,10 @@
 #include "iep2.h"
 #include "iep2_api.h"
 
+#define IEP2_GMV_CAND_NUM       8
+
 void iep2_update_gmv(struct iep2_api_ctx *ctx, struct mv_list *ls);
+/* indices of the k largest bins in descending order to map[0] ~ map[k - 1] */
+void iep2_top_k(const uint32_t bin[], int map[], int size, int k);
 
 #endif
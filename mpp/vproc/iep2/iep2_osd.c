@@ -25,69 +25,67 @@
 
 #include "iep2_api.h"
 
-void iep2_sort(uint32_t bin[], uint32_t map[], int size)
-{
-    int i, m, n;
-    uint32_t *dat = malloc(size * sizeof(uint32_t));
-
-    for (i = 0; i < size; ++i) {
-        map[i] = i;
-        dat[i] = bin[i];
-    }
-
-    for (m = 0; m < size; ++m) {
-        int max = m;
-        uint32_t temp;
-        int p;
-
-        for (n = m + 1; n < size; ++n)
-            if (dat[n] > dat[max])
-                max = n;
-        // Put found minimum element in its place
-        temp = dat[m];
-        p = map[m];
-
-        map[m] = map[max];
-        map[max] = p;
-        dat[m] = dat[max];
-        dat[max] = temp;
-    }
-
-    free(dat);
-}
-
 static int iep2_osd_check(int8_t *mv, int w, int sx, int ex, int sy, int ey,
                           int *mvx)
 {
     /* (28 + 27) * 4 + 1 */
     uint32_t hist[221];
-    uint32_t map[221];
+    int map[221];
+    /*
+     * count all int8 mv without range check into four interleaved tables
+     * so that runs of the same mv do not serialize on one counter
+     */
+    uint32_t cnt[4][256];
     int total = (ey - sy + 1) * (ex - sx + 1);
     int non_zero = 0;
     int domin = 0;
+    int invalid = 0;
     int i, j;
 
-    memset(hist, 0, sizeof(hist));
+    memset(cnt, 0, sizeof(cnt));
 
     for (i = sy; i <= ey; ++i) {
-        for (j = sx; j <= ex; ++j) {
-            int8_t v = mv[i * w + j];
-            uint32_t idx = v + 28 * 4;
+        uint8_t *row = (uint8_t *)mv + i * w;
+
+        for (j = sx; j + 3 <= ex; j += 4) {
+            cnt[0][row[j + 0]]++;
+            cnt[1][row[j + 1]]++;
+            cnt[2][row[j + 2]]++;
+            cnt[3][row[j + 3]]++;
+        }
+        for (; j <= ex; ++j)
+            cnt[0][row[j]]++;
+    }
+
+    for (i = 0; i < 256; ++i) {
+        int8_t v = (int8_t)i;
+        uint32_t idx = v + 28 * 4;
+        uint32_t sum = cnt[0][i] + cnt[1][i] + cnt[2][i] + cnt[3][i];
+
+        if (idx < MPP_ARRAY_ELEMS(hist))
+            hist[idx] = sum;
+        else
+            invalid += sum;
+    }
+
+    /* rescan only for the log of invalid mv position */
+    if (invalid) {
+        for (i = sy; i <= ey; ++i) {
+            for (j = sx; j <= ex; ++j) {
+                uint32_t idx = mv[i * w + j] + 28 * 4;
 
-            if (idx >= MPP_ARRAY_ELEMS(hist)) {
-                mpp_log("invalid mv at (%d, %d)\n", j, i);
-                continue;
+                if (idx >= MPP_ARRAY_ELEMS(hist))
+                    mpp_log("invalid mv at (%d, %d)\n", j, i);
             }
-            hist[idx]++;
         }
     }
 
     non_zero = total - hist[28 * 4];
 
-    iep2_sort(hist, map, MPP_ARRAY_ELEMS(hist));
+    iep2_top_k(hist, map, MPP_ARRAY_ELEMS(hist), 1);
 
     domin = hist[map[0]];
-    if (map[0] + 1 < MPP_ARRAY_ELEMS(hist))
+    if (map[0] + 1 < (int)MPP_ARRAY_ELEMS(hist))
         domin += hist[map[0] + 1];
     if (map[0] >= 1)
         domin += hist[map[0] - 1];
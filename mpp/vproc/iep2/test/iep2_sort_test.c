@@ -0,0 +1,132 @@
+/* SPDX-License-Identifier: Apache-2.0 OR MIT */
+/*
+ * Copyright (c) 2024 Rockchip Electronics Co., Ltd.
+ */
+
+#define MODULE_TAG "iep2_sort_test"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "mpp_log.h"
+#include "mpp_time.h"
+#include "mpp_common.h"
+
+#include "iep2_gmv.h"
+
+#define TEST_ROUND          100000
+#define OSD_HIST_SIZE       221
+#define GMV_HIST_SIZE       (MVL + MVR + 1)
+
+/* the full selection sort used before top k selection */
+static void sort_ref(uint32_t bin[], int map[], int size)
+{
+    uint32_t dat[OSD_HIST_SIZE];
+    int i, m, n;
+
+    for (i = 0; i < size; ++i) {
+        map[i] = i;
+        dat[i] = bin[i];
+    }
+
+    for (m = 0; m < size; ++m) {
+        int max = m;
+        uint32_t temp;
+        int p;
+
+        for (n = m + 1; n < size; ++n)
+            if (dat[n] > dat[max])
+                max = n;
+
+        temp = dat[m];
+        p = map[m];
+
+        map[m] = map[max];
+        map[max] = p;
+        dat[m] = dat[max];
+        dat[max] = temp;
+    }
+}
+
+/* sparse histogram with many equal bins like the mv histogram */
+static void gen_hist(uint32_t *bin, int size, int round)
+{
+    int range = (round & 3) == 0 ? 2 : (round & 3) == 1 ? 8 : 1000;
+    int i;
+
+    for (i = 0; i < size; i++)
+        bin[i] = (rand() % 4) ? 0 : rand() % range;
+
+    if (round & 4)
+        memset(bin, 0, sizeof(bin[0]) * size / 2);
+}
+
+static MPP_RET test_size(int size, int k)
+{
+    uint32_t bin[OSD_HIST_SIZE];
+    int map_ref[OSD_HIST_SIZE];
+    int map[OSD_HIST_SIZE];
+    int i;
+
+    for (i = 0; i < TEST_ROUND; i++) {
+        gen_hist(bin, size, i);
+
+        sort_ref(bin, map_ref, size);
+        iep2_top_k(bin, map, size, k);
+
+        if (memcmp(map, map_ref, sizeof(map[0]) * k)) {
+            mpp_err("size %d k %d round %d candidate list mismatch\n", size, k, i);
+            return MPP_NOK;
+        }
+    }
+
+    return MPP_OK;
+}
+
+static void bench_size(int size, int k)
+{
+    uint32_t bin[OSD_HIST_SIZE];
+    int map[OSD_HIST_SIZE];
+    RK_S64 time_ref, time_new;
+    RK_S64 start;
+    int i;
+
+    gen_hist(bin, size, 2);
+
+    start = mpp_time();
+    for (i = 0; i < TEST_ROUND / 10; i++)
+        sort_ref(bin, map, size);
+    time_ref = mpp_time() - start;
+
+    start = mpp_time();
+    for (i = 0; i < TEST_ROUND / 10; i++)
+        iep2_top_k(bin, map, size, k);
+    time_new = mpp_time() - start;
+
+    mpp_log("size %d top %d x %d: full sort %lld us top k %lld us\n",
+            size, k, TEST_ROUND / 10, time_ref, time_new);
+}
+
+int main()
+{
+    MPP_RET ret = MPP_OK;
+
+    mpp_log("iep2_sort test start\n");
+
+    srand(0x1e92);
+
+    /* gmv candidates and osd dominant mv */
+    ret |= test_size(GMV_HIST_SIZE, IEP2_GMV_CAND_NUM);
+    ret |= test_size(OSD_HIST_SIZE, 1);
+    ret |= test_size(OSD_HIST_SIZE, OSD_HIST_SIZE);
+    ret |= test_size(5, IEP2_GMV_CAND_NUM);
+
+    if (!ret) {
+        bench_size(GMV_HIST_SIZE, IEP2_GMV_CAND_NUM);
+        bench_size(OSD_HIST_SIZE, 1);
+    }
+
+    mpp_log("iep2_sort test %s\n", ret ? "failed" : "success");
+
+    return ret;
+}
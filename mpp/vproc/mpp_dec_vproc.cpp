@@ -102,7 +102,6 @@ typedef struct MppDecVprocCtxImpl_t {
 
 static void dec_vproc_put_frame(Mpp *mpp, MppFrame frame, MppBuffer buf, RK_S64 pts, RK_U32 err)
 {
-    mpp_list *list = mpp->mFrmOut;
     MppFrame out = NULL;
     MppFrameImpl *impl = NULL;
 
@@ -115,14 +114,10 @@ static void dec_vproc_put_frame(Mpp *mpp, MppFrame frame, MppBuffer buf, RK_S64
     if (buf)
         impl->buffer = buf;
 
-    list->lock();
-    list->add_at_tail(&out, sizeof(out));
-
     mpp_dbg_pts("output frame pts %lld\n", mpp_frame_get_pts(out));
 
-    mpp->mFramePutCount++;
-    list->signal();
-    list->unlock();
+    MPP_FETCH_ADD(&mpp->mFramePutCount, 1);
+    mpp_spsc_queue_push(mpp->mFrmOut, out);
 
     if (mpp->mDec)
         mpp_dec_callback(mpp->mDec, MPP_DEC_EVENT_ON_FRM_READY, out);
@@ -21,6 +21,7 @@
 #include "mpp_debug.h"
 
 #include "allocator_std.h"
+#include "mpp_null_dev_api.h"
 
 typedef struct {
     size_t              alignment;
@@ -57,6 +58,22 @@ static MPP_RET allocator_std_alloc(void *ctx, MppBufferInfo *info)
         return MPP_ERR_NULL_PTR;
     }
 
+    /* simulated device only needs cpu memory and a unique fake fd */
+    if (mpp_null_dev_enabled()) {
+        allocator_ctx *p = (allocator_ctx *)ctx;
+
+        if (os_malloc(&info->ptr, p->alignment, info->size)) {
+            mpp_err_f("failed to malloc size %d\n", info->size);
+            info->ptr = NULL;
+            return MPP_ERR_MALLOC;
+        }
+
+        info->hnd = NULL;
+        /* zero fd is taken as invalid by buffer check */
+        info->fd = ++p->fd_count;
+        return MPP_OK;
+    }
+
     mpp_err_f("Warning: std allocator should be used on simulation mode only\n");
     (void)info;
 
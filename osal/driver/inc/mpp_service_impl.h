@@ -40,6 +40,7 @@ typedef struct MppDevMppService_t {
     RK_S32          server;
     void            *serv_ctx;
     RK_S32          batch_io;
+    RK_S32          batch_prio;
     MppCbCtx        *dev_cb;
 
     MppReqV1        *reqs;
@@ -25,6 +25,7 @@
 #include "mpp_platform.h"
 #include "mpp_device_debug.h"
 #include "mpp_service_api.h"
+#include "mpp_null_dev_api.h"
 #include "vcodec_service_api.h"
 
 typedef struct MppDevImpl_t {
@@ -57,17 +58,22 @@ MPP_RET mpp_dev_init(MppDev *ctx, MppClientType type)
     MppIoctlVersion ioctl_version = mpp_get_ioctl_version();
     const MppDevApi *api = NULL;
 
-    switch (ioctl_version) {
-    case IOCTL_VCODEC_SERVICE : {
-        api = &vcodec_service_api;
-    } break;
-    case IOCTL_MPP_SERVICE_V1 : {
-        api = &mpp_service_api;
-    } break;
-    default : {
-        mpp_err_f("invalid ioctl verstion %d\n", ioctl_version);
-        return MPP_NOK;
-    } break;
+    if (mpp_null_dev_enabled()) {
+        api = &mpp_null_dev_api;
+        mpp_log_f("client %d use simulated null device\n", type);
+    } else {
+        switch (ioctl_version) {
+        case IOCTL_VCODEC_SERVICE : {
+            api = &vcodec_service_api;
+        } break;
+        case IOCTL_MPP_SERVICE_V1 : {
+            api = &mpp_service_api;
+        } break;
+        default : {
+            mpp_err_f("invalid ioctl verstion %d\n", ioctl_version);
+            return MPP_NOK;
+        } break;
+        }
     }
 
     MppDevImpl *impl = mpp_calloc(MppDevImpl, 1);
@@ -124,7 +130,7 @@ MPP_RET mpp_dev_ioctl(MppDev ctx, RK_S32 cmd, void *param)
     switch (cmd) {
     case MPP_DEV_BATCH_ON : {
         if (api->attach)
-            ret = api->attach(impl_ctx);
+            ret = api->attach(impl_ctx, param);
     } break;
     case MPP_DEV_BATCH_OFF : {
         if (api->detach)
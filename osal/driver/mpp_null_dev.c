@@ -0,0 +1,293 @@
+/* SPDX-License-Identifier: Apache-2.0 OR MIT */
+/*
+ * Copyright (c) 2024 Rockchip Electronics Co., Ltd.
+ */
+
+#define MODULE_TAG "mpp_null_dev"
+
+#include <string.h>
+#include <unistd.h>
+
+#include "mpp_env.h"
+#include "mpp_mem.h"
+#include "mpp_time.h"
+#include "mpp_common.h"
+
+#include "mpp_device_debug.h"
+#include "mpp_null_dev_api.h"
+
+/*
+ * Simulated device without kernel driver.
+ *
+ * Register write is copied to a shadow register space. Register read is
+ * recorded for the task and filled from the shadow space on poll. Tasks
+ * run one by one and each one completes after a fixed latency.
+ *
+ * Environment config:
+ * mpp_null_dev_latency  - task latency in us
+ * mpp_null_dev_irq      - value or-ed to irq status register on poll
+ * mpp_null_dev_irq_reg  - byte offset of irq status register
+ * mpp_null_dev_err      - poll returns error every N tasks
+ */
+#define NULL_DEV_MAX_TASK       4
+#define NULL_DEV_MAX_RD         16
+
+typedef struct NullDevRegRd_t {
+    void                *reg;
+    RK_U32              size;
+    RK_U32              offset;
+} NullDevRegRd;
+
+typedef struct NullDevTask_t {
+    RK_S64              done_time;
+    RK_S32              rd_count;
+    NullDevRegRd        rd[NULL_DEV_MAX_RD];
+} NullDevTask;
+
+typedef struct MppNullDev_t {
+    MppClientType       type;
+
+    /* shadow register space */
+    RK_U8               *regs;
+    RK_U32              regs_size;
+
+    /* task ring from send to poll */
+    NullDevTask         tasks[NULL_DEV_MAX_TASK];
+    RK_S32              send_idx;
+    RK_S32              poll_idx;
+    RK_S32              task_count;
+
+    /* config */
+    MppNullDevHw        hw;
+    RK_U32              irq_status;
+    RK_U32              irq_reg;
+    RK_U32              err_interval;
+
+    /* statistic */
+    RK_S64              send_count;
+    RK_S64              poll_count;
+    RK_S64              wr_bytes;
+    RK_S64              wait_time;
+} MppNullDev;
+
+RK_U32 mpp_null_dev_enabled(void)
+{
+    static RK_S32 enabled = -1;
+
+    if (enabled < 0) {
+        RK_U32 val = 0;
+
+        mpp_env_get_u32("mpp_null_dev", &val, 0);
+        enabled = val ? 1 : 0;
+    }
+
+    return enabled;
+}
+
+void mpp_null_dev_hw_init(MppNullDevHw *hw)
+{
+    hw->latency = 0;
+    hw->idle_time = 0;
+    mpp_env_get_u32("mpp_null_dev_latency", &hw->latency, 0);
+}
+
+RK_S64 mpp_null_dev_hw_run(MppNullDevHw *hw)
+{
+    RK_S64 start = MPP_MAX(mpp_time(), hw->idle_time);
+
+    hw->idle_time = start + hw->latency;
+    return hw->idle_time;
+}
+
+static MPP_RET null_dev_init(void *ctx, MppClientType type)
+{
+    MppNullDev *p = (MppNullDev *)ctx;
+
+    p->type = type;
+
+    mpp_null_dev_hw_init(&p->hw);
+    mpp_env_get_u32("mpp_null_dev_irq", &p->irq_status, 0);
+    mpp_env_get_u32("mpp_null_dev_irq_reg", &p->irq_reg, 0);
+    mpp_env_get_u32("mpp_null_dev_err", &p->err_interval, 0);
+
+    mpp_dev_dbg_probe("client %d latency %d us irq %x at %x err interval %d\n",
+                      type, p->hw.latency, p->irq_status, p->irq_reg, p->err_interval);
+
+    return MPP_OK;
+}
+
+static MPP_RET null_dev_deinit(void *ctx)
+{
+    MppNullDev *p = (MppNullDev *)ctx;
+
+    mpp_dev_dbg_time("client %d send %lld tasks write %lld bytes wait %lld us\n",
+                     p->type, p->send_count, p->wr_bytes, p->wait_time);
+
+    MPP_FREE(p->regs);
+    p->regs_size = 0;
+
+    return MPP_OK;
+}
+
+static MPP_RET null_dev_reg_wr(void *ctx, MppDevRegWrCfg *cfg)
+{
+    MppNullDev *p = (MppNullDev *)ctx;
+    RK_U32 end = cfg->offset + cfg->size;
+
+    if (end > p->regs_size) {
+        RK_U8 *regs = mpp_realloc(p->regs, RK_U8, end);
+
+        if (NULL == regs) {
+            mpp_err_f("failed to expand shadow regs to %d\n", end);
+            return MPP_ERR_MALLOC;
+        }
+
+        memset(regs + p->regs_size, 0, end - p->regs_size);
+        p->regs = regs;
+        p->regs_size = end;
+    }
+
+    memcpy(p->regs + cfg->offset, cfg->reg, cfg->size);
+    p->wr_bytes += cfg->size;
+
+    mpp_dev_dbg_reg("write offset %08x size %d\n", cfg->offset, cfg->size);
+
+    return MPP_OK;
+}
+
+static MPP_RET null_dev_reg_rd(void *ctx, MppDevRegRdCfg *cfg)
+{
+    MppNullDev *p = (MppNullDev *)ctx;
+    NullDevTask *task = &p->tasks[p->send_idx];
+    NullDevRegRd *rd;
+
+    if (task->rd_count >= NULL_DEV_MAX_RD) {
+        mpp_err_f("read region count reach max %d\n", NULL_DEV_MAX_RD);
+        return MPP_NOK;
+    }
+
+    rd = &task->rd[task->rd_count++];
+    rd->reg = cfg->reg;
+    rd->size = cfg->size;
+    rd->offset = cfg->offset;
+
+    return MPP_OK;
+}
+
+static MPP_RET null_dev_reg_offset(void *ctx, MppDevRegOffsetCfg *cfg)
+{
+    (void)ctx;
+    (void)cfg;
+    return MPP_OK;
+}
+
+static MPP_RET null_dev_reg_offs(void *ctx, MppDevRegOffCfgs *cfg)
+{
+    (void)ctx;
+    (void)cfg;
+    return MPP_OK;
+}
+
+static MPP_RET null_dev_rcb_info(void *ctx, MppDevRcbInfoCfg *cfg)
+{
+    (void)ctx;
+    (void)cfg;
+    return MPP_OK;
+}
+
+static MPP_RET null_dev_set_info(void *ctx, MppDevInfoCfg *cfg)
+{
+    (void)ctx;
+    (void)cfg;
+    return MPP_OK;
+}
+
+static MPP_RET null_dev_cmd_send(void *ctx)
+{
+    MppNullDev *p = (MppNullDev *)ctx;
+    NullDevTask *task = &p->tasks[p->send_idx];
+
+    if (p->task_count >= NULL_DEV_MAX_TASK) {
+        mpp_err_f("too many pending tasks %d\n", p->task_count);
+        return MPP_NOK;
+    }
+
+    task->done_time = mpp_null_dev_hw_run(&p->hw);
+
+    p->send_idx = (p->send_idx + 1) % NULL_DEV_MAX_TASK;
+    p->task_count++;
+    p->send_count++;
+
+    return MPP_OK;
+}
+
+static MPP_RET null_dev_cmd_poll(void *ctx, MppDevPollCfg *cfg)
+{
+    MppNullDev *p = (MppNullDev *)ctx;
+    NullDevTask *task = &p->tasks[p->poll_idx];
+    MPP_RET ret = MPP_OK;
+    RK_S64 now;
+    RK_S32 i;
+
+    if (p->task_count <= 0) {
+        mpp_err_f("poll without task sent\n");
+        return MPP_NOK;
+    }
+
+    now = mpp_time();
+    if (task->done_time > now) {
+        usleep(task->done_time - now);
+        p->wait_time += task->done_time - now;
+    }
+
+    for (i = 0; i < task->rd_count; i++) {
+        NullDevRegRd *rd = &task->rd[i];
+        RK_U32 copy = 0;
+
+        if (rd->offset < p->regs_size)
+            copy = MPP_MIN(rd->size, p->regs_size - rd->offset);
+
+        if (copy)
+            memcpy(rd->reg, p->regs + rd->offset, copy);
+        if (copy < rd->size)
+            memset((RK_U8 *)rd->reg + copy, 0, rd->size - copy);
+
+        if (p->irq_reg >= rd->offset && p->irq_reg + sizeof(RK_U32) <= rd->offset + rd->size)
+            *(RK_U32 *)((RK_U8 *)rd->reg + p->irq_reg - rd->offset) |= p->irq_status;
+    }
+
+    p->poll_count++;
+    if (p->err_interval && !(p->poll_count % p->err_interval))
+        ret = MPP_NOK;
+
+    if (cfg) {
+        cfg->poll_ret = ret;
+        cfg->count_ret = 0;
+    }
+
+    task->rd_count = 0;
+    p->poll_idx = (p->poll_idx + 1) % NULL_DEV_MAX_TASK;
+    p->task_count--;
+
+    return ret;
+}
+
+const MppDevApi mpp_null_dev_api = {
+    "mpp_null_dev",
+    sizeof(MppNullDev),
+    null_dev_init,
+    null_dev_deinit,
+    NULL,
+    NULL,
+    NULL,
+    NULL,
+    null_dev_reg_wr,
+    null_dev_reg_rd,
+    null_dev_reg_offset,
+    null_dev_reg_offs,
+    null_dev_rcb_info,
+    null_dev_set_info,
+    NULL,
+    null_dev_cmd_send,
+    null_dev_cmd_poll,
+};
@@ -30,19 +30,24 @@
 
 #include "mpp_device_debug.h"
 #include "mpp_service_impl.h"
+#include "mpp_null_dev_api.h"
 #include "mpp_server.h"
 
 #define MAX_BATCH_TASK      8
 #define MAX_SESSION_TASK    4
 #define MAX_REQ_SEND_CNT    MAX_REQ_NUM
 #define MAX_REQ_WAIT_CNT    2
+/* default timer interval in ms for batch timeout and poll */
+#define BATCH_TIMEOUT       10
 
 #define MPP_SERVER_DBG_FLOW             (0x00000001)
+#define MPP_SERVER_DBG_STATS            (0x00000002)
 
 #define mpp_serv_dbg(flag, fmt, ...)    _mpp_dbg(mpp_server_debug, flag, fmt, ## __VA_ARGS__)
 #define mpp_serv_dbg_f(flag, fmt, ...)  _mpp_dbg_f(mpp_server_debug, flag, fmt, ## __VA_ARGS__)
 
 #define mpp_serv_dbg_flow(fmt, ...)     mpp_serv_dbg(MPP_SERVER_DBG_FLOW, fmt, ## __VA_ARGS__)
+#define mpp_serv_dbg_stats(fmt, ...)    mpp_serv_dbg(MPP_SERVER_DBG_STATS, fmt, ## __VA_ARGS__)
 
 #define FIFO_WRITE(size, count, wr, rd) \
     do { \
@@ -85,6 +90,11 @@ struct MppDevTask_t {
 
     MppReqV1            *req;
     RK_S32              req_cnt;
+
+    /* time entering pending queue */
+    RK_S64              pend_time;
+    /* finish time on simulated hardware */
+    RK_S64              sim_done;
 };
 
 struct MppDevBatTask_t {
@@ -109,6 +119,7 @@ struct MppDevBatTask_t {
     RK_S32              fill_cnt;
     RK_S32              fill_full;
     RK_S32              fill_timeout;
+    RK_S32              fill_urgent;
     RK_S32              poll_cnt;
 };
 
@@ -126,6 +137,10 @@ struct MppDevSession_t {
     MppDevBatServ       *server;
 
     RK_S32              client;
+    /* latency sensitive session has positive priority */
+    RK_S32              prio;
+    /* last batch id the session is filled in */
+    RK_U32              batch_mark;
 
     RK_S32              task_wait;
     RK_S32              task_done;
@@ -135,8 +150,15 @@ struct MppDevSession_t {
 
 struct MppDevBatServ_t {
     Mutex               *lock;
+    /* lock process_task against statistic reader */
+    Mutex               *proc_lock;
+    /* timer is woken by task sending, lock by server */
+    RK_S32              wake;
 
     RK_S32              server_fd;
+    /* simulated device backend without kernel driver */
+    RK_S32              sim;
+    MppNullDevHw        sim_hw;
     RK_U32              batch_id;
     RK_U32              task_id;
 
@@ -156,10 +178,14 @@ struct MppDevBatServ_t {
     RK_S32              batch_run;
     RK_S32              batch_free;
     RK_S32              max_task_in_batch;
+    /* adaptive batch size to send batch without timeout */
+    RK_S32              batch_size;
 
     /* link to all pending tasks */
     struct list_head    pending_task;
     RK_S32              pending_count;
+
+    MppServerStats      stats;
 };
 
 RK_U32 mpp_server_debug = 0;
@@ -171,6 +197,7 @@ static void batch_reset(MppDevBatTask *batch)
     batch->fill_cnt = 0;
     batch->fill_full = 0;
     batch->fill_timeout = 0;
+    batch->fill_urgent = 0;
     batch->poll_cnt = 0;
     batch->send_req_cnt = 0;
     batch->wait_req_cnt = 0;
@@ -214,31 +241,142 @@ void batch_del(MppDevBatServ *server, MppDevBatTask *batch)
     mpp_serv_dbg_flow("batch del free count %d:%d\n", server->batch_run, server->batch_free);
 }
 
+static void batch_update_stats(MppDevBatServ *server, MppDevBatTask *batch)
+{
+    MppServerStats *stats = &server->stats;
+    MppDevTask *task;
+    RK_S64 now = mpp_time();
+    RK_S32 pending;
+
+    list_for_each_entry(task, &batch->link_tasks, MppDevTask, link_batch) {
+        RK_S64 wait = now - task->pend_time;
+
+        stats->wait_sum += wait;
+        if (wait > stats->wait_max)
+            stats->wait_max = wait;
+    }
+
+    stats->batch_count++;
+    stats->task_count += batch->fill_cnt;
+    if (batch->fill_urgent)
+        stats->send_urgent++;
+    else if (batch->fill_timeout)
+        stats->send_timeout++;
+    else
+        stats->send_full++;
+
+    /*
+     * Adapt batch size to the load:
+     * timeout batch means tasks arrive slower than the batch size so shrink
+     * to the filled count. Full batch with deep queue behind means hardware
+     * is saturated so grow batch size to reduce ioctl and irq count.
+     */
+    server->lock->lock();
+    pending = server->pending_count;
+    server->lock->unlock();
+
+    if (batch->fill_timeout) {
+        RK_S32 size = MPP_MAX(batch->fill_cnt, 1);
+
+        if (size < server->batch_size)
+            stats->size_shrink++;
+        server->batch_size = size;
+    } else if (batch->fill_full && pending >= server->batch_size) {
+        RK_S32 size = MPP_MIN(server->batch_size * 2, server->max_task_in_batch);
+
+        if (size > server->batch_size)
+            stats->size_grow++;
+        server->batch_size = size;
+    }
+    stats->batch_size = server->batch_size;
+}
+
 void batch_send(MppDevBatServ *server, MppDevBatTask *batch)
 {
     RK_S32 ret = 0;
 
     mpp_assert(batch->send_req_cnt);
 
-    ret = mpp_service_ioctl_request(server->server_fd, batch->send_reqs);
-    if (ret) {
-        mpp_err_f("ioctl batch cmd failed ret %d errno %d %s\n",
-                  ret, errno, strerror(errno));
-        ret = errno;
-        mpp_serv_dbg_flow("batch %d -> send failed\n", batch->batch_id);
+    if (server->sim) {
+        MppDevTask *task;
+
+        list_for_each_entry(task, &batch->link_tasks, MppDevTask, link_batch) {
+            task->sim_done = mpp_null_dev_hw_run(&server->sim_hw);
+        }
+    } else {
+        ret = mpp_service_ioctl_request(server->server_fd, batch->send_reqs);
+        if (ret) {
+            mpp_err_f("ioctl batch cmd failed ret %d errno %d %s\n",
+                      ret, errno, strerror(errno));
+            ret = errno;
+            mpp_serv_dbg_flow("batch %d -> send failed\n", batch->batch_id);
+        }
     }
 
+    batch_update_stats(server, batch);
+
     list_del_init(&batch->link_server);
     list_add_tail(&batch->link_server, &server->list_batch);
     server->batch_free--;
     server->batch_run++;
-    mpp_serv_dbg_flow("batch %d -> send %d for %s\n", batch->batch_id,
-                      batch->fill_cnt, batch->fill_timeout ? "timeout" : "ready");
+    mpp_serv_dbg_flow("batch %d -> send %d for %s next size %d\n", batch->batch_id,
+                      batch->fill_cnt, batch->fill_urgent ? "urgent" :
+                      batch->fill_timeout ? "timeout" : "ready", server->batch_size);
+}
+
+static RK_S32 batch_poll(MppDevBatServ *server, MppDevBatTask *batch)
+{
+    MppDevTask *task;
+    RK_S64 now;
+
+    if (!server->sim)
+        return mpp_service_ioctl_request(server->server_fd, batch->wait_reqs);
+
+    now = mpp_time();
+    list_for_each_entry(task, &batch->link_tasks, MppDevTask, link_batch) {
+        MppDevBatCmd *cmd = batch->bat_cmd + task->batch_slot_id;
+
+        cmd->ret = (now >= task->sim_done) ? 0 : EAGAIN;
+    }
+
+    return 0;
 }
 
-void process_task(void *p)
+/*
+ * Select next pending task for the batch. Session with higher priority goes
+ * first and session already in this batch goes after the others so one busy
+ * session can not occupy the whole batch. Tasks of the same session keep the
+ * fifo order. Called with server lock.
+ */
+static MppDevTask *batch_pick_task(MppDevBatServ *server, MppDevBatTask *batch)
+{
+    MppDevTask *task;
+    MppDevTask *best = NULL;
+    RK_U32 mark = batch->batch_id + 1;
+    RK_S32 best_new = 0;
+    RK_S32 best_prio = 0;
+
+    list_for_each_entry(task, &server->pending_task, MppDevTask, link_server) {
+        MppDevSession *session = task->session;
+        RK_S32 is_new = session->batch_mark != mark;
+
+        if (best && (is_new < best_new ||
+                     (is_new == best_new && session->prio <= best_prio)))
+            continue;
+
+        best = task;
+        best_new = is_new;
+        best_prio = session->prio;
+    }
+
+    if (best)
+        best->session->batch_mark = mark;
+
+    return best;
+}
+
+static void process_task_locked(MppDevBatServ *server, RK_S32 timeout)
 {
-    MppDevBatServ *server = (MppDevBatServ *)p;
     Mutex *lock = server->lock;
     RK_S32 ret = MPP_OK;
     MppDevTask *task;
@@ -257,7 +395,7 @@ void process_task(void *p)
             break;
 
         mpp_assert(batch->wait_req_cnt);
-        ret = mpp_service_ioctl_request(server->server_fd, batch->wait_reqs);
+        ret = batch_poll(server, batch);
         if (!ret) {
             MppDevTask *n;
 
@@ -344,23 +482,20 @@ try_proc_pending_task:
     }
     mpp_assert(server->batch_free);
 
+    batch = list_first_entry_or_null(&server->list_batch_free, MppDevBatTask, link_server);
+    mpp_assert(batch);
+    if (NULL == batch) {
+        mpp_log_f("batch run %d free %d\n", server->batch_run, server->batch_free);
+        return;
+    }
+
     /* 4. if no pending task to send check timeout batch and send it */
     if (!pending) {
-        if (!server->batch_free) {
-            /* no pending and no free batch just done */
-            return;
-        }
-
-        batch = list_first_entry_or_null(&server->list_batch_free, MppDevBatTask, link_server);
-        mpp_assert(batch);
-        if (NULL == batch) {
-            mpp_log_f("batch run %d free %d\n", server->batch_run, server->batch_free);
-            return;
-        }
-
-        /* send one timeout task */
-        if (batch->fill_cnt)
+        /* partial batch is only sent on timer and held on task sending */
+        if (timeout && batch->fill_cnt) {
+            batch->fill_timeout = 1;
             batch_send(server, batch);
+        }
 
         mpp_serv_dbg_flow("finish for no pending task\n");
         return;
@@ -369,38 +504,32 @@ try_proc_pending_task:
     mpp_serv_dbg_flow("pending task %d left to process\n", pending);
 
     /* 5. add task to add batch and try send batch */
-    if (!server->batch_free) {
-        /* no pending and no free batch just done */
-        return;
-    }
-
-    batch = list_first_entry_or_null(&server->list_batch_free, MppDevBatTask, link_server);
-    mpp_assert(batch);
-    mpp_assert(pending);
+    /* first task and setup new batch id */
+    if (!batch->fill_cnt)
+        batch->batch_id = server->batch_id++;
 
-    task = NULL;
     lock->lock();
-    task = list_first_entry_or_null(&server->pending_task, MppDevTask, link_server);
+    task = batch_pick_task(server, batch);
+    mpp_assert(task);
     list_del_init(&task->link_server);
     server->pending_count--;
+    pending = server->pending_count;
     lock->unlock();
-    pending--;
-
-    /* first task and setup new batch id */
-    if (!batch->fill_cnt)
-        batch->batch_id = server->batch_id++;
 
     task->batch = batch;
     task->batch_slot_id = batch->fill_cnt++;
     mpp_assert(task->batch_slot_id < server->max_task_in_batch);
     list_add_tail(&task->link_batch, &batch->link_tasks);
-    if (batch->fill_cnt >= server->max_task_in_batch)
+    if (batch->fill_cnt >= server->batch_size)
         batch->fill_full = 1;
 
     session = task->session;
     mpp_assert(session);
     mpp_assert(session->ctx);
 
+    if (session->prio > 0)
+        batch->fill_urgent = 1;
+
     bat_cmd = batch->bat_cmd + task->batch_slot_id;
     bat_cmd->flag = 0;
     bat_cmd->client = session->client;
@@ -443,20 +572,38 @@ try_proc_pending_task:
                       batch->batch_id, task->batch_slot_id, session->client,
                       task->slot_idx, task->task_id);
 
-    if (batch->fill_full) {
-        list_del_init(&batch->link_server);
-        list_add_tail(&batch->link_server, &server->list_batch);
-        mpp_serv_dbg_flow("batch %d -> fill_nb %d fill ready\n",
-                          batch->batch_id, batch->fill_cnt);
+    if (batch->fill_full || batch->fill_urgent) {
+        mpp_serv_dbg_flow("batch %d -> fill_nb %d fill %s\n", batch->batch_id,
+                          batch->fill_cnt, batch->fill_urgent ? "urgent" : "ready");
         batch_send(server, batch);
         batch = NULL;
     }
     goto try_proc_pending_task;
 }
 
+void process_task(MppDevBatServ *server, RK_S32 timeout)
+{
+    server->proc_lock->lock();
+    process_task_locked(server, timeout);
+    server->proc_lock->unlock();
+}
+
+/*
+ * Tasks are only processed on the timer thread. Timer tick polls the
+ * running batches and sends the partial batch as timeout. Task sending
+ * wakes the timer at once to send the full or urgent batch.
+ */
 static void *mpp_server_thread(void *ctx)
 {
-    process_task((MppDevBatServ *)ctx);
+    MppDevBatServ *server = (MppDevBatServ *)ctx;
+    RK_S32 timeout;
+
+    server->lock->lock();
+    timeout = !server->wake;
+    server->wake = 0;
+    server->lock->unlock();
+
+    process_task(server, timeout);
     return NULL;
 }
 
@@ -489,15 +636,19 @@ MPP_RET send_task(MppDevMppService *ctx)
 
     server->lock->lock();
     task->task_id = server->task_id++;
+    task->pend_time = mpp_time();
     list_del_init(&task->link_server);
     list_add_tail(&task->link_server, &server->pending_task);
     server->pending_count++;
     mpp_serv_dbg_flow("session %d:%d add pending %d\n",
                       session->client, task->slot_idx, server->pending_count);
 
+    server->wake = 1;
     mpp_timer_set_enable(server->timer, 1);
     server->lock->unlock();
 
+    mpp_timer_trigger(server->timer);
+
     return MPP_OK;
 }
 
@@ -556,6 +707,8 @@ private:
     MppMemPool          mBatchPool;
 
     RK_S32              mMaxTaskInBatch;
+    RK_S32              mBatchTimeout;
+    RK_S32              mSim;
 
     const MppServiceCmdCap *mCmdCap;
 
@@ -572,6 +725,7 @@ public:
     MPP_RET detach(MppDevMppService *ctx);
 
     MPP_RET check_status(void);
+    MPP_RET get_stats(MppClientType client_type, MppServerStats *stats);
 };
 
 MppDevServer::MppDevServer() :
@@ -582,6 +736,8 @@ MppDevServer::MppDevServer() :
     mSessionPool(NULL),
     mBatchPool(NULL),
     mMaxTaskInBatch(0),
+    mBatchTimeout(BATCH_TIMEOUT),
+    mSim(0),
     mCmdCap(NULL)
 {
     RK_S32 batch_task_size = 0;
@@ -590,20 +746,29 @@ MppDevServer::MppDevServer() :
     mpp_env_get_u32("mpp_server_enable", &mEnable, 1);
     mpp_env_get_u32("mpp_server_batch_task", (RK_U32 *)&mMaxTaskInBatch,
                     MAX_BATCH_TASK);
+    mpp_env_get_u32("mpp_server_batch_timeout", (RK_U32 *)&mBatchTimeout,
+                    BATCH_TIMEOUT);
+    if (mBatchTimeout <= 0)
+        mBatchTimeout = BATCH_TIMEOUT;
 
     mpp_assert(mMaxTaskInBatch >= 1 && mMaxTaskInBatch <= 32);
     batch_task_size = sizeof(MppDevBatTask) + mMaxTaskInBatch *
                       (sizeof(MppReqV1) * (MAX_REQ_SEND_CNT + MAX_REQ_WAIT_CNT) +
                        sizeof(MppDevBatCmd));
 
-    mCmdCap = mpp_get_mpp_service_cmd_cap();
-    if (MPP_OK != mpp_service_check_cmd_valid(MPP_CMD_SET_SESSION_FD, mCmdCap)) {
-        mServerError = "mpp_service cmd not support";
-        return;
+    /* simulated device backend does not need kernel driver */
+    mSim = mpp_null_dev_enabled();
+
+    if (!mSim) {
+        mCmdCap = mpp_get_mpp_service_cmd_cap();
+        if (MPP_OK != mpp_service_check_cmd_valid(MPP_CMD_SET_SESSION_FD, mCmdCap)) {
+            mServerError = "mpp_service cmd not support";
+            return;
+        }
     }
 
     do {
-        mServerName = mpp_get_mpp_service_name();
+        mServerName = mSim ? "mpp_null_dev" : mpp_get_mpp_service_name();
         if (NULL == mServerName) {
             mServerError = "get service device failed";
             break;
@@ -673,10 +838,16 @@ MppDevBatServ *MppDevServer::bat_server_get(MppClientType client_type)
         return NULL;
     }
 
-    server->server_fd = open(mServerName, O_RDWR | O_CLOEXEC);
-    if (server->server_fd < 0) {
-        mpp_err("mpp server get bat server failed to open device\n");
-        goto failed;
+    server->server_fd = -1;
+    server->sim = mSim;
+    if (server->sim) {
+        mpp_null_dev_hw_init(&server->sim_hw);
+    } else {
+        server->server_fd = open(mServerName, O_RDWR | O_CLOEXEC);
+        if (server->server_fd < 0) {
+            mpp_err("mpp server get bat server failed to open device\n");
+            goto failed;
+        }
     }
 
     char timer_name[32];
@@ -691,14 +862,14 @@ MppDevBatServ *MppDevServer::bat_server_get(MppClientType client_type)
     }
 
     server->lock = new Mutex();
-    if (NULL == server->lock) {
+    server->proc_lock = new Mutex();
+    if (NULL == server->lock || NULL == server->proc_lock) {
         mpp_err("mpp server get bat server failed to create mutex\n");
         goto failed;
     }
 
     mpp_timer_set_callback(server->timer, mpp_server_thread, server);
-    /* 10ms */
-    mpp_timer_set_timing(server->timer, 10, 10);
+    mpp_timer_set_timing(server->timer, mBatchTimeout, mBatchTimeout);
 
     INIT_LIST_HEAD(&server->session_list);
     INIT_LIST_HEAD(&server->list_batch);
@@ -707,6 +878,10 @@ MppDevBatServ *MppDevServer::bat_server_get(MppClientType client_type)
 
     server->batch_pool = mBatchPool;
     server->max_task_in_batch = mMaxTaskInBatch;
+    /* start from single task batch for low latency and grow on load */
+    server->batch_size = 1;
+    server->stats.batch_size = 1;
+    server->stats.batch_max = mMaxTaskInBatch;
 
     mBatServer[client_type] = server;
     return server;
@@ -726,6 +901,10 @@ failed:
             delete server->lock;
             server->lock = NULL;
         }
+        if (server->proc_lock) {
+            delete server->proc_lock;
+            server->proc_lock = NULL;
+        }
     }
     MPP_FREE(server);
     return server;
@@ -747,6 +926,16 @@ MPP_RET MppDevServer::bat_server_put(MppClientType client_type)
     mpp_assert(list_empty(&server->list_batch));
     mpp_assert(server->pending_count == 0);
 
+    mpp_serv_dbg_stats("%s batch %lld task %lld send full %lld urgent %lld timeout %lld "
+                       "size %d wait avg %lld max %lld us\n",
+                       strof_client_type(client_type), server->stats.batch_count,
+                       server->stats.task_count, server->stats.send_full,
+                       server->stats.send_urgent, server->stats.send_timeout,
+                       server->stats.batch_size,
+                       server->stats.task_count ?
+                       server->stats.wait_sum / server->stats.task_count : 0,
+                       server->stats.wait_max);
+
     /* stop thread first */
     if (server->timer) {
         mpp_timer_put(server->timer);
@@ -769,6 +958,10 @@ MPP_RET MppDevServer::bat_server_put(MppClientType client_type)
         delete server->lock;
         server->lock = NULL;
     }
+    if (server->proc_lock) {
+        delete server->proc_lock;
+        server->proc_lock = NULL;
+    }
     MPP_FREE(server);
     return MPP_OK;
 }
@@ -797,8 +990,11 @@ MPP_RET MppDevServer::attach(MppDevMppService *ctx)
     }
 
     AutoMutex auto_lock(server->lock);
-    if (ctx->serv_ctx)
+    if (ctx->serv_ctx) {
+        /* attached session only updates priority */
+        ((MppDevSession *)ctx->serv_ctx)->prio = ctx->batch_prio;
         return MPP_OK;
+    }
 
     MppDevSession *session = (MppDevSession *)mpp_mem_pool_get(mSessionPool);
     INIT_LIST_HEAD(&session->list_server);
@@ -808,6 +1004,8 @@ MPP_RET MppDevServer::attach(MppDevMppService *ctx)
     session->ctx = ctx;
     session->server = server;
     session->client = ctx->client;
+    session->prio = ctx->batch_prio;
+    session->batch_mark = 0;
     session->cond = new MppMutexCond();
     session->task_wait = 0;
     session->task_done = 0;
@@ -879,8 +1077,8 @@ MPP_RET MppDevServer::detach(MppDevMppService *ctx)
     }
 
     mpp_mem_pool_put(mSessionPool, session);
-    server->batch_max_count++;
-    server->session_count++;
+    server->batch_max_count--;
+    server->session_count--;
 
     return MPP_OK;
 }
@@ -895,6 +1093,36 @@ MPP_RET MppDevServer::check_status(void)
     return MPP_OK;
 }
 
+MPP_RET MppDevServer::get_stats(MppClientType client_type, MppServerStats *stats)
+{
+    MppDevBatServ *server;
+
+    if (!mInited) {
+        mpp_err("mpp server failed for %s\n", mServerError);
+        return MPP_NOK;
+    }
+
+    if (client_type < 0 || client_type >= VPU_CLIENT_BUTT || NULL == stats) {
+        mpp_err("mpp server get stats with invalid client type %d stats %p\n",
+                client_type, stats);
+        return MPP_NOK;
+    }
+
+    AutoMutex auto_lock(this);
+
+    server = mBatServer[client_type];
+    if (NULL == server) {
+        memset(stats, 0, sizeof(*stats));
+        return MPP_OK;
+    }
+
+    server->proc_lock->lock();
+    *stats = server->stats;
+    server->proc_lock->unlock();
+
+    return MPP_OK;
+}
+
 MPP_RET mpp_server_attach(MppDev ctx)
 {
     MppDevMppService *dev = (MppDevMppService *)ctx;
@@ -926,3 +1154,8 @@ MPP_RET mpp_server_wait_task(MppDev ctx, RK_S64 timeout)
 
     return ret;
 }
+
+MPP_RET mpp_server_get_stats(MppClientType type, MppServerStats *stats)
+{
+    return MppDevServer::get_inst()->get_stats(type, stats);
+}
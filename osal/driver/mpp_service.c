@@ -294,6 +294,7 @@ MPP_RET mpp_service_init(void *ctx, MppClientType type)
     p->client_type = type;
     p->server = p->client;
     p->batch_io = 0;
+    p->batch_prio = 0;
     p->serv_ctx = NULL;
     p->dev_cb   = NULL;
 
@@ -346,7 +347,7 @@ MPP_RET mpp_service_deinit(void *ctx)
     return MPP_OK;
 }
 
-MPP_RET mpp_service_attach(void *ctx)
+MPP_RET mpp_service_attach(void *ctx, void *param)
 {
     MppDevMppService *p = (MppDevMppService *)ctx;
 
@@ -355,8 +356,9 @@ MPP_RET mpp_service_attach(void *ctx)
         return MPP_NOK;
     }
 
-    if (!p->batch_io)
-        mpp_server_attach(p);
+    /* positive priority session flushes batch without waiting for more tasks */
+    p->batch_prio = param ? *(RK_S32 *)param : 0;
+    mpp_server_attach(p);
 
     return MPP_OK;
 }
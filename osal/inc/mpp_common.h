@@ -225,6 +225,9 @@ RK_U32 mpp_align_64(RK_U32 val);
 RK_U32 mpp_align_128(RK_U32 val);
 RK_U32 mpp_align_256_odd(RK_U32 val);
 
+/* fill cnt 16bit values from 2 byte aligned dst, used for roi / qp map span */
+void mpp_fill_u16(void *dst, RK_U16 val, RK_S32 cnt);
+
 #ifdef __cplusplus
 }
 #endif
@@ -106,8 +106,8 @@ typedef struct MppDevApi_t {
     MPP_RET     (*init)(void *ctx, MppClientType type);
     MPP_RET     (*deinit)(void *ctx);
 
-    /* bat mode function */
-    MPP_RET     (*attach)(void *ctx);
+    /* bat mode function, param is optional RK_S32 batch priority */
+    MPP_RET     (*attach)(void *ctx, void *param);
     MPP_RET     (*detach)(void *ctx);
     MPP_RET     (*delimit)(void *ctx);
     MPP_RET     (*set_cb_ctx)(void *ctx, MppCbCtx *cb);
@@ -0,0 +1,39 @@
+/* SPDX-License-Identifier: Apache-2.0 OR MIT */
+/*
+ * Copyright (c) 2024 Rockchip Electronics Co., Ltd.
+ */
+
+#ifndef __MPP_NULL_DEV_API_H__
+#define __MPP_NULL_DEV_API_H__
+
+#include "mpp_device.h"
+
+#ifdef  __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Hardware timing model of the simulated device. Tasks run one by one on
+ * the hardware and each one takes latency us. It is shared by the null
+ * device and the simulated backend of mpp_server.
+ */
+typedef struct MppNullDevHw_t {
+    RK_U32      latency;
+    RK_S64      idle_time;
+} MppNullDevHw;
+
+extern const MppDevApi mpp_null_dev_api;
+
+/* enabled by environment mpp_null_dev=1 */
+RK_U32 mpp_null_dev_enabled(void);
+
+/* setup the model from environment mpp_null_dev_latency */
+void mpp_null_dev_hw_init(MppNullDevHw *hw);
+/* start one task on the hardware and return its finish time in us */
+RK_S64 mpp_null_dev_hw_run(MppNullDevHw *hw);
+
+#ifdef  __cplusplus
+}
+#endif
+
+#endif /* __MPP_NULL_DEV_API_H__ */
@@ -19,6 +19,25 @@
 
 #include "mpp_device.h"
 
+/* batch scheduler statistic of one client type server */
+typedef struct MppServerStats_t {
+    RK_S64  batch_count;
+    RK_S64  task_count;
+    /* batch send reason: batch size reached / urgent session / timer timeout */
+    RK_S64  send_full;
+    RK_S64  send_urgent;
+    RK_S64  send_timeout;
+    /* current adaptive batch size and max task in one batch */
+    RK_S32  batch_size;
+    RK_S32  batch_max;
+    /* adaptive batch size change count */
+    RK_S64  size_grow;
+    RK_S64  size_shrink;
+    /* queue wait time in us from task send to batch send */
+    RK_S64  wait_sum;
+    RK_S64  wait_max;
+} MppServerStats;
+
 #ifdef  __cplusplus
 extern "C" {
 #endif
@@ -29,6 +48,8 @@ MPP_RET mpp_server_detach(MppDev ctx);
 MPP_RET mpp_server_send_task(MppDev ctx);
 MPP_RET mpp_server_wait_task(MppDev ctx, RK_S64 timeout);
 
+MPP_RET mpp_server_get_stats(MppClientType type, MppServerStats *stats);
+
 #ifdef  __cplusplus
 }
 #endif
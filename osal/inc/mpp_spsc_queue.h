@@ -0,0 +1,52 @@
+/* SPDX-License-Identifier: Apache-2.0 OR MIT */
+/*
+ * Copyright (c) 2024 Rockchip Electronics Co., Ltd.
+ */
+
+#ifndef __MPP_SPSC_QUEUE_H__
+#define __MPP_SPSC_QUEUE_H__
+
+#include "rk_type.h"
+#include "mpp_err.h"
+
+typedef void* MppSpscQueue;
+typedef void (*MppSpscQueueFree)(void *data);
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Pointer queue for handoff from one producer thread to consumer threads.
+ *
+ * Elements are stored in a fixed power-of-two ring. Push and pop are lock
+ * free and do not allocate. Only one thread may push at a time. Pop, wait
+ * and flush can be called from several threads.
+ * When the ring is full push blocks until a slot is popped, so the consumer
+ * must keep popping or flush the queue to let the producer go on.
+ *
+ * size     - ring slot count, rounded up to power of two, 0 for default 64
+ * release  - called on each element left on flush or deinit, can be NULL
+ */
+MPP_RET mpp_spsc_queue_init(MppSpscQueue *queue, RK_U32 size, MppSpscQueueFree release);
+MPP_RET mpp_spsc_queue_deinit(MppSpscQueue queue);
+
+MPP_RET mpp_spsc_queue_push(MppSpscQueue queue, void *data);
+/* return MPP_NOK when queue is empty */
+MPP_RET mpp_spsc_queue_pop(MppSpscQueue queue, void **data);
+/*
+ * wait until the queue is not empty
+ * timeout - negative for block wait, zero for no wait, positive in ms
+ * return MPP_OK when element is ready or MPP_ERR_TIMEOUT
+ */
+MPP_RET mpp_spsc_queue_wait(MppSpscQueue queue, RK_S64 timeout);
+
+RK_S32 mpp_spsc_queue_size(MppSpscQueue queue);
+/* release all elements in queue */
+MPP_RET mpp_spsc_queue_flush(MppSpscQueue queue);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __MPP_SPSC_QUEUE_H__ */
@@ -231,6 +231,16 @@ typedef enum MppThreadSignal_e {
     THREAD_SIGNAL_BUTT,
 } MppThreadSignal;
 
+/* wait / notify counters of one thread signal */
+typedef struct MppThreadStats_t {
+    RK_U32          wait;       // block on condition
+    RK_U32          wakeup;     // return from block
+    RK_U32          spurious;   // return from block without expected event
+    RK_U32          spin;       // expected event comes in spin and block is avoided
+    RK_U32          signal;     // notify that wakes the blocked thread
+    RK_U32          skip;       // notify without signal
+} MppThreadStats;
+
 #define THREAD_NORMAL       0
 #define THRE       0
 
@@ -279,11 +289,39 @@ public:
         return mMutexCond[id].mutex();
     }
 
+    /*
+     * Targeted wait / notify on event bits, called with the lock held.
+     * The waiter blocks until one of the events in mask is pending and the
+     * notifier only signals when the blocked waiter expects its event.
+     * Pending events are kept until the owner clears them.
+     */
+    RK_U32 get_event(MppThreadSignal id = THREAD_WORK) {
+        mpp_assert(id < THREAD_SIGNAL_BUTT);
+        return mEvent[id];
+    }
+
+    void clear_event(RK_U32 event, MppThreadSignal id = THREAD_WORK) {
+        mpp_assert(id < THREAD_SIGNAL_BUTT);
+        mEvent[id] &= ~event;
+    }
+
+    void wait_event(RK_U32 mask, MppThreadSignal id = THREAD_WORK);
+    void notify_event(RK_U32 event, MppThreadSignal id = THREAD_WORK);
+
+    void get_stats(MppThreadStats *stats, MppThreadSignal id = THREAD_WORK);
+    void dump_stats(MppThreadSignal id = THREAD_WORK);
+
 private:
     pthread_t       mThread;
     MppMutexCond    mMutexCond[THREAD_SIGNAL_BUTT];
     MppThreadStatus mStatus[THREAD_SIGNAL_BUTT];
 
+    volatile RK_U32 mEvent[THREAD_SIGNAL_BUTT];
+    RK_U32          mEventMask[THREAD_SIGNAL_BUTT];
+    MppThreadStats  mStats[THREAD_SIGNAL_BUTT];
+    /* spin time in us before block in wait_event */
+    RK_U32          mSpinUs;
+
     MppThreadFunc   mFunction;
     char            mName[THREAD_NAME_LEN];
     void            *mContext;
@@ -84,11 +84,15 @@ const char *mpp_clock_get_name(MppClock clock);
  *    ... running ...
  * 5. mpp_timer_set_enable(initial, 0)
  * 6. mpp_timer_put
+ *
+ * mpp_timer_trigger runs the callback on the timer thread at once without
+ * changing the timing of the next expiration.
  */
 MppTimer mpp_timer_get(const char *name);
 void mpp_timer_set_callback(MppTimer timer, MppThreadFunc func, void *ctx);
 void mpp_timer_set_timing(MppTimer timer, RK_S32 initial, RK_S32 interval);
 void mpp_timer_set_enable(MppTimer timer, RK_S32 enable);
+void mpp_timer_trigger(MppTimer timer);
 void mpp_timer_put(MppTimer timer);
 
 /*
@@ -18,6 +18,10 @@
 #define __MPP_TRACE_H__
 
 #include "rk_type.h"
+#include "mpp_err.h"
+
+/* chrome trace event json file writer, open with chrome://tracing or perfetto */
+typedef void* MppTraceJson;
 
 #ifdef __cplusplus
 extern "C" {
@@ -30,6 +34,12 @@ void mpp_trace_async_end(const char* name, RK_S32 cookie);
 void mpp_trace_int32(const char* name, RK_S32 value);
 void mpp_trace_int64(const char* name, RK_S64 value);
 
+MPP_RET mpp_trace_json_open(MppTraceJson *ctx, const char *path);
+MPP_RET mpp_trace_json_close(MppTraceJson ctx);
+/* complete event with start time and duration in us */
+void mpp_trace_json_event(MppTraceJson ctx, const char *name, RK_S32 pid,
+                          RK_S32 tid, RK_S64 start, RK_S64 dur);
+
 #ifdef __cplusplus
 }
 #endif
@@ -14,6 +14,9 @@
  * limitations under the License.
  */
 
+#include <stdint.h>
+#include <string.h>
+
 #include "mpp_common.h"
 
 static const RK_U8 log2_tab[256] = {
@@ -126,3 +129,26 @@ RK_U32 mpp_align_256_odd(RK_U32 val)
 {
     return MPP_ALIGN(val, 256) | 256;
 }
+
+void mpp_fill_u16(void *dst, RK_U16 val, RK_S32 cnt)
+{
+    RK_U8 *p = (RK_U8 *)dst;
+    RK_U64 val64 = val * 0x0001000100010001ULL;
+
+    /* head to 8 byte alignment then four values per 64bit store */
+    while (cnt > 0 && ((uintptr_t)p & 7)) {
+        memcpy(p, &val, sizeof(val));
+        p += sizeof(val);
+        cnt--;
+    }
+
+    for (; cnt >= 4; cnt -= 4) {
+        memcpy(p, &val64, sizeof(val64));
+        p += sizeof(val64);
+    }
+
+    while (cnt-- > 0) {
+        memcpy(p, &val, sizeof(val));
+        p += sizeof(val);
+    }
+}
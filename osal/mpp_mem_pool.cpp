@@ -22,6 +22,7 @@
 #include "mpp_env.h"
 #include "mpp_mem.h"
 #include "mpp_list.h"
+#include "mpp_lock.h"
 #include "mpp_debug.h"
 
 #include "mpp_mem_pool.h"
@@ -33,11 +34,26 @@
 
 #define mem_pool_dbg_flow(fmt, ...)     mem_pool_dbg(MPP_MEM_POOL_DBG_FLOW, fmt, ## __VA_ARGS__)
 
+/*
+ * Allocation layers from fast to slow:
+ * 1. per-thread cache (magazine) of each pool, no lock and no atomic
+ * 2. per-pool lock-free depot slots, exchanged by atomic operation
+ * 3. per-pool mutex protected unused list and malloc
+ */
+#define MEM_POOL_CACHE_SIZE             16
+/* max pools cached by one thread, least recently used one is evicted */
+#define MEM_POOL_CACHE_SLOT             16
+#define MEM_POOL_DEPOT_SIZE             64
+
 RK_U32 mpp_mem_pool_debug = 0;
 
 typedef struct MppMemPoolNode_t {
+    /* equal to node when it is used by caller */
     void                *check;
+    /* link in pool all node list */
     struct list_head    list;
+    /* link in pool unused node list */
+    struct list_head    unused;
     void                *ptr;
     size_t              size;
 } MppMemPoolNode;
@@ -45,18 +61,39 @@ typedef struct MppMemPoolNode_t {
 typedef struct MppMemPoolImpl_t {
     void                *check;
     size_t              size;
+    RK_U32              serial;
     pthread_mutex_t     lock;
     struct list_head    service_link;
 
-    struct list_head    used;
+    /* all nodes allocated by the pool for leak check and release */
+    struct list_head    all;
     struct list_head    unused;
-    RK_S32              used_count;
+    RK_S32              node_count;
     RK_S32              unused_count;
 
+    /* lock-free depot between thread caches */
+    MppMemPoolNode      *depot[MEM_POOL_DEPOT_SIZE];
+    RK_S32              depot_count;
+    RK_U32              depot_pos;
+
     /* extra flag for C++ static destruction order error */
     RK_S32              finalized;
 } MppMemPoolImpl;
 
+typedef struct MppMemPoolCache_t {
+    MppMemPoolImpl      *pool;
+    RK_U32              serial;
+    /* last access tick of this thread for eviction */
+    RK_U32              tick;
+    RK_S32              count;
+    MppMemPoolNode      *nodes[MEM_POOL_CACHE_SIZE];
+} MppMemPoolCache;
+
+static __thread MppMemPoolCache mem_pool_caches[MEM_POOL_CACHE_SLOT];
+static __thread MppMemPoolCache *mem_pool_cache_last = NULL;
+static __thread RK_U32 mem_pool_cache_tick = 0;
+static __thread RK_U32 mem_pool_cache_init = 0;
+
 class MppMemPoolService
 {
 public:
@@ -72,16 +109,36 @@ public:
 
     MppMemPoolImpl *get_pool(size_t size);
     void put_pool(MppMemPoolImpl *impl);
+    void flush_cache(MppMemPoolCache *cache);
+    void register_cache();
 
 private:
     MppMemPoolService();
     ~MppMemPoolService();
     struct list_head    mLink;
+    RK_U32              mSerial;
+    pthread_key_t       mCacheKey;
+
+    static void thread_exit(void *ctx);
 };
 
+static void pool_put_unused(MppMemPoolImpl *impl, MppMemPoolNode **nodes, RK_S32 count)
+{
+    RK_S32 i;
+
+    pthread_mutex_lock(&impl->lock);
+    for (i = 0; i < count; i++) {
+        list_add(&nodes[i]->unused, &impl->unused);
+        impl->unused_count++;
+    }
+    pthread_mutex_unlock(&impl->lock);
+}
+
 MppMemPoolService::MppMemPoolService()
 {
     INIT_LIST_HEAD(&mLink);
+    mSerial = 0;
+    pthread_key_create(&mCacheKey, thread_exit);
 
     mpp_env_get_u32("mpp_mem_pool_debug", &mpp_mem_pool_debug, 0);
 }
@@ -95,11 +152,52 @@ MppMemPoolService::~MppMemPoolService()
             put_pool(pos);
         }
     }
+
+    pthread_key_delete(mCacheKey);
+}
+
+void MppMemPoolService::thread_exit(void *ctx)
+{
+    RK_S32 i;
+
+    (void)ctx;
+
+    for (i = 0; i < MEM_POOL_CACHE_SLOT; i++)
+        getInstance()->flush_cache(&mem_pool_caches[i]);
+}
+
+void MppMemPoolService::register_cache()
+{
+    /* non-NULL value is required for calling destructor on thread exit */
+    pthread_setspecific(mCacheKey, this);
+    mem_pool_cache_init = 1;
+}
+
+/* return cached nodes to the pool when the pool is still alive */
+void MppMemPoolService::flush_cache(MppMemPoolCache *cache)
+{
+    MppMemPoolImpl *pos;
+
+    if (cache->count) {
+        AutoMutex auto_lock(get_lock());
+
+        list_for_each_entry(pos, &mLink, MppMemPoolImpl, service_link) {
+            if (pos == cache->pool && pos->serial == cache->serial) {
+                pool_put_unused(pos, cache->nodes, cache->count);
+                break;
+            }
+        }
+    }
+
+    cache->pool = NULL;
+    cache->serial = 0;
+    cache->tick = 0;
+    cache->count = 0;
 }
 
 MppMemPoolImpl *MppMemPoolService::get_pool(size_t size)
 {
-    MppMemPoolImpl *pool = mpp_malloc(MppMemPoolImpl, 1);
+    MppMemPoolImpl *pool = mpp_calloc(MppMemPoolImpl, 1);
     if (NULL == pool)
         return NULL;
 
@@ -111,14 +209,18 @@ MppMemPoolImpl *MppMemPoolService::get_pool(size_t size)
 
     pool->check = pool;
     pool->size = size;
-    pool->used_count = 0;
+    pool->node_count = 0;
     pool->unused_count = 0;
+    pool->depot_count = 0;
+    pool->depot_pos = 0;
     pool->finalized = 0;
 
-    INIT_LIST_HEAD(&pool->used);
+    INIT_LIST_HEAD(&pool->all);
     INIT_LIST_HEAD(&pool->unused);
     INIT_LIST_HEAD(&pool->service_link);
     AutoMutex auto_lock(get_lock());
+    /* serial distinguishes pool reallocated at the same address */
+    pool->serial = ++mSerial;
     list_add_tail(&pool->service_link, &mLink);
 
     return pool;
@@ -127,6 +229,8 @@ MppMemPoolImpl *MppMemPoolService::get_pool(size_t size)
 void MppMemPoolService::put_pool(MppMemPoolImpl *impl)
 {
     MppMemPoolNode *node, *m;
+    RK_S32 used_count = 0;
+    RK_S32 node_count = 0;
 
     if (impl != impl->check) {
         mpp_err_f("invalid mem impl %p check %p\n", impl, impl->check);
@@ -136,78 +240,148 @@ void MppMemPoolService::put_pool(MppMemPoolImpl *impl)
     if (impl->finalized)
         return;
 
+    /* remove from service first then no thread cache can flush to it */
+    {
+        AutoMutex auto_lock(get_lock());
+        list_del_init(&impl->service_link);
+    }
+
     pthread_mutex_lock(&impl->lock);
 
-    if (!list_empty(&impl->unused)) {
-        list_for_each_entry_safe(node, m, &impl->unused, MppMemPoolNode, list) {
-            MPP_FREE(node);
-            impl->unused_count--;
-        }
+    /* check leak before release */
+    list_for_each_entry(node, &impl->all, MppMemPoolNode, list) {
+        if (node->check == node)
+            used_count++;
+        node_count++;
     }
 
-    if (!list_empty(&impl->used)) {
-        mpp_err_f("found %d used buffer size %d\n",
-                  impl->used_count, impl->size);
+    if (used_count)
+        mpp_err_f("pool size %d found leaked buffer used:total [%d:%d]\n",
+                  (RK_S32)impl->size, used_count, node_count);
 
-        list_for_each_entry_safe(node, m, &impl->used, MppMemPoolNode, list) {
-            MPP_FREE(node);
-            impl->used_count--;
-        }
-    }
+    if (node_count != impl->node_count)
+        mpp_err_f("pool size %d node count mismatch %d:%d\n",
+                  (RK_S32)impl->size, node_count, impl->node_count);
 
-    if (impl->used_count || impl->unused_count)
-        mpp_err_f("pool size %d found leaked buffer used:unused [%d:%d]\n",
-                  impl->size, impl->used_count, impl->unused_count);
+    /* nodes in depot and thread caches are freed by the all list */
+    list_for_each_entry_safe(node, m, &impl->all, MppMemPoolNode, list) {
+        MPP_FREE(node);
+    }
+    impl->node_count = 0;
 
     pthread_mutex_unlock(&impl->lock);
 
+    impl->finalized = 1;
+    mpp_free(impl);
+}
+
+/*
+ * Per-thread map from pool to cache. Pools used by one thread do not evict
+ * each other until the map is full, then the least recently used cache is
+ * flushed back to its pool.
+ */
+static MppMemPoolCache *pool_get_cache(MppMemPoolImpl *impl)
+{
+    MppMemPoolCache *cache = mem_pool_cache_last;
+    MppMemPoolCache *victim = NULL;
+    RK_S32 i;
+
+    if (cache && cache->pool == impl && cache->serial == impl->serial)
+        goto DONE;
+
+    for (i = 0; i < MEM_POOL_CACHE_SLOT; i++) {
+        cache = &mem_pool_caches[i];
+
+        if (cache->pool == impl && cache->serial == impl->serial)
+            goto DONE;
+
+        if (!victim || (victim->pool && (!cache->pool || cache->tick < victim->tick)))
+            victim = cache;
+    }
+
     {
-        AutoMutex auto_lock(get_lock());
-        list_del_init(&impl->service_link);
+        MppMemPoolService *srv = MppMemPoolService::getInstance();
+
+        if (!mem_pool_cache_init)
+            srv->register_cache();
+
+        cache = victim;
+        if (cache->pool)
+            srv->flush_cache(cache);
+
+        cache->pool = impl;
+        cache->serial = impl->serial;
     }
 
-    impl->finalized = 1;
-    mpp_free(impl);
+DONE:
+    cache->tick = ++mem_pool_cache_tick;
+    mem_pool_cache_last = cache;
+    return cache;
 }
 
-MppMemPool mpp_mem_pool_init_f(const char *caller, size_t size)
+static MppMemPoolNode *depot_get(MppMemPoolImpl *impl)
 {
-    mem_pool_dbg_flow("pool %d init from %s", size, caller);
+    RK_U32 pos;
+    RK_S32 i;
 
-    return (MppMemPool)MppMemPoolService::getInstance()->get_pool(size);
+    if (impl->depot_count <= 0)
+        return NULL;
+
+    pos = impl->depot_pos;
+    for (i = 0; i < MEM_POOL_DEPOT_SIZE; i++) {
+        MppMemPoolNode **slot = &impl->depot[(pos + i) % MEM_POOL_DEPOT_SIZE];
+        MppMemPoolNode *node;
+
+        if (!*slot)
+            continue;
+
+        node = (MppMemPoolNode *)MPP_SYNC_TEST_SET(slot, NULL);
+        if (node) {
+            MPP_FETCH_SUB(&impl->depot_count, 1);
+            impl->depot_pos = pos + i;
+            return node;
+        }
+    }
+
+    return NULL;
 }
 
-void mpp_mem_pool_deinit_f(const char *caller, MppMemPool pool)
+static RK_S32 depot_put(MppMemPoolImpl *impl, MppMemPoolNode *node)
 {
-    MppMemPoolImpl *impl = (MppMemPoolImpl *)pool;
+    RK_U32 pos;
+    RK_S32 i;
 
-    mem_pool_dbg_flow("pool %d deinit from %s", impl->size, caller);
+    if (impl->depot_count >= MEM_POOL_DEPOT_SIZE)
+        return 0;
 
-    MppMemPoolService::getInstance()->put_pool(impl);
+    pos = impl->depot_pos;
+    for (i = 0; i < MEM_POOL_DEPOT_SIZE; i++) {
+        MppMemPoolNode **slot = &impl->depot[(pos + i) % MEM_POOL_DEPOT_SIZE];
+
+        if (*slot)
+            continue;
+
+        if (MPP_BOOL_CAS(slot, NULL, node)) {
+            MPP_FETCH_ADD(&impl->depot_count, 1);
+            impl->depot_pos = pos + i;
+            return 1;
+        }
+    }
+
+    return 0;
 }
 
-void *mpp_mem_pool_get_f(const char *caller, MppMemPool pool)
+static MppMemPoolNode *pool_get_node(MppMemPoolImpl *impl)
 {
-    MppMemPoolImpl *impl = (MppMemPoolImpl *)pool;
     MppMemPoolNode *node = NULL;
-    void* ptr = NULL;
 
     pthread_mutex_lock(&impl->lock);
 
-    mem_pool_dbg_flow("pool %d get used:unused [%d:%d] from %s", impl->size,
-                      impl->used_count, impl->unused_count, caller);
-
     if (!list_empty(&impl->unused)) {
-        node = list_first_entry(&impl->unused, MppMemPoolNode, list);
-        if (node) {
-            list_del_init(&node->list);
-            list_add_tail(&node->list, &impl->used);
-            impl->unused_count--;
-            impl->used_count++;
-            ptr = node->ptr;
-            node->check = node;
-            goto DONE;
-        }
+        node = list_first_entry(&impl->unused, MppMemPoolNode, unused);
+        list_del_init(&node->unused);
+        impl->unused_count--;
+        goto DONE;
     }
 
     node = mpp_malloc_size(MppMemPoolNode, sizeof(MppMemPoolNode) + impl->size);
@@ -216,25 +390,66 @@ void *mpp_mem_pool_get_f(const char *caller, MppMemPool pool)
         goto DONE;
     }
 
-    node->check = node;
     node->ptr = (void *)(node + 1);
     node->size = impl->size;
     INIT_LIST_HEAD(&node->list);
-    list_add_tail(&node->list, &impl->used);
-    impl->used_count++;
-    ptr = node->ptr;
+    INIT_LIST_HEAD(&node->unused);
+    list_add_tail(&node->list, &impl->all);
+    impl->node_count++;
 
 DONE:
     pthread_mutex_unlock(&impl->lock);
-    if (node)
-        memset(node->ptr, 0 , node->size);
-    return ptr;
+    return node;
+}
+
+MppMemPool mpp_mem_pool_init_f(const char *caller, size_t size)
+{
+    mem_pool_dbg_flow("pool %d init from %s", size, caller);
+
+    return (MppMemPool)MppMemPoolService::getInstance()->get_pool(size);
+}
+
+void mpp_mem_pool_deinit_f(const char *caller, MppMemPool pool)
+{
+    MppMemPoolImpl *impl = (MppMemPoolImpl *)pool;
+
+    mem_pool_dbg_flow("pool %d deinit from %s", impl->size, caller);
+
+    MppMemPoolService::getInstance()->put_pool(impl);
+}
+
+void *mpp_mem_pool_get_f(const char *caller, MppMemPool pool)
+{
+    MppMemPoolImpl *impl = (MppMemPoolImpl *)pool;
+    MppMemPoolCache *cache = pool_get_cache(impl);
+    MppMemPoolNode *node = NULL;
+
+    mem_pool_dbg_flow("pool %d get cache:depot [%d:%d] from %s", impl->size,
+                      cache->count, impl->depot_count, caller);
+
+    if (cache->count)
+        node = cache->nodes[--cache->count];
+
+    if (!node)
+        node = depot_get(impl);
+
+    if (!node)
+        node = pool_get_node(impl);
+
+    if (!node)
+        return NULL;
+
+    node->check = node;
+    memset(node->ptr, 0, node->size);
+
+    return node->ptr;
 }
 
 void mpp_mem_pool_put_f(const char *caller, MppMemPool pool, void *p)
 {
     MppMemPoolImpl *impl = (MppMemPoolImpl *)pool;
     MppMemPoolNode *node = (MppMemPoolNode *)((RK_U8 *)p - sizeof(MppMemPoolNode));
+    MppMemPoolCache *cache;
 
     if (impl != impl->check) {
         mpp_err_f("invalid mem pool %p check %p\n", impl, impl->check);
@@ -247,16 +462,28 @@ void mpp_mem_pool_put_f(const char *caller, MppMemPool pool, void *p)
         return ;
     }
 
-    pthread_mutex_lock(&impl->lock);
+    cache = pool_get_cache(impl);
 
-    mem_pool_dbg_flow("pool %d put used:unused [%d:%d] from %s", impl->size,
-                      impl->used_count, impl->unused_count, caller);
+    mem_pool_dbg_flow("pool %d put cache:depot [%d:%d] from %s", impl->size,
+                      cache->count, impl->depot_count, caller);
 
-    list_del_init(&node->list);
-    list_add(&node->list, &impl->unused);
-    impl->used_count--;
-    impl->unused_count++;
     node->check = NULL;
 
-    pthread_mutex_unlock(&impl->lock);
+    /* on full cache move half of it to depot to keep cross thread flow */
+    if (cache->count >= MEM_POOL_CACHE_SIZE) {
+        RK_S32 keep = MEM_POOL_CACHE_SIZE / 2;
+        RK_S32 i;
+
+        for (i = keep; i < cache->count; i++) {
+            if (!depot_put(impl, cache->nodes[i]))
+                break;
+        }
+
+        if (i < cache->count)
+            pool_put_unused(impl, &cache->nodes[i], cache->count - i);
+
+        cache->count = keep;
+    }
+
+    cache->nodes[cache->count++] = node;
 }
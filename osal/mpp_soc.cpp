@@ -21,6 +21,7 @@
 #include <fcntl.h>
 #include <string.h>
 
+#include "mpp_env.h"
 #include "mpp_debug.h"
 #include "mpp_common.h"
 
@@ -969,8 +970,18 @@ static const MppSocInfo mpp_soc_default = {
 static void read_soc_name(char *name, RK_S32 size)
 {
     const char *path = "/proc/device-tree/compatible";
-    RK_S32 fd = open(path, O_RDONLY);
+    const char *env_name = NULL;
+    RK_S32 fd;
+
+    /* soc name override for running with simulated device */
+    mpp_env_get_str("mpp_soc_name", &env_name, NULL);
+    if (env_name && env_name[0]) {
+        snprintf(name, size - 1, "%s", env_name);
+        mpp_dbg_platform("chip name from env: %s\n", name);
+        return;
+    }
 
+    fd = open(path, O_RDONLY);
     if (fd < 0) {
         mpp_err("open %s error\n", path);
     } else {
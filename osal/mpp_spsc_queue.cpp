@@ -0,0 +1,274 @@
+/* SPDX-License-Identifier: Apache-2.0 OR MIT */
+/*
+ * Copyright (c) 2024 Rockchip Electronics Co., Ltd.
+ */
+
+#define MODULE_TAG "mpp_spsc_queue"
+
+#include <errno.h>
+#include <time.h>
+#include <pthread.h>
+
+#include "mpp_mem.h"
+#include "mpp_lock.h"
+#include "mpp_time.h"
+#include "mpp_debug.h"
+#include "mpp_common.h"
+
+#include "mpp_spsc_queue.h"
+
+/*
+ * Producer only writes tail and consumers only advance head. Both index are
+ * placed on their own cache line so the two sides do not bounce the same
+ * line on each operation. Push and pop take no lock. The mutex and the
+ * condition are only used when one side has to sleep on empty or full ring
+ * and the other side only takes the mutex when it sees a sleeper.
+ */
+#define SPSC_CACHE_LINE         64
+#define SPSC_ALIGNED            __attribute__((aligned(SPSC_CACHE_LINE)))
+#define SPSC_DEFAULT_SIZE       64
+
+typedef struct MppSpscQueueImpl_t {
+    void                **ring;
+    RK_U32              mask;
+    MppSpscQueueFree    release;
+
+    /* sleep path for empty and full ring */
+    pthread_mutex_t     lock;
+    pthread_cond_t      not_empty;
+    pthread_cond_t      not_full;
+
+    /* producer side */
+    SPSC_ALIGNED
+    volatile RK_U32     tail;
+    volatile RK_S32     prod_waiting;
+
+    /* consumer side */
+    SPSC_ALIGNED
+    volatile RK_U32     head;
+    volatile RK_S32     cons_waiting;
+} MppSpscQueueImpl;
+
+typedef RK_U32 (*SpscReady)(MppSpscQueueImpl *p);
+
+static RK_U32 spsc_not_empty(MppSpscQueueImpl *p)
+{
+    return p->tail != p->head;
+}
+
+static RK_U32 spsc_not_full(MppSpscQueueImpl *p)
+{
+    return p->tail - p->head <= p->mask;
+}
+
+/*
+ * Sleep until ready or timeout. The waiting count is raised before ready is
+ * checked again and the other side reads the count after its update, so
+ * either the waiter sees the update or the other side sees the waiter.
+ * timeout - negative for block wait, zero for no wait, positive in ms
+ */
+static MPP_RET spsc_wait(MppSpscQueueImpl *p, SpscReady ready, pthread_cond_t *cond,
+                         volatile RK_S32 *waiting, RK_S64 timeout)
+{
+    MPP_RET ret = MPP_OK;
+    struct timespec ts;
+
+    if (ready(p))
+        return MPP_OK;
+
+    if (!timeout)
+        return MPP_ERR_TIMEOUT;
+
+    if (timeout > 0) {
+        clock_gettime(CLOCK_REALTIME, &ts);
+        ts.tv_sec += timeout / 1000;
+        ts.tv_nsec += (timeout % 1000) * 1000000;
+        ts.tv_sec += ts.tv_nsec / 1000000000;
+        ts.tv_nsec %= 1000000000;
+    }
+
+    pthread_mutex_lock(&p->lock);
+    MPP_FETCH_ADD(waiting, 1);
+    MPP_SYNC();
+
+    while (!ready(p)) {
+        if (timeout < 0) {
+            pthread_cond_wait(cond, &p->lock);
+        } else if (ETIMEDOUT == pthread_cond_timedwait(cond, &p->lock, &ts)) {
+            ret = ready(p) ? MPP_OK : MPP_ERR_TIMEOUT;
+            break;
+        }
+    }
+
+    MPP_FETCH_SUB(waiting, 1);
+    pthread_mutex_unlock(&p->lock);
+
+    return ret;
+}
+
+/* wake all sleepers on the other side as each of them rechecks the ring */
+static void spsc_wake(MppSpscQueueImpl *p, pthread_cond_t *cond, volatile RK_S32 *waiting)
+{
+    MPP_SYNC();
+    if (!*waiting)
+        return;
+
+    pthread_mutex_lock(&p->lock);
+    pthread_cond_broadcast(cond);
+    pthread_mutex_unlock(&p->lock);
+}
+
+MPP_RET mpp_spsc_queue_init(MppSpscQueue *queue, RK_U32 size, MppSpscQueueFree release)
+{
+    MppSpscQueueImpl *p = NULL;
+    RK_U32 count = SPSC_DEFAULT_SIZE;
+
+    if (NULL == queue) {
+        mpp_err_f("invalid NULL input\n");
+        return MPP_ERR_NULL_PTR;
+    }
+
+    *queue = NULL;
+
+    if (size) {
+        count = 1;
+        while (count < size)
+            count <<= 1;
+    }
+
+    p = mpp_calloc(MppSpscQueueImpl, 1);
+    if (p)
+        p->ring = mpp_calloc(void *, count);
+
+    if (NULL == p || NULL == p->ring) {
+        mpp_err_f("failed to malloc queue size %d\n", count);
+        if (p)
+            MPP_FREE(p->ring);
+        MPP_FREE(p);
+        return MPP_ERR_MALLOC;
+    }
+
+    p->mask = count - 1;
+    p->release = release;
+    pthread_mutex_init(&p->lock, NULL);
+    pthread_cond_init(&p->not_empty, NULL);
+    pthread_cond_init(&p->not_full, NULL);
+
+    *queue = p;
+
+    return MPP_OK;
+}
+
+MPP_RET mpp_spsc_queue_deinit(MppSpscQueue queue)
+{
+    MppSpscQueueImpl *p = (MppSpscQueueImpl *)queue;
+
+    if (NULL == p)
+        return MPP_ERR_NULL_PTR;
+
+    mpp_spsc_queue_flush(p);
+
+    pthread_cond_destroy(&p->not_empty);
+    pthread_cond_destroy(&p->not_full);
+    pthread_mutex_destroy(&p->lock);
+    MPP_FREE(p->ring);
+    MPP_FREE(p);
+
+    return MPP_OK;
+}
+
+MPP_RET mpp_spsc_queue_push(MppSpscQueue queue, void *data)
+{
+    MppSpscQueueImpl *p = (MppSpscQueueImpl *)queue;
+    RK_U32 tail;
+
+    if (NULL == p)
+        return MPP_ERR_NULL_PTR;
+
+    /* backpressure: producer sleeps until consumer frees a slot */
+    spsc_wait(p, spsc_not_full, &p->not_full, &p->prod_waiting, -1);
+
+    tail = p->tail;
+    p->ring[tail & p->mask] = data;
+    /* slot must be visible before the new tail */
+    MPP_SYNC();
+    p->tail = tail + 1;
+
+    spsc_wake(p, &p->not_empty, &p->cons_waiting);
+
+    return MPP_OK;
+}
+
+/*
+ * Consumers claim the head slot by cas so pop from get thread and flush from
+ * reset thread can race. The producer never writes the head slot before the
+ * head moves, so the data read before a successful cas is valid.
+ */
+MPP_RET mpp_spsc_queue_pop(MppSpscQueue queue, void **data)
+{
+    MppSpscQueueImpl *p = (MppSpscQueueImpl *)queue;
+    void *val;
+    RK_U32 head;
+
+    if (NULL == p || NULL == data)
+        return MPP_ERR_NULL_PTR;
+
+    *data = NULL;
+
+    do {
+        head = p->head;
+        if (head == p->tail)
+            return MPP_NOK;
+
+        /* read slot after tail */
+        MPP_SYNC();
+        val = p->ring[head & p->mask];
+    } while (!MPP_BOOL_CAS(&p->head, head, head + 1));
+
+    *data = val;
+
+    spsc_wake(p, &p->not_full, &p->prod_waiting);
+
+    return MPP_OK;
+}
+
+MPP_RET mpp_spsc_queue_wait(MppSpscQueue queue, RK_S64 timeout)
+{
+    MppSpscQueueImpl *p = (MppSpscQueueImpl *)queue;
+
+    if (NULL == p)
+        return MPP_ERR_NULL_PTR;
+
+    return spsc_wait(p, spsc_not_empty, &p->not_empty, &p->cons_waiting, timeout);
+}
+
+RK_S32 mpp_spsc_queue_size(MppSpscQueue queue)
+{
+    MppSpscQueueImpl *p = (MppSpscQueueImpl *)queue;
+    RK_U32 head;
+
+    if (NULL == p)
+        return 0;
+
+    /* read head first so that the later tail is never behind it */
+    head = p->head;
+    MPP_SYNC();
+
+    return (RK_S32)(p->tail - head);
+}
+
+MPP_RET mpp_spsc_queue_flush(MppSpscQueue queue)
+{
+    MppSpscQueueImpl *p = (MppSpscQueueImpl *)queue;
+    void *data = NULL;
+
+    if (NULL == p)
+        return MPP_ERR_NULL_PTR;
+
+    while (!mpp_spsc_queue_pop(p, &data)) {
+        if (p->release)
+            p->release(data);
+    }
+
+    return MPP_OK;
+}
@@ -16,15 +16,19 @@
 
 #define MODULE_TAG "mpp_thread"
 
+#include <sched.h>
 #include <string.h>
 
+#include "mpp_env.h"
 #include "mpp_log.h"
 #include "mpp_mem.h"
 #include "mpp_lock.h"
+#include "mpp_time.h"
 #include "mpp_common.h"
 #include "mpp_thread.h"
 
 #define MPP_THREAD_DBG_FUNCTION     (0x00000001)
+#define MPP_THREAD_DBG_STATS        (0x00000002)
 
 static RK_U32 thread_debug = 0;
 
@@ -39,6 +43,13 @@ MppThread::MppThread(MppThreadFunc func, void *ctx, const char *name)
     mStatus[THREAD_OUTPUT]  = MPP_THREAD_RUNNING;
     mStatus[THREAD_CONTROL] = MPP_THREAD_RUNNING;
 
+    memset((void *)mEvent, 0, sizeof(mEvent));
+    memset(mEventMask, 0, sizeof(mEventMask));
+    memset(mStats, 0, sizeof(mStats));
+
+    mpp_env_get_u32("mpp_thread_debug", &thread_debug, 0);
+    mpp_env_get_u32("mpp_thread_spin_us", &mSpinUs, 0);
+
     if (name)
         strncpy(mName, name, sizeof(mName) - 1);
     else
@@ -62,6 +73,83 @@ void MppThread::dump_status()
             mStatus[THREAD_CONTROL]);
 }
 
+void MppThread::wait_event(RK_U32 mask, MppThreadSignal id)
+{
+    mpp_assert(id < THREAD_SIGNAL_BUTT);
+    MppThreadStatus status = mStatus[id];
+    MppThreadStats *stats = &mStats[id];
+
+    if (mEvent[id] & mask)
+        return;
+
+    /*
+     * Short spin without lock for the event which comes soon, such as the
+     * next task from a fast hardware. It saves a sleep and wakeup pair of
+     * context switch when there are spare cores.
+     */
+    if (mSpinUs) {
+        RK_S64 end = mpp_time() + mSpinUs;
+
+        mMutexCond[id].unlock();
+        while (!(mEvent[id] & mask) && mStatus[id] == status && mpp_time() < end)
+            sched_yield();
+        mMutexCond[id].lock();
+
+        if ((mEvent[id] & mask) || mStatus[id] != status) {
+            stats->spin++;
+            return;
+        }
+    }
+
+    mEventMask[id] = mask;
+    stats->wait++;
+
+    wait(id);
+
+    mEventMask[id] = 0;
+    stats->wakeup++;
+
+    /* stop and status change are not spurious */
+    if (!(mEvent[id] & mask) && mStatus[id] == status)
+        stats->spurious++;
+}
+
+void MppThread::notify_event(RK_U32 event, MppThreadSignal id)
+{
+    mpp_assert(id < THREAD_SIGNAL_BUTT);
+    MppThreadStats *stats = &mStats[id];
+
+    mEvent[id] |= event;
+
+    if (mStatus[id] == MPP_THREAD_WAITING && (mEventMask[id] & event)) {
+        /* one signal is enough until the waiter runs again */
+        mEventMask[id] = 0;
+        stats->signal++;
+        mMutexCond[id].signal();
+    } else {
+        stats->skip++;
+    }
+}
+
+void MppThread::get_stats(MppThreadStats *stats, MppThreadSignal id)
+{
+    mpp_assert(id < THREAD_SIGNAL_BUTT);
+
+    if (stats)
+        *stats = mStats[id];
+}
+
+void MppThread::dump_stats(MppThreadSignal id)
+{
+    mpp_assert(id < THREAD_SIGNAL_BUTT);
+    MppThreadStats *stats = &mStats[id];
+
+    mpp_log("thread %s wait %u wakeup %u spurious %u (%.1f%%) spin %u signal %u skip %u\n",
+            mName, stats->wait, stats->wakeup, stats->spurious,
+            stats->wakeup ? stats->spurious * 100.0 / stats->wakeup : 0.0,
+            stats->spin, stats->signal, stats->skip);
+}
+
 void MppThread::start()
 {
     pthread_attr_t attr;
@@ -102,6 +190,9 @@ void MppThread::stop()
                    mName, mFunction, mContext);
 
         set_status(MPP_THREAD_UNINITED);
+
+        if (thread_debug & MPP_THREAD_DBG_STATS)
+            dump_stats();
     }
 }
 
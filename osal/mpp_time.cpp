@@ -19,6 +19,7 @@
 #include <errno.h>
 #include <string.h>
 #include <sys/timerfd.h>
+#include <sys/eventfd.h>
 #include <sys/epoll.h>
 
 #include "mpp_mem.h"
@@ -208,6 +209,8 @@ typedef struct MppTimerImpl_t {
     RK_S32              initial;
     RK_S32              interval;
     RK_S32              timer_fd;
+    /* eventfd for running callback at once */
+    RK_S32              wake_fd;
     RK_S32              epoll_fd;
 
     MppThread           *thd;
@@ -234,6 +237,7 @@ static void *mpp_timer_thread(void *ctx)
     MppTimerImpl *impl = (MppTimerImpl *)ctx;
     MppThread *thd = impl->thd;
     RK_S32 timer_fd = impl->timer_fd;
+    RK_S32 wake_fd = impl->wake_fd;
 
     // first expire time
     ts.it_value.tv_sec = impl->initial / 1000;
@@ -259,10 +263,11 @@ static void *mpp_timer_thread(void *ctx)
 
         /* wait epoll event */
         RK_S32 fd_cnt = epoll_wait(impl->epoll_fd, &events, 1, 500);
-        if (fd_cnt && (events.events & EPOLLIN) && (events.data.fd == timer_fd)) {
+        if (fd_cnt && (events.events & EPOLLIN) &&
+            (events.data.fd == timer_fd || events.data.fd == wake_fd)) {
             RK_U64 exp = 0;
 
-            ssize_t cnt = read(timer_fd, &exp, sizeof(exp));
+            ssize_t cnt = read(events.data.fd, &exp, sizeof(exp));
             mpp_assert(cnt == sizeof(exp));
             impl->func(impl->ctx);
         }
@@ -274,6 +279,7 @@ static void *mpp_timer_thread(void *ctx)
 MppTimer mpp_timer_get(const char *name)
 {
     RK_S32 timer_fd = -1;
+    RK_S32 wake_fd = -1;
     RK_S32 epoll_fd = -1;
     MppTimerImpl *impl = NULL;
 
@@ -290,6 +296,10 @@ MppTimer mpp_timer_get(const char *name)
         if (timer_fd < 0)
             break;
 
+        wake_fd = eventfd(0, 0);
+        if (wake_fd < 0)
+            break;
+
         epoll_fd = epoll_create(1);
         if (epoll_fd < 0)
             break;
@@ -301,7 +311,12 @@ MppTimer mpp_timer_get(const char *name)
         if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, timer_fd, &event) < 0)
             break;
 
+        event.data.fd = wake_fd;
+        if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, wake_fd, &event) < 0)
+            break;
+
         impl->timer_fd = timer_fd;
+        impl->wake_fd = wake_fd;
         impl->epoll_fd = epoll_fd;
         /* default 1 second (1000ms) looper */
         impl->initial  = 1000;
@@ -324,6 +339,11 @@ MppTimer mpp_timer_get(const char *name)
         timer_fd = -1;
     }
 
+    if (wake_fd >= 0) {
+        close(wake_fd);
+        wake_fd = -1;
+    }
+
     if (epoll_fd >= 0) {
         close(epoll_fd);
         epoll_fd = -1;
@@ -393,6 +413,20 @@ void mpp_timer_set_enable(MppTimer timer, RK_S32 enable)
     }
 }
 
+void mpp_timer_trigger(MppTimer timer)
+{
+    if (NULL == timer || check_is_mpp_timer(timer)) {
+        mpp_err_f("invalid timer %p\n", timer);
+        return ;
+    }
+
+    MppTimerImpl *impl = (MppTimerImpl *)timer;
+    RK_U64 val = 1;
+
+    if (sizeof(val) != write(impl->wake_fd, &val, sizeof(val)))
+        mpp_err_f("failed to wake timer %s\n", impl->name);
+}
+
 void mpp_timer_put(MppTimer timer)
 {
     if (NULL == timer || check_is_mpp_timer(timer)) {
@@ -410,6 +444,11 @@ void mpp_timer_put(MppTimer timer)
         impl->timer_fd = -1;
     }
 
+    if (impl->wake_fd >= 0) {
+        close(impl->wake_fd);
+        impl->wake_fd = -1;
+    }
+
     if (impl->epoll_fd >= 0) {
         close(impl->epoll_fd);
         impl->epoll_fd = -1;
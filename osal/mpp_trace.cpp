@@ -17,13 +17,21 @@
 #define MODULE_TAG "mpp_trace"
 
 #include <fcntl.h>
+#include <stdio.h>
 #include <stdarg.h>
 
+#include "mpp_mem.h"
+#include "mpp_debug.h"
 #include "mpp_common.h"
 #include "mpp_trace.h"
 
 #define ATRACE_MESSAGE_LENGTH 256
 
+typedef struct MppTraceJsonImpl_t {
+    FILE    *fp;
+    RK_S32  count;
+} MppTraceJsonImpl;
+
 class MppTraceService
 {
 private:
@@ -168,3 +176,63 @@ void mpp_trace_int64(const char* name, RK_S64 value)
 {
     MppTraceService::get_inst()->trace_int64(name, value);
 }
+
+MPP_RET mpp_trace_json_open(MppTraceJson *ctx, const char *path)
+{
+    MppTraceJsonImpl *p = NULL;
+    FILE *fp = NULL;
+
+    if (NULL == ctx || NULL == path) {
+        mpp_err_f("invalid input ctx %p path %p\n", ctx, path);
+        return MPP_ERR_NULL_PTR;
+    }
+
+    *ctx = NULL;
+
+    fp = fopen(path, "w");
+    if (NULL == fp) {
+        mpp_err_f("failed to open %s\n", path);
+        return MPP_ERR_OPEN_FILE;
+    }
+
+    p = mpp_calloc(MppTraceJsonImpl, 1);
+    if (NULL == p) {
+        mpp_err_f("failed to malloc context\n");
+        fclose(fp);
+        return MPP_ERR_MALLOC;
+    }
+
+    fprintf(fp, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    p->fp = fp;
+    *ctx = p;
+
+    return MPP_OK;
+}
+
+MPP_RET mpp_trace_json_close(MppTraceJson ctx)
+{
+    MppTraceJsonImpl *p = (MppTraceJsonImpl *)ctx;
+
+    if (NULL == p)
+        return MPP_ERR_NULL_PTR;
+
+    fprintf(p->fp, "\n]}\n");
+    fclose(p->fp);
+    mpp_free(p);
+
+    return MPP_OK;
+}
+
+void mpp_trace_json_event(MppTraceJson ctx, const char *name, RK_S32 pid,
+                          RK_S32 tid, RK_S64 start, RK_S64 dur)
+{
+    MppTraceJsonImpl *p = (MppTraceJsonImpl *)ctx;
+
+    if (NULL == p)
+        return;
+
+    fprintf(p->fp, "%s{\"name\":\"%s\",\"ph\":\"X\",\"pid\":%d,\"tid\":%d,"
+            "\"ts\":%lld,\"dur\":%lld}", p->count ? ",\n" : "",
+            name, pid, tid, start, dur);
+    p->count++;
+}
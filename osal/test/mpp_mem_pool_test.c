@@ -17,13 +17,159 @@
 #define MODULE_TAG "mpp_mem_pool_test"
 
 #include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
 
 #include "mpp_log.h"
+#include "mpp_time.h"
 #include "mpp_mem_pool.h"
 
 #define MPP_MEM_POOL_TEST_SIZE      1024
 #define MPP_MEM_POOL_TEST_COUNT     20
 
+#define MPP_MEM_POOL_MT_THREADS     4
+#define MPP_MEM_POOL_MT_LOOPS       200000
+#define MPP_MEM_POOL_MT_BATCH       8
+/* pools used by one thread like packet / frame / buffer and codec pools */
+#define MPP_MEM_POOL_MULTI_POOLS    12
+#define MPP_MEM_POOL_MULTI_LOOPS    100000
+
+typedef struct MemPoolMtCtx_t {
+    MppMemPool      pool;
+    RK_S32          id;
+    RK_S32          loops;
+    void            **pass;
+    RK_S32          pass_count;
+    RK_S32          error;
+} MemPoolMtCtx;
+
+static void *mem_pool_mt_worker(void *arg)
+{
+    MemPoolMtCtx *ctx = (MemPoolMtCtx *)arg;
+    RK_U8 *p[MPP_MEM_POOL_MT_BATCH];
+    RK_S32 i, j;
+
+    /* release the buffers got by other thread to check cross thread put */
+    for (i = 0; i < ctx->pass_count; i++)
+        mpp_mem_pool_put(ctx->pool, ctx->pass[i]);
+
+    for (i = 0; i < ctx->loops; i++) {
+        for (j = 0; j < MPP_MEM_POOL_MT_BATCH; j++) {
+            p[j] = (RK_U8 *)mpp_mem_pool_get(ctx->pool);
+            if (!p[j] || p[j][0] || p[j][MPP_MEM_POOL_TEST_SIZE - 1]) {
+                ctx->error = 1;
+                return NULL;
+            }
+            p[j][0] = (RK_U8)(ctx->id + 1);
+            p[j][MPP_MEM_POOL_TEST_SIZE - 1] = (RK_U8)(ctx->id + 1);
+        }
+
+        for (j = 0; j < MPP_MEM_POOL_MT_BATCH; j++) {
+            if (p[j][0] != ctx->id + 1) {
+                ctx->error = 1;
+                return NULL;
+            }
+            mpp_mem_pool_put(ctx->pool, p[j]);
+        }
+    }
+
+    return NULL;
+}
+
+static MPP_RET mem_pool_mt_test(RK_S32 thread_count)
+{
+    MemPoolMtCtx ctx[MPP_MEM_POOL_MT_THREADS];
+    pthread_t thd[MPP_MEM_POOL_MT_THREADS];
+    void *pass[MPP_MEM_POOL_MT_THREADS][MPP_MEM_POOL_TEST_COUNT];
+    MppMemPool pool = mpp_mem_pool_init(MPP_MEM_POOL_TEST_SIZE);
+    MPP_RET ret = MPP_OK;
+    RK_S64 start, end;
+    RK_S64 ops;
+    RK_S32 i, j;
+
+    if (!pool)
+        return MPP_NOK;
+
+    memset(ctx, 0, sizeof(ctx));
+
+    for (i = 0; i < thread_count; i++) {
+        for (j = 0; j < MPP_MEM_POOL_TEST_COUNT; j++)
+            pass[i][j] = mpp_mem_pool_get(pool);
+
+        ctx[i].pool = pool;
+        ctx[i].id = i;
+        ctx[i].loops = MPP_MEM_POOL_MT_LOOPS / thread_count;
+        ctx[i].pass = pass[i];
+        ctx[i].pass_count = MPP_MEM_POOL_TEST_COUNT;
+    }
+
+    start = mpp_time();
+
+    for (i = 0; i < thread_count; i++)
+        pthread_create(&thd[i], NULL, mem_pool_mt_worker, &ctx[i]);
+
+    for (i = 0; i < thread_count; i++) {
+        pthread_join(thd[i], NULL);
+        if (ctx[i].error)
+            ret = MPP_NOK;
+    }
+
+    end = mpp_time();
+
+    ops = (RK_S64)(MPP_MEM_POOL_MT_LOOPS / thread_count) * thread_count *
+          MPP_MEM_POOL_MT_BATCH * 2;
+    mpp_log("mpp_mem_pool_test %d threads %lld get/put in %lld us %.2f Mops/s\n",
+            thread_count, ops, end - start,
+            (end > start) ? (double)ops / (end - start) : 0.0);
+
+    mpp_mem_pool_deinit(pool);
+
+    return ret;
+}
+
+/* interleaved access to many pools should not evict the thread cache */
+static MPP_RET mem_pool_multi_test(void)
+{
+    MppMemPool pools[MPP_MEM_POOL_MULTI_POOLS];
+    MPP_RET ret = MPP_OK;
+    RK_S64 start, end;
+    RK_S64 ops;
+    RK_S32 i, j;
+
+    for (i = 0; i < MPP_MEM_POOL_MULTI_POOLS; i++) {
+        pools[i] = mpp_mem_pool_init(64 + i * 64);
+        if (!pools[i])
+            return MPP_NOK;
+    }
+
+    start = mpp_time();
+
+    for (i = 0; i < MPP_MEM_POOL_MULTI_LOOPS && !ret; i++) {
+        for (j = 0; j < MPP_MEM_POOL_MULTI_POOLS; j++) {
+            RK_U8 *p = (RK_U8 *)mpp_mem_pool_get(pools[j]);
+
+            if (!p || p[0]) {
+                ret = MPP_NOK;
+                break;
+            }
+            p[0] = 1;
+            mpp_mem_pool_put(pools[j], p);
+        }
+    }
+
+    end = mpp_time();
+
+    ops = (RK_S64)MPP_MEM_POOL_MULTI_LOOPS * MPP_MEM_POOL_MULTI_POOLS * 2;
+    mpp_log("mpp_mem_pool_test %d pools %lld get/put in %lld us %.2f Mops/s\n",
+            MPP_MEM_POOL_MULTI_POOLS, ops, end - start,
+            (end > start) ? (double)ops / (end - start) : 0.0);
+
+    for (i = 0; i < MPP_MEM_POOL_MULTI_POOLS; i++)
+        mpp_mem_pool_deinit(pools[i]);
+
+    return ret;
+}
+
 int main()
 {
     MppMemPool pool = NULL;
@@ -69,6 +215,21 @@ int main()
         }
     }
 
+    mpp_mem_pool_deinit(pool);
+    pool = NULL;
+
+    for (i = 1; i <= MPP_MEM_POOL_MT_THREADS; i *= 2) {
+        if (mem_pool_mt_test(i)) {
+            mpp_err("mpp_mem_pool_test multi-thread %d failed\n", i);
+            goto mpp_mem_pool_test_failed;
+        }
+    }
+
+    if (mem_pool_multi_test()) {
+        mpp_err("mpp_mem_pool_test multi-pool failed\n");
+        goto mpp_mem_pool_test_failed;
+    }
+
     mpp_log("mpp_mem_pool_test success\n");
     return MPP_OK;
 
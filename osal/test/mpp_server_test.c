@@ -0,0 +1,211 @@
+/* SPDX-License-Identifier: Apache-2.0 OR MIT */
+/*
+ * Copyright (c) 2024 Rockchip Electronics Co., Ltd.
+ */
+
+#define MODULE_TAG "mpp_server_test"
+
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "mpp_log.h"
+#include "mpp_time.h"
+#include "mpp_common.h"
+
+#include "mpp_server.h"
+#include "mpp_service_impl.h"
+
+/*
+ * Batch scheduler test on simulated device backend.
+ *
+ * Several sessions send task and wait for finish concurrently. The first
+ * session is latency sensitive with positive priority. Under this load all
+ * tasks should be finished, the batch size should grow, the priority session
+ * should wait less than the others and sessions with the same priority should
+ * wait about the same time. Then one session sends task slowly and the batch
+ * size should shrink back to one on timer timeout.
+ */
+#define SESSION_CNT         8
+#define TASK_PER_SESSION    200
+#define LIGHT_TASK_CNT      20
+
+typedef struct ServerTestCtx_t {
+    MppDevMppService    dev;
+    RK_S32              idx;
+    RK_S64              wait_sum;
+    RK_S64              wait_max;
+    RK_S32              done;
+} ServerTestCtx;
+
+static RK_S32 server_test_run(ServerTestCtx *ctx, RK_S32 count, RK_S32 gap_ms)
+{
+    RK_S32 i;
+
+    for (i = 0; i < count; i++) {
+        RK_S64 start = mpp_time();
+        RK_S64 wait;
+
+        if (mpp_server_send_task(&ctx->dev))
+            break;
+        if (mpp_server_wait_task(&ctx->dev, -1))
+            break;
+
+        wait = mpp_time() - start;
+        ctx->wait_sum += wait;
+        if (wait > ctx->wait_max)
+            ctx->wait_max = wait;
+
+        ctx->done++;
+        if (gap_ms)
+            msleep(gap_ms);
+    }
+
+    return ctx->done;
+}
+
+static void *server_test_thread(void *arg)
+{
+    server_test_run((ServerTestCtx *)arg, TASK_PER_SESSION, 0);
+
+    return NULL;
+}
+
+static void server_test_show(MppServerStats *stats)
+{
+    mpp_log("batch %lld task %lld fill %.2f of max %d\n", stats->batch_count,
+            stats->task_count, stats->batch_count ?
+            (float)stats->task_count / stats->batch_count : 0, stats->batch_max);
+    mpp_log("send full %lld urgent %lld timeout %lld size %d grow %lld shrink %lld\n",
+            stats->send_full, stats->send_urgent, stats->send_timeout,
+            stats->batch_size, stats->size_grow, stats->size_shrink);
+    mpp_log("queue wait avg %lld max %lld us\n",
+            stats->task_count ? stats->wait_sum / stats->task_count : 0, stats->wait_max);
+}
+
+int main()
+{
+    ServerTestCtx ctxs[SESSION_CNT];
+    pthread_t thds[SESSION_CNT];
+    MppServerStats stats;
+    MppServerStats light;
+    RK_S64 time_start;
+    RK_S64 time_end;
+    RK_S64 wait_min = 0;
+    RK_S64 wait_max = 0;
+    RK_S64 prio_wait = 0;
+    RK_S32 total = 0;
+    RK_S32 ret = 0;
+    RK_S32 i;
+
+    mpp_log("mpp server test start\n");
+
+    /* use simulated device with 200us task latency */
+    setenv("mpp_null_dev", "1", 0);
+    setenv("mpp_null_dev_latency", "200", 0);
+    setenv("mpp_server_batch_timeout", "1", 0);
+
+    memset(ctxs, 0, sizeof(ctxs));
+
+    for (i = 0; i < SESSION_CNT; i++) {
+        ServerTestCtx *ctx = &ctxs[i];
+
+        ctx->idx = i;
+        ctx->dev.client_type = VPU_CLIENT_RKVDEC;
+        /* fake client fd for session identification */
+        ctx->dev.client = i + 1;
+        ctx->dev.server = ctx->dev.client;
+        ctx->dev.batch_prio = (i == 0) ? 1 : 0;
+
+        if (mpp_server_attach(&ctx->dev) || !ctx->dev.batch_io) {
+            mpp_err("session %d attach failed\n", i);
+            ret = -1;
+            goto DONE;
+        }
+    }
+
+    time_start = mpp_time();
+
+    for (i = 0; i < SESSION_CNT; i++)
+        pthread_create(&thds[i], NULL, server_test_thread, &ctxs[i]);
+
+    for (i = 0; i < SESSION_CNT; i++)
+        pthread_join(thds[i], NULL);
+
+    time_end = mpp_time();
+
+    for (i = 0; i < SESSION_CNT; i++) {
+        ServerTestCtx *ctx = &ctxs[i];
+
+        RK_S64 avg = ctx->done ? ctx->wait_sum / ctx->done : 0;
+
+        mpp_log("session %d prio %d done %d wait avg %lld max %lld us\n",
+                i, ctx->dev.batch_prio, ctx->done, avg, ctx->wait_max);
+        total += ctx->done;
+
+        if (ctx->dev.batch_prio) {
+            prio_wait = avg;
+        } else {
+            if (!wait_min || avg < wait_min)
+                wait_min = avg;
+            if (avg > wait_max)
+                wait_max = avg;
+        }
+    }
+
+    mpp_server_get_stats(VPU_CLIENT_RKVDEC, &stats);
+
+    mpp_log("total %d tasks in %lld ms\n", total, (time_end - time_start) / 1000);
+    server_test_show(&stats);
+
+    if (total != SESSION_CNT * TASK_PER_SESSION || stats.task_count != total) {
+        mpp_err("task count mismatch done %d sent %lld expected %d\n",
+                total, stats.task_count, SESSION_CNT * TASK_PER_SESSION);
+        ret = -1;
+    }
+
+    /* deep pending queue on full batch doubles the batch size */
+    if (!stats.size_grow) {
+        mpp_err("batch size does not grow under load\n");
+        ret = -1;
+    }
+
+    /* priority session flushes the batch and is picked first */
+    if (prio_wait >= wait_min) {
+        mpp_err("priority session wait %lld not less than others %lld\n",
+                prio_wait, wait_min);
+        ret = -1;
+    }
+
+    /* one task per session in each batch round keeps the others even */
+    if (wait_max > wait_min * 2) {
+        mpp_err("unfair session wait min %lld max %lld\n", wait_min, wait_max);
+        ret = -1;
+    }
+
+    /* slow task sending only fills one task before the timer timeout */
+    ctxs[1].done = 0;
+    if (server_test_run(&ctxs[1], LIGHT_TASK_CNT, 5) != LIGHT_TASK_CNT) {
+        mpp_err("light load task failed\n");
+        ret = -1;
+    }
+
+    mpp_server_get_stats(VPU_CLIENT_RKVDEC, &light);
+    server_test_show(&light);
+
+    if (!light.size_shrink || light.batch_size != 1 ||
+        (stats.batch_size > 1 && light.size_shrink <= stats.size_shrink)) {
+        mpp_err("batch size does not shrink on timeout\n");
+        ret = -1;
+    }
+
+DONE:
+    for (i = 0; i < SESSION_CNT; i++) {
+        if (ctxs[i].dev.batch_io)
+            mpp_server_detach(&ctxs[i].dev);
+    }
+
+    mpp_log("mpp server test %s\n", ret ? "failed" : "success");
+
+    return ret;
+}
@@ -0,0 +1,407 @@
+/* SPDX-License-Identifier: Apache-2.0 OR MIT */
+/*
+ * Copyright (c) 2024 Rockchip Electronics Co., Ltd.
+ */
+
+#define MODULE_TAG "mpp_spsc_queue_test"
+
+#include <stdlib.h>
+#include <pthread.h>
+
+#include "mpp_log.h"
+#include "mpp_time.h"
+#include "mpp_common.h"
+#include "mpp_spsc_queue.h"
+
+#define STREAM_COUNT        (1000000)
+#define PING_PONG_COUNT     (20000)
+#define FULL_RING_SIZE      (4)
+#define FULL_PUSH_COUNT     (100)
+#define WAITER_COUNT        (2)
+
+/* mutex and condition list with node malloc as mpp_list for reference */
+typedef struct CondNode_t {
+    struct CondNode_t   *next;
+    void                *data;
+} CondNode;
+
+typedef struct CondQueue_t {
+    pthread_mutex_t     lock;
+    pthread_cond_t      cond;
+    CondNode            *head;
+    CondNode            *tail;
+} CondQueue;
+
+typedef struct PingPong_t {
+    MppSpscQueue        spsc[2];
+    CondQueue           cond[2];
+    RK_S32              use_cond;
+    RK_S32              count;
+} PingPong;
+
+static RK_S32 release_count = 0;
+
+static void cond_queue_init(CondQueue *q)
+{
+    pthread_mutex_init(&q->lock, NULL);
+    pthread_cond_init(&q->cond, NULL);
+    q->head = NULL;
+    q->tail = NULL;
+}
+
+static void cond_queue_deinit(CondQueue *q)
+{
+    pthread_cond_destroy(&q->cond);
+    pthread_mutex_destroy(&q->lock);
+}
+
+static void cond_queue_push(CondQueue *q, void *data)
+{
+    CondNode *node = malloc(sizeof(*node));
+
+    node->next = NULL;
+    node->data = data;
+
+    pthread_mutex_lock(&q->lock);
+    if (q->tail)
+        q->tail->next = node;
+    else
+        q->head = node;
+    q->tail = node;
+    pthread_cond_signal(&q->cond);
+    pthread_mutex_unlock(&q->lock);
+}
+
+static void *cond_queue_pop(CondQueue *q)
+{
+    CondNode *node;
+    void *data;
+
+    pthread_mutex_lock(&q->lock);
+    while (NULL == q->head)
+        pthread_cond_wait(&q->cond, &q->lock);
+
+    node = q->head;
+    q->head = node->next;
+    if (NULL == q->head)
+        q->tail = NULL;
+    pthread_mutex_unlock(&q->lock);
+
+    data = node->data;
+    free(node);
+
+    return data;
+}
+
+static void *spsc_pop_block(MppSpscQueue q)
+{
+    void *data = NULL;
+
+    while (mpp_spsc_queue_pop(q, &data))
+        mpp_spsc_queue_wait(q, -1);
+
+    return data;
+}
+
+static void release_data(void *data)
+{
+    (void)data;
+    release_count++;
+}
+
+static void *stream_producer(void *arg)
+{
+    MppSpscQueue q = (MppSpscQueue)arg;
+    intptr_t i;
+
+    for (i = 1; i <= STREAM_COUNT; i++)
+        mpp_spsc_queue_push(q, (void *)i);
+
+    return NULL;
+}
+
+static void *full_producer(void *arg)
+{
+    MppSpscQueue q = (MppSpscQueue)arg;
+    intptr_t i;
+
+    for (i = 1; i <= FULL_PUSH_COUNT; i++)
+        mpp_spsc_queue_push(q, (void *)i);
+
+    return NULL;
+}
+
+static void *waiter_thread(void *arg)
+{
+    MppSpscQueue q = *(MppSpscQueue *)arg;
+    void *data = NULL;
+
+    while (mpp_spsc_queue_pop(q, &data)) {
+        if (mpp_spsc_queue_wait(q, 1000))
+            break;
+    }
+
+    *(void **)arg = data;
+
+    return NULL;
+}
+
+static void *pong_thread(void *arg)
+{
+    PingPong *pp = (PingPong *)arg;
+    RK_S32 i;
+
+    for (i = 0; i < pp->count; i++) {
+        if (pp->use_cond) {
+            cond_queue_push(&pp->cond[1], cond_queue_pop(&pp->cond[0]));
+        } else {
+            mpp_spsc_queue_push(pp->spsc[1], spsc_pop_block(pp->spsc[0]));
+        }
+    }
+
+    return NULL;
+}
+
+static RK_S64 ping_pong(PingPong *pp)
+{
+    pthread_t td;
+    RK_S64 start;
+    RK_S32 i;
+
+    pthread_create(&td, NULL, pong_thread, pp);
+
+    start = mpp_time();
+    for (i = 0; i < pp->count; i++) {
+        void *data = (void *)(intptr_t)(i + 1);
+
+        if (pp->use_cond) {
+            cond_queue_push(&pp->cond[0], data);
+            data = cond_queue_pop(&pp->cond[1]);
+        } else {
+            mpp_spsc_queue_push(pp->spsc[0], data);
+            data = spsc_pop_block(pp->spsc[1]);
+        }
+        if (data != (void *)(intptr_t)(i + 1))
+            return -1;
+    }
+    start = mpp_time() - start;
+
+    pthread_join(td, NULL);
+
+    return start;
+}
+
+static RK_S32 test_order(void)
+{
+    MppSpscQueue q = NULL;
+    void *data = NULL;
+    intptr_t i;
+
+    mpp_spsc_queue_init(&q, 16, release_data);
+
+    /* fill the ring then push across the ring end */
+    for (i = 1; i <= 16; i++)
+        mpp_spsc_queue_push(q, (void *)i);
+
+    if (mpp_spsc_queue_size(q) != 16)
+        goto FAILED;
+
+    for (i = 1; i <= 10; i++) {
+        if (mpp_spsc_queue_pop(q, &data) || data != (void *)i)
+            goto FAILED;
+    }
+
+    for (i = 17; i <= 26; i++)
+        mpp_spsc_queue_push(q, (void *)i);
+
+    for (i = 11; i <= 26; i++) {
+        if (mpp_spsc_queue_pop(q, &data) || data != (void *)i)
+            goto FAILED;
+    }
+
+    if (!mpp_spsc_queue_pop(q, &data) || data)
+        goto FAILED;
+
+    if (mpp_spsc_queue_wait(q, 0) != MPP_ERR_TIMEOUT ||
+        mpp_spsc_queue_wait(q, 10) != MPP_ERR_TIMEOUT)
+        goto FAILED;
+
+    for (i = 1; i <= 16; i++)
+        mpp_spsc_queue_push(q, (void *)i);
+
+    mpp_spsc_queue_flush(q);
+    if (release_count != 16 || mpp_spsc_queue_size(q))
+        goto FAILED;
+
+    mpp_spsc_queue_push(q, (void *)1);
+    mpp_spsc_queue_deinit(q);
+    if (release_count != 17)
+        goto FAILED;
+
+    return MPP_OK;
+
+FAILED:
+    mpp_spsc_queue_deinit(q);
+    return MPP_NOK;
+}
+
+static RK_S32 test_stream(void)
+{
+    MppSpscQueue q = NULL;
+    pthread_t td;
+    RK_S64 time;
+    intptr_t i;
+    RK_S32 ret = MPP_OK;
+
+    mpp_spsc_queue_init(&q, 64, NULL);
+
+    time = mpp_time();
+    pthread_create(&td, NULL, stream_producer, q);
+
+    for (i = 1; i <= STREAM_COUNT; i++) {
+        if (spsc_pop_block(q) != (void *)i) {
+            mpp_err("stream mismatch at %d\n", (RK_S32)i);
+            ret = MPP_NOK;
+            break;
+        }
+    }
+
+    pthread_join(td, NULL);
+    time = mpp_time() - time;
+
+    mpp_log("stream %d elements cost %lld us\n", STREAM_COUNT, time);
+
+    mpp_spsc_queue_deinit(q);
+
+    return ret;
+}
+
+/* producer blocks on full ring and goes on when consumer pops */
+static RK_S32 test_full(void)
+{
+    MppSpscQueue q = NULL;
+    pthread_t td;
+    intptr_t i;
+    RK_S32 ret = MPP_OK;
+
+    mpp_spsc_queue_init(&q, FULL_RING_SIZE, NULL);
+    pthread_create(&td, NULL, full_producer, q);
+
+    msleep(20);
+    if (mpp_spsc_queue_size(q) != FULL_RING_SIZE) {
+        mpp_err("full ring size %d expect %d\n", mpp_spsc_queue_size(q), FULL_RING_SIZE);
+        ret = MPP_NOK;
+    }
+
+    for (i = 1; i <= FULL_PUSH_COUNT; i++) {
+        if (spsc_pop_block(q) != (void *)i) {
+            mpp_err("full ring mismatch at %d\n", (RK_S32)i);
+            ret = MPP_NOK;
+            break;
+        }
+    }
+
+    if (ret)
+        mpp_spsc_queue_flush(q);
+
+    pthread_join(td, NULL);
+    mpp_spsc_queue_deinit(q);
+
+    return ret;
+}
+
+/* each of the waiting consumers gets one element */
+static RK_S32 test_waiters(void)
+{
+    MppSpscQueue q = NULL;
+    pthread_t td[WAITER_COUNT];
+    void *arg[WAITER_COUNT];
+    RK_S32 ret = MPP_OK;
+    intptr_t i;
+
+    mpp_spsc_queue_init(&q, 0, NULL);
+
+    for (i = 0; i < WAITER_COUNT; i++) {
+        arg[i] = q;
+        pthread_create(&td[i], NULL, waiter_thread, &arg[i]);
+    }
+
+    msleep(20);
+    for (i = 1; i <= WAITER_COUNT; i++)
+        mpp_spsc_queue_push(q, (void *)i);
+
+    for (i = 0; i < WAITER_COUNT; i++)
+        pthread_join(td[i], NULL);
+
+    if (!arg[0] || !arg[1] || arg[0] == arg[1]) {
+        mpp_err("waiters get %p %p\n", arg[0], arg[1]);
+        ret = MPP_NOK;
+    }
+
+    mpp_spsc_queue_deinit(q);
+
+    return ret;
+}
+
+static RK_S32 test_ping_pong(void)
+{
+    PingPong pp;
+    RK_S64 time_spsc;
+    RK_S64 time_cond;
+
+    pp.count = PING_PONG_COUNT;
+
+    mpp_spsc_queue_init(&pp.spsc[0], 0, NULL);
+    mpp_spsc_queue_init(&pp.spsc[1], 0, NULL);
+    pp.use_cond = 0;
+    time_spsc = ping_pong(&pp);
+    mpp_spsc_queue_deinit(pp.spsc[0]);
+    mpp_spsc_queue_deinit(pp.spsc[1]);
+
+    cond_queue_init(&pp.cond[0]);
+    cond_queue_init(&pp.cond[1]);
+    pp.use_cond = 1;
+    time_cond = ping_pong(&pp);
+    cond_queue_deinit(&pp.cond[0]);
+    cond_queue_deinit(&pp.cond[1]);
+
+    if (time_spsc < 0 || time_cond < 0)
+        return MPP_NOK;
+
+    mpp_log("ping-pong %d round trip spsc %.2f us cond %.2f us\n", pp.count,
+            (float)time_spsc / pp.count, (float)time_cond / pp.count);
+
+    return MPP_OK;
+}
+
+int main()
+{
+    RK_S32 ret;
+
+    mpp_log("spsc queue test start\n");
+
+    ret = test_order();
+    mpp_log("spsc queue order test %s\n", ret ? "failed" : "success");
+    if (ret)
+        return ret;
+
+    ret = test_full();
+    mpp_log("spsc queue full test %s\n", ret ? "failed" : "success");
+    if (ret)
+        return ret;
+
+    ret = test_waiters();
+    mpp_log("spsc queue waiters test %s\n", ret ? "failed" : "success");
+    if (ret)
+        return ret;
+
+    ret = test_stream();
+    mpp_log("spsc queue stream test %s\n", ret ? "failed" : "success");
+    if (ret)
+        return ret;
+
+    ret = test_ping_pong();
+    mpp_log("spsc queue ping-pong test %s\n", ret ? "failed" : "success");
+
+    return ret;
+}
@@ -22,6 +22,8 @@
 
 int main(void)
 {
+    MppTraceJson json = NULL;
+
     mpp_log("mpp trace test start\n");
 
     mpp_trace_begin("mpp_trace_test");
@@ -33,6 +35,12 @@ int main(void)
     mpp_trace_int32("mpp_trace_test int32", 256);
     mpp_trace_int64("mpp_trace_test int64", 100000000);
 
+    if (!mpp_trace_json_open(&json, "/tmp/mpp_trace_test.json")) {
+        mpp_trace_json_event(json, "mpp_trace_test event0", 1, 1, 0, 100);
+        mpp_trace_json_event(json, "mpp_trace_test event1", 1, 2, 50, 100);
+        mpp_trace_json_close(json);
+    }
+
     mpp_log("mpp trace test done\n");
 
     return 0;
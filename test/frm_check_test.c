@@ -0,0 +1,206 @@
+/* SPDX-License-Identifier: Apache-2.0 OR MIT */
+/*
+ * Copyright (c) 2024 Rockchip Electronics Co., Ltd.
+ */
+
+#define MODULE_TAG "frm_check_test"
+
+#include <string.h>
+
+#include "mpp_env.h"
+#include "mpp_log.h"
+#include "mpp_buffer.h"
+#include "mpp_common.h"
+
+#include "frm_check.h"
+
+/*
+ * Check the checksum engines against reference values. The frame md5 is the
+ * md5 of each Y / U / V component in planar order without stride padding and
+ * 10bit samples as 16bit little endian, reference values are generated from
+ * the same layout with python hashlib.
+ */
+#define FRM_WIDTH       8
+#define FRM_HEIGHT      4
+#define FRM_HOR_STRIDE  16
+#define FRM_VER_STRIDE  4
+#define FRM_BUF_SIZE    (FRM_HOR_STRIDE * FRM_VER_STRIDE * 3)
+
+typedef struct FrmCheckCase_t {
+    const char      *name;
+    MppFrameFormat  fmt;
+    const char      *md5;
+} FrmCheckCase;
+
+static const FrmCheckCase frm_cases[] = {
+    {
+        "nv12", MPP_FMT_YUV420SP,
+        "0fb766cbf818ea9a7cd514ecb22c6001 ef486c78b6be35ceef44209afb9ab331 e359a77cbafca851954067b8737c8cb6",
+    },
+    {
+        "nv21", MPP_FMT_YUV420SP_VU,
+        "0fb766cbf818ea9a7cd514ecb22c6001 e359a77cbafca851954067b8737c8cb6 ef486c78b6be35ceef44209afb9ab331",
+    },
+    {
+        "yuv444sp", MPP_FMT_YUV444SP,
+        "0fb766cbf818ea9a7cd514ecb22c6001 945118e9bdaae1550dca1ce9e70a4621 53aa60905f3080ad1fbd1c419feb29fe",
+    },
+    {
+        "yuv420p", MPP_FMT_YUV420P,
+        "0fb766cbf818ea9a7cd514ecb22c6001 99a1ee9f333891a9c0b3c50ff03f65b0 68403458e3f6c391994364b5ceca4ecc",
+    },
+    {
+        "nv12_10bit", MPP_FMT_YUV420SP_10BIT,
+        "a47771daf1e446efef6db1e2ef260dc8 9a422cf20aa670a0a25c969c16baf90b 9175b978113d25218c0e8792778988e6",
+    },
+};
+
+static const char *nv12_crc32c = "32, 628caa84, 8, a1ef3b1d, 8, 7b6f9ef6";
+
+static MPP_RET test_vectors(void)
+{
+    static const char *md5_abc = "900150983cd24fb0d6963f7d28e17f72";
+    static const char *md5_empty = "d41d8cd98f00b204e9800998ecf8427e";
+    RK_U8 digest[16];
+    char str[33];
+    RK_U32 crc;
+    RK_S32 i;
+    MPP_RET ret = MPP_OK;
+
+    crc = frm_check_crc32c(0, (const RK_U8 *)"123456789", 9);
+    if (crc != 0xe3069283) {
+        mpp_err("crc32c mismatch %08x\n", crc);
+        ret = MPP_NOK;
+    }
+
+    /* split update gives the same crc */
+    crc = frm_check_crc32c(0, (const RK_U8 *)"1234", 4);
+    crc = frm_check_crc32c(crc, (const RK_U8 *)"56789", 5);
+    if (crc != 0xe3069283) {
+        mpp_err("crc32c split mismatch %08x\n", crc);
+        ret = MPP_NOK;
+    }
+
+    frm_check_md5((const RK_U8 *)"abc", 3, digest);
+    for (i = 0; i < 16; i++)
+        snprintf(str + i * 2, 3, "%02x", digest[i]);
+    if (strcmp(str, md5_abc)) {
+        mpp_err("md5 mismatch %s\n", str);
+        ret = MPP_NOK;
+    }
+
+    frm_check_md5((const RK_U8 *)"", 0, digest);
+    for (i = 0; i < 16; i++)
+        snprintf(str + i * 2, 3, "%02x", digest[i]);
+    if (strcmp(str, md5_empty)) {
+        mpp_err("md5 empty mismatch %s\n", str);
+        ret = MPP_NOK;
+    }
+
+    return ret;
+}
+
+static MPP_RET test_frames(FrmCheckType type, RK_U32 async)
+{
+    MppBufferGroup group = NULL;
+    MppBuffer buffer = NULL;
+    MppFrame frame = NULL;
+    FrmCheck check = NULL;
+    FILE *fp = tmpfile();
+    RK_S32 count = (type == FRM_CHECK_MD5) ? (RK_S32)MPP_ARRAY_ELEMS(frm_cases) : 1;
+    char line[256];
+    RK_U8 *ptr;
+    RK_S32 i;
+    MPP_RET ret = MPP_NOK;
+
+    if (NULL == fp) {
+        mpp_err("failed to create tmp file\n");
+        return MPP_NOK;
+    }
+
+    if (mpp_buffer_group_get_internal(&group, MPP_BUFFER_TYPE_NORMAL) ||
+        mpp_buffer_get(group, &buffer, FRM_BUF_SIZE) ||
+        mpp_frame_init(&frame) ||
+        frm_check_init(&check, fp, type, async)) {
+        mpp_err("failed to init\n");
+        goto DONE;
+    }
+
+    ptr = (RK_U8 *)mpp_buffer_get_ptr(buffer);
+    for (i = 0; i < FRM_BUF_SIZE; i++)
+        ptr[i] = (RK_U8)(i * 7 + 3);
+
+    mpp_frame_set_width(frame, FRM_WIDTH);
+    mpp_frame_set_height(frame, FRM_HEIGHT);
+    mpp_frame_set_hor_stride(frame, FRM_HOR_STRIDE);
+    mpp_frame_set_ver_stride(frame, FRM_VER_STRIDE);
+    mpp_frame_set_buffer(frame, buffer);
+
+    for (i = 0; i < count; i++) {
+        mpp_frame_set_fmt(frame, frm_cases[i].fmt);
+        frm_check_put(check, frame);
+    }
+
+    /* deinit flushes the async queue */
+    frm_check_deinit(check);
+    check = NULL;
+
+    ret = MPP_OK;
+    rewind(fp);
+    for (i = 0; i < count; i++) {
+        const char *expect = (type == FRM_CHECK_MD5) ? frm_cases[i].md5 : nv12_crc32c;
+        char *result;
+
+        if (NULL == fgets(line, sizeof(line), fp)) {
+            mpp_err("missing line %d\n", i);
+            ret = MPP_NOK;
+            break;
+        }
+
+        line[strcspn(line, "\n")] = '\0';
+        /* skip frame count */
+        result = line + 8;
+        if (type == FRM_CHECK_CRC32C)
+            result += 2;
+        else
+            result += 1;
+
+        if (strcmp(result, expect)) {
+            mpp_err("%s %s async %d mismatch\n", frm_cases[i].name,
+                    type == FRM_CHECK_MD5 ? "md5" : "crc32c", async);
+            mpp_err("result %s\n", result);
+            mpp_err("expect %s\n", expect);
+            ret = MPP_NOK;
+        }
+    }
+
+DONE:
+    if (check)
+        frm_check_deinit(check);
+    if (frame)
+        mpp_frame_deinit(&frame);
+    if (buffer)
+        mpp_buffer_put(buffer);
+    if (group)
+        mpp_buffer_group_put(group);
+    fclose(fp);
+
+    return ret;
+}
+
+int main()
+{
+    MPP_RET ret = MPP_OK;
+
+    /* frame buffers from cpu memory when there is no device */
+    mpp_env_set_u32("mpp_null_dev", 1);
+
+    ret |= test_vectors();
+    ret |= test_frames(FRM_CHECK_MD5, 0);
+    ret |= test_frames(FRM_CHECK_MD5, 1);
+    ret |= test_frames(FRM_CHECK_CRC32C, 0);
+
+    mpp_log("frm_check_test %s\n", ret ? "failed" : "success");
+
+    return ret;
+}
@@ -0,0 +1,180 @@
+/* SPDX-License-Identifier: Apache-2.0 OR MIT */
+/*
+ * Copyright (c) 2024 Rockchip Electronics Co., Ltd.
+ */
+
+#define MODULE_TAG "frm_dump_test"
+
+#include <string.h>
+
+#include "mpp_env.h"
+#include "mpp_mem.h"
+#include "mpp_log.h"
+#include "mpp_buffer.h"
+#include "mpp_common.h"
+
+#include "utils.h"
+#include "frm_dump.h"
+
+/*
+ * Write the same frames with dump_mpp_frame_to_file and the background
+ * writer and check the files are byte identical. Width is a multiple of 8
+ * as dump_mpp_frame_to_file unpacks 10bit in group of 8 samples.
+ */
+#define DUMP_WIDTH      64
+#define DUMP_HEIGHT     32
+#define DUMP_V_STRIDE   (DUMP_HEIGHT + 2)
+#define DUMP_FRAMES     3
+
+typedef struct FrmDumpCase_t {
+    MppFrameFormat  fmt;
+    /* bytes of one luma / packed line */
+    RK_U32          line;
+} FrmDumpCase;
+
+static const FrmDumpCase dump_cases[] = {
+    { MPP_FMT_YUV420SP,         DUMP_WIDTH      },
+    { MPP_FMT_YUV420SP_VU,      DUMP_WIDTH      },
+    { MPP_FMT_YUV422SP,         DUMP_WIDTH      },
+    { MPP_FMT_YUV444SP,         DUMP_WIDTH      },
+    { MPP_FMT_YUV420P,          DUMP_WIDTH      },
+    { MPP_FMT_YUV420SP_10BIT,   DUMP_WIDTH * 10 / 8 },
+    { MPP_FMT_YUV400,           DUMP_WIDTH      },
+    { MPP_FMT_ARGB8888,         DUMP_WIDTH * 4  },
+    { MPP_FMT_YUV422_YUYV,      DUMP_WIDTH * 2  },
+    { MPP_FMT_RGB888,           DUMP_WIDTH * 3  },
+};
+
+#define DUMP_CASE_CNT   MPP_ARRAY_ELEMS(dump_cases)
+
+static RK_U8 *read_file(FILE *fp, long *size)
+{
+    RK_U8 *buf;
+
+    fseek(fp, 0, SEEK_END);
+    *size = ftell(fp);
+    rewind(fp);
+
+    buf = mpp_malloc(RK_U8, *size + 1);
+    if (buf && fread(buf, 1, *size, fp) != (size_t)*size)
+        MPP_FREE(buf);
+
+    return buf;
+}
+
+static MPP_RET test_dump(FrmDumpCfg *cfg)
+{
+    MppBufferGroup group = NULL;
+    MppBuffer buffers[DUMP_CASE_CNT * DUMP_FRAMES];
+    MppFrame frame = NULL;
+    FrmDump dump = NULL;
+    FILE *fp_ref = tmpfile();
+    FILE *fp_dump = tmpfile();
+    RK_U8 *ref = NULL;
+    RK_U8 *out = NULL;
+    long ref_size = 0;
+    long out_size = 0;
+    RK_U32 i, j, k;
+    MPP_RET ret = MPP_NOK;
+
+    memset(buffers, 0, sizeof(buffers));
+
+    if (NULL == fp_ref || NULL == fp_dump ||
+        mpp_buffer_group_get_internal(&group, MPP_BUFFER_TYPE_NORMAL) ||
+        mpp_frame_init(&frame) || frm_dump_init(&dump, fp_dump, cfg)) {
+        mpp_err("failed to init\n");
+        goto DONE;
+    }
+
+    mpp_frame_set_width(frame, DUMP_WIDTH);
+    mpp_frame_set_height(frame, DUMP_HEIGHT);
+    mpp_frame_set_ver_stride(frame, DUMP_V_STRIDE);
+
+    for (i = 0; i < DUMP_CASE_CNT; i++) {
+        /* stride padding must not be written */
+        RK_U32 h_stride = dump_cases[i].line + 16;
+        RK_U32 size = h_stride * DUMP_V_STRIDE * 3;
+
+        mpp_frame_set_fmt(frame, dump_cases[i].fmt);
+        mpp_frame_set_hor_stride(frame, h_stride);
+
+        for (j = 0; j < DUMP_FRAMES; j++) {
+            MppBuffer *buf = &buffers[i * DUMP_FRAMES + j];
+            RK_U8 *ptr;
+
+            if (mpp_buffer_get(group, buf, size)) {
+                mpp_err("failed to get buffer size %d\n", size);
+                goto DONE;
+            }
+
+            /* queued frames keep the buffer, each frame has its own */
+            ptr = (RK_U8 *)mpp_buffer_get_ptr(*buf);
+            for (k = 0; k < size; k++)
+                ptr[k] = (RK_U8)(k * 13 + i * 7 + j * 31);
+
+            mpp_frame_set_buffer(frame, *buf);
+            dump_mpp_frame_to_file(frame, fp_ref);
+            frm_dump_put(dump, frame);
+        }
+    }
+
+    frm_dump_deinit(dump);
+    dump = NULL;
+
+    ref = read_file(fp_ref, &ref_size);
+    out = read_file(fp_dump, &out_size);
+    if (NULL == ref || NULL == out) {
+        mpp_err("failed to read output\n");
+        goto DONE;
+    }
+
+    if (!ref_size || ref_size != out_size || memcmp(ref, out, ref_size)) {
+        mpp_err("dump queue %d prealloc %d mismatch size %ld vs %ld\n",
+                cfg ? cfg->queue_depth : 0, cfg ? cfg->prealloc : 0,
+                ref_size, out_size);
+        goto DONE;
+    }
+
+    ret = MPP_OK;
+
+DONE:
+    if (dump)
+        frm_dump_deinit(dump);
+    if (frame)
+        mpp_frame_deinit(&frame);
+    for (i = 0; i < MPP_ARRAY_ELEMS(buffers); i++) {
+        if (buffers[i])
+            mpp_buffer_put(buffers[i]);
+    }
+    if (group)
+        mpp_buffer_group_put(group);
+    if (fp_ref)
+        fclose(fp_ref);
+    if (fp_dump)
+        fclose(fp_dump);
+    MPP_FREE(ref);
+    MPP_FREE(out);
+
+    return ret;
+}
+
+int main()
+{
+    FrmDumpCfg cfg;
+    MPP_RET ret = MPP_OK;
+
+    /* frame buffers from cpu memory when there is no device */
+    mpp_env_set_u32("mpp_null_dev", 1);
+
+    /* default config with preallocation */
+    ret |= test_dump(NULL);
+
+    /* shallow queue blocking the caller and no preallocation */
+    memset(&cfg, 0, sizeof(cfg));
+    cfg.queue_depth = 1;
+    ret |= test_dump(&cfg);
+
+    mpp_log("frm_dump_test %s\n", ret ? "failed" : "success");
+
+    return ret;
+}
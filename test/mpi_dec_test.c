@@ -21,6 +21,7 @@
 #define MODULE_TAG "mpi_dec_test"
 
 #include <string.h>
+#include <sys/resource.h>
 #include "rk_mpi.h"
 
 #include "mpp_mem.h"
@@ -45,6 +46,7 @@ typedef struct {
     MppFrame        frame;
 
     FILE            *fp_output;
+    FrmDump         frm_dump;
     RK_S32          frame_count;
     RK_S32          frame_num;
 
@@ -56,7 +58,11 @@ typedef struct {
     RK_S64          elapsed_time;
     RK_S64          delay;
     FILE            *fp_verify;
-    FrmCrc          checkcrc;
+    FrmCheck        frm_check;
+
+    /* zero copy input statistic */
+    RK_S32          zc_pkt_count;
+    RK_S64          zc_pkt_bytes;
 } MpiDecLoopData;
 
 static int dec_simple(MpiDecLoopData *data)
@@ -70,7 +76,6 @@ static int dec_simple(MpiDecLoopData *data)
     MppPacket packet = data->packet;
     FileBufSlot *slot = NULL;
     RK_U32 quiet = data->quiet;
-    FrmCrc *checkcrc = &data->checkcrc;
 
     // when packet size is valid read the input binary file
     ret = reader_read(cmd->reader, &slot);
@@ -91,10 +96,19 @@ static int dec_simple(MpiDecLoopData *data)
         }
     }
 
-    mpp_packet_set_data(packet, slot->data);
-    mpp_packet_set_size(packet, slot->size);
-    mpp_packet_set_pos(packet, slot->data);
-    mpp_packet_set_length(packet, slot->size);
+    if (cmd->zero_copy && slot->buf) {
+        /*
+         * zero copy mode: reader reads stream into MppBuffer like the dma-buf
+         * from demuxer then decoder only takes a reference of the buffer
+         */
+        mpp_packet_init_with_buffer(&packet, slot->buf);
+        mpp_packet_set_length(packet, slot->size);
+    } else {
+        mpp_packet_set_data(packet, slot->data);
+        mpp_packet_set_size(packet, slot->size);
+        mpp_packet_set_pos(packet, slot->data);
+        mpp_packet_set_length(packet, slot->size);
+    }
     // setup eos flag
     if (pkt_eos)
         mpp_packet_set_eos(packet);
@@ -108,6 +122,10 @@ static int dec_simple(MpiDecLoopData *data)
             ret = mpi->decode_put_packet(ctx, packet);
             if (MPP_OK == ret) {
                 pkt_done = 1;
+                if (packet != data->packet) {
+                    data->zc_pkt_count++;
+                    data->zc_pkt_bytes += slot->size;
+                }
                 if (!data->first_pkt)
                     data->first_pkt = mpp_time();
             }
@@ -194,13 +212,11 @@ static int dec_simple(MpiDecLoopData *data)
                     mpp_log_q(quiet, "%p %s\n", ctx, log_buf);
 
                     data->frame_count++;
-                    if (data->fp_output && !err_info)
-                        dump_mpp_frame_to_file(frame, data->fp_output);
+                    if (data->frm_dump && !err_info)
+                        frm_dump_put(data->frm_dump, frame);
 
-                    if (data->fp_verify) {
-                        calc_frm_crc(frame, checkcrc);
-                        write_frm_crc(data->fp_verify, checkcrc);
-                    }
+                    if (data->frm_check)
+                        frm_check_put(data->frm_check, frame);
 
                     fps_calc_inc(cmd->fps);
                 }
@@ -255,6 +271,10 @@ static int dec_simple(MpiDecLoopData *data)
         msleep(1);
     } while (1);
 
+    /* decoder keeps its own reference on the zero copy buffer */
+    if (packet != data->packet)
+        mpp_packet_deinit(&packet);
+
     return ret;
 }
 
@@ -269,7 +289,6 @@ static int dec_advanced(MpiDecLoopData *data)
     MppTask task = NULL;
     RK_U32 quiet = data->quiet;
     FileBufSlot *slot = NULL;
-    FrmCrc *checkcrc = &data->checkcrc;
 
     ret = reader_index_read(cmd->reader, 0, &slot);
     mpp_assert(ret == MPP_OK);
@@ -332,13 +351,11 @@ static int dec_advanced(MpiDecLoopData *data)
                 data->first_frm = mpp_time();
 
             /* write frame to file here */
-            if (data->fp_output)
-                dump_mpp_frame_to_file(frame, data->fp_output);
+            if (data->frm_dump)
+                frm_dump_put(data->frm_dump, frame);
 
-            if (data->fp_verify) {
-                calc_frm_crc(frame, checkcrc);
-                write_frm_crc(data->fp_verify, checkcrc);
-            }
+            if (data->frm_check)
+                frm_check_put(data->frm_check, frame);
 
             mpp_log_q(quiet, "%p decoded frame %d\n", ctx, data->frame_count);
             data->frame_count++;
@@ -406,9 +423,19 @@ void *thread_decode(void *arg)
     MppApi *mpi = data->mpi;
     RK_S64 t_s, t_e;
 
-    memset(&data->checkcrc, 0, sizeof(data->checkcrc));
-    data->checkcrc.luma.sum = mpp_malloc(RK_ULONG, 512);
-    data->checkcrc.chroma.sum = mpp_malloc(RK_ULONG, 512);
+    /* checksum on worker thread to avoid stalling the decode loop */
+    if (data->fp_verify)
+        frm_check_init(&data->frm_check, data->fp_verify, cmd->slt_type, 1);
+
+    /* write output file on worker thread */
+    if (data->fp_output) {
+        FrmDumpCfg dump_cfg;
+
+        mpp_env_get_u32("mpi_dec_dump_depth", &dump_cfg.queue_depth, 0);
+        mpp_env_get_u32("mpi_dec_dump_drop", &dump_cfg.drop, 0);
+        mpp_env_get_u32("mpi_dec_dump_prealloc", &dump_cfg.prealloc, 16);
+        frm_dump_init(&data->frm_dump, data->fp_output, &dump_cfg);
+    }
 
     t_s = mpp_time();
 
@@ -439,8 +466,44 @@ void *thread_decode(void *arg)
             data->frame_count, (RK_S64)(data->elapsed_time / 1000),
             (RK_S32)(data->delay / 1000), data->frame_rate);
 
-    MPP_FREE(data->checkcrc.luma.sum);
-    MPP_FREE(data->checkcrc.chroma.sum);
+    if (data->first_pkt) {
+        struct rusage usage;
+
+        getrusage(RUSAGE_SELF, &usage);
+        mpp_log("start latency %lld ms peak rss %ld KB\n",
+                (data->first_pkt - cmd->start_time) / 1000, usage.ru_maxrss);
+    }
+
+    if (data->zc_pkt_count)
+        mpp_log("zero copy input %d packets %lld bytes copy avoided\n",
+                data->zc_pkt_count, data->zc_pkt_bytes);
+
+    if (!data->quiet) {
+        MppDecPerfStats stats;
+        RK_U32 i;
+
+        if (!mpi->control(ctx, MPP_DEC_GET_PERF_STATS, &stats)) {
+            for (i = 0; i < MPP_DEC_PERF_STAGE_BUTT; i++) {
+                MppDecPerfStat *stat = &stats.stage[i];
+
+                if (!stat->count)
+                    continue;
+
+                mpp_log("stage %-8s count %-6lld p50 %-6d p99 %-6d max %-6d us\n",
+                        stat->name, stat->count, stat->p50, stat->p99, stat->max);
+            }
+        }
+    }
+
+    if (data->frm_check) {
+        frm_check_deinit(data->frm_check);
+        data->frm_check = NULL;
+    }
+
+    if (data->frm_dump) {
+        frm_dump_deinit(data->frm_dump);
+        data->frm_dump = NULL;
+    }
 
     return NULL;
 }
@@ -571,6 +634,18 @@ int dec_decode(MpiDecTestCmd *cmd)
         goto MPP_TEST_OUT;
     }
 
+    /*
+     * zero_copy_pkt let decoder reference the MppBuffer in input packet
+     * instead of copy the stream into a new packet.
+     */
+    if (cmd->simple && cmd->zero_copy) {
+        ret = mpp_dec_cfg_set_u32(cfg, "base:zero_copy_pkt", 1);
+        if (ret) {
+            mpp_err("%p failed to set zero_copy_pkt ret %d\n", ctx, ret);
+            goto MPP_TEST_OUT;
+        }
+    }
+
     ret = mpi->control(ctx, MPP_DEC_SET_CFG, cfg);
     if (ret) {
         mpp_err("%p failed to set cfg %p ret %d\n", ctx, cfg, ret);
@@ -671,6 +746,7 @@ int main(int argc, char **argv)
     MpiDecTestCmd* cmd = &cmd_ctx;
 
     memset((void*)cmd, 0, sizeof(*cmd));
+    cmd->start_time = mpp_time();
     cmd->format = MPP_FMT_BUTT;
     cmd->pkt_size = MPI_DEC_STREAM_SIZE;
 
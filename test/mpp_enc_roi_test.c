@@ -0,0 +1,596 @@
+/* SPDX-License-Identifier: Apache-2.0 OR MIT */
+/*
+ * Copyright (c) 2024 Rockchip Electronics Co., Ltd.
+ */
+
+#define MODULE_TAG "mpp_enc_roi_test"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "mpp_env.h"
+#include "mpp_mem.h"
+#include "mpp_log.h"
+#include "mpp_time.h"
+#include "mpp_common.h"
+
+#include "mpp_enc_roi_utils.h"
+
+/*
+ * Replay a synthetic analytics roi trace with moving, static, appearing and
+ * vanishing regions on a full rebuild roi context and an incremental one,
+ * check both give the same roi buffers as the reference generation below on
+ * each frame and compare the time.
+ */
+#define ROI_WIDTH       3840
+#define ROI_HEIGHT      2160
+#define ROI_CNT         48
+#define ROI_MB_W        (MPP_ALIGN(ROI_WIDTH, 16) / 16)
+#define ROI_MB_H        (MPP_ALIGN(ROI_HEIGHT, 16) / 16)
+#define ROI_FRAMES      300
+
+typedef struct RoiTrace_t {
+    RK_S32  x;
+    RK_S32  y;
+    RK_S32  w;
+    RK_S32  h;
+    RK_S32  vx;
+    RK_S32  vy;
+    RK_S32  qp_mode;
+    RK_S32  qp_val;
+} RoiTrace;
+
+static void init_trace(RoiTrace *trace)
+{
+    RK_S32 i;
+
+    for (i = 0; i < ROI_CNT; i++) {
+        RoiTrace *t = &trace[i];
+
+        t->w = 64 + rand() % 384;
+        t->h = 64 + rand() % 256;
+        t->x = rand() % (ROI_WIDTH - t->w);
+        t->y = rand() % (ROI_HEIGHT - t->h);
+        /* a quarter of the regions stay still */
+        t->vx = (i % 4) ? rand() % 17 - 8 : 0;
+        t->vy = (i % 4) ? rand() % 9 - 4 : 0;
+        t->qp_mode = i & 1;
+        t->qp_val = t->qp_mode ? 20 + rand() % 20 : rand() % 17 - 8;
+    }
+}
+
+static RK_S32 step_trace(RoiTrace *trace, RK_S32 frm, RoiRegionCfg *regions)
+{
+    /* last regions vanish and come back periodically */
+    RK_S32 cnt = (frm / 60) & 1 ? ROI_CNT - 8 : ROI_CNT;
+    RK_S32 i;
+
+    for (i = 0; i < cnt; i++) {
+        RoiTrace *t = &trace[i];
+        RoiRegionCfg *region = &regions[i];
+
+        t->x += t->vx;
+        t->y += t->vy;
+        if (t->x < 0 || t->x + t->w > ROI_WIDTH) {
+            t->vx = -t->vx;
+            t->x = mpp_clip(t->x, 0, ROI_WIDTH - t->w);
+        }
+        if (t->y < 0 || t->y + t->h > ROI_HEIGHT) {
+            t->vy = -t->vy;
+            t->y = mpp_clip(t->y, 0, ROI_HEIGHT - t->h);
+        }
+
+        /*
+         * regions start at the next 16x16 block on unaligned position, keep
+         * them in the frame as the reference asserts
+         */
+        region->x = t->x;
+        region->y = t->y;
+        region->w = MPP_MIN(t->w, (ROI_MB_W - (t->x + 15) / 16) * 16);
+        region->h = MPP_MIN(t->h, (ROI_MB_H - (t->y + 15) / 16) * 16);
+        region->force_intra = (frm + i) % 50 == 0;
+        region->qp_mode = t->qp_mode;
+        region->qp_val = t->qp_val;
+    }
+
+    return cnt;
+}
+
+/*
+ * The whole frame roi generation before the incremental update, kept as the
+ * reference. It writes the 16x16 cu_map on roi type 1 where it is not
+ * allocated and may mark hevc ctu beyond the ctu map, so the reference
+ * cu_map is always allocated with spare lines.
+ */
+typedef struct RefRoiCfg_t {
+    RK_U16 force_intra  : 1;
+    RK_U16 reserved     : 3;
+    RK_U16 qp_area_idx  : 3;
+    RK_U16 qp_area_en   : 1;
+    RK_S16 qp_adj       : 7;
+    RK_U16 qp_adj_mode  : 1;
+} RefRoiCfg;
+
+typedef struct RefH264BsCfg_t {
+    RK_U64 force_inter   : 42;
+    RK_U64 mode_mask     : 9;
+    RK_U64 reserved      : 10;
+    RK_U64 force_intra   : 1;
+    RK_U64 qp_adj_en     : 1;
+    RK_U64 amv_en        : 1;
+} RefH264BsCfg;
+
+typedef struct RefH265BsCfg_t {
+    RK_U8 amv_en        : 1;
+    RK_U8 qp_adj        : 1;
+    RK_U8 force_split   : 1;
+    RK_U8 force_intra   : 2;
+    RK_U8 force_inter   : 2;
+} RefH265BsCfg;
+
+typedef struct RefQpCfg_t {
+    RK_U16 reserved     : 4;
+    RK_U16 qp_area_idx  : 4;
+    RK_S16 qp_adj       : 7;
+    RK_U16 qp_adj_mode  : 1;
+} RefQpCfg;
+
+typedef struct RefRoi_t {
+    RK_S32          w;
+    RK_S32          h;
+    MppCodingType   type;
+    RK_U32          roi_type;
+
+    RoiRegionCfg    *regions;
+    RK_S32          count;
+
+    void            *dst_base;
+    void            *dst_qp;
+    RK_U32          base_cfg_size;
+    RK_U32          qp_cfg_size;
+
+    RK_U8           *cu_map;
+    RK_U32          cu_size;
+    RefRoiCfg       *tmp;
+} RefRoi;
+
+static RK_U32 ref_raster2scan8[64] = {
+    0,  1,  4,  5,  16, 17, 20, 21,
+    2,  3,  6,  7,  18, 19, 22, 23,
+    8,  9,  12, 13, 24, 25, 28, 29,
+    10, 11, 14, 15, 26, 27, 30, 31,
+    32, 33, 36, 37, 48, 49, 52, 53,
+    34, 35, 38, 39, 50, 51, 54, 55,
+    40, 41, 44, 45, 56, 57, 60, 61,
+    42, 43, 46, 47, 58, 59, 62, 63
+};
+
+static RK_U32 ref_raster2zscan16[16] = {
+    0,  1,  4,  5,
+    2,  3,  6,  7,
+    8,  9,  12, 13,
+    10, 11, 14, 15
+};
+
+static void ref_h265_set_roi(RefRoiCfg *dst, RefRoiCfg *src, RK_S32 w, RK_S32 h)
+{
+    RK_S32 mb_w = MPP_ALIGN(w, 64) / 64;
+    RK_S32 mb_h = MPP_ALIGN(h, 64) / 64;
+    RK_S32 ctu_line = mb_w;
+    RK_S32 i, j, cu16cnt;
+
+    for (j = 0; j < mb_h; j++) {
+        for (i = 0; i < mb_w; i++) {
+            RK_S32 ctu_addr = j * ctu_line + i;
+            RK_S32 cu16_num_line = ctu_line * 4;
+
+            for (cu16cnt = 0; cu16cnt < 16; cu16cnt++) {
+                RK_S32 cu16_x = cu16cnt % 4 + i * 4;
+                RK_S32 cu16_y = cu16cnt / 4 + j * 4;
+
+                dst[ctu_addr * 16 + cu16cnt] = src[cu16_x + cu16_y * cu16_num_line];
+            }
+        }
+    }
+}
+
+static void ref_gen_vepu54x(RefRoi *ctx, RefRoiCfg *dst)
+{
+    RoiRegionCfg *region = ctx->regions;
+    RK_S32 mb_w = MPP_ALIGN(ctx->w, 16) / 16;
+    RK_S32 mb_h = MPP_ALIGN(ctx->h, 16) / 16;
+    RK_S32 stride_h = MPP_ALIGN(mb_w, 4);
+    RK_S32 stride_v = MPP_ALIGN(mb_h, 4);
+    RefRoiCfg cfg;
+    RK_S32 i;
+
+    memset(ctx->cu_map, 0, ctx->cu_size);
+
+    cfg.force_intra = 0;
+    cfg.reserved    = 0;
+    cfg.qp_area_idx = 0;
+    cfg.qp_area_en  = 1;
+    cfg.qp_adj      = 0;
+    cfg.qp_adj_mode = 0;
+
+    for (i = 0; i < stride_h * stride_v; i++)
+        memcpy(dst + i, &cfg, sizeof(cfg));
+
+    for (i = 0; i < ctx->count; i++, region++) {
+        RefRoiCfg *p = dst;
+        RK_U8 *map = ctx->cu_map;
+        RK_S32 roi_width  = (region->w + 15) / 16;
+        RK_S32 roi_height = (region->h + 15) / 16;
+        RK_S32 pos_x_init = (region->x + 15) / 16;
+        RK_S32 pos_y_init = (region->y + 15) / 16;
+        RK_S32 x, y;
+
+        cfg.force_intra = region->force_intra;
+        cfg.reserved    = 0;
+        cfg.qp_area_idx = 0;
+        cfg.qp_area_en  = 1;
+        cfg.qp_adj      = region->qp_val;
+        cfg.qp_adj_mode = region->qp_mode;
+
+        p += pos_y_init * stride_h + pos_x_init;
+        map += pos_y_init * stride_h + pos_x_init;
+        for (y = 0; y < roi_height; y++) {
+            for (x = 0; x < roi_width; x++) {
+                memcpy(p + x, &cfg, sizeof(cfg));
+                if (ctx->type == MPP_VIDEO_CodingAVC)
+                    *(map + x) = 1;
+            }
+            p += stride_h;
+            map += stride_h;
+        }
+
+        if (ctx->type == MPP_VIDEO_CodingHEVC) {
+            RK_U32 stride_cu64_h = stride_h * 16 / 64;
+
+            map = ctx->cu_map;
+            roi_width  = (region->w + 64) / 64;
+            roi_height = (region->h + 64) / 64;
+
+            if (region->x < 64) {
+                pos_x_init = 0;
+                roi_width += 2;
+            } else if (region->x % 64) {
+                pos_x_init = (region->x - 64) / 64;
+                roi_width += 2;
+            } else
+                pos_x_init = region->x / 64;
+
+            if (region->y < 64) {
+                pos_y_init = 0;
+                roi_height += 2;
+            } else if (region->y % 64) {
+                pos_y_init = (region->y - 64) / 64;
+                roi_height += 2;
+            } else
+                pos_y_init = region->y / 64;
+
+            map += pos_y_init * stride_cu64_h + pos_x_init;
+            for (y = 0; y < roi_height; y++) {
+                for (x = 0; x < roi_width; x++)
+                    *(map + x) = 1;
+                map += stride_cu64_h;
+            }
+        }
+    }
+}
+
+static void ref_set_pos_val(RK_U32 *buf, RK_U32 pos, RK_U32 value)
+{
+    buf[pos / 32] |= value << (pos % 32);
+}
+
+static void ref_set_base_cfg(RK_U32 *buf, RK_U32 index, RefH265BsCfg val)
+{
+    ref_set_pos_val(buf, 425 + index, val.qp_adj);
+    ref_set_pos_val(buf, 340 + index, val.force_split);
+    ref_set_pos_val(buf, 170 + index * 2, val.force_intra);
+    ref_set_pos_val(buf, index * 2, val.force_inter);
+}
+
+static void ref_set_qp_cfg(void *buf, RK_U32 index, RefRoiCfg *cfg)
+{
+    RefQpCfg *qp_cfg = (RefQpCfg *)buf + index;
+
+    qp_cfg->qp_adj = cfg->qp_adj;
+    qp_cfg->qp_adj_mode = cfg->qp_adj_mode;
+    qp_cfg->qp_area_idx = cfg->qp_area_idx;
+}
+
+static void ref_gen_vepu580_h264(RefRoi *ctx)
+{
+    RK_S32 mb_w = MPP_ALIGN(ctx->w, 16) / 16;
+    RK_S32 mb_h = MPP_ALIGN(ctx->h, 16) / 16;
+    RK_S32 stride_h = MPP_ALIGN(mb_w, 4);
+    RK_S32 stride_v = MPP_ALIGN(mb_h, 4);
+    RefQpCfg *dst_qp = (RefQpCfg *)ctx->dst_qp;
+    RefH264BsCfg *dst_base = (RefH264BsCfg *)ctx->dst_base;
+    RK_S32 j, k;
+
+    memset(dst_base, 0, stride_h * stride_v * 8);
+    memset(dst_qp, 0, stride_h * stride_v * 2);
+
+    for (j = 0; j < mb_h; j++) {
+        for (k = 0; k < stride_h; k++) {
+            if (ctx->cu_map[j * stride_h + k]) {
+                RefRoiCfg *cu_cfg = &ctx->tmp[j * stride_h + k];
+                RefQpCfg *qp_cfg = &dst_qp[j * stride_h + k];
+                RefH264BsCfg *base_cfg = &dst_base[j * stride_h + k];
+
+                qp_cfg->qp_adj = cu_cfg->qp_adj;
+                qp_cfg->qp_adj_mode = cu_cfg->qp_adj_mode;
+                qp_cfg->qp_area_idx = cu_cfg->qp_area_idx;
+                base_cfg->force_intra = cu_cfg->force_intra;
+                base_cfg->qp_adj_en = !!cu_cfg->qp_adj;
+            }
+        }
+    }
+}
+
+static void ref_gen_vepu580_h265(RefRoi *ctx)
+{
+    RK_S32 ctu_w = MPP_ALIGN(ctx->w, 64) / 64;
+    RK_S32 ctu_h = MPP_ALIGN(ctx->h, 64) / 64;
+    RK_U8 *dst_qp = (RK_U8 *)ctx->dst_qp;
+    RK_U32 *dst_base = (RK_U32 *)ctx->dst_base;
+    RK_S32 i, j, k, cu16cnt;
+
+    memset(dst_qp, 0, ctu_w * ctu_h * 256);
+    memset(dst_base, 0, ctu_w * ctu_h * 64);
+
+    for (j = 0; j < ctu_h; j++) {
+        for (k = 0; k < ctu_w; k++) {
+            RK_S32 cu16_num_line = ctu_w * 4;
+            RK_U32 adjust_cnt = 0;
+
+            if (ctx->cu_map[j * ctu_w + k]) {
+                for (cu16cnt = 0; cu16cnt < 16; cu16cnt++) {
+                    RK_S32 cu16_x = (cu16cnt & 3) + k * 4;
+                    RK_S32 cu16_y = cu16cnt / 4 + j * 4;
+                    RefRoiCfg *cu16_cfg = &ctx->tmp[cu16_x + cu16_y * cu16_num_line];
+                    RK_U32 zindex = ref_raster2zscan16[cu16cnt];
+                    RK_U32 cu8cnt;
+                    RefH265BsCfg val;
+
+                    memset(&val, 0, sizeof(val));
+                    val.force_intra = cu16_cfg->force_intra;
+                    val.qp_adj = !!cu16_cfg->qp_adj;
+                    if (val.force_intra || val.qp_adj)
+                        adjust_cnt++;
+
+                    for (cu8cnt = 0; cu8cnt < 4; cu8cnt++) {
+                        RK_U32 raster = ((cu16cnt / 4) * 2 + cu8cnt / 2) * 8 +
+                                        (cu16cnt % 4) * 2 + cu8cnt % 2;
+
+                        ref_set_base_cfg(dst_base, ref_raster2scan8[raster], val);
+                    }
+                    ref_set_base_cfg(dst_base, 64 + zindex, val);
+                    ref_set_qp_cfg(dst_qp, 64 + zindex, cu16_cfg);
+
+                    if (adjust_cnt == 16 && cu16cnt == 15) {
+                        ref_set_base_cfg(dst_base, 84, val);
+                        ref_set_qp_cfg(dst_qp, 84, cu16_cfg);
+                        for (i = 0; i < 4; i++) {
+                            ref_set_base_cfg(dst_base, 80 + i, val);
+                            ref_set_qp_cfg(dst_qp, 80 + i, cu16_cfg);
+                        }
+                        for (i = 0; i < 64; i++) {
+                            ref_set_base_cfg(dst_base, i, val);
+                            ref_set_qp_cfg(dst_qp, i, cu16_cfg);
+                        }
+                    } else if (cu16cnt == 15 && adjust_cnt > 0) {
+                        ref_set_pos_val(dst_base, 340 + 84, 1);
+                        for (i = 0; i < 4; i++)
+                            ref_set_pos_val(dst_base, 340 + 80 + i, 1);
+                        for (i = 0; i < 16; i++)
+                            ref_set_pos_val(dst_base, 340 + 64 + i, 1);
+                    }
+                }
+            }
+            dst_base += 64 / 4;
+            dst_qp += 192;
+        }
+    }
+}
+
+static MPP_RET ref_init(RefRoi *ctx, RK_S32 w, RK_S32 h, MppCodingType type, RK_U32 roi_type)
+{
+    RK_S32 stride_h = MPP_ALIGN(MPP_ALIGN(w, 16) / 16, 4);
+    RK_S32 stride_v = MPP_ALIGN(MPP_ALIGN(h, 16) / 16, 4);
+
+    memset(ctx, 0, sizeof(*ctx));
+    ctx->w = w;
+    ctx->h = h;
+    ctx->type = type;
+    ctx->roi_type = roi_type;
+
+    if (roi_type == 1) {
+        ctx->base_cfg_size = stride_h * stride_v * sizeof(RefRoiCfg);
+        ctx->cu_size = 0;
+    } else if (type == MPP_VIDEO_CodingHEVC) {
+        RK_S32 ctu_w = MPP_ALIGN(w, 64) / 64;
+        RK_S32 ctu_h = MPP_ALIGN(h, 64) / 64;
+
+        ctx->base_cfg_size = ctu_w * ctu_h * 64;
+        ctx->qp_cfg_size = ctu_w * ctu_h * 256;
+        ctx->cu_size = ctu_w * ctu_h;
+    } else {
+        RK_S32 mb_w = MPP_ALIGN(w, 64) / 16;
+        RK_S32 mb_h = MPP_ALIGN(h, 64) / 16;
+
+        ctx->base_cfg_size = mb_w * mb_h * 8;
+        ctx->qp_cfg_size = mb_w * mb_h * 2;
+        ctx->cu_size = mb_w * mb_h;
+    }
+
+    ctx->regions = mpp_calloc(RoiRegionCfg, ROI_CNT);
+    ctx->tmp = mpp_calloc(RefRoiCfg, stride_h * stride_v);
+    ctx->cu_map = mpp_calloc(RK_U8, stride_h * (stride_v + 4));
+    ctx->dst_base = mpp_calloc(RK_U8, ctx->base_cfg_size);
+    ctx->dst_qp = ctx->qp_cfg_size ? mpp_calloc(RK_U8, ctx->qp_cfg_size) : NULL;
+
+    if (!ctx->regions || !ctx->tmp || !ctx->cu_map || !ctx->dst_base ||
+        (ctx->qp_cfg_size && !ctx->dst_qp))
+        return MPP_NOK;
+
+    return MPP_OK;
+}
+
+static void ref_deinit(RefRoi *ctx)
+{
+    MPP_FREE(ctx->regions);
+    MPP_FREE(ctx->tmp);
+    MPP_FREE(ctx->cu_map);
+    MPP_FREE(ctx->dst_base);
+    MPP_FREE(ctx->dst_qp);
+}
+
+static void ref_setup(RefRoi *ctx, RoiRegionCfg *regions, RK_S32 count)
+{
+    memcpy(ctx->regions, regions, sizeof(*regions) * count);
+    ctx->count = count;
+
+    if (ctx->roi_type == 1) {
+        if (ctx->type == MPP_VIDEO_CodingAVC) {
+            ref_gen_vepu54x(ctx, (RefRoiCfg *)ctx->dst_base);
+        } else {
+            ref_gen_vepu54x(ctx, ctx->tmp);
+            ref_h265_set_roi((RefRoiCfg *)ctx->dst_base, ctx->tmp, ctx->w, ctx->h);
+        }
+    } else {
+        ref_gen_vepu54x(ctx, ctx->tmp);
+        if (ctx->type == MPP_VIDEO_CodingAVC)
+            ref_gen_vepu580_h264(ctx);
+        else
+            ref_gen_vepu580_h265(ctx);
+    }
+}
+
+static RK_S32 cmp_roi_buf(MppBuffer a, MppBuffer b)
+{
+    if (!a && !b)
+        return 0;
+
+    if (!a || !b || mpp_buffer_get_size(a) != mpp_buffer_get_size(b))
+        return -1;
+
+    return memcmp(mpp_buffer_get_ptr(a), mpp_buffer_get_ptr(b), mpp_buffer_get_size(a));
+}
+
+static RK_S32 cmp_ref_buf(MppBuffer a, void *ref, RK_U32 size)
+{
+    if (!a || !ref)
+        return (a || ref) ? -1 : 0;
+
+    if (mpp_buffer_get_size(a) != size)
+        return -1;
+
+    return memcmp(mpp_buffer_get_ptr(a), ref, size);
+}
+
+static MPP_RET test_roi(RK_U32 roi_type, MppCodingType type)
+{
+    MppEncRoiCtx ctx[2] = { NULL, NULL };
+    MppMeta meta[2] = { NULL, NULL };
+    RoiTrace *trace = mpp_calloc(RoiTrace, ROI_CNT);
+    RoiRegionCfg *regions = mpp_calloc(RoiRegionCfg, ROI_CNT);
+    RefRoi ref;
+    RK_S64 time[3] = { 0, 0, 0 };
+    MPP_RET ret = MPP_NOK;
+    RK_S32 i, j, k;
+
+    if (ref_init(&ref, ROI_WIDTH, ROI_HEIGHT, type, roi_type) || !trace || !regions)
+        goto DONE;
+
+    srand(0x1234);
+    init_trace(trace);
+
+    mpp_env_set_u32("roi_type", roi_type);
+    for (i = 0; i < 2; i++) {
+        /* context 0 rebuilds whole map each frame, context 1 is incremental */
+        mpp_env_set_u32("roi_full_update", !i);
+        if (mpp_enc_roi_init(&ctx[i], ROI_WIDTH, ROI_HEIGHT, type, ROI_CNT))
+            goto DONE;
+        mpp_meta_get(&meta[i]);
+    }
+    mpp_env_set_u32("roi_full_update", 0);
+
+    for (k = 0; k < ROI_FRAMES; k++) {
+        RK_S32 cnt = step_trace(trace, k, regions);
+        MppEncROICfg2 *cfg[2];
+        RK_S64 ref_start;
+
+        for (i = 0; i < 2; i++) {
+            RK_S64 start = mpp_time();
+
+            for (j = 0; j < cnt; j++)
+                mpp_enc_roi_add_region(ctx[i], &regions[j]);
+
+            mpp_enc_roi_setup_meta(ctx[i], meta[i]);
+            time[i] += mpp_time() - start;
+
+            mpp_meta_get_ptr(meta[i], KEY_ROI_DATA2, (void **)&cfg[i]);
+        }
+
+        ref_start = mpp_time();
+        ref_setup(&ref, regions, cnt);
+        time[2] += mpp_time() - ref_start;
+
+        /* both ways must match the reference generation */
+        for (i = 0; i < 2; i++) {
+            if (cmp_ref_buf(cfg[i]->base_cfg_buf, ref.dst_base, ref.base_cfg_size) ||
+                cmp_ref_buf(cfg[i]->qp_cfg_buf, ref.dst_qp, ref.qp_cfg_size)) {
+                mpp_err("roi type %d coding %d frame %d %s mismatch with reference\n",
+                        roi_type, type, k, i ? "incremental" : "full");
+                goto DONE;
+            }
+        }
+
+        if (cmp_roi_buf(cfg[0]->base_cfg_buf, cfg[1]->base_cfg_buf) ||
+            cmp_roi_buf(cfg[0]->qp_cfg_buf, cfg[1]->qp_cfg_buf)) {
+            mpp_err("roi type %d coding %d frame %d mismatch\n", roi_type, type, k);
+            goto DONE;
+        }
+    }
+
+    mpp_log("roi type %d %s %d regions %dx%d reference %.1f us full %.1f us incremental %.1f us per frame\n",
+            roi_type, type == MPP_VIDEO_CodingAVC ? "h264" : "h265", ROI_CNT,
+            ROI_WIDTH, ROI_HEIGHT, (float)time[2] / ROI_FRAMES,
+            (float)time[0] / ROI_FRAMES, (float)time[1] / ROI_FRAMES);
+    ret = MPP_OK;
+
+DONE:
+    for (i = 0; i < 2; i++) {
+        if (ctx[i])
+            mpp_enc_roi_deinit(ctx[i]);
+        if (meta[i])
+            mpp_meta_put(meta[i]);
+    }
+    ref_deinit(&ref);
+    MPP_FREE(trace);
+    MPP_FREE(regions);
+
+    return ret;
+}
+
+int main()
+{
+    MPP_RET ret = MPP_OK;
+
+    /* roi buffers from cpu memory when there is no encoder device */
+    mpp_env_set_u32("mpp_null_dev", 1);
+
+    /* rv1126 / rk356x roi and rk3588 roi */
+    ret |= test_roi(1, MPP_VIDEO_CodingAVC);
+    ret |= test_roi(1, MPP_VIDEO_CodingHEVC);
+    ret |= test_roi(2, MPP_VIDEO_CodingAVC);
+    ret |= test_roi(2, MPP_VIDEO_CodingHEVC);
+
+    mpp_log("mpp_enc_roi_test %s\n", ret ? "failed" : "success");
+
+    return ret;
+}
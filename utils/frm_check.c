@@ -0,0 +1,626 @@
+/* SPDX-License-Identifier: Apache-2.0 OR MIT */
+/*
+ * Copyright (c) 2024 Rockchip Electronics Co., Ltd.
+ */
+
+#define MODULE_TAG "frm_check"
+
+#include <string.h>
+#include <pthread.h>
+
+#if defined(__x86_64__)
+#include <nmmintrin.h>
+#elif defined(__aarch64__) && defined(__linux__)
+#include <arm_acle.h>
+#include <sys/auxv.h>
+#ifndef HWCAP_CRC32
+#define HWCAP_CRC32     (1 << 7)
+#endif
+#define FRM_CHECK_ARM_CRC
+#endif
+
+#include "mpp_mem.h"
+#include "mpp_log.h"
+#include "mpp_common.h"
+#include "mpp_buffer.h"
+
+#include "utils.h"
+#include "frm_check.h"
+#include "frm_worker.h"
+
+#define FRM_CHECK_QUEUE_LEN     4
+
+/*
+ * One Y / U / V component of the frame. The checksum runs on the component
+ * in planar order, one byte per 8bit sample or 16bit little endian per 10bit
+ * sample, which is the same as the md5 of reference decoders.
+ */
+typedef struct FrmPlane_t {
+    RK_U8           *ptr;
+    RK_U32          width;      /* in sample */
+    RK_U32          height;
+    RK_U32          stride;     /* in byte */
+    /* sample interleave step and offset, 2 and 0 / 1 for semi-planar chroma */
+    RK_U32          step;
+    RK_U32          offset;
+    RK_U32          bit10;
+} FrmPlane;
+
+typedef struct FrmCheckImpl_t {
+    FILE            *fp;
+    FrmCheckType    type;
+    RK_U32          frame_count;
+
+    /* legacy sum / xor record */
+    FrmCrc          crc;
+    /* line buffer for chroma deinterleave and 10bit unpack */
+    RK_U8           *line;
+    RK_U32          line_size;
+
+    /* async worker, NULL in sync mode */
+    FrmWorker       worker;
+} FrmCheckImpl;
+
+static const char *frm_check_names[FRM_CHECK_BUTT] = {
+    "sum",
+    "crc32c",
+    "md5",
+};
+
+/* ------------------------------------------------------------------------
+ * crc32c (Castagnoli) with slice-by-8 table and hardware instruction
+ * ------------------------------------------------------------------------ */
+#define CRC32C_POLY     0x82F63B78
+
+static RK_U32 crc32c_table[8][256];
+static pthread_once_t crc32c_once = PTHREAD_ONCE_INIT;
+static RK_U32 crc32c_hw = 0;
+
+static void crc32c_table_init(void)
+{
+    RK_U32 i, j;
+
+    for (i = 0; i < 256; i++) {
+        RK_U32 crc = i;
+
+        for (j = 0; j < 8; j++)
+            crc = (crc >> 1) ^ ((crc & 1) ? CRC32C_POLY : 0);
+
+        crc32c_table[0][i] = crc;
+    }
+
+    for (i = 0; i < 256; i++) {
+        for (j = 1; j < 8; j++)
+            crc32c_table[j][i] = (crc32c_table[j - 1][i] >> 8) ^
+                                 crc32c_table[0][crc32c_table[j - 1][i] & 0xff];
+    }
+
+#if defined(__x86_64__)
+    crc32c_hw = __builtin_cpu_supports("sse4.2");
+#elif defined(FRM_CHECK_ARM_CRC)
+    crc32c_hw = (getauxval(AT_HWCAP) & HWCAP_CRC32) ? 1 : 0;
+#endif
+}
+
+static RK_U32 crc32c_sw(RK_U32 crc, const RK_U8 *buf, size_t len)
+{
+    while (len && ((uintptr_t)buf & 7)) {
+        crc = (crc >> 8) ^ crc32c_table[0][(crc ^ *buf++) & 0xff];
+        len--;
+    }
+
+    while (len >= 8) {
+        RK_U32 lo = crc ^ (buf[0] | buf[1] << 8 | buf[2] << 16 | (RK_U32)buf[3] << 24);
+        RK_U32 hi = buf[4] | buf[5] << 8 | buf[6] << 16 | (RK_U32)buf[7] << 24;
+
+        crc = crc32c_table[7][lo & 0xff] ^ crc32c_table[6][(lo >> 8) & 0xff] ^
+              crc32c_table[5][(lo >> 16) & 0xff] ^ crc32c_table[4][lo >> 24] ^
+              crc32c_table[3][hi & 0xff] ^ crc32c_table[2][(hi >> 8) & 0xff] ^
+              crc32c_table[1][(hi >> 16) & 0xff] ^ crc32c_table[0][hi >> 24];
+        buf += 8;
+        len -= 8;
+    }
+
+    while (len--)
+        crc = (crc >> 8) ^ crc32c_table[0][(crc ^ *buf++) & 0xff];
+
+    return crc;
+}
+
+#if defined(__x86_64__)
+__attribute__((target("sse4.2")))
+static RK_U32 crc32c_hw_calc(RK_U32 crc, const RK_U8 *buf, size_t len)
+{
+    RK_U64 crc64;
+
+    while (len && ((uintptr_t)buf & 7)) {
+        crc = _mm_crc32_u8(crc, *buf++);
+        len--;
+    }
+
+    crc64 = crc;
+    while (len >= 8) {
+        crc64 = _mm_crc32_u64(crc64, *(const RK_U64 *)buf);
+        buf += 8;
+        len -= 8;
+    }
+    crc = (RK_U32)crc64;
+
+    while (len--)
+        crc = _mm_crc32_u8(crc, *buf++);
+
+    return crc;
+}
+#elif defined(FRM_CHECK_ARM_CRC)
+__attribute__((target("+crc")))
+static RK_U32 crc32c_hw_calc(RK_U32 crc, const RK_U8 *buf, size_t len)
+{
+    while (len && ((uintptr_t)buf & 7)) {
+        crc = __crc32cb(crc, *buf++);
+        len--;
+    }
+
+    while (len >= 8) {
+        crc = __crc32cd(crc, *(const RK_U64 *)buf);
+        buf += 8;
+        len -= 8;
+    }
+
+    while (len--)
+        crc = __crc32cb(crc, *buf++);
+
+    return crc;
+}
+#else
+static RK_U32 crc32c_hw_calc(RK_U32 crc, const RK_U8 *buf, size_t len)
+{
+    return crc32c_sw(crc, buf, len);
+}
+#endif
+
+RK_U32 frm_check_crc32c(RK_U32 crc, const RK_U8 *buf, size_t len)
+{
+    pthread_once(&crc32c_once, crc32c_table_init);
+
+    crc = ~crc;
+    crc = crc32c_hw ? crc32c_hw_calc(crc, buf, len) : crc32c_sw(crc, buf, len);
+
+    return ~crc;
+}
+
+/* ------------------------------------------------------------------------
+ * md5 (RFC 1321)
+ * ------------------------------------------------------------------------ */
+typedef struct Md5Ctx_t {
+    RK_U32          state[4];
+    RK_U64          len;
+    RK_U8           buf[64];
+} Md5Ctx;
+
+static const RK_U32 md5_k[64] = {
+    0xd76aa478, 0xe8c7b756, 0x242070db, 0xc1bdceee, 0xf57c0faf, 0x4787c62a, 0xa8304613, 0xfd469501,
+    0x698098d8, 0x8b44f7af, 0xffff5bb1, 0x895cd7be, 0x6b901122, 0xfd987193, 0xa679438e, 0x49b40821,
+    0xf61e2562, 0xc040b340, 0x265e5a51, 0xe9b6c7aa, 0xd62f105d, 0x02441453, 0xd8a1e681, 0xe7d3fbc8,
+    0x21e1cde6, 0xc33707d6, 0xf4d50d87, 0x455a14ed, 0xa9e3e905, 0xfcefa3f8, 0x676f02d9, 0x8d2a4c8a,
+    0xfffa3942, 0x8771f681, 0x6d9d6122, 0xfde5380c, 0xa4beea44, 0x4bdecfa9, 0xf6bb4b60, 0xbebfbc70,
+    0x289b7ec6, 0xeaa127fa, 0xd4ef3085, 0x04881d05, 0xd9d4d039, 0xe6db99e5, 0x1fa27cf8, 0xc4ac5665,
+    0xf4292244, 0x432aff97, 0xab9423a7, 0xfc93a039, 0x655b59c3, 0x8f0ccc92, 0xffeff47d, 0x85845dd1,
+    0x6fa87e4f, 0xfe2ce6e0, 0xa3014314, 0x4e0811a1, 0xf7537e82, 0xbd3af235, 0x2ad7d2bb, 0xeb86d391,
+};
+
+static const RK_U8 md5_r[64] = {
+    7, 12, 17, 22, 7, 12, 17, 22, 7, 12, 17, 22, 7, 12, 17, 22,
+    5,  9, 14, 20, 5,  9, 14, 20, 5,  9, 14, 20, 5,  9, 14, 20,
+    4, 11, 16, 23, 4, 11, 16, 23, 4, 11, 16, 23, 4, 11, 16, 23,
+    6, 10, 15, 21, 6, 10, 15, 21, 6, 10, 15, 21, 6, 10, 15, 21,
+};
+
+static void md5_block(Md5Ctx *ctx, const RK_U8 *blk)
+{
+    RK_U32 a = ctx->state[0];
+    RK_U32 b = ctx->state[1];
+    RK_U32 c = ctx->state[2];
+    RK_U32 d = ctx->state[3];
+    RK_U32 w[16];
+    RK_U32 i;
+
+    for (i = 0; i < 16; i++)
+        w[i] = blk[i * 4] | blk[i * 4 + 1] << 8 | blk[i * 4 + 2] << 16 | (RK_U32)blk[i * 4 + 3] << 24;
+
+    for (i = 0; i < 64; i++) {
+        RK_U32 f, g, tmp;
+
+        if (i < 16) {
+            f = (b & c) | (~b & d);
+            g = i;
+        } else if (i < 32) {
+            f = (d & b) | (~d & c);
+            g = (5 * i + 1) & 15;
+        } else if (i < 48) {
+            f = b ^ c ^ d;
+            g = (3 * i + 5) & 15;
+        } else {
+            f = c ^ (b | ~d);
+            g = (7 * i) & 15;
+        }
+
+        tmp = d;
+        d = c;
+        c = b;
+        f += a + md5_k[i] + w[g];
+        b += (f << md5_r[i]) | (f >> (32 - md5_r[i]));
+        a = tmp;
+    }
+
+    ctx->state[0] += a;
+    ctx->state[1] += b;
+    ctx->state[2] += c;
+    ctx->state[3] += d;
+}
+
+static void md5_init(Md5Ctx *ctx)
+{
+    ctx->state[0] = 0x67452301;
+    ctx->state[1] = 0xefcdab89;
+    ctx->state[2] = 0x98badcfe;
+    ctx->state[3] = 0x10325476;
+    ctx->len = 0;
+}
+
+static void md5_update(Md5Ctx *ctx, const RK_U8 *buf, size_t len)
+{
+    RK_U32 used = ctx->len & 63;
+
+    ctx->len += len;
+
+    if (used) {
+        RK_U32 fill = MPP_MIN(64 - used, len);
+
+        memcpy(ctx->buf + used, buf, fill);
+        buf += fill;
+        len -= fill;
+        if (used + fill < 64)
+            return;
+
+        md5_block(ctx, ctx->buf);
+    }
+
+    while (len >= 64) {
+        md5_block(ctx, buf);
+        buf += 64;
+        len -= 64;
+    }
+
+    if (len)
+        memcpy(ctx->buf, buf, len);
+}
+
+static void md5_final(Md5Ctx *ctx, RK_U8 digest[16])
+{
+    RK_U64 bits = ctx->len << 3;
+    RK_U8 pad[72] = { 0x80 };
+    RK_U32 used = ctx->len & 63;
+    /* 0x80 and zero padding up to 56 bytes in the last block */
+    RK_U32 pad_len = (used < 56) ? (56 - used) : (120 - used);
+    RK_U32 i;
+
+    for (i = 0; i < 8; i++)
+        pad[pad_len + i] = (RK_U8)(bits >> (i * 8));
+
+    md5_update(ctx, pad, pad_len + 8);
+
+    for (i = 0; i < 16; i++)
+        digest[i] = (RK_U8)(ctx->state[i / 4] >> ((i & 3) * 8));
+}
+
+void frm_check_md5(const RK_U8 *buf, size_t len, RK_U8 digest[16])
+{
+    Md5Ctx ctx;
+
+    md5_init(&ctx);
+    md5_update(&ctx, buf, len);
+    md5_final(&ctx, digest);
+}
+
+/* ------------------------------------------------------------------------
+ * frame plane walker and engines
+ * ------------------------------------------------------------------------ */
+static void frm_set_plane(FrmPlane *plane, RK_U8 *ptr, RK_U32 width, RK_U32 height,
+                          RK_U32 stride, RK_U32 step, RK_U32 offset, RK_U32 bit10)
+{
+    plane->ptr = ptr;
+    plane->width = width;
+    plane->height = height;
+    plane->stride = stride;
+    plane->step = step;
+    plane->offset = offset;
+    plane->bit10 = bit10;
+}
+
+/* split frame into Y / U / V components, return component count */
+static RK_S32 frm_get_planes(MppFrame frame, FrmPlane planes[3])
+{
+    MppFrameFormat fmt = mpp_frame_get_fmt(frame) & MPP_FRAME_FMT_MASK;
+    RK_U32 width = mpp_frame_get_width(frame);
+    RK_U32 height = mpp_frame_get_height(frame);
+    RK_U32 h_stride = mpp_frame_get_hor_stride(frame);
+    RK_U32 v_stride = mpp_frame_get_ver_stride(frame);
+    RK_U8 *base = (RK_U8 *)mpp_buffer_get_ptr(mpp_frame_get_buffer(frame));
+    RK_U8 *chroma = base + h_stride * v_stride;
+    RK_U32 bit10 = MPP_FRAME_FMT_IS_YUV_10BIT(fmt) ? 1 : 0;
+    RK_U32 c_w = width / 2;
+    RK_U32 c_h = height / 2;
+    RK_U32 swap = 0;
+
+    if (NULL == base)
+        return 0;
+
+    frm_set_plane(&planes[0], base, width, height, h_stride, 1, 0, bit10);
+
+    switch (fmt) {
+    case MPP_FMT_YUV400 : {
+        return 1;
+    } break;
+    case MPP_FMT_YUV420P :
+    case MPP_FMT_YUV422P :
+    case MPP_FMT_YUV444P : {
+        RK_U32 c_stride = h_stride / 2;
+        RK_U32 c_v_stride = v_stride / 2;
+
+        if (fmt == MPP_FMT_YUV422P) {
+            c_h = height;
+            c_v_stride = v_stride;
+        } else if (fmt == MPP_FMT_YUV444P) {
+            c_w = width;
+            c_h = height;
+            c_stride = h_stride;
+            c_v_stride = v_stride;
+        }
+
+        frm_set_plane(&planes[1], chroma, c_w, c_h, c_stride, 1, 0, 0);
+        frm_set_plane(&planes[2], chroma + c_stride * c_v_stride, c_w, c_h, c_stride, 1, 0, 0);
+        return 3;
+    } break;
+    case MPP_FMT_YUV420SP_VU : {
+        swap = 1;
+    } break;
+    case MPP_FMT_YUV422SP_VU : {
+        swap = 1;
+        c_h = height;
+    } break;
+    case MPP_FMT_YUV422SP :
+    case MPP_FMT_YUV422SP_10BIT : {
+        c_h = height;
+    } break;
+    case MPP_FMT_YUV440SP : {
+        c_w = width;
+    } break;
+    case MPP_FMT_YUV411SP : {
+        c_w = width / 4;
+        c_h = height;
+    } break;
+    case MPP_FMT_YUV444SP : {
+        c_w = width;
+        c_h = height;
+    } break;
+    default : {
+    } break;
+    }
+
+    /* semi-planar interleaved chroma in U then V order */
+    frm_set_plane(&planes[1], chroma, c_w, c_h, h_stride, 2, swap, bit10);
+    frm_set_plane(&planes[2], chroma, c_w, c_h, h_stride, 2, !swap, bit10);
+
+    return 3;
+}
+
+/* return one line of the component in checksum layout */
+static const RK_U8 *frm_get_line(FrmCheckImpl *p, FrmPlane *plane, RK_U32 y, RK_U32 *size)
+{
+    const RK_U8 *src = plane->ptr + y * plane->stride;
+    RK_U8 *dst = p->line;
+    RK_U32 x;
+
+    if (!plane->bit10) {
+        *size = plane->width;
+        if (plane->step == 1)
+            return src;
+
+        for (x = 0; x < plane->width; x++)
+            dst[x] = src[x * plane->step + plane->offset];
+
+        return dst;
+    }
+
+    /* 10bit samples are packed from lsb without padding */
+    for (x = 0; x < plane->width; x++) {
+        RK_U32 pos = (x * plane->step + plane->offset) * 10;
+        RK_U32 val = ((src[pos >> 3] | src[(pos >> 3) + 1] << 8) >> (pos & 7)) & 0x3ff;
+
+        dst[x * 2] = (RK_U8)val;
+        dst[x * 2 + 1] = (RK_U8)(val >> 8);
+    }
+    *size = plane->width * 2;
+
+    return dst;
+}
+
+static RK_S32 frm_check_prepare(FrmCheckImpl *p, MppFrame frame, FrmPlane planes[3])
+{
+    RK_S32 count = frm_get_planes(frame, planes);
+    /* luma is the widest component */
+    RK_U32 size = count ? planes[0].width * 2 : 0;
+
+    if (p->line_size < size) {
+        MPP_FREE(p->line);
+        p->line = mpp_malloc(RK_U8, size);
+        p->line_size = p->line ? size : 0;
+        if (NULL == p->line)
+            return 0;
+    }
+
+    return count;
+}
+
+static void frm_check_crc32c_calc(FrmCheckImpl *p, MppFrame frame)
+{
+    FrmPlane planes[3];
+    RK_S32 count = frm_check_prepare(p, frame, planes);
+    RK_S32 i;
+    RK_U32 y;
+
+    fprintf(p->fp, "%08d", p->frame_count);
+    for (i = 0; i < count; i++) {
+        FrmPlane *plane = &planes[i];
+        RK_U32 crc = 0;
+        RK_U32 size = 0;
+
+        for (y = 0; y < plane->height; y++) {
+            const RK_U8 *line = frm_get_line(p, plane, y, &size);
+
+            crc = frm_check_crc32c(crc, line, size);
+        }
+
+        fprintf(p->fp, ", %d, %08x", size * plane->height, crc);
+    }
+    fprintf(p->fp, "\n");
+}
+
+static void frm_check_md5_calc(FrmCheckImpl *p, MppFrame frame)
+{
+    FrmPlane planes[3];
+    RK_S32 count = frm_check_prepare(p, frame, planes);
+    RK_S32 i;
+    RK_U32 x, y;
+
+    fprintf(p->fp, "%08d", p->frame_count);
+    for (i = 0; i < count; i++) {
+        FrmPlane *plane = &planes[i];
+        RK_U8 digest[16];
+        Md5Ctx ctx;
+
+        md5_init(&ctx);
+        for (y = 0; y < plane->height; y++) {
+            RK_U32 size = 0;
+            const RK_U8 *line = frm_get_line(p, plane, y, &size);
+
+            md5_update(&ctx, line, size);
+        }
+        md5_final(&ctx, digest);
+
+        fprintf(p->fp, " ");
+        for (x = 0; x < 16; x++)
+            fprintf(p->fp, "%02x", digest[x]);
+    }
+    fprintf(p->fp, "\n");
+}
+
+static void frm_check_calc(void *ctx, MppFrame frame)
+{
+    FrmCheckImpl *p = (FrmCheckImpl *)ctx;
+
+    switch (p->type) {
+    case FRM_CHECK_CRC32C : {
+        frm_check_crc32c_calc(p, frame);
+    } break;
+    case FRM_CHECK_MD5 : {
+        frm_check_md5_calc(p, frame);
+    } break;
+    default : {
+        calc_frm_crc(frame, &p->crc);
+        write_frm_crc(p->fp, &p->crc);
+    } break;
+    }
+
+    p->frame_count++;
+}
+
+MPP_RET frm_check_init(FrmCheck *ctx, FILE *fp, FrmCheckType type, RK_U32 async)
+{
+    FrmCheckImpl *p = NULL;
+
+    if (NULL == ctx || NULL == fp || type >= FRM_CHECK_BUTT) {
+        mpp_err_f("invalid input ctx %p fp %p type %d\n", ctx, fp, type);
+        return MPP_ERR_NULL_PTR;
+    }
+
+    *ctx = NULL;
+
+    p = mpp_calloc(FrmCheckImpl, 1);
+    if (NULL == p) {
+        mpp_err_f("failed to malloc context\n");
+        return MPP_ERR_MALLOC;
+    }
+
+    p->fp = fp;
+    p->type = type;
+
+    if (type == FRM_CHECK_SUM) {
+        p->crc.luma.sum = mpp_calloc(RK_ULONG, 512);
+        p->crc.chroma.sum = mpp_calloc(RK_ULONG, 512);
+        if (NULL == p->crc.luma.sum || NULL == p->crc.chroma.sum)
+            goto FAILED;
+    }
+
+    if (async && frm_worker_init(&p->worker, frm_check_calc, p, FRM_CHECK_QUEUE_LEN, 0))
+        mpp_err_f("failed to create worker, fallback to sync mode\n");
+
+    *ctx = p;
+    return MPP_OK;
+
+FAILED:
+    MPP_FREE(p->crc.luma.sum);
+    MPP_FREE(p->crc.chroma.sum);
+    MPP_FREE(p);
+    return MPP_ERR_MALLOC;
+}
+
+MPP_RET frm_check_deinit(FrmCheck ctx)
+{
+    FrmCheckImpl *p = (FrmCheckImpl *)ctx;
+
+    if (NULL == p)
+        return MPP_ERR_NULL_PTR;
+
+    if (p->worker) {
+        frm_worker_deinit(p->worker, NULL);
+        p->worker = NULL;
+    }
+
+    fflush(p->fp);
+
+    MPP_FREE(p->crc.luma.sum);
+    MPP_FREE(p->crc.chroma.sum);
+    MPP_FREE(p->line);
+    MPP_FREE(p);
+
+    return MPP_OK;
+}
+
+MPP_RET frm_check_put(FrmCheck ctx, MppFrame frame)
+{
+    FrmCheckImpl *p = (FrmCheckImpl *)ctx;
+
+    if (NULL == p || NULL == frame)
+        return MPP_ERR_NULL_PTR;
+
+    if (p->worker)
+        return frm_worker_put(p->worker, frame);
+
+    frm_check_calc(p, frame);
+    return MPP_OK;
+}
+
+MPP_RET name_to_frm_check_type(const char *name, FrmCheckType *type)
+{
+    RK_U32 i;
+
+    for (i = 0; i < FRM_CHECK_BUTT; i++) {
+        if (!strcmp(name, frm_check_names[i])) {
+            *type = (FrmCheckType)i;
+            return MPP_OK;
+        }
+    }
+
+    return MPP_NOK;
+}
@@ -0,0 +1,48 @@
+/* SPDX-License-Identifier: Apache-2.0 OR MIT */
+/*
+ * Copyright (c) 2024 Rockchip Electronics Co., Ltd.
+ */
+
+#ifndef __FRM_CHECK_H__
+#define __FRM_CHECK_H__
+
+#include <stdio.h>
+
+#include "mpp_frame.h"
+
+typedef enum FrmCheckType_e {
+    /* legacy slt format: word sum per group and xor, see calc_frm_crc */
+    FRM_CHECK_SUM,
+    /* crc32c of luma and chroma plane */
+    FRM_CHECK_CRC32C,
+    /* md5 of each Y / U / V plane in planar order without stride padding */
+    FRM_CHECK_MD5,
+    FRM_CHECK_BUTT,
+} FrmCheckType;
+
+typedef void* FrmCheck;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Frame checksum engine writing one line per frame to fp.
+ * With async enabled the checksum is calculated on a worker thread which
+ * keeps a reference of the frame buffer until the frame is done.
+ */
+MPP_RET frm_check_init(FrmCheck *ctx, FILE *fp, FrmCheckType type, RK_U32 async);
+/* flush pending frames then release */
+MPP_RET frm_check_deinit(FrmCheck ctx);
+MPP_RET frm_check_put(FrmCheck ctx, MppFrame frame);
+
+MPP_RET name_to_frm_check_type(const char *name, FrmCheckType *type);
+
+RK_U32 frm_check_crc32c(RK_U32 crc, const RK_U8 *buf, size_t len);
+void frm_check_md5(const RK_U8 *buf, size_t len, RK_U8 digest[16]);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __FRM_CHECK_H__ */
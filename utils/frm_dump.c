@@ -0,0 +1,428 @@
+/* SPDX-License-Identifier: Apache-2.0 OR MIT */
+/*
+ * Copyright (c) 2024 Rockchip Electronics Co., Ltd.
+ */
+
+#define MODULE_TAG "frm_dump"
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/uio.h>
+
+#include "mpp_mem.h"
+#include "mpp_log.h"
+#include "mpp_time.h"
+#include "mpp_common.h"
+#include "mpp_buffer.h"
+
+#include "frm_dump.h"
+#include "frm_worker.h"
+
+#define FRM_DUMP_QUEUE_DEFAULT  4
+#define FRM_DUMP_PREALLOC_DEF   16
+#define FRM_DUMP_IOV_MAX        256
+
+typedef struct FrmDumpImpl_t {
+    FILE            *fp;
+    RK_S32          fd;
+    FrmDumpCfg      cfg;
+
+    /* staging buffer for format conversion */
+    RK_U8           *stage;
+    size_t          stage_size;
+    struct iovec    iov[FRM_DUMP_IOV_MAX];
+    RK_S32          iov_cnt;
+
+    FrmWorker       worker;
+
+    /* file space reserved ahead of the write position */
+    RK_S64          file_start;
+    RK_S64          alloc_end;
+    RK_S64          frame_size;
+
+    /* statistic */
+    RK_S64          write_bytes;
+    RK_S64          write_time;
+} FrmDumpImpl;
+
+static MPP_RET dump_write(FrmDumpImpl *p, const void *buf, size_t size)
+{
+    const RK_U8 *ptr = (const RK_U8 *)buf;
+
+    while (size) {
+        ssize_t ret = write(p->fd, ptr, size);
+
+        if (ret < 0) {
+            if (errno == EINTR)
+                continue;
+
+            mpp_err_f("write failed %s\n", strerror(errno));
+            return MPP_NOK;
+        }
+
+        ptr += ret;
+        size -= ret;
+        p->write_bytes += ret;
+    }
+
+    return MPP_OK;
+}
+
+static MPP_RET dump_iov_flush(FrmDumpImpl *p)
+{
+    struct iovec *iov = p->iov;
+    RK_S32 cnt = p->iov_cnt;
+
+    while (cnt) {
+        ssize_t ret = writev(p->fd, iov, cnt);
+
+        if (ret < 0) {
+            if (errno == EINTR)
+                continue;
+
+            mpp_err_f("writev failed %s\n", strerror(errno));
+            p->iov_cnt = 0;
+            return MPP_NOK;
+        }
+
+        p->write_bytes += ret;
+
+        /* skip the written part on short write */
+        while (cnt && (size_t)ret >= iov->iov_len) {
+            ret -= iov->iov_len;
+            iov++;
+            cnt--;
+        }
+
+        if (cnt) {
+            iov->iov_base = (RK_U8 *)iov->iov_base + ret;
+            iov->iov_len -= ret;
+        }
+    }
+
+    p->iov_cnt = 0;
+    return MPP_OK;
+}
+
+/* gather rows of a plane, adjacent rows without stride padding are merged */
+static MPP_RET dump_rows(FrmDumpImpl *p, RK_U8 *base, RK_U32 width, RK_U32 height, RK_U32 stride)
+{
+    RK_U32 i;
+
+    if (!width || !height)
+        return MPP_OK;
+
+    if (width == stride) {
+        width *= height;
+        height = 1;
+    }
+
+    for (i = 0; i < height; i++, base += stride) {
+        struct iovec *iov;
+
+        if (p->iov_cnt >= FRM_DUMP_IOV_MAX && dump_iov_flush(p))
+            return MPP_NOK;
+
+        iov = &p->iov[p->iov_cnt++];
+        iov->iov_base = base;
+        iov->iov_len = width;
+    }
+
+    return MPP_OK;
+}
+
+static RK_U8 *dump_get_stage(FrmDumpImpl *p, size_t size)
+{
+    if (p->stage_size < size) {
+        MPP_FREE(p->stage);
+        p->stage = mpp_malloc(RK_U8, size);
+        p->stage_size = p->stage ? size : 0;
+        if (NULL == p->stage)
+            mpp_err_f("failed to malloc stage buffer size %d\n", (RK_S32)size);
+    }
+
+    return p->stage;
+}
+
+/* split interleaved chroma line, written as plain loop for compiler vectorization */
+static void split_uv(RK_U8 *restrict dst_u, RK_U8 *restrict dst_v,
+                     const RK_U8 *restrict src, RK_U32 count)
+{
+    RK_U32 i;
+
+    for (i = 0; i < count; i++) {
+        dst_u[i] = src[2 * i + 0];
+        dst_v[i] = src[2 * i + 1];
+    }
+}
+
+/* unpack 10bit little endian compact samples to 16bit, 4 samples in 5 bytes */
+static void unpack_10bit(RK_U16 *restrict dst, const RK_U8 *restrict src, RK_U32 count)
+{
+    RK_U32 i;
+
+    for (i = 0; i + 4 <= count; i += 4, src += 5) {
+        RK_U64 val = (RK_U64)src[0] | (RK_U64)src[1] << 8 | (RK_U64)src[2] << 16 |
+                     (RK_U64)src[3] << 24 | (RK_U64)src[4] << 32;
+
+        dst[i + 0] = val & 0x3ff;
+        dst[i + 1] = (val >> 10) & 0x3ff;
+        dst[i + 2] = (val >> 20) & 0x3ff;
+        dst[i + 3] = (val >> 30) & 0x3ff;
+    }
+
+    if (i < count) {
+        RK_U64 val = 0;
+        RK_U32 bytes = ((count - i) * 10 + 7) / 8;
+        RK_U32 k;
+
+        for (k = 0; k < bytes; k++)
+            val |= (RK_U64)src[k] << (k * 8);
+
+        for (k = 0; i < count; i++, k++)
+            dst[i] = (val >> (k * 10)) & 0x3ff;
+    }
+}
+
+static MPP_RET dump_split_plane(FrmDumpImpl *p, RK_U8 *base, RK_U32 count,
+                                RK_U32 height, RK_U32 stride)
+{
+    size_t size = (size_t)count * height;
+    RK_U8 *dst_u = dump_get_stage(p, size * 2);
+    RK_U8 *dst_v = dst_u + size;
+    RK_U32 i;
+
+    if (NULL == dst_u)
+        return MPP_ERR_MALLOC;
+
+    for (i = 0; i < height; i++, base += stride)
+        split_uv(dst_u + i * count, dst_v + i * count, base, count);
+
+    return dump_write(p, dst_u, size * 2);
+}
+
+static MPP_RET dump_10bit_plane(FrmDumpImpl *p, RK_U8 *base, RK_U32 width,
+                                RK_U32 height, RK_U32 stride)
+{
+    size_t line = (size_t)width * sizeof(RK_U16);
+    RK_U16 *dst = (RK_U16 *)dump_get_stage(p, line * height);
+    RK_U32 i;
+
+    if (NULL == dst)
+        return MPP_ERR_MALLOC;
+
+    for (i = 0; i < height; i++, base += stride)
+        unpack_10bit(dst + i * width, base, width);
+
+    return dump_write(p, dst, line * height);
+}
+
+/*
+ * Reserve disk space for next frames without changing the file size so the
+ * filesystem does not allocate blocks on each write. Stop on the first
+ * failure, pipe and some filesystems do not support it.
+ */
+static void dump_prealloc(FrmDumpImpl *p)
+{
+#ifdef FALLOC_FL_KEEP_SIZE
+    RK_S64 pos = p->file_start + p->write_bytes;
+    RK_S64 size;
+
+    if (!p->cfg.prealloc || !p->frame_size || pos + p->frame_size <= p->alloc_end)
+        return;
+
+    size = p->frame_size * p->cfg.prealloc;
+    if (fallocate(p->fd, FALLOC_FL_KEEP_SIZE, pos, size)) {
+        mpp_log_f("stop preallocation on %s\n", strerror(errno));
+        p->cfg.prealloc = 0;
+        return;
+    }
+
+    p->alloc_end = pos + size;
+#else
+    (void)p;
+#endif
+}
+
+static MPP_RET dump_frame(FrmDumpImpl *p, MppFrame frame)
+{
+    RK_U32 width = mpp_frame_get_width(frame);
+    RK_U32 height = mpp_frame_get_height(frame);
+    RK_U32 h_stride = mpp_frame_get_hor_stride(frame);
+    RK_U32 v_stride = mpp_frame_get_ver_stride(frame);
+    MppFrameFormat fmt = mpp_frame_get_fmt(frame);
+    MppBuffer buffer = mpp_frame_get_buffer(frame);
+    RK_U8 *base = NULL;
+    RK_U8 *base_c = NULL;
+    MPP_RET ret = MPP_OK;
+
+    if (NULL == buffer)
+        return MPP_OK;
+
+    base = (RK_U8 *)mpp_buffer_get_ptr(buffer);
+    base_c = base + h_stride * v_stride;
+
+    switch (fmt & MPP_FRAME_FMT_MASK) {
+    case MPP_FMT_YUV422SP : {
+        /* YUV422SP -> YUV422P for better display */
+        ret = dump_rows(p, base, width, height, h_stride);
+        ret |= dump_iov_flush(p);
+        if (!ret)
+            ret = dump_split_plane(p, base_c, width / 2, height, h_stride);
+    } break;
+    case MPP_FMT_YUV444SP : {
+        /* YUV444SP -> YUV444P for better display */
+        ret = dump_rows(p, base, width, height, h_stride);
+        ret |= dump_iov_flush(p);
+        if (!ret)
+            ret = dump_split_plane(p, base_c, width, height, h_stride * 2);
+    } break;
+    case MPP_FMT_YUV420SP_VU :
+    case MPP_FMT_YUV420SP : {
+        ret = dump_rows(p, base, width, height, h_stride);
+        ret |= dump_rows(p, base_c, width, height / 2, h_stride);
+    } break;
+    case MPP_FMT_YUV420P : {
+        ret = dump_rows(p, base, width, height, h_stride);
+        ret |= dump_rows(p, base_c, width / 2, height / 2, h_stride / 2);
+        base_c += h_stride / 2 * (height / 2);
+        ret |= dump_rows(p, base_c, width / 2, height / 2, h_stride / 2);
+    } break;
+    case MPP_FMT_YUV420SP_10BIT : {
+        ret = dump_10bit_plane(p, base, width, height, h_stride);
+        if (!ret)
+            ret = dump_10bit_plane(p, base_c, width, height / 2, h_stride);
+    } break;
+    case MPP_FMT_YUV400 : {
+        ret = dump_rows(p, base, width, height, h_stride);
+    } break;
+    case MPP_FMT_ARGB8888 :
+    case MPP_FMT_ABGR8888 :
+    case MPP_FMT_BGRA8888 :
+    case MPP_FMT_RGBA8888 : {
+        ret = dump_rows(p, base, width * 4, height, h_stride);
+    } break;
+    case MPP_FMT_YUV422_YUYV :
+    case MPP_FMT_YUV422_YVYU :
+    case MPP_FMT_YUV422_UYVY :
+    case MPP_FMT_YUV422_VYUY :
+    case MPP_FMT_RGB565 :
+    case MPP_FMT_BGR565 :
+    case MPP_FMT_RGB555 :
+    case MPP_FMT_BGR555 :
+    case MPP_FMT_RGB444 :
+    case MPP_FMT_BGR444 : {
+        ret = dump_rows(p, base, width * 2, height, h_stride);
+    } break;
+    case MPP_FMT_RGB888 : {
+        ret = dump_rows(p, base, width * 3, height, h_stride);
+    } break;
+    default : {
+        mpp_err("not supported format %d\n", fmt);
+    } break;
+    }
+
+    if (p->iov_cnt)
+        ret |= dump_iov_flush(p);
+
+    return ret;
+}
+
+static void frm_dump_proc(void *ctx, MppFrame frame)
+{
+    FrmDumpImpl *p = (FrmDumpImpl *)ctx;
+    RK_S64 start = mpp_time();
+    RK_S64 bytes = p->write_bytes;
+
+    dump_prealloc(p);
+    dump_frame(p, frame);
+
+    /* frame size is constant until info change, reserve with the last one */
+    p->frame_size = p->write_bytes - bytes;
+    p->write_time += mpp_time() - start;
+}
+
+MPP_RET frm_dump_init(FrmDump *ctx, FILE *fp, FrmDumpCfg *cfg)
+{
+    FrmDumpImpl *p = NULL;
+
+    if (NULL == ctx || NULL == fp) {
+        mpp_err_f("invalid input ctx %p fp %p\n", ctx, fp);
+        return MPP_ERR_NULL_PTR;
+    }
+
+    *ctx = NULL;
+
+    p = mpp_calloc(FrmDumpImpl, 1);
+    if (NULL == p) {
+        mpp_err_f("failed to malloc context\n");
+        return MPP_ERR_MALLOC;
+    }
+
+    if (cfg)
+        p->cfg = *cfg;
+    else
+        p->cfg.prealloc = FRM_DUMP_PREALLOC_DEF;
+    if (!p->cfg.queue_depth)
+        p->cfg.queue_depth = FRM_DUMP_QUEUE_DEFAULT;
+
+    /* data already in FILE buffer goes first */
+    fflush(fp);
+    p->fp = fp;
+    p->fd = fileno(fp);
+    p->file_start = lseek(p->fd, 0, SEEK_CUR);
+    if (p->file_start < 0) {
+        /* not seekable, no preallocation */
+        p->file_start = 0;
+        p->cfg.prealloc = 0;
+    }
+    p->alloc_end = p->file_start;
+
+    if (frm_worker_init(&p->worker, frm_dump_proc, p, p->cfg.queue_depth, p->cfg.drop)) {
+        MPP_FREE(p);
+        return MPP_NOK;
+    }
+
+    *ctx = p;
+    return MPP_OK;
+}
+
+MPP_RET frm_dump_deinit(FrmDump ctx)
+{
+    FrmDumpImpl *p = (FrmDumpImpl *)ctx;
+    FrmWorkerStat stat;
+
+    if (NULL == p)
+        return MPP_ERR_NULL_PTR;
+
+    frm_worker_deinit(p->worker, &stat);
+
+    mpp_log("dump %d frames %lld bytes write %lld ms wait %lld ms drop %d\n",
+            stat.frame_count, p->write_bytes, p->write_time / 1000,
+            stat.wait_time / 1000, stat.drop_count);
+
+    MPP_FREE(p->stage);
+    MPP_FREE(p);
+
+    return MPP_OK;
+}
+
+MPP_RET frm_dump_put(FrmDump ctx, MppFrame frame)
+{
+    FrmDumpImpl *p = (FrmDumpImpl *)ctx;
+
+    if (NULL == p || NULL == frame)
+        return MPP_ERR_NULL_PTR;
+
+    if (NULL == mpp_frame_get_buffer(frame))
+        return MPP_OK;
+
+    return frm_worker_put(p->worker, frame);
+}
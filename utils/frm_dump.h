@@ -0,0 +1,43 @@
+/* SPDX-License-Identifier: Apache-2.0 OR MIT */
+/*
+ * Copyright (c) 2024 Rockchip Electronics Co., Ltd.
+ */
+
+#ifndef __FRM_DUMP_H__
+#define __FRM_DUMP_H__
+
+#include <stdio.h>
+
+#include "mpp_frame.h"
+
+typedef struct FrmDumpCfg_t {
+    /* max frames pending for write, 0 for default */
+    RK_U32          queue_depth;
+    /* drop new frame on full queue instead of blocking the caller */
+    RK_U32          drop;
+    /* frames of file space reserved ahead of writing, 0 to disable */
+    RK_U32          prealloc;
+} FrmDumpCfg;
+
+typedef void* FrmDump;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Background frame writer with the same output layout as
+ * dump_mpp_frame_to_file. Queued frames keep a reference of their buffer
+ * until written. The file is written through its descriptor, so fp must
+ * not be written by others before frm_dump_deinit.
+ */
+MPP_RET frm_dump_init(FrmDump *ctx, FILE *fp, FrmDumpCfg *cfg);
+/* write all pending frames then release */
+MPP_RET frm_dump_deinit(FrmDump ctx);
+MPP_RET frm_dump_put(FrmDump ctx, MppFrame frame);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __FRM_DUMP_H__ */
@@ -0,0 +1,179 @@
+/* SPDX-License-Identifier: Apache-2.0 OR MIT */
+/*
+ * Copyright (c) 2024 Rockchip Electronics Co., Ltd.
+ */
+
+#define MODULE_TAG "frm_worker"
+
+#include <pthread.h>
+
+#include "mpp_mem.h"
+#include "mpp_log.h"
+#include "mpp_time.h"
+#include "mpp_buffer.h"
+
+#include "frm_worker.h"
+
+typedef struct FrmWorkerImpl_t {
+    FrmWorkerFunc   func;
+    void            *ctx;
+    RK_U32          depth;
+    RK_U32          drop;
+
+    pthread_t       thd;
+    pthread_mutex_t lock;
+    pthread_cond_t  cond;
+    RK_U32          thd_stop;
+    RK_U32          rd_idx;
+    RK_U32          wr_idx;
+    MppFrame        *queue;
+
+    FrmWorkerStat   stat;
+} FrmWorkerImpl;
+
+static void *frm_worker_thread(void *arg)
+{
+    FrmWorkerImpl *p = (FrmWorkerImpl *)arg;
+
+    pthread_mutex_lock(&p->lock);
+    while (1) {
+        MppFrame frame;
+
+        while (p->rd_idx == p->wr_idx && !p->thd_stop)
+            pthread_cond_wait(&p->cond, &p->lock);
+
+        if (p->rd_idx == p->wr_idx)
+            break;
+
+        frame = p->queue[p->rd_idx % p->depth];
+        pthread_mutex_unlock(&p->lock);
+
+        p->func(p->ctx, frame);
+        mpp_frame_deinit(&frame);
+
+        pthread_mutex_lock(&p->lock);
+        p->rd_idx++;
+        p->stat.frame_count++;
+        pthread_cond_broadcast(&p->cond);
+    }
+    pthread_mutex_unlock(&p->lock);
+
+    return NULL;
+}
+
+MPP_RET frm_worker_init(FrmWorker *worker, FrmWorkerFunc func, void *ctx,
+                        RK_U32 depth, RK_U32 drop)
+{
+    FrmWorkerImpl *p = NULL;
+
+    if (NULL == worker || NULL == func || !depth) {
+        mpp_err_f("invalid input worker %p func %p depth %d\n", worker, func, depth);
+        return MPP_ERR_NULL_PTR;
+    }
+
+    *worker = NULL;
+
+    p = mpp_calloc(FrmWorkerImpl, 1);
+    if (NULL == p) {
+        mpp_err_f("failed to malloc context\n");
+        return MPP_ERR_MALLOC;
+    }
+
+    p->queue = mpp_calloc(MppFrame, depth);
+    if (NULL == p->queue) {
+        mpp_err_f("failed to malloc queue depth %d\n", depth);
+        MPP_FREE(p);
+        return MPP_ERR_MALLOC;
+    }
+
+    p->func = func;
+    p->ctx = ctx;
+    p->depth = depth;
+    p->drop = drop;
+
+    pthread_mutex_init(&p->lock, NULL);
+    pthread_cond_init(&p->cond, NULL);
+
+    if (pthread_create(&p->thd, NULL, frm_worker_thread, p)) {
+        mpp_err_f("failed to create worker\n");
+        pthread_cond_destroy(&p->cond);
+        pthread_mutex_destroy(&p->lock);
+        MPP_FREE(p->queue);
+        MPP_FREE(p);
+        return MPP_NOK;
+    }
+
+    *worker = p;
+    return MPP_OK;
+}
+
+MPP_RET frm_worker_deinit(FrmWorker worker, FrmWorkerStat *stat)
+{
+    FrmWorkerImpl *p = (FrmWorkerImpl *)worker;
+
+    if (NULL == p)
+        return MPP_ERR_NULL_PTR;
+
+    pthread_mutex_lock(&p->lock);
+    p->thd_stop = 1;
+    pthread_cond_broadcast(&p->cond);
+    pthread_mutex_unlock(&p->lock);
+
+    pthread_join(p->thd, NULL);
+    pthread_cond_destroy(&p->cond);
+    pthread_mutex_destroy(&p->lock);
+
+    if (stat)
+        *stat = p->stat;
+
+    MPP_FREE(p->queue);
+    MPP_FREE(p);
+
+    return MPP_OK;
+}
+
+MPP_RET frm_worker_put(FrmWorker worker, MppFrame frame)
+{
+    FrmWorkerImpl *p = (FrmWorkerImpl *)worker;
+    MppFrame task = NULL;
+
+    if (NULL == p || NULL == frame)
+        return MPP_ERR_NULL_PTR;
+
+    pthread_mutex_lock(&p->lock);
+    if (p->wr_idx - p->rd_idx >= p->depth) {
+        RK_S64 start;
+
+        if (p->drop) {
+            p->stat.drop_count++;
+            pthread_mutex_unlock(&p->lock);
+            return MPP_NOK;
+        }
+
+        start = mpp_time();
+        while (p->wr_idx - p->rd_idx >= p->depth)
+            pthread_cond_wait(&p->cond, &p->lock);
+        p->stat.wait_time += mpp_time() - start;
+    }
+    pthread_mutex_unlock(&p->lock);
+
+    /* keep the buffer referenced until the worker is done with the frame */
+    if (mpp_frame_init(&task))
+        return MPP_ERR_MALLOC;
+
+    mpp_frame_set_width(task, mpp_frame_get_width(frame));
+    mpp_frame_set_height(task, mpp_frame_get_height(frame));
+    mpp_frame_set_hor_stride(task, mpp_frame_get_hor_stride(frame));
+    mpp_frame_set_ver_stride(task, mpp_frame_get_ver_stride(frame));
+    mpp_frame_set_fmt(task, mpp_frame_get_fmt(frame));
+    mpp_frame_set_buffer(task, mpp_frame_get_buffer(frame));
+
+    /* single producer, the free slot checked above is still available */
+    pthread_mutex_lock(&p->lock);
+    p->queue[p->wr_idx % p->depth] = task;
+    p->wr_idx++;
+    pthread_cond_broadcast(&p->cond);
+    pthread_mutex_unlock(&p->lock);
+
+    return MPP_OK;
+}
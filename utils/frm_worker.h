@@ -0,0 +1,42 @@
+/* SPDX-License-Identifier: Apache-2.0 OR MIT */
+/*
+ * Copyright (c) 2024 Rockchip Electronics Co., Ltd.
+ */
+
+#ifndef __FRM_WORKER_H__
+#define __FRM_WORKER_H__
+
+#include "mpp_frame.h"
+
+typedef void* FrmWorker;
+
+/* called on the worker thread for each queued frame in put order */
+typedef void (*FrmWorkerFunc)(void *ctx, MppFrame frame);
+
+typedef struct FrmWorkerStat_t {
+    RK_U32          frame_count;
+    RK_U32          drop_count;
+    /* time the caller blocked on full queue in us */
+    RK_S64          wait_time;
+} FrmWorkerStat;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Bounded frame queue with one worker thread. Queued frames are shallow
+ * copies keeping a reference of the frame buffer until func returns.
+ * With drop enabled put returns MPP_NOK on full queue instead of blocking.
+ */
+MPP_RET frm_worker_init(FrmWorker *worker, FrmWorkerFunc func, void *ctx,
+                        RK_U32 depth, RK_U32 drop);
+/* process all pending frames then release, stat is optional */
+MPP_RET frm_worker_deinit(FrmWorker worker, FrmWorkerStat *stat);
+MPP_RET frm_worker_put(FrmWorker worker, MppFrame frame);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __FRM_WORKER_H__ */
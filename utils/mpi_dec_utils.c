@@ -18,6 +18,7 @@
 
 #include <string.h>
 #include <pthread.h>
+#include <sys/mman.h>
 
 #include "rk_mpi.h"
 
@@ -35,6 +36,10 @@
 #define IVF_FRAME_HEADER_LENGTH     12
 
 #define DEFAULT_PACKET_SIZE         SZ_4K
+/* zero pages after the mapped file as stuffing of the last packet */
+#define READER_MAP_PAD              SZ_4K
+#define READER_MAP_PREFETCH         SZ_1M
+#define READER_SLOT_ALL             0xfffffffe
 
 typedef enum {
     FILE_NORMAL_TYPE,
@@ -56,6 +61,8 @@ typedef struct FileReader_t {
     size_t          stuff_size;
     RK_S32          seek_base;
     ReaderFunc      read_func;
+    /* read packet into MppBuffer from group for zero copy input */
+    RK_U32          zero_copy;
 
     /* return value for each read */
     size_t          read_total;
@@ -69,6 +76,22 @@ typedef struct FileReader_t {
     RK_U32          slot_cnt;
     RK_U32          slot_rd_idx;
     FileBufSlot     **slots;
+
+    /*
+     * lazy mode: slots are created on read instead of pre-read by the worker
+     * thread. mmap slots are views into the mapped file and zero copy slots
+     * are read into MppBuffer only when the decoder needs them.
+     */
+    RK_U32          lazy;
+    RK_U32          fill_eos;
+    pthread_mutex_t fill_lock;
+    /* zero copy slots are read again from file start after rewind */
+    RK_U32          zc_rewind;
+
+    RK_U8           *map_base;
+    size_t          map_size;
+    size_t          map_pos;
+    size_t          map_prefetch;
 } FileReaderImpl;
 
 typedef struct DecBufMgrImpl_t {
@@ -103,6 +126,38 @@ static MPP_RET add_new_slot(FileReaderImpl* impl, FileBufSlot *slot)
     return MPP_OK;
 }
 
+/*
+ * normal slot keeps the data right after itself and zero copy slot reads the
+ * data into a MppBuffer which is passed to decoder without copy
+ */
+static FileBufSlot *reader_slot_get(FileReaderImpl *impl, size_t size, size_t alloc)
+{
+    FileBufSlot *slot = NULL;
+
+    if (!impl->zero_copy) {
+        slot = mpp_malloc_size(FileBufSlot, alloc);
+        if (slot) {
+            slot->data = (char *)(slot + 1);
+            slot->buf = NULL;
+        }
+        return slot;
+    }
+
+    slot = mpp_calloc(FileBufSlot, 1);
+    if (NULL == slot || !size)
+        return slot;
+
+    if (mpp_buffer_get(impl->group, &slot->buf, size)) {
+        mpp_err("failed to get packet buffer size %d\n", (RK_S32)size);
+        MPP_FREE(slot);
+        return NULL;
+    }
+
+    slot->data = mpp_buffer_get_ptr(slot->buf);
+
+    return slot;
+}
+
 static FileBufSlot *read_ivf_file(FileReader data)
 {
     FileReaderImpl *impl = (FileReaderImpl*)data;
@@ -124,9 +179,12 @@ static FileBufSlot *read_ivf_file(FileReader data)
 
     impl->read_total += ivf_data_size;
     data_size = ivf_data[0] | (ivf_data[1] << 8) | (ivf_data[2] << 16) | (ivf_data[3] << 24);
-    slot = mpp_malloc_size(FileBufSlot, MPP_ALIGN(sizeof(FileBufSlot) + data_size, SZ_4K));
-    slot->data = (char *)(slot + 1);
-    read_size = fread(slot->data, 1, data_size, fp);
+    slot = reader_slot_get(impl, data_size, MPP_ALIGN(sizeof(FileBufSlot) + data_size, SZ_4K));
+    if (NULL == slot)
+        return NULL;
+
+    if (data_size)
+        read_size = fread(slot->data, 1, data_size, fp);
     impl->read_total += read_size;
     impl->read_size = read_size;
 
@@ -136,7 +194,6 @@ static FileBufSlot *read_ivf_file(FileReader data)
     if (!data_size || read_size != data_size || feof(fp) || impl->read_total >= impl->file_size)
         eos = 1;
 
-    slot->buf = NULL;
     slot->size = read_size;
     slot->eos = eos;
 
@@ -177,11 +234,13 @@ static FileBufSlot *read_normal_file(FileReader data)
     FILE *fp = impl->fp_input;
     size_t read_size = 0;
     size_t buf_size = impl->buf_size;
-    size_t size = sizeof(FileBufSlot) + buf_size + impl->stuff_size;
-    FileBufSlot *slot = mpp_malloc_size(FileBufSlot, size);
+    size_t size = buf_size + impl->stuff_size;
+    FileBufSlot *slot = reader_slot_get(impl, size, sizeof(FileBufSlot) + size);
     RK_U32 eos = 0;
 
-    slot->data = (char *)(slot + 1);
+    if (NULL == slot)
+        return NULL;
+
     read_size = fread(slot->data, 1, buf_size, fp);
     impl->read_total += read_size;
     impl->read_size = read_size;
@@ -190,13 +249,184 @@ static FileBufSlot *read_normal_file(FileReader data)
     if (read_size != buf_size || feof(fp) || impl->read_total >= impl->file_size)
         eos = 1;
 
-    slot->buf = NULL;
     slot->size  = read_size;
     slot->eos   = eos;
 
     return slot;
 }
 
+static FileBufSlot *read_ivf_map(FileReader data)
+{
+    FileReaderImpl *impl = (FileReaderImpl*)data;
+    FileBufSlot *slot = mpp_calloc(FileBufSlot, 1);
+    RK_U8 *ivf_data = impl->map_base + impl->map_pos;
+    size_t remain = impl->file_size - impl->map_pos;
+    size_t data_size = 0;
+
+    if (NULL == slot)
+        return NULL;
+
+    if (remain < IVF_FRAME_HEADER_LENGTH) {
+        /* end of frame queue */
+        slot->eos = 1;
+        impl->map_pos = impl->file_size;
+        return slot;
+    }
+
+    data_size = ivf_data[0] | (ivf_data[1] << 8) | (ivf_data[2] << 16) | (ivf_data[3] << 24);
+    remain -= IVF_FRAME_HEADER_LENGTH;
+    if (!data_size)
+        mpp_err("data_size is zero! pos %d\n", (RK_S32)impl->map_pos);
+
+    slot->data = (char *)ivf_data + IVF_FRAME_HEADER_LENGTH;
+    slot->size = MPP_MIN(data_size, remain);
+    impl->map_pos += IVF_FRAME_HEADER_LENGTH + slot->size;
+    impl->read_total = impl->map_pos;
+    impl->read_size = slot->size;
+
+    if (!data_size || slot->size != data_size || impl->map_pos >= impl->file_size)
+        slot->eos = 1;
+
+    return slot;
+}
+
+static FileBufSlot *read_normal_map(FileReader data)
+{
+    FileReaderImpl *impl = (FileReaderImpl*)data;
+    FileBufSlot *slot = mpp_calloc(FileBufSlot, 1);
+
+    if (NULL == slot)
+        return NULL;
+
+    slot->data = (char *)impl->map_base + impl->map_pos;
+    slot->size = MPP_MIN(impl->buf_size, impl->file_size - impl->map_pos);
+    impl->map_pos += slot->size;
+    impl->read_total = impl->map_pos;
+    impl->read_size = slot->size;
+
+    if (impl->map_pos >= impl->file_size)
+        slot->eos = 1;
+
+    return slot;
+}
+
+static MPP_RET reader_map(FileReaderImpl *impl)
+{
+    RK_U32 use_mmap = 1;
+    size_t size;
+    void *base;
+
+    mpp_env_get_u32("reader_mmap", &use_mmap, 1);
+
+    /* jpeg and zero copy input are read into hardware buffer directly */
+    if (!use_mmap || impl->file_type == FILE_JPEG_TYPE || impl->zero_copy ||
+        !impl->file_size)
+        return MPP_NOK;
+
+    /*
+     * reserve zero pages after the file so that the stuffing read after the
+     * last packet does not hit the end of mapping
+     */
+    size = MPP_ALIGN(impl->file_size, SZ_4K) + READER_MAP_PAD;
+    base = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (base == MAP_FAILED)
+        return MPP_NOK;
+
+    if (mmap(base, impl->file_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_FIXED,
+             fileno(impl->fp_input), 0) == MAP_FAILED) {
+        munmap(base, size);
+        return MPP_NOK;
+    }
+
+    madvise(base, impl->file_size, MADV_SEQUENTIAL);
+
+    impl->map_base = (RK_U8 *)base;
+    impl->map_size = size;
+    impl->map_pos = impl->seek_base;
+    impl->map_prefetch = 0;
+    impl->read_func = (impl->file_type == FILE_IVF_TYPE) ? read_ivf_map : read_normal_map;
+
+    return MPP_OK;
+}
+
+/* create slots on read until the index is available */
+static void reader_fill(FileReaderImpl *impl, RK_U32 index)
+{
+    pthread_mutex_lock(&impl->fill_lock);
+
+    while (impl->slot_cnt <= index && !impl->fill_eos) {
+        FileBufSlot *slot = impl->read_func(impl);
+
+        if (NULL == slot)
+            break;
+
+        add_new_slot(impl, slot);
+        impl->fill_eos = slot->eos;
+
+        /* read ahead the next window of mapped file in background */
+        if (impl->map_base && impl->map_pos + READER_MAP_PREFETCH / 2 > impl->map_prefetch &&
+            impl->map_prefetch < impl->file_size) {
+            size_t start = MPP_MAX(impl->map_prefetch, impl->map_pos) & ~((size_t)SZ_4K - 1);
+            size_t len = MPP_MIN(READER_MAP_PREFETCH, impl->file_size - start);
+
+            madvise(impl->map_base + start, len, MADV_WILLNEED);
+            impl->map_prefetch = start + len;
+        }
+    }
+
+    pthread_mutex_unlock(&impl->fill_lock);
+}
+
+static void reader_slots_free(FileReaderImpl *impl)
+{
+    RK_U32 i;
+
+    for (i = 0; i < impl->slot_cnt; i++) {
+        FileBufSlot *slot = impl->slots[i];
+        if (!slot)
+            continue;
+
+        if (slot->buf) {
+            mpp_buffer_put(slot->buf);
+            slot->buf = NULL;
+        }
+        MPP_FREE(impl->slots[i]);
+    }
+
+    impl->slot_cnt = 0;
+}
+
+/*
+ * The packet sent to decoder holds its own reference of the zero copy slot
+ * buffer. So the reader drops the buffer of the last slot on next read and
+ * only the packets still in decoder keep MppBuffer in use.
+ */
+static void reader_zc_recycle(FileReaderImpl *impl)
+{
+    FileBufSlot *slot;
+
+    if (impl->zc_rewind) {
+        pthread_mutex_lock(&impl->fill_lock);
+        reader_slots_free(impl);
+        impl->fill_eos = 0;
+        impl->zc_rewind = 0;
+        impl->read_total = impl->seek_base;
+        fseek(impl->fp_input, impl->seek_base, SEEK_SET);
+        pthread_mutex_unlock(&impl->fill_lock);
+        return;
+    }
+
+    if (!impl->slot_rd_idx)
+        return;
+
+    slot = impl->slots[impl->slot_rd_idx - 1];
+    if (slot && slot->buf) {
+        mpp_buffer_put(slot->buf);
+        slot->buf = NULL;
+        slot->data = NULL;
+    }
+}
+
 static void check_file_type(FileReader data, char *file_in, MppCodingType type)
 {
     FileReaderImpl *impl = (FileReaderImpl*)data;
@@ -261,6 +491,12 @@ MPP_RET reader_read(FileReader reader, FileBufSlot **buf)
         return MPP_NOK;
     }
 
+    if (impl->zero_copy)
+        reader_zc_recycle(impl);
+
+    if (impl->lazy)
+        reader_fill(impl, impl->slot_rd_idx);
+
     if (impl->slot_rd_idx >= impl->slot_max) {
         mpp_log_f("invalid read index % max %d\n", impl->slot_rd_idx, impl->slot_max);
         return MPP_NOK;
@@ -290,6 +526,9 @@ MPP_RET reader_index_read(FileReader reader, RK_S32 index, FileBufSlot **buf)
         return MPP_NOK;
     }
 
+    if (impl->lazy && index >= 0)
+        reader_fill(impl, index);
+
     if (index >= (RK_S32)impl->slot_max) {
         mpp_log_f("invalid read index % max %d\n", index, impl->slot_max);
         return MPP_NOK;
@@ -313,9 +552,12 @@ void reader_rewind(FileReader reader)
     FileReaderImpl *impl = (FileReaderImpl*)reader;
 
     impl->slot_rd_idx = 0;
+    if (impl->zero_copy)
+        impl->zc_rewind = 1;
 }
 
-void reader_init(FileReader* reader, char* file_in, MppCodingType type)
+static void reader_create(FileReader* reader, char* file_in, MppCodingType type,
+                          RK_U32 zero_copy)
 {
     FILE *fp_input = fopen(file_in, "rb");
     FileReaderImpl *impl = NULL;
@@ -336,17 +578,40 @@ void reader_init(FileReader* reader, char* file_in, MppCodingType type)
 
     check_file_type(impl, file_in, type);
 
+    if (zero_copy && impl->file_type != FILE_JPEG_TYPE) {
+        mpp_buffer_group_get_internal(&impl->group, MPP_BUFFER_TYPE_DRM |
+                                      MPP_BUFFER_FLAGS_CACHABLE);
+        mpp_assert(impl->group);
+        impl->zero_copy = 1;
+    }
+
     impl->slots = mpp_calloc(FileBufSlot*, impl->slot_max);
+    pthread_mutex_init(&impl->fill_lock, NULL);
 
-    reader_start(impl);
+    /* zero copy reader reads on demand to keep only a few buffers in use */
+    if (impl->zero_copy || !reader_map(impl)) {
+        impl->lazy = 1;
+        impl->thd_stop = 1;
+    } else {
+        reader_start(impl);
+    }
 
     *reader = impl;
 }
 
+void reader_init(FileReader* reader, char* file_in, MppCodingType type)
+{
+    reader_create(reader, file_in, type, 0);
+}
+
+void reader_init_zero_copy(FileReader* reader, char* file_in, MppCodingType type)
+{
+    reader_create(reader, file_in, type, 1);
+}
+
 void reader_deinit(FileReader reader)
 {
     FileReaderImpl *impl = (FileReaderImpl*)(reader);
-    RK_U32 i;
 
     mpp_assert(impl);
     reader_stop(impl);
@@ -356,23 +621,19 @@ void reader_deinit(FileReader reader)
         impl->fp_input = NULL;
     }
 
-    for (i = 0; i < impl->slot_cnt; i++) {
-        FileBufSlot *slot = impl->slots[i];
-        if (!slot)
-            continue;
-
-        if (slot->buf) {
-            mpp_buffer_put(slot->buf);
-            slot->buf = NULL;
-        }
-        MPP_FREE(impl->slots[i]);
-    }
+    reader_slots_free(impl);
 
     if (impl->group) {
         mpp_buffer_group_put(impl->group);
         impl->group = NULL;
     }
 
+    if (impl->map_base) {
+        munmap(impl->map_base, impl->map_size);
+        impl->map_base = NULL;
+    }
+    pthread_mutex_destroy(&impl->fill_lock);
+
     MPP_FREE(impl->slots);
     MPP_FREE(impl);
 }
@@ -399,6 +660,10 @@ void reader_start(FileReader reader)
 {
     FileReaderImpl *impl = (FileReaderImpl*)reader;
 
+    /* lazy reader creates slots on read */
+    if (impl->lazy)
+        return;
+
     impl->thd_stop = 0;
     pthread_create(&impl->thd, NULL, reader_worker, impl);
 }
@@ -407,6 +672,11 @@ void reader_sync(FileReader reader)
 {
     FileReaderImpl *impl = (FileReaderImpl*)reader;
 
+    if (impl->lazy) {
+        reader_fill(impl, READER_SLOT_ALL);
+        return;
+    }
+
     pthread_join(impl->thd, NULL);
     impl->thd_stop = 1;
 }
@@ -592,6 +862,19 @@ RK_S32 mpi_dec_opt_slt(void *ctx, const char *next)
     return 0;
 }
 
+RK_S32 mpi_dec_opt_sltt(void *ctx, const char *next)
+{
+    MpiDecTestCmd *cmd = (MpiDecTestCmd *)ctx;
+
+    if (next) {
+        if (!name_to_frm_check_type(next, &cmd->slt_type))
+            return 1;
+    }
+
+    mpp_err("input slt check type is invalid\n");
+    return 0;
+}
+
 RK_S32 mpi_dec_opt_bufmode(void *ctx, const char *next)
 {
     MpiDecTestCmd *cmd = (MpiDecTestCmd *)ctx;
@@ -614,6 +897,18 @@ RK_S32 mpi_dec_opt_bufmode(void *ctx, const char *next)
     return 0;
 }
 
+RK_S32 mpi_dec_opt_zc(void *ctx, const char *next)
+{
+    MpiDecTestCmd *cmd = (MpiDecTestCmd *)ctx;
+
+    if (next) {
+        cmd->zero_copy = atoi(next) ? 1 : 0;
+        return 1;
+    }
+
+    mpp_err("invalid zero copy mode value\n");
+    return 0;
+}
 
 RK_S32 mpi_dec_opt_help(void *ctx, const char *next)
 {
@@ -634,8 +929,10 @@ static MppOptInfo dec_opts[] = {
     {"s",       "instance_nb",  "number of instances",              mpi_dec_opt_s},
     {"v",       "trace option", "q - quiet f - show fps",           mpi_dec_opt_v},
     {"slt",     "slt file",     "slt verify data file",             mpi_dec_opt_slt},
+    {"sltt",    "slt type",     "slt check type: sum (default) crc32c md5", mpi_dec_opt_sltt},
     {"help",    "help",         "show help",                        mpi_dec_opt_help},
     {"bufmode", "buffer mode",  "hi - half internal (default) i -internal e - external", mpi_dec_opt_bufmode},
+    {"zc",      "zero copy",    "1 - put packet in MppBuffer without copy", mpi_dec_opt_zc},
 };
 
 static RK_U32 dec_opt_cnt = MPP_ARRAY_ELEMS(dec_opts);
@@ -696,7 +993,7 @@ RK_S32 mpi_dec_test_cmd_init(MpiDecTestCmd* cmd, int argc, char **argv)
 
     mpp_opt_init(&opts);
     /* should change node count when option increases */
-    mpp_opt_setup(opts, cmd, 35, dec_opt_cnt);
+    mpp_opt_setup(opts, cmd, 37, dec_opt_cnt);
 
     for (i = 0; i < dec_opt_cnt; i++)
         mpp_opt_add(opts, &dec_opts[i]);
@@ -707,7 +1004,10 @@ RK_S32 mpi_dec_test_cmd_init(MpiDecTestCmd* cmd, int argc, char **argv)
     ret = mpp_opt_parse(opts, argc, argv);
 
     if (cmd->have_input) {
-        reader_init(&cmd->reader, cmd->file_input, cmd->type);
+        if (cmd->zero_copy)
+            reader_init_zero_copy(&cmd->reader, cmd->file_input, cmd->type);
+        else
+            reader_init(&cmd->reader, cmd->file_input, cmd->type);
         if (cmd->reader)
             mpp_log("input file %s size %ld\n", cmd->file_input, reader_size(cmd->reader));
     }
@@ -762,7 +1062,9 @@ void mpi_dec_test_cmd_options(MpiDecTestCmd* cmd)
     mpp_log("type       : %4d\n", cmd->type);
     mpp_log("max frames : %4d\n", cmd->frame_num);
     if (cmd->file_slt)
-        mpp_log("verify     : %s\n", cmd->file_slt);
+        mpp_log("verify     : %s type %d\n", cmd->file_slt, cmd->slt_type);
+    if (cmd->zero_copy)
+        mpp_log("zero copy  : %4d\n", cmd->zero_copy);
 }
 
 MPP_RET dec_buf_mgr_init(DecBufMgr *mgr)
@@ -19,6 +19,8 @@
 
 #include <stdio.h>
 #include "utils.h"
+#include "frm_check.h"
+#include "frm_dump.h"
 
 #define MAX_FILE_NAME_LENGTH        256
 #define MPI_DEC_STREAM_SIZE         (SZ_4K)
@@ -119,6 +121,8 @@ typedef struct MpiDecTestCmd_t {
     RK_S32          frame_num;
     size_t          pkt_size;
     MppDecBufMode   buf_mode;
+    /* put packet with MppBuffer and let decoder reference it */
+    RK_U32          zero_copy;
 
     /* use for mpi_dec_multi_test */
     RK_S32          nthreads;
@@ -129,10 +133,14 @@ typedef struct MpiDecTestCmd_t {
     FileReader      reader;
     FpsCalc         fps;
 
+    /* process start time for start latency report */
+    RK_S64          start_time;
+
     /* runtime log flag */
     RK_U32          quiet;
     RK_U32          trace_fps;
     char            *file_slt;
+    FrmCheckType    slt_type;
 } MpiDecTestCmd;
 
 RK_S32  mpi_dec_test_cmd_init(MpiDecTestCmd* cmd, int argc, char **argv);
@@ -140,6 +148,11 @@ RK_S32  mpi_dec_test_cmd_deinit(MpiDecTestCmd* cmd);
 void    mpi_dec_test_cmd_options(MpiDecTestCmd* cmd);
 
 void    reader_init(FileReader* reader, char* file_in, MppCodingType type);
+/*
+ * read each packet into slot buf MppBuffer for zero copy input on reader_read
+ * and the slot buf is released on next reader_read
+ */
+void    reader_init_zero_copy(FileReader* reader, char* file_in, MppCodingType type);
 void    reader_deinit(FileReader reader);
 
 void    reader_start(FileReader reader);
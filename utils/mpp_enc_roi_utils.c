@@ -31,6 +31,7 @@
 #define VEPU541_MAX_ROI_NUM     8
 #define CU_BASE_CFG_BYTE        64
 #define CU_QP_CFG_BYTE          192
+#define ROI_BUF_CNT             2
 
 typedef enum RoiType_e {
     ROI_TYPE_AUTO       = -2,
@@ -80,6 +81,14 @@ typedef struct Vepu541RoiCfg_t {
     RK_U16 qp_adj_mode  : 1;
 } Vepu541RoiCfg;
 
+/* rect in 16x16 block unit, end exclusive */
+typedef struct RoiRect_t {
+    RK_S32 x0;
+    RK_S32 y0;
+    RK_S32 x1;
+    RK_S32 y1;
+} RoiRect;
+
 typedef struct Vepu580RoiH264BsCfg_t {
     RK_U64 force_inter   : 42;
     RK_U64 mode_mask     : 9;
@@ -147,13 +156,18 @@ typedef struct MppEncRoiImpl_t {
     MppEncROICfg        legacy_roi_cfg;
     MppEncROIRegion     *legacy_roi_region;
 
-    /* For roi type 1&2 config */
+    /*
+     * For roi type 1&2 config
+     * Output buffers are double buffered. The slot sent with current frame is
+     * not touched on next setup while the encoder may still read it.
+     */
     MppBufferGroup      roi_grp;
-    MppEncROICfg2       roi_cfg;
+    MppEncROICfg2       roi_cfg[ROI_BUF_CNT];
+    RK_S32              buf_idx;
 
     /* buffer address and size of MppBuffer in MppEncROICfg2 */
-    void                *dst_base;
-    void                *dst_qp;
+    void                *dst_base[ROI_BUF_CNT];
+    void                *dst_qp[ROI_BUF_CNT];
     void                *dst_amv;
     void                *dst_mv;
     RK_U32              base_cfg_size;
@@ -164,8 +178,31 @@ typedef struct MppEncRoiImpl_t {
     RK_U8               *cu_map;
     RK_U32              cu_size;
 
-    /* tmp buffer for convert vepu54x roi cfg to vepu58x roi cfg */
+    /*
+     * vepu54x roi cfg of 16x16 block for whole frame. It is kept across
+     * frames and only the area of changed regions is rasterized again.
+     */
     Vepu541RoiCfg       *tmp;
+    RK_S32              mb_w;
+    RK_S32              mb_h;
+    RK_S32              stride_h;
+    RK_S32              stride_v;
+
+    /* regions rasterized in tmp on last setup */
+    RoiRegionCfg        *prev_regions;
+    RK_S32              prev_count;
+
+    /*
+     * changed 64x64 area map of current setup and the one not written to each
+     * output slot yet, both in ctu_w x ctu_h
+     */
+    RK_U8               *frm_dirty;
+    RK_U8               *slot_dirty[ROI_BUF_CNT];
+    RK_S32              ctu_w;
+    RK_S32              ctu_h;
+
+    /* rasterize whole frame on each setup for comparison */
+    RK_U32              full_update;
 } MppEncRoiImpl;
 
 static RK_U32 raster2scan8[64] = {
@@ -186,19 +223,17 @@ static RK_U32 raster2zscan16[16] = {
     10, 11, 14, 15
 };
 
-static MPP_RET vepu54x_h265_set_roi(void *dst_buf, void *src_buf, RK_S32 w, RK_S32 h)
+static MPP_RET vepu54x_h265_set_roi(void *dst_buf, void *src_buf, RK_S32 w, RoiRect *ctu)
 {
     Vepu541RoiCfg *src = (Vepu541RoiCfg *)src_buf;
     Vepu541RoiCfg *dst = (Vepu541RoiCfg *)dst_buf;
-    RK_S32 mb_w = MPP_ALIGN(w, 64) / 64;
-    RK_S32 mb_h = MPP_ALIGN(h, 64) / 64;
-    RK_S32 ctu_line = mb_w;
+    RK_S32 ctu_line = MPP_ALIGN(w, 64) / 64;
     RK_S32 j;
 
-    for (j = 0; j < mb_h; j++) {
+    for (j = ctu->y0; j < ctu->y1; j++) {
         RK_S32 i;
 
-        for (i = 0; i < mb_w; i++) {
+        for (i = ctu->x0; i < ctu->x1; i++) {
             RK_S32 ctu_addr = j * ctu_line + i;
             RK_S32 cu16_num_line = ctu_line * 4;
             RK_S32 cu16cnt;
@@ -220,37 +255,101 @@ static MPP_RET vepu54x_h265_set_roi(void *dst_buf, void *src_buf, RK_S32 w, RK_S
     return MPP_OK;
 }
 
-static MPP_RET gen_vepu54x_roi(MppEncRoiImpl *ctx, Vepu541RoiCfg *dst)
+static RK_U16 get_roi_cfg_val(RK_S32 force_intra, RK_S32 qp_mode, RK_S32 qp_val)
 {
-    RoiRegionCfg *region = ctx->regions;
-    RK_S32 mb_w = MPP_ALIGN(ctx->w, 16) / 16;
-    RK_S32 mb_h = MPP_ALIGN(ctx->h, 16) / 16;
-    RK_S32 stride_h = MPP_ALIGN(mb_w, 4);
-    RK_S32 stride_v = MPP_ALIGN(mb_h, 4);
     Vepu541RoiCfg cfg;
-    MPP_RET ret = MPP_NOK;
-    RK_S32 i;
-
-    memset(ctx->cu_map, 0, ctx->cu_size);
+    RK_U16 val;
 
-    cfg.force_intra = 0;
+    cfg.force_intra = force_intra;
     cfg.reserved    = 0;
     cfg.qp_area_idx = 0;
-    cfg.qp_area_en  = 1;
-    cfg.qp_adj      = 0;
-    cfg.qp_adj_mode = 0;
+    // NOTE: When roi is enabled the qp_area_en should be one.
+    cfg.qp_area_en  = 1; // region->area_map_en;
+    cfg.qp_adj      = qp_val;
+    cfg.qp_adj_mode = qp_mode;
+
+    memcpy(&val, &cfg, sizeof(val));
+    return val;
+}
+
+static RK_S32 roi_rect_clip(RoiRect *dst, RoiRect *a, RoiRect *b)
+{
+    dst->x0 = MPP_MAX(a->x0, b->x0);
+    dst->y0 = MPP_MAX(a->y0, b->y0);
+    dst->x1 = MPP_MIN(a->x1, b->x1);
+    dst->y1 = MPP_MIN(a->y1, b->y1);
+
+    return dst->x0 < dst->x1 && dst->y0 < dst->y1;
+}
+
+/* 16x16 block rect of region */
+static void get_region_rect(MppEncRoiImpl *ctx, RoiRegionCfg *region, RoiRect *rect)
+{
+    rect->x0 = (region->x + 15) / 16;
+    rect->y0 = (region->y + 15) / 16;
+    rect->x1 = MPP_MIN(rect->x0 + (region->w + 15) / 16, ctx->mb_w);
+    rect->y1 = MPP_MIN(rect->y0 + (region->h + 15) / 16, ctx->mb_h);
+}
+
+/* 64x64 ctu rect of region marked in hevc cu_map, one more ctu around */
+static void get_region_ctu_rect(MppEncRoiImpl *ctx, RoiRegionCfg *region, RoiRect *rect)
+{
+    RK_S32 roi_width  = (region->w + 64) / 64;
+    RK_S32 roi_height = (region->h + 64) / 64;
+    RK_S32 pos_x_init;
+    RK_S32 pos_y_init;
+
+    if (region->x < 64) {
+        pos_x_init = 0;
+        roi_width += 2;
+    } else if (region->x % 64) {
+        pos_x_init = (region->x - 64) / 64;
+        roi_width += 2;
+    } else
+        pos_x_init = region->x / 64;
+
+    if (region->y < 64) {
+        pos_y_init = 0;
+        roi_height += 2;
+    } else if (region->y % 64) {
+        pos_y_init = (region->y - 64) / 64;
+        roi_height += 2;
+    } else
+        pos_y_init = region->y / 64;
+
+    rect->x0 = pos_x_init;
+    rect->y0 = pos_y_init;
+    rect->x1 = MPP_MIN(pos_x_init + roi_width, ctx->stride_h / 4);
+    rect->y1 = MPP_MIN(pos_y_init + roi_height, ctx->stride_v / 4);
+}
+
+/* 16x16 block rect which config is affected by region */
+static void get_region_dirty(MppEncRoiImpl *ctx, RoiRegionCfg *region, RoiRect *rect)
+{
+    get_region_rect(ctx, region, rect);
 
-    /* step 1. reset all the config */
-    for (i = 0; i < stride_h * stride_v; i++)
-        memcpy(dst + i, &cfg, sizeof(cfg));
+    if (ctx->cu_map && ctx->type == MPP_VIDEO_CodingHEVC) {
+        RoiRect ctu;
+
+        get_region_ctu_rect(ctx, region, &ctu);
+        rect->x0 = MPP_MIN(rect->x0, ctu.x0 * 4);
+        rect->y0 = MPP_MIN(rect->y0, ctu.y0 * 4);
+        rect->x1 = MPP_MAX(rect->x1, ctu.x1 * 4);
+        rect->y1 = MPP_MAX(rect->y1, ctu.y1 * 4);
+    }
+}
+
+static MPP_RET check_roi_regions(MppEncRoiImpl *ctx)
+{
+    RoiRegionCfg *region = ctx->regions;
+    MPP_RET ret = MPP_OK;
+    RK_S32 i;
 
     if (ctx->w <= 0 || ctx->h <= 0) {
         mpp_err_f("invalid size [%d:%d]\n", ctx->w, ctx->h);
-        goto DONE;
+        return MPP_NOK;
     }
 
-    /* check region config */
-    ret = MPP_OK;
     for (i = 0; i < ctx->count; i++, region++) {
         if (region->x + region->w > ctx->w || region->y + region->h > ctx->h)
             ret = MPP_NOK;
@@ -268,89 +367,183 @@ static MPP_RET gen_vepu54x_roi(MppEncRoiImpl *ctx, Vepu541RoiCfg *dst)
                       region->x, region->y, region->w, region->h, ctx->w, ctx->h);
             mpp_err_f("force intra %d qp mode %d val %d\n",
                       region->force_intra, region->qp_mode, region->qp_val);
-            goto DONE;
+            break;
         }
     }
 
-    region = ctx->regions;
-    /* step 2. setup region for top to bottom */
+    return ret;
+}
+
+/* reset the rect in tmp and cu_map then draw regions on it from first to last */
+static void gen_vepu54x_roi_rect(MppEncRoiImpl *ctx, RoiRect *rect)
+{
+    RoiRegionCfg *region = ctx->regions;
+    RK_S32 stride = ctx->stride_h;
+    RK_U8 *mb_map = ctx->type == MPP_VIDEO_CodingAVC ? ctx->cu_map : NULL;
+    RK_U16 val = get_roi_cfg_val(0, 0, 0);
+    RoiRect r;
+    RK_S32 i, y;
+
+    for (y = rect->y0; y < rect->y1; y++) {
+        mpp_fill_u16(ctx->tmp + y * stride + rect->x0, val, rect->x1 - rect->x0);
+        if (mb_map)
+            memset(mb_map + y * stride + rect->x0, 0, rect->x1 - rect->x0);
+    }
+
     for (i = 0; i < ctx->count; i++, region++) {
-        Vepu541RoiCfg *p = dst;
-        RK_U8 *map = ctx->cu_map;
-        RK_S32 roi_width  = (region->w + 15) / 16;
-        RK_S32 roi_height = (region->h + 15) / 16;
-        RK_S32 pos_x_init = (region->x + 15) / 16;
-        RK_S32 pos_y_init = (region->y + 15) / 16;
-        RK_S32 pos_x_end  = pos_x_init + roi_width;
-        RK_S32 pos_y_end  = pos_y_init + roi_height;
-        RK_S32 x, y;
-
-        mpp_assert(pos_x_init >= 0 && pos_x_init < mb_w);
-        mpp_assert(pos_x_end  >= 0 && pos_x_end <= mb_w);
-        mpp_assert(pos_y_init >= 0 && pos_y_init < mb_h);
-        mpp_assert(pos_y_end  >= 0 && pos_y_end <= mb_h);
-
-        cfg.force_intra = region->force_intra;
-        cfg.reserved    = 0;
-        cfg.qp_area_idx = 0;
-        // NOTE: When roi is enabled the qp_area_en should be one.
-        cfg.qp_area_en  = 1; // region->area_map_en;
-        cfg.qp_adj      = region->qp_val;
-        cfg.qp_adj_mode = region->qp_mode;
-
-        p += pos_y_init * stride_h + pos_x_init;
-        map += pos_y_init * stride_h + pos_x_init;
-        for (y = 0; y < roi_height; y++) {
-            for (x = 0; x < roi_width; x++) {
-                memcpy(p + x, &cfg, sizeof(cfg));
-                if (ctx->type == MPP_VIDEO_CodingAVC) {
-                    *(map + x) = 1;
-                }
+        get_region_rect(ctx, region, &r);
+        if (!roi_rect_clip(&r, &r, rect))
+            continue;
+
+        val = get_roi_cfg_val(region->force_intra, region->qp_mode, region->qp_val);
+        for (y = r.y0; y < r.y1; y++) {
+            mpp_fill_u16(ctx->tmp + y * stride + r.x0, val, r.x1 - r.x0);
+            if (mb_map)
+                memset(mb_map + y * stride + r.x0, 1, r.x1 - r.x0);
+        }
+    }
 
-            }
-            p += stride_h;
-            map += stride_h;
+    if (ctx->cu_map && ctx->type == MPP_VIDEO_CodingHEVC) {
+        RK_S32 ctu_w = stride / 4;
+        RoiRect ctu;
+
+        ctu.x0 = rect->x0 / 4;
+        ctu.y0 = rect->y0 / 4;
+        ctu.x1 = (rect->x1 + 3) / 4;
+        ctu.y1 = (rect->y1 + 3) / 4;
+
+        for (y = ctu.y0; y < ctu.y1; y++)
+            memset(ctx->cu_map + y * ctu_w + ctu.x0, 0, ctu.x1 - ctu.x0);
+
+        region = ctx->regions;
+        for (i = 0; i < ctx->count; i++, region++) {
+            get_region_ctu_rect(ctx, region, &r);
+            if (!roi_rect_clip(&r, &r, &ctu))
+                continue;
+
+            for (y = r.y0; y < r.y1; y++)
+                memset(ctx->cu_map + y * ctu_w + r.x0, 1, r.x1 - r.x0);
         }
+    }
+}
+
+static void mark_roi_dirty(MppEncRoiImpl *ctx, RK_U8 *map, RoiRect *rect)
+{
+    RK_S32 x0 = rect->x0 / 4;
+    RK_S32 x1 = (rect->x1 + 3) / 4;
+    RK_S32 y;
+
+    if (x0 >= x1)
+        return;
+
+    for (y = rect->y0 / 4; y < (rect->y1 + 3) / 4; y++)
+        memset(map + y * ctx->ctu_w + x0, 1, x1 - x0);
+}
+
+/*
+ * Get next run of dirty 64x64 area on one row from *pos and clear it.
+ * Return 0 when there is no more dirty area.
+ */
+static RK_S32 get_roi_dirty_run(MppEncRoiImpl *ctx, RK_U8 *map, RK_S32 *pos, RoiRect *rect)
+{
+    RK_S32 size = ctx->ctu_w * ctx->ctu_h;
+    RK_S32 i = *pos;
+    RK_S32 end;
+
+    while (i < size && !map[i])
+        i++;
+
+    if (i >= size) {
+        *pos = size;
+        return 0;
+    }
+
+    end = i + 1;
+    while (end < size && map[end] && end % ctx->ctu_w)
+        end++;
+
+    memset(map + i, 0, end - i);
+
+    rect->x0 = (i % ctx->ctu_w) * 4;
+    rect->y0 = (i / ctx->ctu_w) * 4;
+    rect->x1 = rect->x0 + (end - i) * 4;
+    rect->y1 = rect->y0 + 4;
+    *pos = end;
+
+    return 1;
+}
+
+/*
+ * Rasterize the area of regions changed from last setup into tmp and record
+ * the area for each output slot.
+ */
+static void gen_vepu54x_roi(MppEncRoiImpl *ctx)
+{
+    RK_S32 size = ctx->ctu_w * ctx->ctu_h;
+    RK_U8 *frm_dirty = ctx->frm_dirty;
+    RoiRect rect;
+    RK_S32 pos;
+    RK_S32 i;
 
-        if (ctx->type == MPP_VIDEO_CodingHEVC) {
-            map = ctx->cu_map;
-            RK_U32 stride_cu64_h = stride_h * 16 / 64;
-
-            roi_width  = (region->w + 64) / 64;
-            roi_height = (region->h + 64) / 64;
-
-            if (region->x < 64) {
-                pos_x_init = 0;
-                roi_width += 2;
-            } else if (region->x % 64) {
-                pos_x_init = (region->x - 64) / 64;
-                roi_width += 2;
-            } else
-                pos_x_init = region->x / 64;
-
-            if (region->y < 64) {
-                pos_y_init = 0;
-                roi_height += 2;
-            } else if (region->y % 64) {
-                pos_y_init = (region->y - 64) / 64;
-                roi_height += 2;
-            } else
-                pos_y_init = region->y / 64;
-
-            map += pos_y_init * stride_cu64_h + pos_x_init;
-            for (y = 0; y < roi_height; y++) {
-                for (x = 0; x < roi_width; x++) {
-                    *(map + x) = 1;
-                }
-                map += stride_cu64_h;
+    if (check_roi_regions(ctx))
+        ctx->count = 0;
+
+    if (ctx->full_update) {
+        memset(frm_dirty, 1, size);
+    } else {
+        RK_S32 cnt = MPP_MAX(ctx->count, ctx->prev_count);
+
+        for (i = 0; i < cnt; i++) {
+            RoiRegionCfg *cur = i < ctx->count ? &ctx->regions[i] : NULL;
+            RoiRegionCfg *prev = i < ctx->prev_count ? &ctx->prev_regions[i] : NULL;
+
+            if (cur && prev && !memcmp(cur, prev, sizeof(*cur)))
+                continue;
+
+            if (prev) {
+                get_region_dirty(ctx, prev, &rect);
+                mark_roi_dirty(ctx, frm_dirty, &rect);
+            }
+            if (cur) {
+                get_region_dirty(ctx, cur, &rect);
+                mark_roi_dirty(ctx, frm_dirty, &rect);
             }
         }
     }
 
-DONE:
-    return ret;
-}
+    for (i = 0; i < ROI_BUF_CNT; i++) {
+        RK_U8 *slot = ctx->slot_dirty[i];
+        RK_S32 j;
 
+        for (j = 0; j < size; j++)
+            slot[j] |= frm_dirty[j];
+    }
+
+    /* one rect per 64 pixel row from first to last dirty area for fewer region walks */
+    for (pos = 0; pos < ctx->ctu_h; pos++) {
+        RK_U8 *line = frm_dirty + pos * ctx->ctu_w;
+        RK_S32 x0 = 0;
+        RK_S32 x1 = ctx->ctu_w;
+
+        while (x0 < x1 && !line[x0])
+            x0++;
+        while (x1 > x0 && !line[x1 - 1])
+            x1--;
+
+        if (x0 == x1)
+            continue;
+
+        rect.x0 = x0 * 4;
+        rect.y0 = pos * 4;
+        rect.x1 = x1 * 4;
+        rect.y1 = rect.y0 + 4;
+        gen_vepu54x_roi_rect(ctx, &rect);
+        memset(line, 0, ctx->ctu_w);
+    }
+
+    memcpy(ctx->prev_regions, ctx->regions, sizeof(*ctx->regions) * ctx->count);
+    ctx->prev_count = ctx->count;
+}
 
 static MPP_RET set_roi_pos_val(RK_U32 *buf, RK_U32 pos, RK_U32 value)
 {
@@ -458,50 +651,37 @@ void set_roi_amv(RK_U32 *buf, Vepu580RoiH265BsCfg val)
     set_roi_pos_val(buf, 511, val.amv_en);
 }
 
-static MPP_RET gen_vepu580_roi_h264(MppEncRoiImpl *ctx)
+static MPP_RET gen_vepu580_roi_h264(MppEncRoiImpl *ctx, RK_S32 idx, RoiRect *rect)
 {
-    RK_S32 mb_w = MPP_ALIGN(ctx->w, 16) / 16;
     RK_S32 mb_h = MPP_ALIGN(ctx->h, 16) / 16;
-    RK_S32 stride_h = MPP_ALIGN(mb_w, 4);
-    RK_S32 stride_v = MPP_ALIGN(mb_h, 4);
-    RK_S32 roi_buf_size = stride_h * stride_v * 8;
-    RK_S32 roi_qp_size = stride_h * stride_v * 2;
-
+    RK_S32 stride_h = ctx->stride_h;
     Vepu541RoiCfg *src = (Vepu541RoiCfg *)ctx->tmp;
-    Vepu580RoiQpCfg *dst_qp = ctx->dst_qp;
-    Vepu580RoiH264BsCfg *dst_base = ctx->dst_base;
+    Vepu580RoiQpCfg *dst_qp = ctx->dst_qp[idx];
+    Vepu580RoiH264BsCfg *dst_base = ctx->dst_base[idx];
+    RK_S32 x1 = rect->x1;
+    RK_S32 y1 = MPP_MIN(rect->y1, mb_h);
     RK_S32 j, k;
 
     if (!src || !dst_qp || !dst_base)
         return MPP_NOK;
 
-    memset(dst_base, 0, roi_buf_size);
-    memset(dst_qp, 0, roi_qp_size);
+    for (j = rect->y0; j < y1; j++) {
+        RK_S32 pos = j * stride_h;
 
-    for (j = 0; j < mb_h; j++) {
-        for (k = 0; k < stride_h; k++) {
-            if (ctx->cu_map[j * stride_h + k]) {
-                Vepu541RoiCfg *cu_cfg = &src[j * stride_h + k];
-                Vepu580RoiQpCfg *qp_cfg = &dst_qp[j * stride_h + k];
-                Vepu580RoiH264BsCfg *base_cfg = &dst_base[j * stride_h + k];
+        memset(dst_base + pos + rect->x0, 0, (x1 - rect->x0) * sizeof(*dst_base));
+        memset(dst_qp + pos + rect->x0, 0, (x1 - rect->x0) * sizeof(*dst_qp));
+
+        for (k = rect->x0; k < x1; k++) {
+            if (ctx->cu_map[pos + k]) {
+                Vepu541RoiCfg *cu_cfg = &src[pos + k];
+                Vepu580RoiQpCfg *qp_cfg = &dst_qp[pos + k];
+                Vepu580RoiH264BsCfg *base_cfg = &dst_base[pos + k];
 
                 qp_cfg->qp_adj = cu_cfg->qp_adj;
                 qp_cfg->qp_adj_mode = cu_cfg->qp_adj_mode;
                 qp_cfg->qp_area_idx = cu_cfg->qp_area_idx;
                 base_cfg->force_intra = cu_cfg->force_intra;
                 base_cfg->qp_adj_en = !!cu_cfg->qp_adj;
-#if 0
-                if (j < 8 && k < 8) {
-                    RK_U64 *tmp = (RK_U64 *)base_cfg;
-                    RK_U16 *qp = (RK_U16 *)qp_cfg;
-
-                    mpp_log("force_intra %d, qp_adj_en %d qp_adj %d, qp_adj_mode %d",
-                            base_cfg->force_intra, base_cfg->qp_adj_en, qp_cfg->qp_adj, qp_cfg->qp_adj_mode);
-                    mpp_log("val low %8x hight %8x", *tmp & 0xffffffff, ((*tmp >> 32) & 0xffffffff));
-
-                    mpp_log("qp cfg %4x", *qp);
-                }
-#endif
             }
         }
     }
@@ -530,104 +710,199 @@ void set_roi_cu16_split_cu8(RK_U32 *buf, RK_U32 cu16index, Vepu580RoiH265BsCfg v
     }
 }
 
-static MPP_RET gen_vepu580_roi_h265(MppEncRoiImpl *ctx)
+static void gen_vepu580_roi_h265_ctu(Vepu541RoiCfg *src, RK_S32 ctu_line, RK_S32 j, RK_S32 k,
+                                     RK_U32 *dst_base, void *dst_qp)
+{
+    RK_S32 cu16_num_line = ctu_line * 4;
+    RK_U32 adjust_cnt = 0;
+    RK_S32 i, cu16cnt;
+
+    for (cu16cnt = 0; cu16cnt < 16; cu16cnt++) {
+        RK_S32 cu16_x;
+        RK_S32 cu16_y;
+        RK_S32 cu16_addr_in_frame;
+        RK_U32 zindex = 0;
+        Vepu541RoiCfg *cu16_cfg = NULL;
+        Vepu580RoiH265BsCfg val;
+
+        memset(&val, 0, sizeof(val));
+        cu16_x = cu16cnt & 3;
+        cu16_y = cu16cnt / 4;
+        cu16_x += k * 4;
+        cu16_y += j * 4;
+        cu16_addr_in_frame = cu16_x + cu16_y * cu16_num_line;
+        cu16_cfg = &src[cu16_addr_in_frame];
+        zindex = raster2zscan16[cu16cnt];
+
+        val.force_intra = cu16_cfg->force_intra;
+        val.qp_adj = !!cu16_cfg->qp_adj;
+        if (val.force_intra || val.qp_adj) {
+            adjust_cnt++;
+        }
+
+        set_roi_cu16_split_cu8(dst_base, cu16cnt, val);
+        set_roi_cu16_base_cfg(dst_base, zindex, val);
+        set_roi_cu16_qp_cfg(dst_qp, zindex, cu16_cfg);
+        /*
+         * if all cu16 adjust c64 and cu32 must adjust
+         * or we will force split to cu 16
+         */
+        if (adjust_cnt == 16 && cu16cnt == 15) {
+            // cu64
+            set_roi_cu64_base_cfg(dst_base, val);
+            set_roi_cu64_qp_cfg(dst_qp, cu16_cfg);
+            // cu32
+            for (i = 0; i < 4; i++) {
+                set_roi_cu32_base_cfg(dst_base, i, val);
+                set_roi_cu32_qp_cfg(dst_qp, i, cu16_cfg);
+            }
+
+            for (i = 0; i < 64; i ++) {
+                set_roi_cu8_base_cfg(dst_base, i, val);
+                set_roi_qp_cfg(dst_qp, i, cu16_cfg);
+            }
+        } else if (cu16cnt == 15 && adjust_cnt > 0) {
+            val.force_split = 1;
+            set_roi_force_split(dst_base, 84, val.force_split);
+            for (i = 0; i < 4; i++) {
+                set_roi_force_split(dst_base, 80 + i, val.force_split);
+            }
+            for (i = 0; i < 16; i++) {
+                set_roi_force_split(dst_base, 64 + i, val.force_split);
+            }
+        }
+    }
+}
+
+static RK_S32 check_ctu_default(Vepu541RoiCfg *src, RK_S32 ctu_line, RK_S32 j, RK_S32 k)
 {
-    RK_S32 ctu_w = MPP_ALIGN(ctx->w, 64) / 64;
-    RK_S32 ctu_h = MPP_ALIGN(ctx->h, 64) / 64;
-    RK_S32 roi_buf_size = ctu_w * ctu_h * 64;
-    RK_S32 roi_qp_size =  ctu_w * ctu_h * 256;
-    RK_S32 ctu_line = ctu_w;
+    RK_U16 def = get_roi_cfg_val(0, 0, 0);
+    RK_S32 y, x;
+
+    for (y = 0; y < 4; y++) {
+        RK_U16 *line = (RK_U16 *)(src + (j * 4 + y) * ctu_line * 4 + k * 4);
+
+        for (x = 0; x < 4; x++)
+            if (line[x] != def)
+                return 0;
+    }
+
+    return 1;
+}
 
+static MPP_RET gen_vepu580_roi_h265(MppEncRoiImpl *ctx, RK_S32 idx, RoiRect *ctu)
+{
+    RK_S32 ctu_line = MPP_ALIGN(ctx->w, 64) / 64;
     Vepu541RoiCfg *src = (Vepu541RoiCfg *)ctx->tmp;
-    void *dst_qp = ctx->dst_qp;
-    RK_U32 *dst_base = ctx->dst_base;
-    RK_S32 i, j, k, cu16cnt;
+    RK_U8 *dst_qp = ctx->dst_qp[idx];
+    RK_U32 *dst_base = ctx->dst_base[idx];
+    RK_S32 j, k;
 
     if (!src || !dst_qp || !dst_base)
         return MPP_NOK;
 
-    // mpp_log("roi_qp_size = %d, roi_buf_size %d", roi_qp_size, roi_buf_size);
-    memset(dst_qp, 0, roi_qp_size);
-    memset(dst_base, 0, roi_buf_size);
+    for (j = ctu->y0; j < ctu->y1; j++) {
+        for (k = ctu->x0; k < ctu->x1; k++) {
+            RK_S32 ctu_addr = j * ctu_line + k;
+            RK_U32 *ctu_base = dst_base + ctu_addr * CU_BASE_CFG_BYTE / 4;
+            RK_U8 *ctu_qp = dst_qp + ctu_addr * CU_QP_CFG_BYTE;
 
-    for (j = 0; j < ctu_h; j++) {
-        for (k = 0; k < ctu_w; k++) {
-            RK_S32 cu16_num_line = ctu_line * 4;
-            RK_U32 adjust_cnt = 0;
-
-            if (ctx->cu_map[j * ctu_w + k]) {
-                for (cu16cnt = 0; cu16cnt < 16; cu16cnt++) {
-                    RK_S32 cu16_x;
-                    RK_S32 cu16_y;
-                    RK_S32 cu16_addr_in_frame;
-                    RK_U32 zindex = 0;
-                    Vepu541RoiCfg *cu16_cfg = NULL;
-                    Vepu580RoiH265BsCfg val;
-
-                    memset(&val, 0, sizeof(val));
-                    cu16_x = cu16cnt & 3;
-                    cu16_y = cu16cnt / 4;
-                    cu16_x += k * 4;
-                    cu16_y += j * 4;
-                    cu16_addr_in_frame = cu16_x + cu16_y * cu16_num_line;
-                    cu16_cfg = &src[cu16_addr_in_frame];
-                    zindex = raster2zscan16[cu16cnt];
-
-                    val.force_intra = cu16_cfg->force_intra;
-                    val.qp_adj = !!cu16_cfg->qp_adj;
-                    if (val.force_intra || val.qp_adj) {
-                        adjust_cnt++;
-                    }
-
-                    set_roi_cu16_split_cu8(dst_base, cu16cnt, val);
-                    set_roi_cu16_base_cfg(dst_base, zindex, val);
-                    set_roi_cu16_qp_cfg(dst_qp, zindex, cu16_cfg);
-                    /*
-                     * if all cu16 adjust c64 and cu32 must adjust
-                     * or we will force split to cu 16
-                     */
-                    if (adjust_cnt == 16 && cu16cnt == 15) {
-                        // cu64
-                        set_roi_cu64_base_cfg(dst_base, val);
-                        set_roi_cu64_qp_cfg(dst_qp, cu16_cfg);
-                        // cu32
-                        for (i = 0; i < 4; i++) {
-                            set_roi_cu32_base_cfg(dst_base, i, val);
-                            set_roi_cu32_qp_cfg(dst_qp, i, cu16_cfg);
-                        }
-
-                        for (i = 0; i < 64; i ++) {
-                            set_roi_cu8_base_cfg(dst_base, i, val);
-                            set_roi_qp_cfg(dst_qp, i, cu16_cfg);
-                        }
-                    } else if (cu16cnt == 15 && adjust_cnt > 0) {
-                        val.force_split = 1;
-                        set_roi_force_split(dst_base, 84, val.force_split);
-                        for (i = 0; i < 4; i++) {
-                            set_roi_force_split(dst_base, 80 + i, val.force_split);
-                        }
-                        for (i = 0; i < 16; i++) {
-                            set_roi_force_split(dst_base, 64 + i, val.force_split);
-                        }
-                    }
-                }
-            }
-#if 0
-            if (j < 3 && (k < 3 )) {
-                mpp_log("j %d, k %d need_update = %d", j, k, need_update);
-                RK_U16 *qp_val = (RK_U16 *)dst_qp;
-                for (i = 0; i < CU_BASE_CFG_BYTE / 4; i++) {
-                    mpp_log("cfg[%d] = %08x", i, dst_base[i]);
-                }
-                for (i = 0; i < CU_QP_CFG_BYTE / 2; i++) {
-                    mpp_log("qp[%d] = %04x", i, qp_val[i]);
-                }
+            memset(ctu_base, 0, CU_BASE_CFG_BYTE);
+            memset(ctu_qp, 0, CU_QP_CFG_BYTE);
+
+            /* ctu marked only by the extension around region is all zero */
+            if (ctx->cu_map[ctu_addr] && !check_ctu_default(src, ctu_line, j, k))
+                gen_vepu580_roi_h265_ctu(src, ctu_line, j, k, ctu_base, ctu_qp);
+        }
+    }
+    return MPP_OK;
+}
+
+/* write changed rect of tmp to output slot */
+static void gen_roi_slot_rect(MppEncRoiImpl *ctx, RK_S32 idx, RoiRect *rect)
+{
+    RoiRect ctu;
+
+    ctu.x0 = rect->x0 / 4;
+    ctu.y0 = rect->y0 / 4;
+    ctu.x1 = (rect->x1 + 3) / 4;
+    ctu.y1 = (rect->y1 + 3) / 4;
+
+    switch (ctx->roi_type) {
+    case ROI_TYPE_1 : {
+        switch (ctx->type) {
+        case MPP_VIDEO_CodingAVC : {
+            Vepu541RoiCfg *dst = (Vepu541RoiCfg *)ctx->dst_base[idx];
+            RK_S32 y;
+
+            for (y = rect->y0; y < rect->y1; y++) {
+                RK_S32 pos = y * ctx->stride_h + rect->x0;
+
+                memcpy(dst + pos, ctx->tmp + pos, (rect->x1 - rect->x0) * sizeof(*dst));
             }
-#endif
-            dst_base += CU_BASE_CFG_BYTE / 4;
-            dst_qp += CU_QP_CFG_BYTE;
+        } break;
+        case MPP_VIDEO_CodingHEVC : {
+            vepu54x_h265_set_roi(ctx->dst_base[idx], ctx->tmp, ctx->w, &ctu);
+        } break;
+        default : {
+        } break;
+        }
+    } break;
+    case ROI_TYPE_2 : {
+        switch (ctx->type) {
+        case MPP_VIDEO_CodingAVC : {
+            gen_vepu580_roi_h264(ctx, idx, rect);
+        } break;
+        case MPP_VIDEO_CodingHEVC : {
+            gen_vepu580_roi_h265(ctx, idx, &ctu);
+        } break;
+        default : {
+        } break;
         }
+    } break;
+    default : {
+    } break;
+    }
+}
+
+static void gen_roi_slot(MppEncRoiImpl *ctx, RK_S32 idx)
+{
+    RoiRect rect;
+    RK_S32 pos = 0;
+
+    while (get_roi_dirty_run(ctx, ctx->slot_dirty[idx], &pos, &rect))
+        gen_roi_slot_rect(ctx, idx, &rect);
+}
+
+static MPP_RET roi_alloc_map(MppEncRoiImpl *impl)
+{
+    RK_S32 i;
+
+    impl->mb_w = MPP_ALIGN(impl->w, 16) / 16;
+    impl->mb_h = MPP_ALIGN(impl->h, 16) / 16;
+    impl->stride_h = MPP_ALIGN(impl->mb_w, 4);
+    impl->stride_v = MPP_ALIGN(impl->mb_h, 4);
+
+    impl->ctu_w = impl->stride_h / 4;
+    impl->ctu_h = impl->stride_v / 4;
+
+    impl->tmp = mpp_malloc(Vepu541RoiCfg, impl->stride_h * impl->stride_v);
+    impl->prev_regions = mpp_calloc(RoiRegionCfg, impl->max_count);
+    impl->frm_dirty = mpp_calloc(RK_U8, impl->ctu_w * impl->ctu_h);
+    if (!impl->regions || !impl->tmp || !impl->prev_regions || !impl->frm_dirty)
+        return MPP_NOK;
+
+    mpp_fill_u16(impl->tmp, get_roi_cfg_val(0, 0, 0), impl->stride_h * impl->stride_v);
+
+    for (i = 0; i < ROI_BUF_CNT; i++) {
+        impl->slot_dirty[i] = mpp_malloc(RK_U8, impl->ctu_w * impl->ctu_h);
+        if (!impl->slot_dirty[i])
+            return MPP_NOK;
+
+        /* slot is not written yet */
+        memset(impl->slot_dirty[i], 1, impl->ctu_w * impl->ctu_h);
     }
+
     return MPP_OK;
 }
 
@@ -637,6 +912,7 @@ MPP_RET mpp_enc_roi_init(MppEncRoiCtx *ctx, RK_U32 w, RK_U32 h, MppCodingType ty
     RoiType roi_type = ROI_TYPE_AUTO;
     MppEncRoiImpl *impl = NULL;
     MPP_RET ret = MPP_NOK;
+    RK_S32 i;
 
     switch (soc_type) {
     case ROCKCHIP_SOC_RV1109 :
@@ -669,29 +945,24 @@ MPP_RET mpp_enc_roi_init(MppEncRoiCtx *ctx, RK_U32 w, RK_U32 h, MppCodingType ty
     impl->max_count = count;
     impl->regions = mpp_calloc(RoiRegionCfg, count);
 
+    mpp_env_get_u32("roi_full_update", &impl->full_update, 0);
+
     switch (roi_type) {
     case ROI_TYPE_1 : {
-        RK_S32 mb_w = MPP_ALIGN(impl->w, 16) / 16;
-        RK_S32 mb_h = MPP_ALIGN(impl->h, 16) / 16;
-        RK_S32 stride_h = MPP_ALIGN(mb_w, 4);
-        RK_S32 stride_v = MPP_ALIGN(mb_h, 4);
-
         mpp_log("set to vepu54x roi generation\n");
 
-        impl->base_cfg_size = stride_h * stride_v * sizeof(Vepu541RoiCfg);
-        mpp_buffer_group_get_internal(&impl->roi_grp, MPP_BUFFER_TYPE_ION);
-
-        mpp_buffer_get(impl->roi_grp, &impl->roi_cfg.base_cfg_buf, impl->base_cfg_size);
-        if (!impl->roi_cfg.base_cfg_buf) {
+        if (roi_alloc_map(impl))
             goto done;
-        }
-        impl->dst_base = mpp_buffer_get_ptr(impl->roi_cfg.base_cfg_buf);
 
-        /* create tmp buffer for hevc */
-        if (type == MPP_VIDEO_CodingHEVC) {
-            impl->tmp = mpp_malloc(Vepu541RoiCfg, stride_h * stride_v);
-            if (!impl->tmp)
+        impl->base_cfg_size = impl->stride_h * impl->stride_v * sizeof(Vepu541RoiCfg);
+        mpp_buffer_group_get_internal(&impl->roi_grp, MPP_BUFFER_TYPE_ION);
+
+        for (i = 0; i < ROI_BUF_CNT; i++) {
+            mpp_buffer_get(impl->roi_grp, &impl->roi_cfg[i].base_cfg_buf, impl->base_cfg_size);
+            if (!impl->roi_cfg[i].base_cfg_buf) {
                 goto done;
+            }
+            impl->dst_base[i] = mpp_buffer_get_ptr(impl->roi_cfg[i].base_cfg_buf);
         }
 
         ret = MPP_OK;
@@ -721,39 +992,42 @@ MPP_RET mpp_enc_roi_init(MppEncRoiCtx *ctx, RK_U32 w, RK_U32 h, MppCodingType ty
 
         mpp_log("set to vepu58x roi generation\n");
 
-        impl->roi_cfg.roi_qp_en = 1;
-        mpp_buffer_group_get_internal(&impl->roi_grp, MPP_BUFFER_TYPE_ION);
-        mpp_buffer_get(impl->roi_grp, &impl->roi_cfg.base_cfg_buf, impl->base_cfg_size);
-        if (!impl->roi_cfg.base_cfg_buf) {
+        if (!impl->cu_map || roi_alloc_map(impl))
             goto done;
-        }
-        impl->dst_base = mpp_buffer_get_ptr(impl->roi_cfg.base_cfg_buf);
-        mpp_buffer_get(impl->roi_grp, &impl->roi_cfg.qp_cfg_buf, impl->qp_cfg_size);
-        if (!impl->roi_cfg.qp_cfg_buf) {
-            goto done;
-        }
-        impl->dst_qp = mpp_buffer_get_ptr(impl->roi_cfg.qp_cfg_buf);
-        mpp_buffer_get(impl->roi_grp, &impl->roi_cfg.amv_cfg_buf, impl->amv_cfg_size);
-        if (!impl->roi_cfg.amv_cfg_buf) {
+
+        mpp_buffer_group_get_internal(&impl->roi_grp, MPP_BUFFER_TYPE_ION);
+        /* amv and mv config are not generated, share them between slots */
+        mpp_buffer_get(impl->roi_grp, &impl->roi_cfg[0].amv_cfg_buf, impl->amv_cfg_size);
+        if (!impl->roi_cfg[0].amv_cfg_buf) {
             goto done;
         }
-        impl->dst_amv = mpp_buffer_get_ptr(impl->roi_cfg.amv_cfg_buf);
-        mpp_buffer_get(impl->roi_grp, &impl->roi_cfg.mv_cfg_buf, impl->mv_cfg_size);
-        if (!impl->roi_cfg.mv_cfg_buf) {
+        impl->dst_amv = mpp_buffer_get_ptr(impl->roi_cfg[0].amv_cfg_buf);
+        mpp_buffer_get(impl->roi_grp, &impl->roi_cfg[0].mv_cfg_buf, impl->mv_cfg_size);
+        if (!impl->roi_cfg[0].mv_cfg_buf) {
             goto done;
         }
-        impl->dst_mv = mpp_buffer_get_ptr(impl->roi_cfg.mv_cfg_buf);
+        impl->dst_mv = mpp_buffer_get_ptr(impl->roi_cfg[0].mv_cfg_buf);
+
+        for (i = 0; i < ROI_BUF_CNT; i++) {
+            MppEncROICfg2 *cfg = &impl->roi_cfg[i];
 
-        {
-            // create tmp buffer for vepu54x H.264 config first
-            RK_S32 mb_w = MPP_ALIGN(impl->w, 16) / 16;
-            RK_S32 mb_h = MPP_ALIGN(impl->h, 16) / 16;
-            RK_S32 stride_h = MPP_ALIGN(mb_w, 4);
-            RK_S32 stride_v = MPP_ALIGN(mb_h, 4);
+            cfg->roi_qp_en = 1;
+            cfg->amv_cfg_buf = impl->roi_cfg[0].amv_cfg_buf;
+            cfg->mv_cfg_buf = impl->roi_cfg[0].mv_cfg_buf;
 
-            impl->tmp = mpp_malloc(Vepu541RoiCfg, stride_h * stride_v);
-            if (!impl->tmp)
+            mpp_buffer_get(impl->roi_grp, &cfg->base_cfg_buf, impl->base_cfg_size);
+            if (!cfg->base_cfg_buf) {
                 goto done;
+            }
+            impl->dst_base[i] = mpp_buffer_get_ptr(cfg->base_cfg_buf);
+            mpp_buffer_get(impl->roi_grp, &cfg->qp_cfg_buf, impl->qp_cfg_size);
+            if (!cfg->qp_cfg_buf) {
+                goto done;
+            }
+            impl->dst_qp[i] = mpp_buffer_get_ptr(cfg->qp_cfg_buf);
+            /* part out of the generated area should stay zero */
+            memset(impl->dst_base[i], 0, impl->base_cfg_size);
+            memset(impl->dst_qp[i], 0, impl->qp_cfg_size);
         }
         ret = MPP_OK;
     } break;
@@ -783,26 +1057,33 @@ done:
 MPP_RET mpp_enc_roi_deinit(MppEncRoiCtx ctx)
 {
     MppEncRoiImpl *impl = (MppEncRoiImpl *)ctx;
+    RK_S32 i;
 
     if (!impl)
         return MPP_OK;
 
-    if (impl->roi_cfg.base_cfg_buf) {
-        mpp_buffer_put(impl->roi_cfg.base_cfg_buf);
-        impl->roi_cfg.base_cfg_buf = NULL;
-    }
+    for (i = 0; i < ROI_BUF_CNT; i++) {
+        MppEncROICfg2 *cfg = &impl->roi_cfg[i];
 
-    if (impl->roi_cfg.qp_cfg_buf) {
-        mpp_buffer_put(impl->roi_cfg.qp_cfg_buf);
-        impl->roi_cfg.qp_cfg_buf = NULL;
+        if (cfg->base_cfg_buf) {
+            mpp_buffer_put(cfg->base_cfg_buf);
+            cfg->base_cfg_buf = NULL;
+        }
+        if (cfg->qp_cfg_buf) {
+            mpp_buffer_put(cfg->qp_cfg_buf);
+            cfg->qp_cfg_buf = NULL;
+        }
+        MPP_FREE(impl->slot_dirty[i]);
     }
-    if (impl->roi_cfg.amv_cfg_buf) {
-        mpp_buffer_put(impl->roi_cfg.amv_cfg_buf);
-        impl->roi_cfg.amv_cfg_buf = NULL;
+
+    /* amv and mv buffer are shared by all slots */
+    if (impl->roi_cfg[0].amv_cfg_buf) {
+        mpp_buffer_put(impl->roi_cfg[0].amv_cfg_buf);
+        impl->roi_cfg[0].amv_cfg_buf = NULL;
     }
-    if (impl->roi_cfg.mv_cfg_buf) {
-        mpp_buffer_put(impl->roi_cfg.mv_cfg_buf);
-        impl->roi_cfg.mv_cfg_buf = NULL;
+    if (impl->roi_cfg[0].mv_cfg_buf) {
+        mpp_buffer_put(impl->roi_cfg[0].mv_cfg_buf);
+        impl->roi_cfg[0].mv_cfg_buf = NULL;
     }
 
     if (impl->roi_grp) {
@@ -812,6 +1093,8 @@ MPP_RET mpp_enc_roi_deinit(MppEncRoiCtx ctx)
     MPP_FREE(impl->cu_map);
     MPP_FREE(impl->legacy_roi_region);
     MPP_FREE(impl->regions);
+    MPP_FREE(impl->prev_regions);
+    MPP_FREE(impl->frm_dirty);
     MPP_FREE(impl->tmp);
 
     MPP_FREE(impl);
@@ -838,36 +1121,15 @@ MPP_RET mpp_enc_roi_setup_meta(MppEncRoiCtx ctx, MppMeta meta)
     MppEncRoiImpl *impl = (MppEncRoiImpl *)ctx;
 
     switch (impl->roi_type) {
-    case ROI_TYPE_1 : {
-        switch (impl->type) {
-        case MPP_VIDEO_CodingAVC : {
-            gen_vepu54x_roi(impl, impl->dst_base);
-        } break;
-        case MPP_VIDEO_CodingHEVC : {
-            gen_vepu54x_roi(impl, impl->tmp);
-            vepu54x_h265_set_roi(impl->dst_base, impl->tmp, impl->w, impl->h);
-        } break;
-        default : {
-        } break;
-        }
-
-        mpp_meta_set_ptr(meta, KEY_ROI_DATA2, (void*)&impl->roi_cfg);
-    } break;
+    case ROI_TYPE_1 :
     case ROI_TYPE_2 : {
-        gen_vepu54x_roi(impl, impl->tmp);
+        RK_S32 idx = impl->buf_idx;
 
-        switch (impl->type) {
-        case MPP_VIDEO_CodingAVC : {
-            gen_vepu580_roi_h264(impl);
-        } break;
-        case MPP_VIDEO_CodingHEVC : {
-            gen_vepu580_roi_h265(impl);
-        } break;
-        default : {
-        } break;
-        }
+        gen_vepu54x_roi(impl);
+        gen_roi_slot(impl, idx);
 
-        mpp_meta_set_ptr(meta, KEY_ROI_DATA2, (void*)&impl->roi_cfg);
+        mpp_meta_set_ptr(meta, KEY_ROI_DATA2, (void*)&impl->roi_cfg[idx]);
+        impl->buf_idx = (idx + 1) % ROI_BUF_CNT;
     } break;
     case ROI_TYPE_LEGACY : {
         MppEncROIRegion *region = impl->legacy_roi_region;
@@ -251,6 +251,9 @@ void wide_bit_sum(RK_U8 *data, RK_U32 len, RK_ULONG *sum)
 {
     RK_U8   *data8 = NULL;
     RK_U32  loop;
+    RK_U32  cnt = len / CAL_BYTE;
+    /* independent accumulators let the compiler vectorize the loop */
+    RK_ULONG s0 = 0, s1 = 0, s2 = 0, s3 = 0;
     data8 = data;
 #if LONG_MAX == INT_MAX
     RK_U16 *data_rk = NULL;
@@ -260,22 +263,58 @@ void wide_bit_sum(RK_U8 *data, RK_U32 len, RK_ULONG *sum)
     data_rk = (RK_U32 *)data;
 #endif
 
-    for (loop = 0; loop < len / CAL_BYTE; loop++) {
-        *sum += data_rk[loop];
+    for (loop = 0; loop + 4 <= cnt; loop += 4) {
+        s0 += data_rk[loop + 0];
+        s1 += data_rk[loop + 1];
+        s2 += data_rk[loop + 2];
+        s3 += data_rk[loop + 3];
     }
-    for (loop = len / CAL_BYTE * CAL_BYTE; loop < len; loop++) {
-        *sum += data8[loop];
+    for (; loop < cnt; loop++) {
+        s0 += data_rk[loop];
     }
+    for (loop = cnt * CAL_BYTE; loop < len; loop++) {
+        s0 += data8[loop];
+    }
+
+    *sum += s0 + s1 + s2 + s3;
 
     return;
 }
 
+/* xor of 32bit words, use 64bit words on aligned data */
+static RK_U32 word_xor(RK_U8 *data, RK_U32 cnt)
+{
+    RK_U32 *dat32 = (RK_U32 *)data;
+    RK_U32 xor = 0;
+    RK_U32 i = 0;
+
+    if (!((uintptr_t)data & 7)) {
+        RK_U64 *dat64 = (RK_U64 *)data;
+        RK_U64 x0 = 0, x1 = 0;
+
+        for (i = 0; i + 2 <= cnt / 2; i += 2) {
+            x0 ^= dat64[i];
+            x1 ^= dat64[i + 1];
+        }
+        for (; i < cnt / 2; i++)
+            x0 ^= dat64[i];
+
+        x0 ^= x1;
+        xor = (RK_U32)x0 ^ (RK_U32)(x0 >> 32);
+        i *= 2;
+    }
+
+    for (; i < cnt; i++)
+        xor ^= dat32[i];
+
+    return xor;
+}
+
 void calc_data_crc(RK_U8 *dat, RK_U32 len, DataCrc *crc)
 {
     RK_ULONG data_grp_byte_cnt = MAX_HALF_WORD_SUM_CNT * CAL_BYTE;
     RK_U32 i = 0, grp_loop = 0;
     RK_U8 *dat8 = NULL;
-    RK_U32 *dat32 = NULL;
     RK_U32 xor = 0;
 
     /*calc sum */
@@ -288,9 +327,7 @@ void calc_data_crc(RK_U8 *dat, RK_U32 len, DataCrc *crc)
     }
 
     /*calc xor */
-    dat32 = (RK_U32 *)dat;
-    for (i = 0; i < len / 4; i++)
-        xor ^= dat32[i];
+    xor = word_xor(dat, len / 4);
 
     if (len % 4) {
         RK_U32 val = 0;
@@ -340,9 +377,8 @@ void calc_frm_crc(MppFrame frame, FrmCrc *crc)
     RK_U32 grp_line_cnt = 0;
     RK_U32 grp_cnt = 0;
 
-    RK_U32 y = 0, x = 0;
+    RK_U32 y = 0;
     RK_U8 *dat8 = NULL;
-    RK_U32 *dat32 = NULL;
     RK_U32 xor = 0;
 
     RK_U32 width  = mpp_frame_get_width(frame);
@@ -367,11 +403,8 @@ void calc_frm_crc(MppFrame frame, FrmCrc *crc)
     }
 
     dat8 = buf;
-    for (y = 0; y < height; y++) {
-        dat32 = (RK_U32 *)&dat8[y * stride];
-        for (x = 0; x < width / 4; x++)
-            xor ^= dat32[x];
-    }
+    for (y = 0; y < height; y++)
+        xor ^= word_xor(&dat8[y * stride], width / 4);
     crc->luma.len = height * width;
     crc->luma.vor = xor;
 
@@ -390,11 +423,8 @@ void calc_frm_crc(MppFrame frame, FrmCrc *crc)
     }
 
     dat8 = buf + height * stride;
-    for (y = 0; y < height / 2; y++) {
-        dat32 = (RK_U32 *)&dat8[y * stride];
-        for (x = 0; x < width / 4; x++)
-            xor ^= dat32[x];
-    }
+    for (y = 0; y < height / 2; y++)
+        xor ^= word_xor(&dat8[y * stride], width / 4);
     crc->chroma.len = height * width / 2;
     crc->chroma.vor = xor;
 }